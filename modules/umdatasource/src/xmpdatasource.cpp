@@ -311,7 +311,7 @@ void XMPDataSource::saveXMPstructs()
 
         try
         {
-            cMetaSource->saveSchema(schemaCompression, cStream.getAll());
+            cMetaSource->saveSchema(schemaCompression, cStream);
             cSchemaSource->save(schemaCompression);
         }
         catch(const XMP_Error& e)
@@ -358,7 +358,7 @@ void XMPDataSource::saveXMPstructs()
 
         try
         {
-            eMetaSource->saveSchema(schemaEncryption, eStream.getAll());
+            eMetaSource->saveSchema(schemaEncryption, eStream);
             eSchemaSource->save(schemaEncryption);
         }
         catch(const XMP_Error& e)
@@ -484,12 +484,12 @@ void XMPDataSource::loadProperty(const umf_string &schemaName, const umf_string
 }
 
 
-void XMPDataSource::saveSchema(const std::shared_ptr<MetadataSchema>& schemaDesc, const MetadataSet& mdSet)
+void XMPDataSource::saveSchema(const std::shared_ptr<MetadataSchema>& schemaDesc, const MetadataStream& stream)
 {
     metadataSourceCheck();
     try
     {
-        metadataSource->saveSchema(schemaDesc, mdSet);
+        metadataSource->saveSchema(schemaDesc, stream);
     }
     catch(const XMP_Error& e)
     {
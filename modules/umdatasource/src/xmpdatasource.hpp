@@ -65,7 +65,7 @@ public:
 
     virtual void loadProperty(const umf::umf_string &schemaName, const umf::umf_string &propertyName, MetadataStream &stream);
 
-    virtual void saveSchema(const std::shared_ptr<MetadataSchema>& schemaDesc, const MetadataSet& mdSet);
+    virtual void saveSchema(const std::shared_ptr<MetadataSchema>& schemaDesc, const MetadataStream& stream);
 
     virtual void save(const std::shared_ptr<umf::MetadataSchema>& schema);
 
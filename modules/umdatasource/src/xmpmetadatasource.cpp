@@ -68,6 +68,7 @@ public:
       : MetadataStream() { }
     virtual ~MetadataStreamAccessor() { }
     using MetadataStream::internalAdd;
+    using MetadataStream::internalAddBatch;
 };
 
 XMPMetadataSource::XMPMetadataSource(const std::shared_ptr<SXMPMeta>& meta)
@@ -76,7 +77,7 @@ XMPMetadataSource::XMPMetadataSource(const std::shared_ptr<SXMPMeta>& meta)
     loadIds();
 }
 
-void XMPMetadataSource::saveSchema(const std::shared_ptr<MetadataSchema>& schemaDesc, const MetadataSet& mdSet)
+void XMPMetadataSource::saveSchema(const std::shared_ptr<MetadataSchema>& schemaDesc, const MetadataStream& stream)
 {
     shared_ptr<MetadataSchema> thisSchemaDescription = schemaDesc;
     umf_string schemaName = schemaDesc->getName();
@@ -90,12 +91,11 @@ void XMPMetadataSource::saveSchema(const std::shared_ptr<MetadataSchema>& schema
         xmp->SetStructField(UMF_NS, thisSchemaPath.c_str(), UMF_NS, SCHEMA_SET, nullptr, kXMP_PropValueIsArray);
     }
 
-    MetadataSet thisSchemaSet = mdSet.queryBySchema(schemaName);
     vector< shared_ptr<MetadataDesc> > thisSchemaProperties = thisSchemaDescription->getAll();
     for(auto descIter = thisSchemaProperties.begin(); descIter != thisSchemaProperties.end(); ++descIter)
     {
         umf_string metadataName = (*descIter)->getMetadataName();
-        MetadataSet currentPropertySet(thisSchemaSet.queryByName(metadataName));
+        MetadataSet currentPropertySet(stream.queryBySchemaAndName(schemaName, metadataName));
         saveProperty(currentPropertySet, thisSchemaPath, metadataName);
     }
 }
@@ -248,11 +248,31 @@ void XMPMetadataSource::loadPropertyByPath(const umf_string& pathToProperty, con
 
     shared_ptr<MetadataDesc> description(schema->findMetadataDesc(metadataName));
 
+    // Items of the property are added at once, references are loaded afterwards
+    // since they may pull items of other properties
+    MetadataSet batch;
+    vector<umf_string> paths;
     SXMPIterator mIter(*xmp, UMF_NS, pathToMetadataSet.c_str(), kXMP_IterJustChildren);
     umf_string pathToCurrentMetadata;
     while(mIter.Next(nullptr, &pathToCurrentMetadata))
     {
-        loadMetadata(pathToCurrentMetadata, description, stream);
+        IdType id;
+        loadMetadataId(pathToCurrentMetadata, id);
+        if (stream.getById(id))
+        {
+            // already loaded
+            continue;
+        }
+        batch.push_back(readMetadata(pathToCurrentMetadata, id, description, stream));
+        paths.push_back(pathToCurrentMetadata);
+    }
+
+    MetadataStreamAccessor* streamAccessor = (MetadataStreamAccessor*) &stream;
+    streamAccessor->internalAddBatch(batch);
+
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        loadReferences(paths[i], batch[i], stream);
     }
     //unsorted stream fails on save
     stream.sortById();
@@ -270,6 +290,17 @@ void XMPMetadataSource::loadMetadata(const umf_string& pathToCurrentMetadata, co
         return;
     }
 
+    thisMetadata = readMetadata(pathToCurrentMetadata, id, description, stream);
+
+    MetadataStreamAccessor* streamAccessor = (MetadataStreamAccessor*) &stream;
+    streamAccessor->internalAdd(thisMetadata);
+
+    // Load refs only after adding to steam to stop recursive loading when there are circular references
+    loadReferences(pathToCurrentMetadata, thisMetadata, stream);
+}
+
+shared_ptr<Metadata> XMPMetadataSource::readMetadata(const umf_string& pathToCurrentMetadata, IdType id, const shared_ptr<MetadataDesc>& description, MetadataStream& stream)
+{
     long long frameIndex;
     loadMetadataFrameIndex(pathToCurrentMetadata, frameIndex);
 
@@ -286,7 +317,9 @@ void XMPMetadataSource::loadMetadata(const umf_string& pathToCurrentMetadata, co
     umf_string encryptedData;
     loadMetadataEncrypted(pathToCurrentMetadata, isEncrypted, encryptedData);
 
-    shared_ptr<MetadataAccessor> metadataAccessor(new MetadataAccessor(description));
+    // The item is taken from the storage of the stream, MetadataAccessor only exposes setId()
+    shared_ptr<Metadata> spMetadata = stream.createMetadata(description);
+    MetadataAccessor* metadataAccessor = (MetadataAccessor*) spMetadata.get();
 
     metadataAccessor->setFrameIndex(frameIndex, numOfFrames);
     metadataAccessor->setTimestamp(timestamp, duration);
@@ -311,22 +344,22 @@ void XMPMetadataSource::loadMetadata(const umf_string& pathToCurrentMetadata, co
     umf_string currentFieldPath;
     while(fieldsIterator.Next(NULL, &currentFieldPath))
     {
-        loadField(currentFieldPath, metadataAccessor, thisPropertyDesc);
+        loadField(currentFieldPath, spMetadata, thisPropertyDesc);
     }
 
-    MetadataStreamAccessor* streamAccessor = (MetadataStreamAccessor*) &stream;
-    streamAccessor->internalAdd(metadataAccessor);
+    return spMetadata;
+}
 
-    // Load refs only after adding to steam to stop recursive loading when there are circular references
+void XMPMetadataSource::loadReferences(const umf_string& pathToCurrentMetadata, const shared_ptr<Metadata>& md, MetadataStream& stream)
+{
     umf_string pathToRefs;
     SXMPUtils::ComposeStructFieldPath(UMF_NS, pathToCurrentMetadata.c_str(), UMF_NS, METADATA_REFERENCES, &pathToRefs);
     SXMPIterator refsIterator(*xmp, UMF_NS, pathToRefs.c_str(), kXMP_IterJustChildren);
     umf_string currentRefPath;
     while(refsIterator.Next(NULL, &currentRefPath))
     {
-        loadReference(currentRefPath, metadataAccessor, stream);
+        loadReference(currentRefPath, md, stream);
     }
-
 }
 
 void XMPMetadataSource::loadPropertyName(const umf_string& pathToMetadata, umf_string& metadataName)
@@ -29,7 +29,7 @@ class XMPMetadataSource
 {
 public:
     explicit XMPMetadataSource(const std::shared_ptr<SXMPMeta>& meta);
-    void saveSchema(const std::shared_ptr<MetadataSchema>& schemaDesc, const umf::MetadataSet& mdSet);
+    void saveSchema(const std::shared_ptr<MetadataSchema>& schemaDesc, const umf::MetadataStream& stream);
     void loadSchema(const umf::umf_string& schemaName, umf::MetadataStream& stream);
     void loadProperty(const umf::umf_string& schemaName, const umf::umf_string& metadataName, umf::MetadataStream& stream);
     void remove(const std::vector<umf::IdType>& removedIds);
@@ -47,6 +47,8 @@ private:
     void saveProperty(const umf::MetadataSet& property, const umf::umf_string& pathToSchema, const umf::umf_string& propertyName);
 
     void loadMetadata(const umf::umf_string& pathToCurrentMetadata, const std::shared_ptr<MetadataDesc>& description, umf::MetadataStream& stream);
+    std::shared_ptr<umf::Metadata> readMetadata(const umf::umf_string& pathToCurrentMetadata, umf::IdType id, const std::shared_ptr<MetadataDesc>& description, umf::MetadataStream& stream);
+    void loadReferences(const umf::umf_string& pathToCurrentMetadata, const std::shared_ptr<umf::Metadata>& md, umf::MetadataStream& stream);
     void saveMetadata(const std::shared_ptr<umf::Metadata>& md, const umf::umf_string& thisPropertySetPath);
 
     void loadSchemaName(const umf::umf_string& pathToSchema, umf::umf_string& schemaName);
@@ -42,6 +42,7 @@
 #define FIELD_TYPE "type"
 #define FIELD_OPTIONALITY "optional"
 #define FIELD_ENCRYPTED "encrypted"
+#define FIELD_INDEXED "indexed"
 
 
 using namespace std;
@@ -197,6 +198,8 @@ void XMPSchemaSource::saveField(const FieldDesc& desc, const umf_string& pathToF
     metadata->SetStructField(UMF_NS, thisField.c_str(), UMF_NS, FIELD_TYPE, Variant::typeToString(desc.type).c_str());
     if(desc.optional)
         metadata->SetStructField(UMF_NS, thisField.c_str(), UMF_NS, FIELD_OPTIONALITY, "true");
+    if(desc.indexed)
+        metadata->SetStructField(UMF_NS, thisField.c_str(), UMF_NS, FIELD_INDEXED, "true");
     if(desc.useEncryption)
     {
         metadata->SetStructField(UMF_NS, thisField.c_str(), UMF_NS, FIELD_ENCRYPTED, "true");
@@ -309,7 +312,12 @@ shared_ptr<MetadataDesc> XMPSchemaSource::loadDescription(const umf_string& path
                                                            FIELD_ENCRYPTED, &encryptedFieldStr, NULL);
         useEncryptionField = useEncryptionField && encryptedFieldStr == "true";
 
-        fields.push_back(FieldDesc(name, type, optional, useEncryptionField));
+        umf_string indexedFieldStr;
+        bool indexed = metadata->GetStructField(UMF_NS, currentFieldPath.c_str(), UMF_NS,
+                                                FIELD_INDEXED, &indexedFieldStr, NULL);
+        indexed = indexed && indexedFieldStr == "true";
+
+        fields.push_back(FieldDesc(name, type, optional, useEncryptionField, indexed));
     }
 
     vector < shared_ptr<ReferenceDesc> > refs;
@@ -20,6 +20,7 @@
 
 #include "variant.hpp"
 #include "global.hpp"
+#include "symbol.hpp"
 #include <string>
 
 namespace umf
@@ -35,7 +36,7 @@ public:
     /*!
      * \brief Default constructor
      */
-    FieldValue() : m_name(""), m_useEncryption(false), m_encryptedData("")
+    FieldValue() : m_useEncryption(false), m_encryptedData("")
     {}
 
     /*!
@@ -69,12 +70,12 @@ public:
     /*!
      * \brief Constructor with some members
      * \param name Name of the field
-     * \param variant Value of the field, Variant type
+     * \param variant Value of the field, Variant type, pass an rvalue to move the value in
      * \param useEncryption Flag specifying whether to use separate encryption
      * for this field or not
      */
-    FieldValue( const std::string& name, umf::Variant variant, bool useEncryption = false)
-        : umf::Variant( variant )
+    FieldValue( const Symbol& name, umf::Variant variant, bool useEncryption = false)
+        : umf::Variant( std::move( variant ))
         , m_name( name )
         , m_useEncryption(useEncryption)
         , m_encryptedData("")
@@ -86,6 +87,12 @@ public:
      */
     const std::string& getName() const { return m_name; }
 
+    /*!
+     * \brief Gets the interned name of the field
+     * \return
+     */
+    const Symbol& getNameSymbol() const { return m_name; }
+
     /*!
      * \brief Gets the flag specifying whether to use separate encryption
      * for this field or not
@@ -113,6 +120,7 @@ public:
      * \param encryptedData
      */
     void setEncryptedData(const std::string& encryptedData) { m_encryptedData = encryptedData; }
+    void setEncryptedData(std::string&& encryptedData) { m_encryptedData = std::move(encryptedData); }
 
     FieldValue& operator = ( const FieldValue& other )
     {
@@ -149,7 +157,7 @@ private:
     /*!
      * \brief m_name Field name
      */
-    umf_string m_name;
+    Symbol m_name;
 
     /*!
      * \brief m_useEncryption Flag specifying whether to use separate encryption
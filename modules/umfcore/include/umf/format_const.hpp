@@ -63,6 +63,7 @@
 
 #define ATTR_FIELD_TYPE "type"
 #define ATTR_FIELD_OPTIONAL "optional"
+#define ATTR_FIELD_INDEXED "indexed"
 
 #define ATTR_REFERENCE_UNIQUE "unique"
 #define ATTR_REFERENCE_CUSTOM "custom"
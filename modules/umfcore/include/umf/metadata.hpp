@@ -54,6 +54,7 @@ class UMF_EXPORT Metadata : public std::vector< umf::FieldValue >
 {
     friend class MetadataSet;
     friend class MetadataStream;
+    friend class MetadataColumns; // setId()
 
 public:
     /*!
@@ -135,6 +136,16 @@ public:
     */
     std::string getSchemaName() const;
 
+    /*!
+    * \brief Get interned metadata item name
+    */
+    const Symbol& getNameSymbol() const { return m_sName; }
+
+    /*!
+    * \brief Get interned schema name
+    */
+    const Symbol& getSchemaNameSymbol() const { return m_sSchemaName; }
+
     /*!
     * \brief Returns list of field names
     * \return list of field names
@@ -164,6 +175,58 @@ public:
     * \return Const_tierator to the specified field
     */
     const_iterator findField(const std::string& sFieldName) const;
+
+    /*!
+    * \brief Find field by interned name, no string comparisons are made
+    * \param name [in] field name
+    * \return Iterator to the specified field
+    */
+    iterator findField( const Symbol& name );
+    const_iterator findField( const Symbol& name ) const;
+
+    iterator findField( const char* pszFieldName ) { return findField( std::string( pszFieldName ) ); }
+    const_iterator findField( const char* pszFieldName ) const { return findField( std::string( pszFieldName ) ); }
+    /*!
+    * \brief Get the value of a field by its slot in the description
+    * \param slot [in] slot resolved by MetadataDesc::getFieldSlot()
+    * \return Pointer to the field value or nullptr if the field has no value
+    * \throw IncorrectParamException if the description has no such slot
+    */
+    const FieldValue* tryField( size_t slot ) const;
+
+    /*!
+    * \brief Get the value of a field by its slot in the description
+    * \param slot [in] slot resolved by MetadataDesc::getFieldSlot()
+    * \return Reference to the field value, no copy is made
+    * \throw IncorrectParamException if there's no such slot or the field has no value
+    */
+    const FieldValue& field( size_t slot ) const;
+
+    /*!
+    * \brief Get the typed value of a field by its slot in the description
+    * \return Reference to the value, T is the type of the field (umf_integer, umf_string...)
+    * \throw IncorrectParamException if there's no such slot or the field has no value
+    * \throw TypeCastException if the field holds a value of another type
+    */
+    template< typename T > const T& get( size_t slot ) const
+    {
+        const T* pValue = field( slot ).template try_get< T >();
+        if( !pValue )
+            UMF_EXCEPTION(TypeCastException, "bad cast");
+        return *pValue;
+    }
+
+    /*!
+    * \brief Get the typed value of a field by its name
+    * \return Reference to the value, T is the type of the field (umf_integer, umf_string...)
+    * \throw IncorrectParamException if there's no such field or the field has no value
+    * \throw TypeCastException if the field holds a value of another type
+    */
+    template< typename T > const T& get( const std::string& sFieldName ) const
+    {
+        return get< T >( getFieldSlot( sFieldName ) );
+    }
+
     /*!
     * \brief Checks if the field is present (i.e. has a value) in the metadata
     */
@@ -241,6 +304,27 @@ public:
     */
     void setFieldValue( const std::string& sFieldName, const umf::Variant& value );
 
+    /*!
+    * \brief Set value of specified field taking over the storage of the value
+    * \param sFieldName [in] name of field
+    * \param value [in] new field value, left empty or unspecified after the call
+    * \throw NullPointerException when metadata field description object is null
+    * \throw IncorrectParamException when field description not found
+    */
+    void setFieldValue( const std::string& sFieldName, umf::Variant&& value );
+
+    /*!
+    * \brief Construct the value of specified field in place
+    * \param sFieldName [in] name of field
+    * \param value [in] any value a Variant is made of, rvalue strings, raw buffers and vectors are moved
+    * \throw NullPointerException when metadata field description object is null
+    * \throw IncorrectParamException when field description not found
+    */
+    template< typename T > void emplaceField( const std::string& sFieldName, T&& value )
+    {
+        setFieldValue( sFieldName, umf::Variant( std::forward< T >( value )));
+    }
+
     /*!
     * \brief Add new value with empty name to metadata item
     * \param value [in] value to add
@@ -249,13 +333,14 @@ public:
     * \throw TypeCastException if field type is incompatible with type of value
     */
     void addValue( const umf::Variant& value );
+    void addValue( umf::Variant&& value );
 
 
     /*!
     * \brief Get the descriptor of the metadata
     * \return the descriptor of the metadata.
     */
-    std::shared_ptr< MetadataDesc > getDesc() const;
+    const std::shared_ptr< MetadataDesc >& getDesc() const;
 
 
     /*!
@@ -293,6 +378,7 @@ public:
      * \param encData
      */
     void setEncryptedData(const std::string& encData);
+    void setEncryptedData(std::string&& encData);
 
     enum {
         UNDEFINED_FRAME_INDEX = -1, UNDEFINED_FRAMES_NUMBER = 0,
@@ -301,13 +387,15 @@ public:
 
 protected:
     void setId( const IdType& id );
+    size_t getFieldSlot( const std::string& sFieldName ) const;
+    size_t getSlotPosition( size_t slot ) const;
     bool shiftFrameIndex( long long nTarFrameIndex, long long nSrcFrameIndex, long long nNumOfFrames = FRAME_COUNT_ALL );
     void removeInvalidReferences();
     bool operator > ( const Metadata& ) const { throw std::runtime_error("Operator not available!"); }
 
     void removeAllReferences();
     void setDescriptor( const std::shared_ptr< MetadataDesc >& spDescriptor );
-    void setStreamRef(const MetadataStream* streamPtr);
+    void setStreamRef(MetadataStream* streamPtr);
 
 private:
     IdType          m_Id;
@@ -315,14 +403,14 @@ private:
     long long       m_nNumOfFrames;
     long long       m_nTimestamp;
     long long       m_nDuration;
-    std::string     m_sName;
-    std::string     m_sSchemaName;
+    Symbol          m_sName;
+    Symbol          m_sSchemaName;
     bool            m_useEncryption;
     std::string     m_encryptedData;
 
     std::vector<Reference> m_vReferences;
     std::shared_ptr< MetadataDesc >	m_spDesc;
-    const MetadataStream *m_pStream;
+    MetadataStream *m_pStream;
 };
 }
 
@@ -0,0 +1,231 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+/*!
+* \file metadatacolumns.hpp
+* \brief %MetadataColumns class header file
+*/
+
+#ifndef __UMF_METADATA_COLUMNS_H__
+#define __UMF_METADATA_COLUMNS_H__
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+
+#include "global.hpp"
+#include "metadata.hpp"
+#include <memory>
+#include <vector>
+
+namespace umf
+{
+
+/*!
+* \class ColumnSpan
+* \brief Read-only contiguous range of column values
+* \details A span borrows the storage of its columns and is valid until they are modified.
+*/
+template< typename T > class ColumnSpan
+{
+public:
+    ColumnSpan() : m_pData( nullptr ), m_nSize( 0 ) {}
+    ColumnSpan( const T* pData, size_t nSize ) : m_pData( pData ), m_nSize( nSize ) {}
+
+    const T* data() const { return m_pData; }
+    size_t size() const { return m_nSize; }
+    bool empty() const { return m_nSize == 0; }
+
+    const T* begin() const { return m_pData; }
+    const T* end() const { return m_pData + m_nSize; }
+
+    const T& operator[]( size_t i ) const { return m_pData[i]; }
+
+private:
+    const T* m_pData;
+    size_t m_nSize;
+};
+
+/*!
+* \class MetadataColumns
+* \brief %MetadataColumns stores the metadata items of one description as a structure of arrays
+* \details Identifiers, frame indexes, timestamps and every field have their own contiguous
+* array, rows are ordered by identifier. Integer fields are stored as umf_integer values,
+* real and vector fields as umf_real values with 1, 2, 3 or 4 components per row.
+* Absent optional values are stored as zeros and marked in the presence array of the field.
+* Only descriptions of integer, real and vector fields without encryption are supported,
+* the rows can't have references.
+*/
+class UMF_EXPORT MetadataColumns
+{
+public:
+    /*!
+    * \brief Class constructor
+    * \param spDesc [in] description of the stored items
+    * \throw IncorrectParamException if the description is not supported
+    */
+    explicit MetadataColumns( const std::shared_ptr< MetadataDesc >& spDesc );
+
+    /*!
+    * \brief Check whether items of the description can be stored in columns
+    * \param desc [in] metadata description
+    */
+    static bool isSupported( const MetadataDesc& desc );
+
+    /*!
+    * \brief Get description of the stored items
+    */
+    const std::shared_ptr< MetadataDesc >& getDesc() const { return m_spDesc; }
+
+    /*!
+    * \brief Get the number of rows
+    */
+    size_t size() const { return m_vIds.size(); }
+
+    /*!
+    * \brief Check whether there are no rows
+    */
+    bool empty() const { return m_vIds.empty(); }
+
+    /*!
+    * \brief Reserve storage for the rows
+    * \param nRows [in] expected number of rows
+    */
+    void reserve( size_t nRows );
+
+    /*!
+    * \brief Check whether a metadata item can be stored
+    * \param md [in] valid metadata item of the description with an identifier
+    * \throw IncorrectParamException if the item has another description, references or encrypted data,
+    * or if an item with the same identifier is already stored
+    */
+    void check( const Metadata& md ) const;
+
+    /*!
+    * \brief Store a copy of a metadata item
+    * \param md [in] valid metadata item of the description with an identifier
+    * \throw IncorrectParamException in the cases listed for check()
+    */
+    void append( const Metadata& md );
+
+    /*!
+    * \brief Remove the row of an item
+    * \param id [in] identifier of the item
+    * \return true if the row was found
+    */
+    bool remove( const IdType& id );
+
+    /*!
+    * \brief Remove all rows
+    */
+    void clear();
+
+    /*!
+    * \brief Find the row of an item
+    * \param id [in] identifier of the item
+    * \param row [out] row of the item
+    * \return true if the row was found
+    */
+    bool find( const IdType& id, size_t& row ) const;
+
+    /*!
+    * \brief Create a metadata item from a row
+    * \param row [in] row of the item
+    * \return new metadata item, changes of it don't affect the row
+    * \throw OutOfRangeException if there's no such row
+    */
+    std::shared_ptr< Metadata > materialize( size_t row ) const;
+
+    /*!
+    * \brief Get the value of a field in a row
+    * \param row [in] row of the item
+    * \param slot [in] slot of the field in the description
+    * \param value [out] field value
+    * \return false if the optional value is absent
+    * \throw OutOfRangeException if there's no such row or slot
+    */
+    bool getValue( size_t row, size_t slot, Variant& value ) const;
+
+    ColumnSpan< IdType > ids() const { return span( m_vIds ); }
+    ColumnSpan< long long > frameIndexes() const { return span( m_vFrameIndexes ); }
+    ColumnSpan< long long > numsOfFrames() const { return span( m_vNumsOfFrames ); }
+    ColumnSpan< long long > timestamps() const { return span( m_vTimestamps ); }
+    ColumnSpan< long long > durations() const { return span( m_vDurations ); }
+
+    /*!
+    * \brief Get the number of values per row of a field
+    * \param slot [in] slot of the field in the description
+    * \return 1 for integer and real fields, the dimension for vector fields
+    */
+    size_t getComponents( size_t slot ) const;
+
+    /*!
+    * \brief Get the values of an integer field
+    * \param slot [in] slot of the field in the description
+    * \throw TypeCastException if the field is not integer
+    */
+    ColumnSpan< umf_integer > integers( size_t slot ) const;
+
+    /*!
+    * \brief Get the values of a real or vector field
+    * \param slot [in] slot of the field in the description
+    * \return getComponents() values per row, row after row
+    * \throw TypeCastException if the field is neither real nor vector
+    */
+    ColumnSpan< umf_real > reals( size_t slot ) const;
+
+    /*!
+    * \brief Get the presence flags of an optional field
+    * \param slot [in] slot of the field in the description
+    * \return non-zero flag per row if the row has the value, empty span for required fields
+    */
+    ColumnSpan< unsigned char > presence( size_t slot ) const;
+
+private:
+    struct Column
+    {
+        Variant::Type type;
+        size_t nComponents;
+        bool optional;
+        std::vector< umf_integer > integers;
+        std::vector< umf_real > reals;
+        std::vector< unsigned char > present;
+    };
+
+    template< typename T > static ColumnSpan< T > span( const std::vector< T >& v )
+    {
+        return ColumnSpan< T >( v.data(), v.size() );
+    }
+
+    const Column& getColumn( size_t slot ) const;
+
+    std::shared_ptr< MetadataDesc > m_spDesc;
+    std::vector< IdType > m_vIds;
+    std::vector< long long > m_vFrameIndexes;
+    std::vector< long long > m_vNumsOfFrames;
+    std::vector< long long > m_vTimestamps;
+    std::vector< long long > m_vDurations;
+    std::vector< Column > m_vColumns;
+};
+
+}
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#endif /* __UMF_METADATA_COLUMNS_H__ */
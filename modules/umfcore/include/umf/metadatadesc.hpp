@@ -30,6 +30,7 @@
 
 #include <vector>
 #include "variant.hpp"
+#include "symbol.hpp"
 #include "config.hpp"
 
 namespace umf
@@ -46,10 +47,11 @@ struct FieldDesc
     * \param eType [in] field type
     * \param isOptional [in] field optional
     * \param _useEncryption [in] field useEncryption
+    * \param isIndexed [in] field indexed
     */
     FieldDesc( const std::string& sName = "", Variant::Type eType = Variant::type_string,
-               bool isOptional = false, bool _useEncryption = false ) :
-        name( sName ), type( eType ), optional(isOptional), useEncryption(_useEncryption) {};
+               bool isOptional = false, bool _useEncryption = false, bool isIndexed = false ) :
+        name( sName ), type( eType ), optional(isOptional), useEncryption(_useEncryption), indexed(isIndexed) {};
 
     /*!
     * \brief field name
@@ -71,6 +73,15 @@ struct FieldDesc
      */
     bool            useEncryption;
 
+    /*!
+     * \brief field indexed
+     * \details %MetadataStream keeps a value index for such fields: a hash index
+     * for equality lookups and, for integer and real fields, an ordered index
+     * for range lookups. Changes made via Metadata::setFieldValue() and
+     * Metadata::addValue() are tracked by the index.
+     */
+    bool            indexed;
+
     /*!
     * \brief Compare operator
     * \param oth [in] another field description object
@@ -100,6 +111,7 @@ typedef struct ReferenceDesc
 class UMF_EXPORT MetadataDesc
 {
     friend class MetadataSchema;
+    friend class Metadata;
 
 public:
     
@@ -183,17 +195,54 @@ public:
     * \param sFieldName [in] field name. This should be empty for single value descriptor or array-type descriptor.
     * \retval field description
     * \throw IncorrectParamException if there's no such field
+    * \details Name, type and optional flag of the field are fixed once the description is added to a schema,
+    * Metadata::validate() doesn't see later changes of them.
     */
     FieldDesc& getFieldDesc(const std::string &sFieldName);
 
+    /*!
+    * \brief Get the slot of a field
+    * \details Slot is the position of the field in the description, it does not
+    * change during the life of the description. Resolving a slot once and using
+    * it with Metadata::field() or Metadata::get() avoids name lookups.
+    * \param sFieldName [in] field name. This should be empty for single value descriptor or array-type descriptor.
+    * \param slot [out] slot of the field
+    * \retval true if field exists
+    * \retval false otherwise
+    */
+    bool getFieldSlot( const std::string& sFieldName, size_t& slot ) const;
+
+    /*!
+    * \brief Get the number of field slots
+    */
+    size_t getSlotCount() const { return m_vFields.size(); }
+
+    /*!
+    * \brief Get the description of the field in the slot
+    * \throw IncorrectParamException if there's no such slot
+    */
+    const FieldDesc& getSlotDesc( size_t slot ) const;
+
+    /*!
+    * \brief Get the interned name of the field in the slot
+    * \throw IncorrectParamException if there's no such slot
+    */
+    const Symbol& getSlotName( size_t slot ) const;
+
 protected:
     void validate();
     void setSchemaName( const std::string& sAppName );
 
 private:
+    void compileValidator();
+
     std::string                 m_sSchemaName;
     std::string                 m_sMetadataName;
     std::vector< FieldDesc >    m_vFields;
+    std::vector< Symbol >       m_vSlotNames;
+    // Compact form of the fields checked by Metadata::validate(): a bit per non-optional slot and the slot types
+    std::vector< uint64_t >     m_vRequiredSlots;
+    std::vector< Variant::Type > m_vSlotTypes;
     std::vector<std::shared_ptr<ReferenceDesc>>  m_vRefDesc;
     bool m_useEncryption;
 };
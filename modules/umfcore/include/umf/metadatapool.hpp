@@ -0,0 +1,197 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+/*!
+* \file metadatapool.hpp
+* \brief %MetadataPool class header file
+*/
+
+#ifndef __UMF_METADATA_POOL_H__
+#define __UMF_METADATA_POOL_H__
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+
+#include "global.hpp"
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace umf
+{
+
+/*!
+* \class MetadataPool
+* \brief Thread-safe pool of small memory blocks
+* \details Blocks are grouped by size in 16 bytes steps and carved from large chunks,
+* released blocks are reused by the next allocations of the same size. Chunks are freed
+* only when the pool is destroyed. Blocks larger than getMaxBlockSize() are taken from the heap.
+*/
+class UMF_EXPORT MetadataPool
+{
+public:
+    /*!
+    * \brief Class constructor
+    * \param nBlocksPerChunk [in] number of blocks carved from a chunk at once
+    */
+    explicit MetadataPool( size_t nBlocksPerChunk = 1024 );
+
+    /*!
+    * \brief Class destructor, frees all chunks
+    */
+    ~MetadataPool();
+
+    /*!
+    * \brief Allocate a block
+    * \param nBytes [in] block size
+    * \return block aligned as a heap block
+    */
+    void* allocate( size_t nBytes );
+
+    /*!
+    * \brief Release a block
+    * \param p [in] block returned by allocate()
+    * \param nBytes [in] size passed to allocate()
+    */
+    void deallocate( void* p, size_t nBytes );
+
+    /*!
+    * \brief Get the number of allocated and not yet released blocks
+    */
+    size_t getBlockCount() const;
+
+    /*!
+    * \brief Get the number of chunks taken from the heap
+    */
+    size_t getChunkCount() const;
+
+    /*!
+    * \brief Get the largest block size served from the chunks
+    */
+    static size_t getMaxBlockSize() { return nSizeClasses * nGranularity; }
+
+private:
+    MetadataPool( const MetadataPool& ) = delete;
+    MetadataPool& operator = ( const MetadataPool& ) = delete;
+
+    enum { nGranularity = 16, nSizeClasses = 32 };
+
+    struct FreeBlock
+    {
+        FreeBlock* pNext;
+    };
+
+    struct SizeClass
+    {
+        SizeClass() : pFree( nullptr ), pNext( nullptr ), pEnd( nullptr ) {}
+
+        FreeBlock* pFree;
+        char* pNext;
+        char* pEnd;
+    };
+
+    size_t m_nBlocksPerChunk;
+    SizeClass m_classes[nSizeClasses];
+    std::vector< void* > m_chunks;
+    size_t m_nBlocks;
+    mutable std::mutex m_mutex;
+};
+
+/*!
+* \class PoolAllocator
+* \brief Standard allocator drawing from a MetadataPool
+* \details Copies share the pool and keep it alive, so objects made by std::allocate_shared()
+* may outlive the owner of the pool. A default constructed allocator uses the heap.
+*/
+template< typename T > class PoolAllocator
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    template< typename U > struct rebind
+    {
+        typedef PoolAllocator< U > other;
+    };
+
+    PoolAllocator() {}
+    explicit PoolAllocator( const std::shared_ptr< MetadataPool >& spPool ) : m_spPool( spPool ) {}
+    template< typename U > PoolAllocator( const PoolAllocator< U >& other ) : m_spPool( other.getPool() ) {}
+
+    T* allocate( size_t n )
+    {
+        if( !m_spPool )
+            return static_cast< T* >( ::operator new( n * sizeof( T )));
+        return static_cast< T* >( m_spPool->allocate( n * sizeof( T )));
+    }
+
+    void deallocate( T* p, size_t n )
+    {
+        if( !m_spPool )
+            ::operator delete( p );
+        else
+            m_spPool->deallocate( p, n * sizeof( T ));
+    }
+
+    template< typename U, typename... Args > void construct( U* p, Args&&... args )
+    {
+        ::new( (void*)p ) U( std::forward< Args >( args )... );
+    }
+
+    template< typename U > void destroy( U* p )
+    {
+        p->~U();
+    }
+
+    const std::shared_ptr< MetadataPool >& getPool() const { return m_spPool; }
+
+private:
+    std::shared_ptr< MetadataPool > m_spPool;
+};
+
+template< typename T, typename U >
+bool operator == ( const PoolAllocator< T >& a, const PoolAllocator< U >& b )
+{
+    return a.getPool() == b.getPool();
+}
+
+template< typename T, typename U >
+bool operator != ( const PoolAllocator< T >& a, const PoolAllocator< U >& b )
+{
+    return !( a == b );
+}
+
+}
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#endif /* __UMF_METADATA_POOL_H__ */
@@ -153,38 +153,40 @@ private:
     schema->add( desc );\
 };
 
-#define UMF_FIELD_STR_( name, isOptional ) \
-    fields.emplace_back( umf::FieldDesc( name, umf::Variant::type_string, isOptional ));
+#define UMF_FIELD_( name, type, isOptional, isIndexed ) \
+    fields.emplace_back( umf::FieldDesc( name, type, isOptional, false, isIndexed ));
+
+#define UMF_FIELD_STR_( name, isOptional ) UMF_FIELD_( name, umf::Variant::type_string, isOptional, false )
 #define UMF_FIELD_STR( name ) UMF_FIELD_STR_( name, false )
 #define UMF_FIELD_STR_OPT( name ) UMF_FIELD_STR_( name, true )
+#define UMF_FIELD_STR_IDX( name ) UMF_FIELD_( name, umf::Variant::type_string, false, true )
+#define UMF_FIELD_STR_OPT_IDX( name ) UMF_FIELD_( name, umf::Variant::type_string, true, true )
 
-#define UMF_FIELD_INT_( name, isOptional ) \
-    fields.emplace_back( umf::FieldDesc( name, umf::Variant::type_integer, isOptional ));
+#define UMF_FIELD_INT_( name, isOptional ) UMF_FIELD_( name, umf::Variant::type_integer, isOptional, false )
 #define UMF_FIELD_INT( name ) UMF_FIELD_INT_( name, false )
 #define UMF_FIELD_INT_OPT( name ) UMF_FIELD_INT_( name, true )
+#define UMF_FIELD_INT_IDX( name ) UMF_FIELD_( name, umf::Variant::type_integer, false, true )
+#define UMF_FIELD_INT_OPT_IDX( name ) UMF_FIELD_( name, umf::Variant::type_integer, true, true )
 
-#define UMF_FIELD_REAL_( name, isOptional ) \
-    fields.emplace_back( umf::FieldDesc( name, umf::Variant::type_real, isOptional ));
+#define UMF_FIELD_REAL_( name, isOptional ) UMF_FIELD_( name, umf::Variant::type_real, isOptional, false )
 #define UMF_FIELD_REAL( name ) UMF_FIELD_REAL_( name, false )
 #define UMF_FIELD_REAL_OPT( name ) UMF_FIELD_REAL_( name, true )
+#define UMF_FIELD_REAL_IDX( name ) UMF_FIELD_( name, umf::Variant::type_real, false, true )
+#define UMF_FIELD_REAL_OPT_IDX( name ) UMF_FIELD_( name, umf::Variant::type_real, true, true )
 
-#define UMF_FIELD_VEC2D_( name, isOptional ) \
-    fields.emplace_back( umf::FieldDesc( name, umf::Variant::type_vector2d, isOptional ));
+#define UMF_FIELD_VEC2D_( name, isOptional ) UMF_FIELD_( name, umf::Variant::type_vec2d, isOptional, false )
 #define UMF_FIELD_VEC2D( name ) UMF_FIELD_VEC2D_( name, false )
 #define UMF_FIELD_VEC2D_OPT( name ) UMF_FIELD_VEC2D_( name, true )
 
-#define UMF_FIELD_VEC3D_( name, isOptional ) \
-    fields.emplace_back( umf::FieldDesc( name, umf::Variant::type_vector3d, isOptional ));
+#define UMF_FIELD_VEC3D_( name, isOptional ) UMF_FIELD_( name, umf::Variant::type_vec3d, isOptional, false )
 #define UMF_FIELD_VEC3D( name ) UMF_FIELD_VEC3D_( name, false )
 #define UMF_FIELD_VEC3D_OPT( name ) UMF_FIELD_VEC3D_( name, true )
 
-#define UMF_FIELD_VEC4D_( name, isOptional ) \
-    fields.emplace_back( umf::FieldDesc( name, umf::Variant::type_vector4d, isOptional ));
+#define UMF_FIELD_VEC4D_( name, isOptional ) UMF_FIELD_( name, umf::Variant::type_vec4d, isOptional, false )
 #define UMF_FIELD_VEC4D( name ) UMF_FIELD_VEC4D_( name, false )
 #define UMF_FIELD_VEC4D_OPT( name ) UMF_FIELD_VEC4D_( name, true )
 
-#define UMF_FIELD_RAW_( name, isOptional ) \
-    fields.emplace_back( umf::FieldDesc( name, umf::Variant::type_rawbuffer, isOptional ));
+#define UMF_FIELD_RAW_( name, isOptional ) UMF_FIELD_( name, umf::Variant::type_rawbuffer, isOptional, false )
 #define UMF_FIELD_RAW( name ) UMF_FIELD_RAW_( name, false )
 #define UMF_FIELD_RAW_OPT( name ) UMF_FIELD_RAW_( name, true )
 
@@ -30,6 +30,7 @@
 #include "global.hpp"
 #include "metadata.hpp"
 #include "iquery.hpp"
+#include "metadataview.hpp"
 #include <functional>
 
 namespace umf
@@ -90,6 +91,12 @@ public:
     MetadataSet queryByReference( const std::string& sReferenceName, const umf::FieldValue& value ) const;
     MetadataSet queryByReference( const std::string& sReferenceName, const std::vector< umf::FieldValue>& vFields ) const;
 
+    /*!
+    * \brief Get view of the items of the set
+    * \return view borrowing the items of the set, valid until the set is modified
+    */
+    MetadataView view() const { return MetadataView( data(), data() + size() ); }
+
     /*!
     * \brief Shift frame index value associated with metadata
     * \param nTarFrameIndex [in] The new frame index of the frame referenced by nSrcFrameIndex
@@ -30,6 +30,10 @@
 #include "umf/global.hpp"
 #include "umf/metadatainternal.hpp"
 #include "umf/metadataset.hpp"
+#include "umf/metadataview.hpp"
+#include "umf/metadatacolumns.hpp"
+#include "umf/metadatapool.hpp"
+#include "umf/queryexpr.hpp"
 #include "umf/metadataschema.hpp"
 #include "umf/compressor.hpp"
 #include "umf/encryptor.hpp"
@@ -39,12 +43,15 @@
 #include <map>
 #include <memory>
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <algorithm>
 
 namespace umf
 {
 class IDataSource;
+class RWLock;
 class IReader;
 class IWriter;
 class Format;
@@ -56,6 +63,9 @@ class Format;
 */
 class UMF_EXPORT MetadataStream : public IQuery
 {
+    friend class Metadata; // on*Changed(), onReferenceAdded(), onReferenceRemoved()
+    friend class QueryPlanner; // indexes
+
 public:
     /*!
     * \brief File open mode flags
@@ -128,6 +138,11 @@ public:
     */
     MetadataStream(void);
 
+    /*!
+    * \brief Copy constructor
+    */
+    MetadataStream(const MetadataStream& other);
+
     /*!
     * \brief Class destructor
     */
@@ -211,16 +226,50 @@ public:
     */
     IdType add(MetadataInternal& mdi);
 
+    /*!
+    * \brief Add new metadata item taking over its string values and encrypted data
+    * \param mdi [in] MetadataInternal object, consumed by the call
+    * \return ID of added metadata object
+    * \throw ValidateException if metadata is not valid to selected scheme or description
+    * \throw IncorrectParamException if metadata with such id is already exists
+    */
+    IdType add(MetadataInternal&& mdi);
+
+    /*!
+    * \brief Add a batch of new metadata items
+    * \param items [in] metadata items, consumed by the call
+    * \param nValidationThreads [in] number of threads validating the items, 0 means one per hardware thread
+    * \return IDs of added metadata objects in the order of the batch
+    * \details Descriptions are resolved once per description and all items are validated
+    * before any of them is added, so the stream is left unchanged if an item is invalid.
+    * References between items of the batch are resolved regardless of their order.
+    * \throw ValidateException if metadata is not valid to selected scheme or description
+    * \throw IncorrectParamException if metadata with such id is already exists
+    */
+    std::vector< IdType > addBatch(std::vector< MetadataInternal >&& items, unsigned nValidationThreads = 1);
+
+    /*!
+    * \brief Add a batch of new metadata items
+    * \param items [in] pointers to metadata objects, consumed by the call
+    * \param nValidationThreads [in] number of threads validating the items, 0 means one per hardware thread
+    * \details Every item gets a new identifier as with add(). All items are validated
+    * before any of them is added, so the stream is left unchanged if an item is invalid.
+    * \throw ValidateException if metadata is not valid to selected scheme or description
+    */
+    void addBatch(MetadataSet&& items, unsigned nValidationThreads = 1);
+
     /*!
     * \brief Remove metadata by their id
     * \param id [in] metadata identifier
     * \return operation result
+    * \details The remaining items keep their order.
     */
     bool remove( const IdType& id );
 
     /*!
     * \brief Remove set of metadata objects
     * \param set [in] set of metadata objects
+    * \details The item list is compacted in a single pass, the remaining items keep their order.
     */
     void remove( const MetadataSet& set );
 
@@ -234,6 +283,30 @@ public:
     */
     void remove();
 
+    /*!
+    * \brief Store metadata items of the description in columns
+    * \param sSchemaName [in] schema name
+    * \param sMetadataName [in] metadata description name
+    * \details Items of the description are kept in a %MetadataColumns table instead of separate
+    * objects, the items already in the stream are moved there. The stream returns such items as
+    * new objects created from their rows, so changing them doesn't change the stream: remove the
+    * item and add the changed one instead. These items can't have or be targets of references,
+    * the frame, time and field indexes don't cover them and queries scan their columns.
+    * \throw NotFoundException if the schema or the description is not in the stream
+    * \throw IncorrectParamException if the description isn't supported by %MetadataColumns
+    * or an item of the description has references
+    */
+    void setColumnar( const std::string& sSchemaName, const std::string& sMetadataName );
+
+    /*!
+    * \brief Get columns of the description
+    * \param sSchemaName [in] schema name
+    * \param sMetadataName [in] metadata description name
+    * \return columns holding the items of the description, null pointer if its items are not stored in columns
+    * \details The columns are changed as the stream is modified, spans taken from them are valid until then.
+    */
+    std::shared_ptr< const MetadataColumns > getColumns( const std::string& sSchemaName, const std::string& sMetadataName ) const;
+
     /*!
     * \brief Add new schema
     * \throw NullPointerException if schema pointer is null
@@ -277,10 +350,49 @@ public:
 
     /*!
     * \brief Get all metadata
-    * \return set of metadata objects
+    * \return set of metadata objects, items stored in columns follow the others
     */
     MetadataSet getAll() const;
 
+    /*!
+    * \brief Get view of all metadata items
+    * \return view borrowing the items of the stream, valid until the stream is modified
+    * \details Items stored in columns are created for the view and follow the others.
+    */
+    MetadataView view() const;
+
+    /*!
+    * \brief Get view of metadata items of the schema ordered by id
+    * \param sSchemaName [in] schema name
+    */
+    MetadataView viewBySchema( const std::string& sSchemaName ) const;
+
+    /*!
+    * \brief Get view of metadata items of the given name ordered by id
+    * \param sName [in] metadata description name
+    */
+    MetadataView viewByName( const std::string& sName ) const;
+
+    /*!
+    * \brief Get view of metadata items of the given description ordered by id
+    * \param sSchemaName [in] schema name
+    * \param sName [in] metadata description name
+    */
+    MetadataView viewBySchemaAndName( const std::string& sSchemaName, const std::string& sName ) const;
+
+    /*!
+    * \brief Get view of metadata items covering the frame ordered by id
+    * \param index [in] frame index
+    */
+    MetadataView viewByFrameIndex( size_t index ) const;
+
+    /*!
+    * \brief Get view of metadata items intersecting the time interval ordered by id
+    * \param startTime [in] start of the interval
+    * \param endTime [in] end of the interval
+    */
+    MetadataView viewByTime( long long startTime, long long endTime ) const;
+
     /*!
      * \brief Unload all metadata from the stream
      */
@@ -295,18 +407,137 @@ public:
     MetadataSet queryBySchema( const std::string& sSchemaName ) const;
     MetadataSet queryByName( const std::string& sName ) const;
 
+    /*!
+    * \brief Get all metadata items of the given description
+    * \param sSchemaName [in] schema name
+    * \param sName [in] metadata description name
+    * \return set of metadata items ordered by id
+    */
+    MetadataSet queryBySchemaAndName( const std::string& sSchemaName, const std::string& sName ) const;
+
     MetadataSet queryByNameAndValue( const std::string& sMetadataName, const umf::FieldValue& value ) const;
     MetadataSet queryByNameAndFields( const std::string& sMetadataName, const std::vector< umf::FieldValue>& vFields ) const;
 
+    /*!
+    * \brief Get metadata items which field value lies in the range [lo, hi]
+    * \details Uses the value index of the field if the field is declared as indexed.
+    * Only values of the declared field type are matched.
+    * \param sMetadataName [in] metadata description name
+    * \param sFieldName [in] name of an integer or real field
+    * \param lo [in] lower bound, integer or real
+    * \param hi [in] upper bound, integer or real
+    * \return set of metadata items ordered by id
+    * \throw IncorrectParamException if the bounds or the field are neither integer nor real
+    */
+    MetadataSet queryByNameAndRange( const std::string& sMetadataName, const std::string& sFieldName, const Variant& lo, const Variant& hi ) const;
+
     MetadataSet queryByReference( const std::string& sReferenceName ) const;
     MetadataSet queryByReference( const std::string& sReferenceName, const umf::FieldValue& value ) const;
     MetadataSet queryByReference( const std::string& sReferenceName, const std::vector< umf::FieldValue>& vFields ) const;
 
-    void sortById()
+    /*!
+    * \brief Get metadata items referencing the item with the specified identifier
+    * \param id [in] identifier of the referenced metadata item
+    * \return set of metadata items ordered by id
+    */
+    MetadataSet queryReferrers( const IdType& id ) const;
+
+    /*!
+    * \brief Get metadata items referencing the item with the specified identifier by the named reference
+    * \param id [in] identifier of the referenced metadata item
+    * \param sRefName [in] name of the reference
+    * \return set of metadata items ordered by id
+    */
+    MetadataSet queryReferrers( const IdType& id, const std::string& sRefName ) const;
+
+    /*!
+    * \brief Get view of metadata items matching the query expression
+    * \param expr [in] query expression
+    * \return view ordered by id when served by an index or when the stream has items stored in columns,
+    * in stream order when the stream is scanned
+    * \details Candidates are taken from the most selective index applicable to the expression,
+    * the rest of the expression is checked while the view is iterated.
+    */
+    MetadataView select( const QueryExpr& expr ) const;
+
+    /*!
+    * \brief Describe how the query expression would be evaluated
+    * \param expr [in] query expression
+    * \return the index used with the number of candidates and the conditions checked on each candidate
+    */
+    std::string explain( const QueryExpr& expr ) const;
+
+    void sortById();
+
+    /*!
+    * \brief Enable or disable concurrent access to the stream
+    * \param bConcurrent [in] true to guard the stream by a reader-writer lock
+    * \details In concurrent mode queries, getById() and getAll() run in parallel with each other
+    * and wait only while another thread adds or removes items. Views borrow the storage of the stream,
+    * hold a ReadLock while a view is iterated. Items of the stream shouldn't be modified while other
+    * threads read them. Switch the mode while no other thread uses the stream.
+    */
+    void setConcurrent( bool bConcurrent );
+
+    /*!
+    * \brief Check whether the stream is in concurrent mode
+    */
+    bool isConcurrent() const;
+
+    /*!
+    * \brief Enable or disable pooled allocation of metadata items
+    * \param bPooled [in] true to take items and the id index entries from a pool owned by the stream
+    * \details Items made by the stream while loading or deserializing, and by createMetadata(), get their
+    * object and reference counter in one pool block, released blocks are reused by later items.
+    * The pool stays alive while any of its items is referenced, also after the stream is destroyed.
+    */
+    void setPooled( bool bPooled );
+
+    /*!
+    * \brief Check whether the stream allocates metadata items from its pool
+    */
+    bool isPooled() const;
+
+    /*!
+    * \brief Enable or disable validation of added metadata items
+    * \param bTrusted [in] true to add items without Metadata::validate(), false to validate them
+    * \details Meant for bulk loads of data known to be valid, for example written by UMF itself.
+    * Items that don't match their description break queries and saving, so the stream should
+    * be switched back once the load is done. Schemas and references are checked as usual.
+    */
+    void setTrusted( bool bTrusted );
+
+    /*!
+    * \brief Check whether the stream adds items without validation
+    */
+    bool isTrusted() const;
+
+    /*!
+    * \brief Create a metadata item in the storage of the stream
+    * \param spDesc [in] metadata item description
+    * \return new item taken from the pool of the stream if it is pooled, from the heap otherwise
+    * \details The item isn't added to the stream.
+    */
+    std::shared_ptr< Metadata > createMetadata( const std::shared_ptr< MetadataDesc >& spDesc ) const;
+
+    /*!
+    * \class ReadLock
+    * \brief Keeps a concurrent stream unmodified during its lifetime
+    * \details Other threads may read the stream meanwhile, the owner of the lock may call any reading
+    * function of the stream but not the modifying ones. Does nothing if the stream isn't concurrent.
+    */
+    class UMF_EXPORT ReadLock
     {
-        std::sort(m_oMetadataSet.begin(), m_oMetadataSet.end(),
-            [](const std::shared_ptr<Metadata> &a, const std::shared_ptr<Metadata>& b){ return a->getId() < b->getId(); });
-    }
+    public:
+        explicit ReadLock( const MetadataStream& stream );
+        ~ReadLock();
+
+    private:
+        ReadLock( const ReadLock& ) = delete;
+        ReadLock& operator = ( const ReadLock& ) = delete;
+
+        RWLock* m_pLock;
+    };
 
 
     /*
@@ -439,24 +670,58 @@ protected:
     * \param spMetadata [in] pointer to metadata object
     */
     void notifyStat(std::shared_ptr< Metadata > spMetadata, Stat::Action::Type action = Stat::Action::Add);
+    void notifyStat(const MetadataSet& items, Stat::Action::Type action = Stat::Action::Add);
+    void notifyStat(MetadataSet&& items, Stat::Action::Type action);
     void dataSourceCheck();
     std::shared_ptr<Metadata> import( MetadataStream& srcStream, std::shared_ptr< Metadata >& spMetadata, std::map< IdType, IdType >& mapIds, 
         long long nTarFrameIndex, long long nSrcFrameIndex, long long nNumOfFrames = FRAME_COUNT_ALL );
     void internalAdd(const std::shared_ptr< Metadata >& spMetadata);
+    IdType internalAdd(MetadataInternal& mdi, bool bMoveValues);
+    void internalAddBatch(const MetadataSet& items, unsigned nValidationThreads = 1);
+    void insertItem(const std::shared_ptr< Metadata >& spMetadata);
+    void removeItems(MetadataSet&& items);
+    void onTimeChanged(const Metadata& md);
+    void onFrameIndexChanged(const Metadata& md);
+    void onFieldChanged(const Metadata& md, const std::string& sFieldName);
+    void onReferenceAdded(const Metadata& md, const IdType& id, const std::string& sRefName);
+    void onReferenceRemoved(const Metadata& md, const IdType& id, const std::string& sRefName);
+    void onReferencesChanged(const Metadata& md);
+    MetadataSet getByIds(std::vector< IdType >& vIds) const;
+    MetadataView viewByIds(std::vector< IdType >& vIds) const;
+    MetadataSet queryByReferenceTo(const std::string& sMetadataName, std::function< bool( const Metadata& reference )> filter) const;
+
+    typedef std::function< void( const MetadataColumns& columns, std::vector< size_t >& rows )> RowSelector;
+    MetadataColumns* findColumns(const MetadataDesc& desc) const;
+    bool hasRows(const std::string* pSchemaName, const std::string* pName) const;
+    MetadataSet getRows(const std::string* pSchemaName, const std::string* pName, const RowSelector& select = RowSelector()) const;
+    MetadataView withRows(const MetadataView& view, const std::string* pSchemaName, const std::string* pName, const RowSelector& select = RowSelector()) const;
+    MetadataSet getAllItems() const;
+    bool removeRow(const IdType& id);
     void decrypt();
     void encrypt();
 
 private:
+    class Index;
+    typedef std::pair< const IdType, std::shared_ptr< Metadata > > IdMapEntry;
+    typedef std::unordered_map< IdType, std::shared_ptr< Metadata >, std::hash< IdType >,
+                                std::equal_to< IdType >, PoolAllocator< IdMapEntry > > IdMap;
+
     OpenMode m_eMode;
     std::string m_sFilePath;
     MetadataSet m_oMetadataSet;
-
-    std::map<IdType, std::vector<std::pair<IdType, std::string>>> m_pendingReferences;
+    IdMap m_mapMetadataById;
+    std::unique_ptr< Index > m_index;
+    std::unique_ptr< RWLock > m_lock;
+    std::vector< std::shared_ptr< MetadataColumns > > m_columns;
+    std::shared_ptr< MetadataPool > m_spPool;
+    bool m_bTrusted;
+
+    std::unordered_map<IdType, std::vector<std::pair<IdType, std::string>>> m_pendingReferences;
     std::map< std::string, std::shared_ptr< MetadataSchema > > m_mapSchemas;
     std::map< std::string, std::shared_ptr< MetadataSchema > > removedSchemas;
     std::vector<std::shared_ptr<VideoSegment>> videoSegments;
     std::vector<IdType> removedIds;
-    std::vector<IdType> addedIds;
+    std::unordered_set<IdType> addedIds;
     std::shared_ptr<IDataSource> dataSource;
     umf::IdType nextId;
     std::string m_sChecksumMedia;
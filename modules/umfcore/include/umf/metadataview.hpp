@@ -0,0 +1,187 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+/*!
+* \file metadataview.hpp
+* \brief %MetadataView class header file
+*/
+
+#ifndef __UMF_METADATA_VIEW_H__
+#define __UMF_METADATA_VIEW_H__
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+
+#include "global.hpp"
+#include "metadata.hpp"
+#include "metadatapool.hpp"
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace umf
+{
+class MetadataSet;
+
+/*!
+* \class MetadataView
+* \brief %MetadataView is a lazily evaluated sequence of metadata objects borrowed from their owner
+* \details A view refers to the items of a metadata stream or set without copying their pointers,
+* filters are applied while the view is iterated. A view is valid until its owner is modified.
+* Use materialize() to get a %MetadataSet that outlives such changes.
+*/
+class UMF_EXPORT MetadataView
+{
+public:
+    typedef std::function< bool( const std::shared_ptr<Metadata>& spMetadata )> Filter;
+    typedef std::map< IdType, std::shared_ptr<Metadata>, std::less< IdType >,
+                      PoolAllocator< std::pair< const IdType, std::shared_ptr<Metadata> > > > Bucket;
+    typedef std::vector< const std::shared_ptr<Metadata>* > ItemList;
+
+    /*!
+    * \class const_iterator
+    * \brief Forward iterator over the items of a view which pass all its filters
+    */
+    class UMF_EXPORT const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::shared_ptr<Metadata> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const std::shared_ptr<Metadata>* pointer;
+        typedef const std::shared_ptr<Metadata>& reference;
+
+        const_iterator();
+
+        const std::shared_ptr<Metadata>& operator*() const { return *m_pCurrent; }
+        const std::shared_ptr<Metadata>* operator->() const { return m_pCurrent; }
+
+        const_iterator& operator++();
+        const_iterator operator++(int);
+
+        bool operator==(const const_iterator& other) const { return m_pCurrent == other.m_pCurrent; }
+        bool operator!=(const const_iterator& other) const { return m_pCurrent != other.m_pCurrent; }
+
+    private:
+        friend class MetadataView;
+        explicit const_iterator(const MetadataView* pView);
+
+        void seek();
+        const std::shared_ptr<Metadata>* source() const;
+
+        const MetadataView* m_pView;
+        size_t m_nPos;
+        Bucket::const_iterator m_itBucket;
+        size_t m_nYielded;
+        const std::shared_ptr<Metadata>* m_pCurrent;
+    };
+
+    typedef const_iterator iterator;
+
+    /*!
+    * \brief Default class constructor, creates an empty view
+    */
+    MetadataView();
+
+    /*!
+    * \brief Create view of a contiguous range of metadata pointers
+    * \param first [in] pointer to the first item
+    * \param last [in] pointer past the last item
+    */
+    MetadataView( const std::shared_ptr<Metadata>* first, const std::shared_ptr<Metadata>* last );
+
+    /*!
+    * \brief Create view of the items of an id-ordered bucket
+    * \param bucket [in] bucket to borrow the items from
+    */
+    explicit MetadataView( const Bucket& bucket );
+
+    /*!
+    * \brief Create view of the listed items
+    * \param items [in] pointers to the metadata pointers owned by someone else
+    */
+    explicit MetadataView( ItemList&& items );
+
+    /*!
+    * \brief Create view owning the items
+    * \param items [in] metadata pointers, moved into the view and shared by its copies
+    */
+    explicit MetadataView( std::vector< std::shared_ptr<Metadata> >&& items );
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /*!
+    * \brief Get view of the items which also pass the filter
+    * \param filter [in] filter function
+    * \return new view, this one is unchanged
+    */
+    MetadataView where( Filter filter ) const;
+
+    /*!
+    * \brief Get view of the first items only
+    * \param n [in] maximal number of items
+    * \return new view, this one is unchanged
+    */
+    MetadataView limit( size_t n ) const;
+
+    /*!
+    * \brief Count the items of the view
+    * \return number of items passing all filters
+    */
+    size_t count() const;
+
+    /*!
+    * \brief Check whether the view has no items
+    */
+    bool empty() const { return begin() == end(); }
+
+    /*!
+    * \brief Get the first item of the view
+    * \return pointer to the first item or null pointer if the view is empty
+    */
+    std::shared_ptr<Metadata> first() const;
+
+    /*!
+    * \brief Copy the items of the view into a metadata set
+    * \return set of metadata in the order of the view
+    */
+    MetadataSet materialize() const;
+
+private:
+    enum class Source { Range, Bucket, List };
+
+    Source m_source;
+    const std::shared_ptr<Metadata>* m_pFirst;
+    size_t m_nSize;
+    const Bucket* m_pBucket;
+    std::shared_ptr< const ItemList > m_spItems;
+    std::shared_ptr< const std::vector< std::shared_ptr<Metadata> > > m_spOwned;
+    std::vector< Filter > m_filters;
+    size_t m_nLimit;
+};
+
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#endif /* __UMF_METADATA_VIEW_H__ */
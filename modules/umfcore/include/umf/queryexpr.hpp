@@ -0,0 +1,201 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+/*!
+* \file queryexpr.hpp
+* \brief %QueryExpr class header file
+*/
+
+#ifndef __UMF_QUERY_EXPR_H__
+#define __UMF_QUERY_EXPR_H__
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif
+
+#include "global.hpp"
+#include "metadata.hpp"
+#include "symbol.hpp"
+#include "variant.hpp"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace umf
+{
+class QueryPlanner;
+
+/*!
+* \class QueryExpr
+* \brief %QueryExpr is a condition on metadata items combined from simple conditions with AND, OR and NOT
+* \details Expressions are immutable and cheap to copy. They are evaluated by MetadataStream::select(),
+* which takes the candidates from the most selective index applicable and checks the rest of the
+* expression on every candidate. Use MetadataStream::explain() to see the chosen plan.
+*/
+class UMF_EXPORT QueryExpr
+{
+public:
+    typedef std::function< bool( const std::shared_ptr<Metadata>& spMetadata )> Filter;
+
+    /*!
+    * \brief Comparison of a field value with the given one
+    * \details Ordered comparisons apply to integer and real values only
+    */
+    enum class Compare { Equal, NotEqual, Less, LessOrEqual, Greater, GreaterOrEqual };
+
+    /*!
+    * \brief Default class constructor, creates expression matching all items
+    */
+    QueryExpr();
+
+    /*!
+    * \brief Condition matching all items
+    */
+    static QueryExpr all();
+
+    /*!
+    * \brief Condition matching the item with the given id
+    */
+    static QueryExpr id( IdType id );
+
+    /*!
+    * \brief Condition matching items of the schema
+    */
+    static QueryExpr schema( const std::string& sSchemaName );
+
+    /*!
+    * \brief Condition matching items of the given name
+    */
+    static QueryExpr name( const std::string& sName );
+
+    /*!
+    * \brief Condition matching items which time interval intersects [startTime, endTime]
+    */
+    static QueryExpr time( long long startTime, long long endTime );
+
+    /*!
+    * \brief Condition matching items covering at least one frame of [firstFrame, lastFrame]
+    */
+    static QueryExpr frames( long long firstFrame, long long lastFrame );
+
+    /*!
+    * \brief Condition matching items covering the frame
+    */
+    static QueryExpr frame( long long index ) { return frames( index, index ); }
+
+    /*!
+    * \brief Condition matching items which field is equal to the value
+    */
+    static QueryExpr field( const std::string& sFieldName, const Variant& value );
+
+    /*!
+    * \brief Condition matching items which field compares with the value as requested
+    * \param sFieldName [in] name of the field
+    * \param compare [in] comparison applied as "field compare value"
+    * \param value [in] value to compare with, integer or real for ordered comparisons
+    */
+    static QueryExpr field( const std::string& sFieldName, Compare compare, const Variant& value );
+
+    /*!
+    * \brief Condition matching items which field lies in [lo, hi]
+    * \details Bounds should be integer or real values
+    */
+    static QueryExpr fieldRange( const std::string& sFieldName, const Variant& lo, const Variant& hi );
+
+    /*!
+    * \brief Condition matching items having a reference of the given name
+    */
+    static QueryExpr hasReference( const std::string& sRefName );
+
+    /*!
+    * \brief Condition matching items referencing the item with the given id
+    */
+    static QueryExpr referencesTo( IdType id );
+
+    /*!
+    * \brief Condition matching items referencing the item with the given id by the reference of the given name
+    */
+    static QueryExpr referencesTo( IdType id, const std::string& sRefName );
+
+    /*!
+    * \brief Condition matching items referenced by the item with the given id
+    */
+    static QueryExpr referencedBy( IdType id );
+
+    /*!
+    * \brief Condition matching items referenced by the item with the given id by the reference of the given name
+    */
+    static QueryExpr referencedBy( IdType id, const std::string& sRefName );
+
+    /*!
+    * \brief Arbitrary condition, can't be served by an index
+    */
+    static QueryExpr predicate( Filter filter );
+
+    /*!
+    * \brief Get text representation of the expression
+    */
+    std::string toString() const;
+
+    friend UMF_EXPORT QueryExpr operator && ( const QueryExpr& left, const QueryExpr& right );
+    friend UMF_EXPORT QueryExpr operator || ( const QueryExpr& left, const QueryExpr& right );
+    friend UMF_EXPORT QueryExpr operator ! ( const QueryExpr& expr );
+
+private:
+    friend class QueryPlanner;
+
+    enum class Kind
+    {
+        All, Id, Schema, Name, Time, Frames, Field, FieldRange,
+        HasReference, ReferencesTo, ReferencedBy, Predicate, And, Or, Not
+    };
+
+    struct Node
+    {
+        Node( Kind k ) : kind( k ), compare( Compare::Equal ), lo( 0 ), hi( 0 ), id( 0 ), bAnyName( false ) {}
+
+        Kind kind;
+        Symbol sName;           //!< schema, metadata, field or reference name
+        Variant value;          //!< compared value or lower range bound
+        Variant bound;          //!< upper range bound
+        Compare compare;
+        long long lo, hi;       //!< time or frame interval
+        IdType id;
+        bool bAnyName;          //!< reference of any name
+        Filter filter;
+        std::vector< std::shared_ptr<const Node> > children;
+    };
+
+    explicit QueryExpr( std::shared_ptr<const Node> spNode ) : m_spNode( spNode ) {}
+    static QueryExpr combine( Kind kind, const QueryExpr& left, const QueryExpr& right );
+    static std::string toString( const Node& node );
+
+    std::shared_ptr<const Node> m_spNode;
+};
+
+UMF_EXPORT QueryExpr operator && ( const QueryExpr& left, const QueryExpr& right );
+UMF_EXPORT QueryExpr operator || ( const QueryExpr& left, const QueryExpr& right );
+UMF_EXPORT QueryExpr operator ! ( const QueryExpr& expr );
+
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#endif /* __UMF_QUERY_EXPR_H__ */
@@ -80,6 +80,33 @@ public:
     */
     virtual void handle( const Variant& fieldValue ) = 0;
 
+    /*!
+    * \brief Handle addition of several metadata field values at once
+    * \param fieldValues [in] pointers to input field values to be added, in chronological order
+    * \param count [in] number of values
+    * \details The values stay in the metadata they belong to, nothing is copied for the call.
+    * The default implementation calls handle() for each value;
+    * operations may override it to take their lock once per batch.
+    */
+    virtual void handle( const Variant* const* fieldValues, size_t count )
+    {
+        for( size_t i = 0; i < count; i++ )
+            handle( *fieldValues[i] );
+    }
+
+    /*!
+    * \brief Tells whether the operation can take back the values it has handled (@ref unhandle)
+    * \return true if removal of metadata can be handled incrementally, false if it needs a rescan
+    */
+    virtual bool isReversible() const { return false; }
+
+    /*!
+    * \brief Handle removal of metadata field value handled before
+    * \param fieldValue [in] input field value to be removed
+    * \throw NotImplementedException if the operation isn't reversible (@ref isReversible)
+    */
+    virtual void unhandle( const Variant& fieldValue );
+
     /*!
     * \brief Get current field value
     * \return value
@@ -108,6 +135,7 @@ public:
     * \return pointer to newly created instance, cannot be nullptr
     * \throw NotFoundException if user-defined operation wasn't registered
     * \throw NullPointerException if instance creator for user-defined operation didn't create one (returned nullptr)
+    * \throw IncorrectParamException if parameters of builtin operation are wrong
     */
     static StatOpBase* create( const std::string& name );
 
@@ -146,9 +174,25 @@ public:
         * - BuiltinOp::Count: counts input field values, applicable to any types, result has Variant::type_integer type;
         * - BuiltinOp::Sum: computes sum value, applicable to Variant::type_integer and Variant::type_real fields,
         * result has the same type as input;
-        * - BuiltinOp::Last: holds chronologically last value of input fields, result has the same type as input.
+        * - BuiltinOp::Last: holds chronologically last value of input fields, result has the same type as input;
+        * - BuiltinOp::Variance: computes population variance in a single pass (Welford),
+        * applicable to Variant::type_integer and Variant::type_real fields, result has always Variant::type_real type;
+        * - BuiltinOp::StdDev: computes population standard deviation, the same way as BuiltinOp::Variance;
+        * - BuiltinOp::Histogram: counts values in equal-width buckets, parameters are (lower, upper, buckets),
+        * (0, 100, 10) by default; result has Variant::type_integer_vector type with buckets + 2 counts,
+        * the first one for values below lower and the last one for values not below upper;
+        * - BuiltinOp::LogHistogram: the same as BuiltinOp::Histogram with bucket bounds in geometric progression
+        * from lower > 0 to upper, (1, 1048576, 20) by default;
+        * - BuiltinOp::Quantiles: estimates quantiles within 0.4% of relative error from log-linear buckets,
+        * parameters are the probabilities, (0.5, 0.95, 0.99) by default; result has Variant::type_real_vector type;
+        * - BuiltinOp::DistinctCount: estimates the number of distinct values with a HyperLogLog sketch,
+        * applicable to any types, the parameter is the precision p in [4, 18], 12 by default (2^p bytes,
+        * 1.6% of standard error); result has Variant::type_integer type.
+        *
+        * All of them but Last and DistinctCount are reversible (@ref StatOpBase::isReversible); Min and Max keep
+        * every distinct input value for that, the others take bounded memory.
         */
-        enum Type { Min, Max, Average, Count, Sum, Last };
+        enum Type { Min, Max, Average, Count, Sum, Last, Variance, StdDev, Histogram, LogHistogram, Quantiles, DistinctCount };
     };
 
     /*!
@@ -160,6 +204,16 @@ public:
     */
     static std::string builtinName( BuiltinOp::Type opType );
 
+    /*!
+    * \brief Get name string for builtin operations with parameters
+    * \param opType [in] builtin operation type
+    * \param params [in] operation parameters, see @ref BuiltinOp::Type
+    * \return name string, the parameters are kept in it so that the operation can be saved and created again
+    * \throw IncorrectParamException if input value is outside of declared constant range
+    * \details Parameters are checked when the operation is created (@ref create).
+    */
+    static std::string builtinName( BuiltinOp::Type opType, const std::vector< umf_real >& params );
+
 private:
     typedef std::pair< std::string, InstanceCreator > UserOpItem;
     typedef std::map< std::string, InstanceCreator > UserOpMap;
@@ -174,7 +228,7 @@ private:
 */
 class UMF_EXPORT StatField
 {
-    friend class Stat; // setStream()
+    friend class Stat; // resolve(), handle()
 
 public:
     /*!
@@ -269,7 +323,10 @@ public:
     Variant getValue() const { return m_op->value(); }
 
 private:
-    void handle( std::shared_ptr< Metadata > metadata );
+    bool resolve( const MetadataDesc& metadataDesc, size_t& slot ) const;
+    void handle( const std::vector< const Variant* >& values );
+    void unhandle( const std::vector< const Variant* >& values );
+    bool isReversible() const { return m_op->isReversible(); }
     void reset();
 
     class StatFieldDesc;
@@ -285,7 +342,7 @@ private:
 */
 class UMF_EXPORT Stat
 {
-    friend class MetadataStream; // setStream()
+    friend class MetadataStream; // bind(), onFieldChanged()
     friend class StatWorker;     // handle()
 
 public:
@@ -318,7 +375,10 @@ public:
         * \brief Actions over statistics values
         * \details
         * - Action::Add: need to handle addition of new metadata;
-        * - Action::Remove: need to handle removal of metadata.
+        * - Action::Remove: need to handle removal of metadata; it is handled incrementally
+        * if all the operations of the statistics object are reversible (@ref StatOpBase::isReversible),
+        * otherwise the statistics object needs a rescan (@ref State::NeedRescan).
+        * Changing a field the statistics object covers in a metadata of the stream needs a rescan too.
         */
         enum Type { Add = 1, Remove = 2 /*, Change*/ };
     };
@@ -429,6 +489,8 @@ public:
     * \brief Update statistics object
     * \param doWait [in] specifies whether update will be done in blocking or non-blocking mode;
     * function will wait for completion of scheduled update/rescan if true, and not wait otherwise
+    * \details A blocking update is done in the calling thread, a non-blocking one is handed over
+    * to the worker threads shared by all statistics objects
     */
     void update(bool doWait = false );
 
@@ -440,6 +502,22 @@ public:
     */
     void notify( std::shared_ptr< Metadata > metadata, Action::Type action = Action::Add);
 
+    /*!
+    * \brief Notifies statistics object about the same event for several metadata items
+    * \param metadata [in] pointers to metadata to process
+    * \param action [in] required action for the metadata (@ref Action::Type)
+    * \details Equivalent to notifying about each item in turn, but the worker is woken up once.
+    */
+    void notify( const std::vector< std::shared_ptr< Metadata > >& metadata, Action::Type action = Action::Add);
+
+    /*!
+    * \brief Notifies statistics object about the same event for several metadata items
+    * \param metadata [in] pointers to metadata to process, moved to the update queue
+    * \param action [in] required action for the metadata (@ref Action::Type)
+    * \details The same as the overload above without taking another reference to each item.
+    */
+    void notify( std::vector< std::shared_ptr< Metadata > >&& metadata, Action::Type action = Action::Add);
+
     /*!
     * \brief Get names of all statistics fields for the statistics object
     * \return Statistics field names (vector of)
@@ -463,7 +541,11 @@ public:
     Variant operator[]( const std::string& name ) const { return getField( name ).getValue(); }
 
 private:
-    void handle( const std::shared_ptr< Metadata > metadata );
+    void bind( const std::vector< std::shared_ptr< MetadataDesc >>& descs );
+    void resolve( const MetadataDesc& metadataDesc, std::vector< std::pair< size_t, size_t >>& targets ) const;
+    void handle( const std::vector< std::vector< const Variant* >>& values, Action::Type action );
+    void onFieldChanged( const MetadataDesc& metadataDesc, const std::string& fieldName );
+    bool isReversible() const;
 
     class StatDesc;
     std::unique_ptr< StatDesc > m_desc;
@@ -471,7 +553,7 @@ private:
     std::vector< StatField > m_fields;
 
     class StatWorker;
-    std::unique_ptr< StatWorker > m_worker;
+    std::shared_ptr< StatWorker > m_worker;
 
     UpdateMode::Type m_updateMode;
     unsigned m_updateTimeout;
@@ -0,0 +1,89 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*!
+* \file symbol.hpp
+* \brief %Symbol class header file
+*/
+
+#ifndef __UMF_SYMBOL_H__
+#define __UMF_SYMBOL_H__
+
+#include "global.hpp"
+#include <string>
+
+namespace umf
+{
+/*!
+ * \class Symbol
+ * \brief Interned string used for schema, metadata and field names.
+ * \details All symbols with the same text share one copy of it in a
+ * process-wide table, so a symbol costs a pointer and two symbols are
+ * compared by comparing pointers. The table only grows, names are
+ * expected to come from a limited set of schemas.
+ */
+class UMF_EXPORT Symbol
+{
+public:
+    /*!
+     * \brief Creates the symbol of the empty string
+     */
+    Symbol();
+
+    /*!
+     * \brief Interns the string
+     * \param name Text of the symbol
+     */
+    Symbol(const std::string& name);
+
+    /*!
+     * \brief Interns the string
+     * \param name Text of the symbol
+     */
+    Symbol(const char* name);
+
+    /*!
+     * \brief Looks up a string without interning it
+     * \param name Text to look up
+     * \param [out] symbol The symbol of the text if it is interned
+     * \return true if the text is interned. Otherwise no symbol equals it.
+     */
+    static bool find(const std::string& name, Symbol& symbol);
+
+    /*!
+     * \brief Gets the text of the symbol
+     */
+    const std::string& str() const { return *m_pName; }
+
+    operator const std::string& () const { return *m_pName; }
+
+    bool empty() const { return m_pName->empty(); }
+
+    bool operator == (const Symbol& other) const { return m_pName == other.m_pName; }
+    bool operator != (const Symbol& other) const { return m_pName != other.m_pName; }
+
+private:
+    const std::string* m_pName;
+};
+
+inline bool operator == (const Symbol& symbol, const std::string& name) { return symbol.str() == name; }
+inline bool operator == (const std::string& name, const Symbol& symbol) { return symbol.str() == name; }
+inline bool operator != (const Symbol& symbol, const std::string& name) { return symbol.str() != name; }
+inline bool operator != (const std::string& name, const Symbol& symbol) { return symbol.str() != name; }
+}
+
+#endif /* __UMF_SYMBOL_H__ */
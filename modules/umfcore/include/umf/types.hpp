@@ -116,7 +116,7 @@ namespace umf
         umf_rawbuffer(const std::vector<char>& vec) : std::vector<char>(vec)
         { }
 
-        umf_rawbuffer(std::vector<char>&& rVec) : std::vector<char>(rVec)
+        umf_rawbuffer(std::vector<char>&& rVec) : std::vector<char>(std::move(rVec))
         { }
 
         umf_rawbuffer(const umf_rawbuffer& other) : std::vector<char>(other)
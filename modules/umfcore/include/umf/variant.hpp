@@ -25,10 +25,37 @@
 
 #include "umf/global.hpp"
 #include <vector>
+#include <utility>
 
 namespace umf
 {
-    class IData; // helper class for Variant implementation
+    /*!
+    * \brief Base of the heap allocated Variant values (strings, raw buffers and arrays).
+    */
+    class IData
+    {
+    public:
+        virtual ~IData() {}
+        virtual IData* clone() const = 0;
+    };
+
+    template<class T> class Data : public IData
+    {
+    public:
+        T content;
+        Data(const T& value) : content(value) {}
+        Data(T&& value) : content(std::move(value)) {}
+        ~Data() {}
+        IData* clone() const
+        {
+            return new Data<T>(content);
+        }
+    };
+
+    /*!
+    * \brief Maps a C++ value type to the Variant::Type tag it is stored with.
+    */
+    template<typename T> struct VariantTypeOf;
 
     /*!
     * \class Variant
@@ -62,6 +89,11 @@ namespace umf
             type_vec4d_vector
         };
 
+        /*!
+        * \brief Value passed to Variant::visit() visitors for the empty Variant.
+        */
+        struct Empty {};
+
         /*!
         * \brief Constructor
         */
@@ -98,9 +130,21 @@ namespace umf
         DECLARE_UMF_TYPE( vec4d )
         DECLARE_UMF_TYPE( rawbuffer )
 
+#define DECLARE_MOVABLE_UMF_TYPE( T ) \
+    Variant( umf_##T&& v); \
+    Variant& operator = ( umf_##T&& v );
+
+        /*!
+        * \brief Constructors and assignments taking over the storage of strings and raw buffers
+        */
+        DECLARE_MOVABLE_UMF_TYPE( string )
+        DECLARE_MOVABLE_UMF_TYPE( rawbuffer )
+
 #define DECLARE_VECTOR_UMF_TYPE( T ) \
     Variant( const std::vector<umf_##T>& v); \
+    Variant( std::vector<umf_##T>&& v); \
     Variant& operator = ( const std::vector<umf_##T>& v ); \
+    Variant& operator = ( std::vector<umf_##T>&& v ); \
     const std::vector<umf_##T>& get_##T##_vector() const; \
     operator const std::vector<umf_##T>& () const;
 
@@ -204,6 +248,44 @@ namespace umf
         */
         bool operator != (const Variant& other) const;
 
+        /*!
+        * \brief Typed access without exceptions.
+        * \return Pointer to the stored value if it has type T (umf_integer, umf_string,
+        * std::vector<umf_real> and so on), nullptr otherwise.
+        */
+        template<typename T> const T* try_get() const
+        {
+            return m_type == VariantTypeOf<T>::value ? &ref<T>() : nullptr;
+        }
+
+        /*!
+        * \brief Call the visitor with the stored value.
+        * \param [in] visitor Function object callable with every value type
+        * (and Variant::Empty), typically via a template operator().
+        * \return What the visitor returns.
+        */
+        template<class Visitor>
+        auto visit(Visitor&& visitor) const -> decltype(visitor(std::declval<const umf_integer&>()))
+        {
+            switch(m_type)
+            {
+            case type_integer:        return visitor(m_value.integer);
+            case type_real:           return visitor(m_value.real);
+            case type_string:         return visitor(ref<umf_string>());
+            case type_vec2d:          return visitor(m_value.vec2d);
+            case type_vec3d:          return visitor(m_value.vec3d);
+            case type_vec4d:          return visitor(m_value.vec4d);
+            case type_rawbuffer:      return visitor(ref<umf_rawbuffer>());
+            case type_integer_vector: return visitor(ref<std::vector<umf_integer>>());
+            case type_real_vector:    return visitor(ref<std::vector<umf_real>>());
+            case type_string_vector:  return visitor(ref<std::vector<umf_string>>());
+            case type_vec2d_vector:   return visitor(ref<std::vector<umf_vec2d>>());
+            case type_vec3d_vector:   return visitor(ref<std::vector<umf_vec3d>>());
+            case type_vec4d_vector:   return visitor(ref<std::vector<umf_vec4d>>());
+            default:                  return visitor(Empty());
+            }
+        }
+
         /*!
         * \brief Return the string representation of the value.
         * \return The string description of the value.
@@ -355,10 +437,58 @@ namespace umf
         * \brief Release internal memory.
         */
         void release();
-        
-        IData* data;
+
+        /*!
+        * \brief Value storage, m_type tells which member is active.
+        * \details Scalars and fixed size vectors are kept inline,
+        * strings, raw buffers and arrays are allocated.
+        */
+        union Storage
+        {
+            Storage() : integer(0) {}
+
+            umf_integer integer;
+            umf_real real;
+            umf_vec2d vec2d;
+            umf_vec3d vec3d;
+            umf_vec4d vec4d;
+            IData* data;
+        };
+
+        /*!
+        * \brief Stored value of type T, the caller checks m_type.
+        */
+        template<typename T> const T& ref() const
+        {
+            return static_cast<const Data<T>*>(m_value.data)->content;
+        }
+
+        Storage m_value;
         Type m_type;
     };
+
+    template<> inline const umf_integer& Variant::ref<umf_integer>() const { return m_value.integer; }
+    template<> inline const umf_real& Variant::ref<umf_real>() const { return m_value.real; }
+    template<> inline const umf_vec2d& Variant::ref<umf_vec2d>() const { return m_value.vec2d; }
+    template<> inline const umf_vec3d& Variant::ref<umf_vec3d>() const { return m_value.vec3d; }
+    template<> inline const umf_vec4d& Variant::ref<umf_vec4d>() const { return m_value.vec4d; }
+
+#define DECLARE_VARIANT_TYPE_OF( T, TAG ) \
+    template<> struct VariantTypeOf<T> { static const Variant::Type value = Variant::TAG; };
+
+    DECLARE_VARIANT_TYPE_OF( umf_integer, type_integer )
+    DECLARE_VARIANT_TYPE_OF( umf_real, type_real )
+    DECLARE_VARIANT_TYPE_OF( umf_string, type_string )
+    DECLARE_VARIANT_TYPE_OF( umf_vec2d, type_vec2d )
+    DECLARE_VARIANT_TYPE_OF( umf_vec3d, type_vec3d )
+    DECLARE_VARIANT_TYPE_OF( umf_vec4d, type_vec4d )
+    DECLARE_VARIANT_TYPE_OF( umf_rawbuffer, type_rawbuffer )
+    DECLARE_VARIANT_TYPE_OF( std::vector<umf_integer>, type_integer_vector )
+    DECLARE_VARIANT_TYPE_OF( std::vector<umf_real>, type_real_vector )
+    DECLARE_VARIANT_TYPE_OF( std::vector<umf_string>, type_string_vector )
+    DECLARE_VARIANT_TYPE_OF( std::vector<umf_vec2d>, type_vec2d_vector )
+    DECLARE_VARIANT_TYPE_OF( std::vector<umf_vec3d>, type_vec3d_vector )
+    DECLARE_VARIANT_TYPE_OF( std::vector<umf_vec4d>, type_vec4d_vector )
 };
 
 #endif /* __UMF_VARIANT_H__ */
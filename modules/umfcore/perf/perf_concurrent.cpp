@@ -0,0 +1,98 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "perf_precomp.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+class PerfConcurrentReaders : public ::testing::TestWithParam<int>
+{
+protected:
+    void SetUp()
+    {
+        auto spSchema = std::make_shared<umf::MetadataSchema>("perf_schema");
+        std::vector<umf::FieldDesc> fields;
+        fields.emplace_back(umf::FieldDesc("value", umf::Variant::type_integer, false, false, true));
+        spDesc = std::make_shared<umf::MetadataDesc>("record", fields);
+        spSchema->add(spDesc);
+        stream.addSchema(spSchema);
+        stream.setConcurrent(true);
+
+        for(size_t i = 0; i < nRecords; i++)
+            stream.add(makeRecord(i));
+    }
+
+    std::shared_ptr<umf::Metadata> makeRecord(size_t i)
+    {
+        auto spMd = std::make_shared<umf::Metadata>(spDesc);
+        spMd->setFieldValue("value", (umf::umf_integer)i);
+        spMd->setFrameIndex((long long)i, 10);
+        return spMd;
+    }
+
+    static const size_t nRecords = 100000;
+
+    umf::MetadataStream stream;
+    std::shared_ptr<umf::MetadataDesc> spDesc;
+};
+
+// Readers query the stream while a single writer keeps adding records
+TEST_P(PerfConcurrentReaders, QueryDuringIngest)
+{
+    const int nReaders = GetParam();
+    const size_t nQueriesPerReader = 20000;
+    std::atomic<bool> bDone(false);
+    std::atomic<size_t> nFound(0);
+    size_t nWritten = 0;
+
+    std::thread writer([&]()
+    {
+        while(!bDone)
+        {
+            stream.add(makeRecord(nRecords + nWritten));
+            nWritten++;
+        }
+    });
+
+    perf::Timer timer;
+    std::vector<std::thread> readers;
+    for(int r = 0; r < nReaders; r++)
+        readers.emplace_back([&, r]()
+        {
+            size_t found = 0;
+            for(size_t i = 0; i < nQueriesPerReader; i++)
+            {
+                size_t index = (i * 7919 + r * 104729) % nRecords;
+                found += stream.queryByFrameIndex(index).size();
+                found += stream.getById((umf::IdType)index) != nullptr;
+            }
+            nFound += found;
+        });
+    for(auto& reader : readers)
+        reader.join();
+    double ms = timer.elapsedMs();
+
+    bDone = true;
+    writer.join();
+
+    perf::report("queryDuringIngest_readers_" + umf::to_string(nReaders), nReaders * nQueriesPerReader, ms);
+    std::cout << "[     PERF ] records added meanwhile: " << nWritten << std::endl;
+    ASSERT_GT(nFound.load(), 0u);
+}
+
+INSTANTIATE_TEST_CASE_P(Readers, PerfConcurrentReaders, ::testing::Values(1, 2, 4, 8));
@@ -0,0 +1,50 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "perf_precomp.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<size_t> g_nAllocations(0);
+
+size_t perf::allocationCount()
+{
+    return g_nAllocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t nBytes)
+{
+    g_nAllocations.fetch_add(1, std::memory_order_relaxed);
+    if(void* p = std::malloc(nBytes ? nBytes : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+int main(int argc, char **argv)
+{
+    std::cout << "UMF build info:\n" << umf::getBuildInfo() << std::endl;
+    ::testing::InitGoogleTest(&argc, argv);
+    umf::Log::setVerbosityLevel(umf::LOG_NO_MESSAGE);
+
+    return RUN_ALL_TESTS();
+}
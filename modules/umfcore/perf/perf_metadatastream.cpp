@@ -0,0 +1,523 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "perf_precomp.hpp"
+
+#include <algorithm>
+#include <random>
+
+class PerfMetadataStream : public ::testing::TestWithParam<size_t>
+{
+protected:
+    void SetUp()
+    {
+        spSchema = std::make_shared<umf::MetadataSchema>("perf_schema");
+        std::vector<umf::FieldDesc> fields;
+        fields.emplace_back(umf::FieldDesc("value", umf::Variant::type_integer, false, false, true));
+        fields.emplace_back(umf::FieldDesc("label", umf::Variant::type_string, true));
+        spDesc = std::make_shared<umf::MetadataDesc>("record", fields);
+        spSchema->add(spDesc);
+        stream.addSchema(spSchema);
+    }
+
+    std::shared_ptr<umf::Metadata> makeRecord(size_t i)
+    {
+        auto spMd = std::make_shared<umf::Metadata>(spDesc);
+        spMd->setFieldValue("value", (umf::umf_integer)i);
+        spMd->setFrameIndex((long long)i, 10);
+        spMd->setTimestamp((long long)i * 40, 400);
+        return spMd;
+    }
+
+    void fill(size_t n)
+    {
+        for(size_t i = 0; i < n; i++)
+            stream.add(makeRecord(i));
+    }
+
+    std::string label(const std::string& op) const
+    {
+        return op + "_" + umf::to_string(GetParam());
+    }
+
+    umf::MetadataStream stream;
+    std::shared_ptr<umf::MetadataSchema> spSchema;
+    std::shared_ptr<umf::MetadataDesc> spDesc;
+};
+
+TEST_P(PerfMetadataStream, Add)
+{
+    size_t n = GetParam();
+    perf::Timer timer;
+    fill(n);
+    perf::report(label("add"), n, timer.elapsedMs());
+    ASSERT_EQ(n, stream.getAll().size());
+}
+
+TEST_P(PerfMetadataStream, AddBatch)
+{
+    size_t n = GetParam();
+    std::vector<umf::MetadataInternal> items;
+    items.reserve(n);
+    for(size_t i = 0; i < n; i++)
+    {
+        umf::MetadataInternal mdi("record", "perf_schema");
+        mdi.fields["value"].value = umf::to_string(i);
+        mdi.frameIndex = (long long)i;
+        mdi.frameNum = 10;
+        if(i > 0)
+            mdi.refs.emplace_back((umf::IdType)i - 1, "");
+        items.push_back(std::move(mdi));
+    }
+
+    perf::Timer timer;
+    stream.addBatch(std::move(items), 0);
+    perf::report(label("addBatch"), n, timer.elapsedMs());
+    ASSERT_EQ(n, stream.getAll().size());
+}
+
+TEST_P(PerfMetadataStream, PooledLoad)
+{
+    size_t n = GetParam();
+    for(bool bPooled : {false, true})
+    {
+        umf::MetadataStream loaded;
+        loaded.addSchema(spSchema);
+        loaded.setPooled(bPooled);
+        std::vector<umf::MetadataInternal> items;
+        items.reserve(n);
+        for(size_t i = 0; i < n; i++)
+        {
+            umf::MetadataInternal mdi("record", "perf_schema");
+            mdi.fields["value"].value = umf::to_string(i);
+            mdi.frameIndex = (long long)i;
+            mdi.frameNum = 10;
+            items.push_back(std::move(mdi));
+        }
+
+        std::string mode = bPooled ? "pooled" : "heap";
+        size_t nAllocations = perf::allocationCount();
+        perf::Timer timer;
+        loaded.addBatch(std::move(items), 1);
+        perf::report(label(mode + "Load"), n, timer.elapsedMs());
+        perf::reportAllocations(label(mode + "LoadAllocations"), n, perf::allocationCount() - nAllocations);
+        ASSERT_EQ(n, loaded.getAll().size());
+
+        perf::Timer clearTimer;
+        loaded.clear();
+        perf::report(label(mode + "Clear"), n, clearTimer.elapsedMs());
+    }
+}
+
+TEST_P(PerfMetadataStream, Validate)
+{
+    size_t n = GetParam();
+    std::vector<std::shared_ptr<umf::Metadata>> items;
+    items.reserve(n);
+    for(size_t i = 0; i < n; i++)
+        items.push_back(makeRecord(i));
+
+    size_t nAllocations = perf::allocationCount();
+    perf::Timer timer;
+    for(const auto& spMd : items)
+        spMd->validate();
+    perf::report(label("validate"), n, timer.elapsedMs());
+    perf::reportAllocations(label("validateAllocations"), n, perf::allocationCount() - nAllocations);
+
+    for(bool bTrusted : {false, true})
+    {
+        umf::MetadataStream loaded;
+        loaded.addSchema(spSchema);
+        loaded.setTrusted(bTrusted);
+        std::vector<umf::MetadataInternal> batch;
+        batch.reserve(n);
+        for(size_t i = 0; i < n; i++)
+        {
+            umf::MetadataInternal mdi("record", "perf_schema");
+            mdi.fields["value"].value = umf::to_string(i);
+            batch.push_back(std::move(mdi));
+        }
+
+        perf::Timer loadTimer;
+        loaded.addBatch(std::move(batch), 1);
+        perf::report(label(bTrusted ? "trustedLoad" : "validatedLoad"), n, loadTimer.elapsedMs());
+        ASSERT_EQ(n, loaded.getAll().size());
+    }
+}
+
+TEST_P(PerfMetadataStream, MoveLargeValues)
+{
+    size_t n = GetParam() / 10;
+    const std::string label4k(4096, 'l');
+
+    size_t nAllocations = perf::allocationCount();
+    perf::Timer timer;
+    for(size_t i = 0; i < n; i++)
+    {
+        auto spMd = std::make_shared<umf::Metadata>(spDesc);
+        std::string text(label4k);
+        spMd->setFieldValue("value", (umf::umf_integer)i);
+        spMd->setFieldValue("label", text);
+        stream.add(spMd);
+    }
+    perf::report(label("setFieldValueCopy"), n, timer.elapsedMs());
+    perf::reportAllocations(label("setFieldValueCopyAllocations"), n, perf::allocationCount() - nAllocations);
+
+    nAllocations = perf::allocationCount();
+    perf::Timer moveTimer;
+    for(size_t i = 0; i < n; i++)
+    {
+        auto spMd = std::make_shared<umf::Metadata>(spDesc);
+        std::string text(label4k);
+        spMd->emplaceField("value", (umf::umf_integer)i);
+        spMd->emplaceField("label", std::move(text));
+        stream.add(std::move(spMd));
+    }
+    perf::report(label("emplaceFieldMove"), n, moveTimer.elapsedMs());
+    perf::reportAllocations(label("emplaceFieldMoveAllocations"), n, perf::allocationCount() - nAllocations);
+    ASSERT_EQ(2 * n, stream.getAll().size());
+}
+
+TEST_P(PerfMetadataStream, SerializeNumbers)
+{
+    // libxml2 refuses documents larger than 10 MB without XML_PARSE_HUGE
+    size_t n = std::min<size_t>(GetParam() / 10, 10000);
+    std::vector<umf::FieldDesc> fields;
+    fields.emplace_back(umf::FieldDesc("score", umf::Variant::type_real));
+    fields.emplace_back(umf::FieldDesc("contour", umf::Variant::type_vec3d_vector));
+    auto spShape = std::make_shared<umf::MetadataDesc>("shape", fields);
+    auto spShapes = std::make_shared<umf::MetadataSchema>("perf_shapes");
+    spShapes->add(spShape);
+    stream.addSchema(spShapes);
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> coordinate(-1000, 1000);
+    for(size_t i = 0; i < n; i++)
+    {
+        auto spMd = std::make_shared<umf::Metadata>(spShape);
+        std::vector<umf::umf_vec3d> contour;
+        for(int j = 0; j < 8; j++)
+            contour.emplace_back(coordinate(random), coordinate(random), coordinate(random));
+        spMd->emplaceField("score", coordinate(random) / 1000);
+        spMd->emplaceField("contour", std::move(contour));
+        spMd->setFrameIndex((long long)i);
+        stream.add(std::move(spMd));
+    }
+
+    umf::FormatXML xml;
+    umf::FormatJSON json;
+    for(auto format : { std::make_pair(std::string("XML"), (umf::Format*)&xml), std::make_pair(std::string("JSON"), (umf::Format*)&json) })
+    {
+        perf::Timer timer;
+        std::string text = stream.serialize(*format.second);
+        perf::report(label("serialize" + format.first), n, timer.elapsedMs());
+        std::cout << "[     PERF ] " << label("serialize" + format.first) << ": " << text.size() / n << " bytes/item" << std::endl;
+
+        umf::MetadataStream loaded;
+        perf::Timer loadTimer;
+        loaded.deserialize(text, *format.second);
+        perf::report(label("deserialize" + format.first), n, loadTimer.elapsedMs());
+        ASSERT_EQ(n, loaded.queryByName("shape").size());
+        ASSERT_EQ(text, loaded.serialize(*format.second));
+    }
+}
+
+TEST_P(PerfMetadataStream, GetById)
+{
+    size_t n = GetParam();
+    fill(n);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<umf::IdType> dist(0, (umf::IdType)n - 1);
+    const size_t nLookups = 100000;
+    size_t found = 0;
+
+    perf::Timer timer;
+    for(size_t i = 0; i < nLookups; i++)
+        if(stream.getById(dist(gen)))
+            found++;
+    perf::report(label("getById"), nLookups, timer.elapsedMs());
+    ASSERT_EQ(nLookups, found);
+}
+
+TEST_P(PerfMetadataStream, Remove)
+{
+    size_t n = GetParam();
+    fill(n);
+
+    const size_t nRemovals = 1000;
+    size_t step = n / nRemovals;
+
+    perf::Timer timer;
+    for(size_t i = 0; i < nRemovals; i++)
+        ASSERT_TRUE(stream.remove((umf::IdType)(i * step)));
+    perf::report(label("remove"), nRemovals, timer.elapsedMs());
+    ASSERT_EQ(n - nRemovals, stream.getAll().size());
+
+    // The oldest items, which are at the front of the stream
+    perf::Timer frontTimer;
+    for(size_t i = 0; i < nRemovals; i++)
+        stream.remove((umf::IdType)(i * step + 1));
+    perf::report(label("removeFront"), nRemovals, frontTimer.elapsedMs());
+
+    // Items spread over the whole stream in random order
+    std::vector<umf::IdType> ids;
+    for(size_t i = 0; i < n; i++)
+        if(i % step > 1)
+            ids.push_back((umf::IdType)i);
+    std::shuffle(ids.begin(), ids.end(), std::mt19937(7));
+    ids.resize(nRemovals);
+    perf::Timer randomTimer;
+    for(auto id : ids)
+        ASSERT_TRUE(stream.remove(id));
+    perf::report(label("removeRandom"), ids.size(), randomTimer.elapsedMs());
+    ASSERT_EQ(n - 2 * nRemovals - ids.size(), stream.getAll().size());
+}
+
+TEST_P(PerfMetadataStream, RemoveSet)
+{
+    size_t n = GetParam();
+    fill(n);
+
+    umf::MetadataSet victims;
+    for(size_t i = 0; i < n; i += 10)
+        victims.push_back(stream.getById((umf::IdType)i));
+
+    perf::Timer timer;
+    stream.remove(victims);
+    perf::report(label("removeSet"), victims.size(), timer.elapsedMs());
+    ASSERT_EQ(n - victims.size(), stream.getAll().size());
+}
+
+TEST_P(PerfMetadataStream, QueryByFrameIndex)
+{
+    size_t n = GetParam();
+    fill(n);
+
+    const size_t nQueries = 10000;
+    size_t found = 0;
+
+    perf::Timer timer;
+    for(size_t i = 0; i < nQueries; i++)
+        found += stream.queryByFrameIndex(i * (n / nQueries)).size();
+    perf::report(label("queryByFrameIndex"), nQueries, timer.elapsedMs());
+    ASSERT_GT(found, 0u);
+}
+
+TEST_P(PerfMetadataStream, QueryByTime)
+{
+    size_t n = GetParam();
+    fill(n);
+
+    const size_t nQueries = 10000;
+    size_t found = 0;
+
+    perf::Timer timer;
+    for(size_t i = 0; i < nQueries; i++)
+    {
+        long long start = (long long)(i * (n / nQueries)) * 40;
+        found += stream.queryByTime(start, start + 40).size();
+    }
+    perf::report(label("queryByTime"), nQueries, timer.elapsedMs());
+    ASSERT_GT(found, 0u);
+}
+
+TEST_P(PerfMetadataStream, QueryByNameAndValue)
+{
+    size_t n = GetParam();
+    fill(n);
+
+    const size_t nQueries = 1000;
+    size_t found = 0;
+
+    perf::Timer timer;
+    for(size_t i = 0; i < nQueries; i++)
+    {
+        umf::FieldValue value("value", umf::Variant((umf::umf_integer)(i * (n / nQueries))));
+        found += stream.queryByNameAndValue("record", value).size();
+    }
+    perf::report(label("queryByNameAndValue"), nQueries, timer.elapsedMs());
+    ASSERT_EQ(nQueries, found);
+}
+
+TEST_P(PerfMetadataStream, QueryByNameAndRange)
+{
+    size_t n = GetParam();
+    fill(n);
+
+    const size_t nQueries = 1000;
+    size_t found = 0;
+
+    perf::Timer timer;
+    for(size_t i = 0; i < nQueries; i++)
+    {
+        umf::umf_integer lo = (umf::umf_integer)(i * (n / nQueries));
+        found += stream.queryByNameAndRange("record", "value", umf::Variant(lo), umf::Variant(lo + 9)).size();
+    }
+    perf::report(label("queryByNameAndRange"), nQueries, timer.elapsedMs());
+    ASSERT_EQ(nQueries * 10, found);
+}
+
+TEST_P(PerfMetadataStream, SelectExpression)
+{
+    size_t n = GetParam();
+    fill(n);
+
+    const size_t nQueries = 1000;
+    size_t found = 0;
+
+    perf::Timer timer;
+    for(size_t i = 0; i < nQueries; i++)
+    {
+        long long start = (long long)(i * (n / nQueries)) * 40;
+        umf::QueryExpr expr = umf::QueryExpr::name("record") && umf::QueryExpr::time(start, start + 400) &&
+            umf::QueryExpr::field("value", umf::QueryExpr::Compare::Greater, umf::Variant((umf::umf_integer)(start / 40)));
+        found += stream.select(expr).count();
+    }
+    perf::report(label("selectExpression"), nQueries, timer.elapsedMs());
+    ASSERT_GT(found, 0u);
+}
+
+TEST_P(PerfMetadataStream, ScanAll)
+{
+    size_t n = GetParam();
+    fill(n);
+
+    const size_t nScans = 10;
+    size_t found = 0;
+
+    perf::Timer timer;
+    for(size_t i = 0; i < nScans; i++)
+        for(const auto& spItem : stream.getAll())
+            found += spItem->getFrameIndex() % 2 == 0;
+    perf::report(label("scanAll"), nScans, timer.elapsedMs());
+
+    perf::Timer viewTimer;
+    for(size_t i = 0; i < nScans; i++)
+        for(const auto& spItem : stream.view())
+            found -= spItem->getFrameIndex() % 2 == 0;
+    perf::report(label("scanView"), nScans, viewTimer.elapsedMs());
+    ASSERT_EQ(0u, found);
+}
+
+TEST_P(PerfMetadataStream, CountByName)
+{
+    size_t n = GetParam();
+    fill(n);
+
+    const size_t nQueries = 10;
+    size_t found = 0;
+
+    perf::Timer timer;
+    for(size_t i = 0; i < nQueries; i++)
+        found += stream.queryByName("record").size();
+    perf::report(label("queryByName_size"), nQueries, timer.elapsedMs());
+
+    perf::Timer viewTimer;
+    for(size_t i = 0; i < nQueries; i++)
+        found -= stream.viewByName("record").count();
+    perf::report(label("viewByName_count"), nQueries, viewTimer.elapsedMs());
+    ASSERT_EQ(0u, found);
+}
+
+TEST_P(PerfMetadataStream, FieldAccess)
+{
+    size_t n = GetParam();
+    fill(n);
+    umf::MetadataSet items = stream.getAll();
+
+    umf::umf_integer sum = 0;
+    perf::Timer timer;
+    for(const auto& spItem : items)
+        sum += spItem->getFieldValue("value").get_integer();
+    perf::report(label("getFieldValue"), n, timer.elapsedMs());
+
+    size_t slot = 0;
+    ASSERT_TRUE(spDesc->getFieldSlot("value", slot));
+    perf::Timer slotTimer;
+    for(const auto& spItem : items)
+        sum -= spItem->get<umf::umf_integer>(slot);
+    perf::report(label("getBySlot"), n, slotTimer.elapsedMs());
+    ASSERT_EQ(0, sum);
+}
+
+TEST_P(PerfMetadataStream, StdSchemaMemory)
+{
+    size_t n = GetParam();
+    umf::MetadataStream stdStream;
+    auto spStdSchema = umf::MetadataSchema::getStdSchema();
+    stdStream.addSchema(spStdSchema);
+    auto spLocation = spStdSchema->findMetadataDesc("location");
+
+    size_t before = perf::residentBytes();
+    perf::Timer timer;
+    for(size_t i = 0; i < n; i++)
+    {
+        auto spMd = std::make_shared<umf::Metadata>(spLocation);
+        spMd->push_back(umf::FieldValue("latitude", (umf::umf_real)i));
+        spMd->push_back(umf::FieldValue("longitude", (umf::umf_real)-(double)i));
+        spMd->setTimestamp((long long)i * 40, 40);
+        stdStream.add(spMd);
+    }
+    perf::report(label("addStdLocation"), n, timer.elapsedMs());
+    perf::reportMemory(label("stdLocationMemory"), n, perf::residentBytes() - before);
+
+    size_t found = stdStream.queryByName("location").size() + stdStream.queryBySchema(spStdSchema->getName()).size();
+    ASSERT_EQ(2 * n, found);
+}
+
+TEST_P(PerfMetadataStream, ColumnarScan)
+{
+    size_t n = GetParam();
+    fill(n);
+    size_t slot = 0;
+    ASSERT_TRUE(spDesc->getFieldSlot("value", slot));
+
+    umf::umf_integer sum = 0;
+    perf::Timer timer;
+    for(const auto& spItem : stream.view())
+        sum += spItem->get<umf::umf_integer>(slot);
+    perf::report(label("objectScan"), n, timer.elapsedMs());
+
+    umf::MetadataStream columnar;
+    auto spColumnarSchema = std::make_shared<umf::MetadataSchema>("perf_schema");
+    std::vector<umf::FieldDesc> fields;
+    fields.emplace_back(umf::FieldDesc("value", umf::Variant::type_integer));
+    auto spColumnarDesc = std::make_shared<umf::MetadataDesc>("record", fields);
+    spColumnarSchema->add(spColumnarDesc);
+    columnar.addSchema(spColumnarSchema);
+    columnar.setColumnar("perf_schema", "record");
+
+    size_t before = perf::residentBytes();
+    for(size_t i = 0; i < n; i++)
+    {
+        auto spMd = std::make_shared<umf::Metadata>(spColumnarDesc);
+        spMd->setFieldValue("value", (umf::umf_integer)i);
+        spMd->setFrameIndex((long long)i, 10);
+        spMd->setTimestamp((long long)i * 40, 400);
+        columnar.add(spMd);
+    }
+    perf::reportMemory(label("columnarMemory"), n, perf::residentBytes() - before);
+
+    auto spColumns = columnar.getColumns("perf_schema", "record");
+    perf::Timer columnTimer;
+    for(umf::umf_integer value : spColumns->integers(0))
+        sum -= value;
+    perf::report(label("columnScan"), n, columnTimer.elapsedMs());
+    ASSERT_EQ(0, sum);
+}
+
+INSTANTIATE_TEST_CASE_P(Sizes, PerfMetadataStream, ::testing::Values<size_t>(10000, 100000, 1000000));
@@ -0,0 +1,135 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#ifndef _PERF_PRECOMP_HPP
+#define _PERF_PRECOMP_HPP
+
+#include "gtest/gtest.h"
+#include "umf/umf.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace perf
+{
+
+/*!
+* \brief Wall clock timer used by the performance tests
+*/
+class Timer
+{
+public:
+    Timer() : m_start(std::chrono::steady_clock::now()) {}
+
+    void restart() { m_start = std::chrono::steady_clock::now(); }
+
+    double elapsedMs() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+/*!
+* \brief Print the measured time of an operation repeated \p nOps times
+* and store it as a property of the current test
+*/
+inline void report(const std::string& sName, size_t nOps, double ms)
+{
+    double nsPerOp = nOps ? ms * 1e6 / nOps : 0;
+    std::cout << "[     PERF ] " << sName << ": " << nOps << " ops, "
+              << ms << " ms, " << nsPerOp << " ns/op" << std::endl;
+    ::testing::Test::RecordProperty(sName, umf::to_string((long long)nsPerOp));
+}
+
+/*!
+* \brief Resident set size of the process in bytes, 0 where it is not available
+*/
+inline size_t residentBytes()
+{
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if(statm >> pages >> resident)
+        return resident * (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    return 0;
+}
+
+/*!
+* \brief Number of threads of the process, 0 where it is not available
+*/
+inline size_t threadCount()
+{
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while(std::getline(status, line))
+        if(line.compare(0, 8, "Threads:") == 0)
+            return (size_t)std::stoul(line.substr(8));
+#endif
+    return 0;
+}
+
+/*!
+* \brief CPU time consumed by all threads of the process in milliseconds
+*/
+inline double cpuTimeMs()
+{
+    return (double)std::clock() * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/*!
+* \brief Print the memory taken by \p nItems items
+*/
+inline void reportMemory(const std::string& sName, size_t nItems, size_t bytes)
+{
+    size_t bytesPerItem = nItems ? bytes / nItems : 0;
+    std::cout << "[   MEMORY ] " << sName << ": " << nItems << " items, "
+              << bytes / (1024 * 1024) << " MB, " << bytesPerItem << " bytes/item" << std::endl;
+    ::testing::Test::RecordProperty(sName, umf::to_string((long long)bytesPerItem));
+}
+
+/*!
+* \brief Number of heap allocations made by the process so far, counted by perf_main.cpp
+*/
+size_t allocationCount();
+
+/*!
+* \brief Print the number of heap allocations made for \p nItems items
+*/
+inline void reportAllocations(const std::string& sName, size_t nItems, size_t nAllocations)
+{
+    double perItem = nItems ? (double)nAllocations / nItems : 0;
+    std::cout << "[   ALLOCS ] " << sName << ": " << nItems << " items, "
+              << nAllocations << " allocations, " << perItem << " allocations/item" << std::endl;
+    ::testing::Test::RecordProperty(sName, umf::to_string((long long)nAllocations));
+}
+
+} // namespace perf
+
+#endif //_PERF_PRECOMP_HPP
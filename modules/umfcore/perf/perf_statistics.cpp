@@ -0,0 +1,175 @@
+/*
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "perf_precomp.hpp"
+
+#include <thread>
+#include <vector>
+
+class PerfStatistics : public ::testing::TestWithParam<umf::Stat::UpdateMode::Type>
+{
+protected:
+    void SetUp()
+    {
+        auto spSchema = std::make_shared<umf::MetadataSchema>("perf_schema");
+        std::vector<umf::FieldDesc> fields;
+        fields.emplace_back(umf::FieldDesc("value", umf::Variant::type_integer));
+        spDesc = std::make_shared<umf::MetadataDesc>("record", fields);
+        spSchema->add(spDesc);
+        stream.addSchema(spSchema);
+    }
+
+    std::shared_ptr<umf::Stat> makeStat(size_t i) const
+    {
+        std::vector<umf::StatField> fields;
+        fields.emplace_back("count", "perf_schema", "record", "value",
+                            umf::StatOpFactory::builtinName(umf::StatOpFactory::BuiltinOp::Count));
+        fields.emplace_back("sum", "perf_schema", "record", "value",
+                            umf::StatOpFactory::builtinName(umf::StatOpFactory::BuiltinOp::Sum));
+        auto spStat = std::make_shared<umf::Stat>("stat" + umf::to_string((long long)i), fields, GetParam());
+        spStat->setUpdateTimeout(10);
+        return spStat;
+    }
+
+    std::string label(const std::string& op) const
+    {
+        static const char* modes[] = { "", "disabled", "manual", "onAdd", "onTimer" };
+        return op + "_" + modes[GetParam()];
+    }
+
+    static const size_t nStats = 64;
+
+    umf::MetadataStream stream;
+    std::shared_ptr<umf::MetadataDesc> spDesc;
+};
+
+// Threads and CPU taken by many Stat objects of the same stream, idle and while gathering
+TEST_P(PerfStatistics, ManyStats)
+{
+    const size_t nRecords = 20000;
+    size_t nThreads = perf::threadCount();
+
+    for(size_t i = 0; i < nStats; i++)
+        stream.addStat(makeStat(i));
+    std::vector<umf::Stat> copies(nStats, *stream.getStat("stat0"));
+    std::cout << "[  THREADS ] " << label("stats") << ": " << nStats * 2 << " stats, "
+              << perf::threadCount() - nThreads << " threads" << std::endl;
+
+    double cpuMs = perf::cpuTimeMs();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    std::cout << "[      CPU ] " << label("idle") << ": " << perf::cpuTimeMs() - cpuMs << " ms in 200 ms" << std::endl;
+
+    cpuMs = perf::cpuTimeMs();
+    perf::Timer timer;
+    for(size_t i = 0; i < nRecords; i++)
+    {
+        auto spMd = std::make_shared<umf::Metadata>(spDesc);
+        spMd->setFieldValue("value", (umf::umf_integer)i);
+        stream.add(spMd);
+    }
+    for(const auto& name : stream.getAllStatNames())
+        stream.getStat(name)->update(true);
+    perf::report(label("gather"), nRecords, timer.elapsedMs());
+    std::cout << "[      CPU ] " << label("gather") << ": " << perf::cpuTimeMs() - cpuMs << " ms" << std::endl;
+    std::cout << "[  THREADS ] " << label("gathered") << ": " << nStats * 2 << " stats, "
+              << perf::threadCount() - nThreads << " threads" << std::endl;
+
+    if(GetParam() != umf::Stat::UpdateMode::Disabled)
+    {
+        ASSERT_EQ((umf::umf_integer)nRecords, (umf::umf_integer)(*stream.getStat("stat1"))["count"]);
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(PerfStatistics, PerfStatistics,
+                        ::testing::Values(umf::Stat::UpdateMode::Disabled, umf::Stat::UpdateMode::Manual,
+                                          umf::Stat::UpdateMode::OnAdd, umf::Stat::UpdateMode::OnTimer));
+
+// One statistics object with a field for each of the fields of several metadata descriptions
+TEST(PerfStatFields, ManyFields)
+{
+    const size_t nDescs = 4, nFields = 32, nRecords = 20000;
+
+    umf::MetadataStream stream;
+    auto spSchema = std::make_shared<umf::MetadataSchema>("perf_schema");
+    std::vector<std::shared_ptr<umf::MetadataDesc>> descs;
+    for(size_t d = 0; d < nDescs; d++)
+    {
+        std::vector<umf::FieldDesc> fields;
+        for(size_t f = 0; f < nFields; f++)
+            fields.emplace_back(umf::FieldDesc("value" + umf::to_string((long long)f), umf::Variant::type_integer));
+        descs.push_back(std::make_shared<umf::MetadataDesc>("record" + umf::to_string((long long)d), fields));
+        spSchema->add(descs.back());
+    }
+    stream.addSchema(spSchema);
+
+    std::vector<umf::StatField> statFields;
+    for(const auto& spDesc : descs)
+        for(size_t f = 0; f < nFields; f++)
+            statFields.emplace_back(spDesc->getMetadataName() + "_sum" + umf::to_string((long long)f), "perf_schema",
+                                    spDesc->getMetadataName(), "value" + umf::to_string((long long)f),
+                                    umf::StatOpFactory::builtinName(umf::StatOpFactory::BuiltinOp::Sum));
+    stream.addStat(std::make_shared<umf::Stat>("stat", statFields, umf::Stat::UpdateMode::Manual));
+
+    std::vector<std::shared_ptr<umf::Metadata>> records;
+    for(size_t i = 0; i < nRecords; i++)
+    {
+        auto spMd = std::make_shared<umf::Metadata>(descs[i % nDescs]);
+        for(size_t f = 0; f < nFields; f++)
+            spMd->setFieldValue("value" + umf::to_string((long long)f), (umf::umf_integer)i);
+        records.push_back(spMd);
+    }
+
+    perf::Timer timer;
+    for(const auto& spMd : records)
+        stream.add(spMd);
+    stream.getStat("stat")->update(true);
+    perf::report("gather_" + umf::to_string((long long)statFields.size()) + "fields", nRecords, timer.elapsedMs());
+
+    ASSERT_EQ((umf::umf_integer)(nRecords / nDescs) * (nRecords - nDescs) / 2,
+              (umf::umf_integer)(*stream.getStat("stat"))["record0_sum0"]);
+}
+
+// Analytic operations over many values: time per value and allocations once the state is built
+TEST(PerfStatOps, Analytics)
+{
+    typedef umf::StatOpFactory::BuiltinOp BuiltinOp;
+    const size_t nValues = 1000000, nBatch = 256;
+    const BuiltinOp::Type types[] = { BuiltinOp::Sum, BuiltinOp::Variance, BuiltinOp::Histogram,
+                                      BuiltinOp::LogHistogram, BuiltinOp::Quantiles, BuiltinOp::DistinctCount };
+
+    std::vector<umf::Variant> values;
+    for(size_t i = 0; i < nValues; i++)
+        values.emplace_back((umf::umf_integer)((i * 2654435761u) % 1000003));
+    std::vector<const umf::Variant*> pValues;
+    for(const auto& value : values)
+        pValues.push_back(&value);
+
+    for(auto type : types)
+    {
+        std::unique_ptr<umf::StatOpBase> op(umf::StatOpFactory::create(umf::StatOpFactory::builtinName(type)));
+        const std::string name = op->name().substr(op->name().rfind('.') + 1);
+
+        op->handle(pValues.data(), nBatch);
+        size_t nAllocations = perf::allocationCount();
+        perf::Timer timer;
+        for(size_t i = nBatch; i < nValues; i += nBatch)
+            op->handle(pValues.data() + i, std::min(nBatch, nValues - i));
+        perf::report("handle_" + name, nValues - nBatch, timer.elapsedMs());
+        perf::reportAllocations("handle_" + name, nValues - nBatch, perf::allocationCount() - nAllocations);
+
+        ASSERT_NE(umf::Variant::type_empty, op->value().getType());
+    }
+}
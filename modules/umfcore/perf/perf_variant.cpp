@@ -0,0 +1,169 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "perf_precomp.hpp"
+
+#include <algorithm>
+
+class PerfVariant : public ::testing::TestWithParam<umf::Variant::Type>
+{
+protected:
+    void SetUp()
+    {
+        switch(GetParam())
+        {
+        case umf::Variant::type_integer: source = umf::Variant((umf::umf_integer) 42); break;
+        case umf::Variant::type_real: source = umf::Variant((umf::umf_real) 42.42); break;
+        case umf::Variant::type_vec3d: source = umf::Variant(umf::umf_vec3d(1, 2, 3)); break;
+        case umf::Variant::type_vec3d_vector:
+            source = umf::Variant(std::vector<umf::umf_vec3d>(8, umf::umf_vec3d(12.5, -0.375, 1.0 / 3)));
+            break;
+        default: source = umf::Variant(umf::umf_string("perf_variant")); break;
+        }
+    }
+
+    std::string label(const std::string& op) const
+    {
+        return op + "_" + umf::Variant::typeToString(source.getType());
+    }
+
+    umf::Variant source;
+
+    static const size_t nOps = 1000000;
+};
+
+const size_t PerfVariant::nOps;
+
+TEST_P(PerfVariant, Copy)
+{
+    size_t same = 0;
+
+    perf::Timer timer;
+    for(size_t i = 0; i < nOps; i++)
+    {
+        umf::Variant copy(source);
+        same += copy.getType() == source.getType();
+    }
+    perf::report(label("copy"), nOps, timer.elapsedMs());
+    ASSERT_EQ(nOps, same);
+}
+
+TEST_P(PerfVariant, Assign)
+{
+    std::vector<umf::Variant> values(1000);
+
+    perf::Timer timer;
+    for(size_t i = 0; i < nOps; i++)
+        values[i % values.size()] = source;
+    perf::report(label("assign"), nOps, timer.elapsedMs());
+    ASSERT_TRUE(values.back() == source);
+}
+
+TEST_P(PerfVariant, Compare)
+{
+    umf::Variant copy(source);
+    size_t same = 0;
+
+    perf::Timer timer;
+    for(size_t i = 0; i < nOps; i++)
+        same += copy == source;
+    perf::report(label("compare"), nOps, timer.elapsedMs());
+    ASSERT_EQ(nOps, same);
+}
+
+TEST_P(PerfVariant, Get)
+{
+    size_t found = 0;
+
+    perf::Timer timer;
+    for(size_t i = 0; i < nOps; i++)
+        found += source.try_get<umf::umf_integer>() != nullptr;
+    perf::report(label("tryGetInteger"), nOps, timer.elapsedMs());
+
+    if(source.getType() == umf::Variant::type_integer)
+    {
+        perf::Timer getTimer;
+        for(size_t i = 0; i < nOps; i++)
+            found -= source.get_integer() == 42;
+        perf::report(label("getInteger"), nOps, getTimer.elapsedMs());
+    }
+    ASSERT_EQ(0u, found);
+}
+
+TEST_P(PerfVariant, ToString)
+{
+    const size_t nConversions = nOps / 10;
+    size_t length = 0;
+
+    perf::Timer timer;
+    for(size_t i = 0; i < nConversions; i++)
+        length += source.toString().size();
+    perf::report(label("toString"), nConversions, timer.elapsedMs());
+    ASSERT_GT(length, 0u);
+}
+
+TEST_P(PerfVariant, FromString)
+{
+    const size_t nConversions = nOps / 10;
+    const std::string text = source.toString();
+    umf::Variant parsed;
+
+    perf::Timer timer;
+    for(size_t i = 0; i < nConversions; i++)
+        parsed.fromString(source.getType(), text);
+    perf::report(label("fromString"), nConversions, timer.elapsedMs());
+    ASSERT_EQ(text, parsed.toString());
+}
+
+INSTANTIATE_TEST_CASE_P(Types, PerfVariant, ::testing::Values(umf::Variant::type_integer, umf::Variant::type_real,
+    umf::Variant::type_vec3d, umf::Variant::type_vec3d_vector, umf::Variant::type_string));
+
+class PerfBase64 : public ::testing::TestWithParam<size_t>
+{
+};
+
+TEST_P(PerfBase64, EncodeDecode)
+{
+    const size_t size = GetParam();
+    const size_t nOps = std::max<size_t>(1, (64 << 20) / size);
+    umf::umf_rawbuffer buf;
+    buf.resize(size);
+    for(size_t i = 0; i < size; i++)
+        buf[i] = (char)(i * 131 + (i >> 7));
+    const std::string label = umf::to_string((long long)size);
+
+    size_t length = 0;
+    perf::Timer timer;
+    for(size_t i = 0; i < nOps; i++)
+        length += umf::Variant::base64encode(buf).size();
+    double ms = timer.elapsedMs();
+    perf::report("base64encode_" + label, nOps, ms);
+    std::cout << "[     PERF ] base64encode_" << label << ": " << nOps * size / ms / 1000 << " MB/s" << std::endl;
+    ASSERT_EQ(nOps * ((size + 2) / 3 * 4), length);
+
+    const std::string text = umf::Variant::base64encode(buf);
+    size_t decoded = 0;
+    timer.restart();
+    for(size_t i = 0; i < nOps; i++)
+        decoded += umf::Variant::base64decode(text).size();
+    ms = timer.elapsedMs();
+    perf::report("base64decode_" + label, nOps, ms);
+    std::cout << "[     PERF ] base64decode_" << label << ": " << nOps * size / ms / 1000 << " MB/s" << std::endl;
+    ASSERT_EQ(nOps * size, decoded);
+    ASSERT_EQ(buf, umf::Variant::base64decode(text));
+}
+
+INSTANTIATE_TEST_CASE_P(Sizes, PerfBase64, ::testing::Values(64, 4096, 1 << 20, 16 << 20));
@@ -0,0 +1,308 @@
+/*
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "base64.hpp"
+#include "umf/exceptions.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define UMF_BASE64_SIMD
+#include <immintrin.h>
+#endif
+
+namespace umf {
+namespace base64 {
+
+static const char encodeTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+//! Value of each base64 character, -1 for the others
+class DecodeTable
+{
+public:
+    DecodeTable()
+    {
+        for(int i = 0; i < 256; i++)
+            m_values[i] = -1;
+        for(int i = 0; i < 64; i++)
+            m_values[(unsigned char)encodeTable[i]] = (signed char)i;
+    }
+
+    int operator[](char c) const { return m_values[(unsigned char)c]; }
+
+private:
+    signed char m_values[256];
+};
+
+static const DecodeTable decodeTable;
+
+//! Encodes whole 3 byte groups, returns the number of bytes consumed
+static size_t encodeScalar(const unsigned char* in, size_t size, char* out)
+{
+    size_t i = 0;
+    for(; i + 3 <= size; i += 3, out += 4)
+    {
+        unsigned group = (unsigned)in[i] << 16 | (unsigned)in[i + 1] << 8 | in[i + 2];
+        out[0] = encodeTable[group >> 18];
+        out[1] = encodeTable[(group >> 12) & 0x3f];
+        out[2] = encodeTable[(group >> 6) & 0x3f];
+        out[3] = encodeTable[group & 0x3f];
+    }
+    return i;
+}
+
+//! Decodes whole 4 character groups up to the first one with an invalid character, returns the number decoded
+static size_t decodeScalar(const char* in, size_t nGroups, char* out)
+{
+    size_t i = 0;
+    for(; i < nGroups; i++, in += 4, out += 3)
+    {
+        int a = decodeTable[in[0]], b = decodeTable[in[1]], c = decodeTable[in[2]], d = decodeTable[in[3]];
+        if((a | b | c | d) < 0)
+            break;
+        unsigned group = (unsigned)a << 18 | (unsigned)b << 12 | (unsigned)c << 6 | (unsigned)d;
+        out[0] = (char)(group >> 16);
+        out[1] = (char)(group >> 8);
+        out[2] = (char)group;
+    }
+    return i;
+}
+
+#ifdef UMF_BASE64_SIMD
+
+/*
+ * The vector code follows W. Mula and D. Lemire, "Faster Base64 Encoding and
+ * Decoding Using AVX2 Instructions": each 3 byte group is spread to 4 bytes of
+ * 6 bit indices with one shuffle and two multiplies, and the indices are turned
+ * into characters by adding an offset looked up by the index range. Decoding
+ * classifies each character by its nibbles, which also detects invalid ones.
+ */
+
+__attribute__((target("ssse3")))
+static inline __m128i encodeIndices(__m128i in)
+{
+    in = _mm_shuffle_epi8(in, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+    __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+    __m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t0, t1);
+}
+
+__attribute__((target("ssse3")))
+static inline __m128i indicesToChars(__m128i indices)
+{
+    // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+}
+
+__attribute__((target("ssse3")))
+static size_t encodeSSSE3(const unsigned char* in, size_t size, char* out)
+{
+    // 16 bytes are loaded for every 12 encoded
+    size_t i = 0;
+    for(; i + 16 <= size; i += 12, out += 16)
+    {
+        __m128i indices = encodeIndices(_mm_loadu_si128((const __m128i*)(in + i)));
+        _mm_storeu_si128((__m128i*)out, indicesToChars(indices));
+    }
+    return i + encodeScalar(in + i, size - i, out);
+}
+
+__attribute__((target("avx2")))
+static size_t encodeAVX2(const unsigned char* in, size_t size, char* out)
+{
+    const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+        1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+    // each 128 bit lane takes 12 bytes, 28 bytes are loaded for every 24 encoded
+    size_t i = 0;
+    for(; i + 28 <= size; i += 24, out += 32)
+    {
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(in + i))),
+                                            _mm_loadu_si128((const __m128i*)(in + i + 12)), 1);
+        v = _mm256_shuffle_epi8(v, spread);
+        __m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+        __m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+        __m256i indices = _mm256_or_si256(t0, t1);
+
+        __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+        _mm256_storeu_si256((__m256i*)out, _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices));
+    }
+    return i + encodeSSSE3(in + i, size - i, out);
+}
+
+__attribute__((target("ssse3")))
+static size_t decodeSSSE3(const char* in, size_t nGroups, char* out)
+{
+    const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2F = _mm_set1_epi8(0x2f);
+    const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    // 16 bytes are stored for every 12 decoded, so two groups more must follow
+    size_t i = 0;
+    for(; i + 6 <= nGroups; i += 4, in += 16, out += 12)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)in);
+        __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(v, 4), mask2F);
+        __m128i lo = _mm_shuffle_epi8(lutLo, _mm_and_si128(v, mask2F));
+        __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xffff)
+            break;
+        __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(v, mask2F), hiNibbles));
+        v = _mm_add_epi8(v, roll);
+        v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+        v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+        _mm_storeu_si128((__m128i*)out, _mm_shuffle_epi8(v, pack));
+    }
+    return i + decodeScalar(in, nGroups - i, out);
+}
+
+__attribute__((target("avx2")))
+static size_t decodeAVX2(const char* in, size_t nGroups, char* out)
+{
+    const __m256i lutLo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m256i lutHi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask2F = _mm256_set1_epi8(0x2f);
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    // 32 bytes are stored for every 24 decoded, so three groups more must follow
+    size_t i = 0;
+    for(; i + 11 <= nGroups; i += 8, in += 32, out += 24)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)in);
+        __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(v, 4), mask2F);
+        __m256i lo = _mm256_shuffle_epi8(lutLo, _mm256_and_si256(v, mask2F));
+        __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+        if(!_mm256_testz_si256(lo, hi))
+            break;
+        __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(_mm256_cmpeq_epi8(v, mask2F), hiNibbles));
+        v = _mm256_add_epi8(v, roll);
+        v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+        v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+        v = _mm256_shuffle_epi8(v, pack);
+        v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm256_storeu_si256((__m256i*)out, v);
+    }
+    return i + decodeSSSE3(in, nGroups - i, out);
+}
+
+#endif // UMF_BASE64_SIMD
+
+typedef size_t (*EncodeFunc)(const unsigned char* in, size_t size, char* out);
+typedef size_t (*DecodeFunc)(const char* in, size_t nGroups, char* out);
+
+static EncodeFunc encodeFunc()
+{
+#ifdef UMF_BASE64_SIMD
+    static const EncodeFunc func = __builtin_cpu_supports("avx2") ? encodeAVX2 :
+                                   __builtin_cpu_supports("ssse3") ? encodeSSSE3 : encodeScalar;
+    return func;
+#else
+    return encodeScalar;
+#endif
+}
+
+static DecodeFunc decodeFunc()
+{
+#ifdef UMF_BASE64_SIMD
+    static const DecodeFunc func = __builtin_cpu_supports("avx2") ? decodeAVX2 :
+                                   __builtin_cpu_supports("ssse3") ? decodeSSSE3 : decodeScalar;
+    return func;
+#else
+    return decodeScalar;
+#endif
+}
+
+void encode(const char* data, size_t size, char* out)
+{
+    const unsigned char* in = (const unsigned char*)data;
+    size_t done = encodeFunc()(in, size, out);
+    out += done / 3 * 4;
+
+    size_t rest = size - done;
+    if(rest)
+    {
+        unsigned group = (unsigned)in[done] << 16 | (rest > 1 ? (unsigned)in[done + 1] << 8 : 0);
+        out[0] = encodeTable[group >> 18];
+        out[1] = encodeTable[(group >> 12) & 0x3f];
+        out[2] = rest > 1 ? encodeTable[(group >> 6) & 0x3f] : '=';
+        out[3] = '=';
+    }
+}
+
+void append(std::string& s, const char* data, size_t size)
+{
+    size_t offset = s.size();
+    s.resize(offset + encodedSize(size));
+    encode(data, size, &s[offset]);
+}
+
+umf_rawbuffer decode(const char* text, size_t size)
+{
+    if(!size)
+        return umf_rawbuffer();
+
+    if(size % 4 != 0)
+        UMF_EXCEPTION(IncorrectParamException, "Invalid base64 string size (isn't multiple of 4)");
+
+    size_t nPadding = 0;
+    while(nPadding < size && text[size - 1 - nPadding] == '=')
+        nPadding++;
+    if(nPadding > 2)
+        UMF_EXCEPTION(IncorrectParamException, "Invalid base64 string: more than 2 trailing '=' symbols");
+
+    size_t nGroups = size / 4 - (nPadding ? 1 : 0);
+    umf_rawbuffer result;
+    result.resize(size / 4 * 3 - nPadding);
+
+    if(decodeFunc()(text, nGroups, result.data()) != nGroups)
+        UMF_EXCEPTION(IncorrectParamException, "Input base64 string contains invalid symbol");
+
+    if(nPadding)
+    {
+        const char* in = text + nGroups * 4;
+        char* out = result.data() + nGroups * 3;
+        int a = decodeTable[in[0]], b = decodeTable[in[1]], c = nPadding == 1 ? decodeTable[in[2]] : 0;
+        if((a | b | c) < 0)
+            UMF_EXCEPTION(IncorrectParamException, "Input base64 string contains invalid symbol");
+        out[0] = (char)(a << 2 | b >> 4);
+        if(nPadding == 1)
+            out[1] = (char)(b << 4 | c >> 2);
+    }
+    return result;
+}
+
+}
+}
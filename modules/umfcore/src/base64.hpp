@@ -0,0 +1,54 @@
+/*
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef UMF_BASE64_HPP
+#define UMF_BASE64_HPP
+
+#include "umf/types.hpp"
+
+#include <string>
+
+namespace umf {
+
+/*!
+ * \brief Base64 codec used by Variant for raw buffers and string arrays.
+ * \details The output is allocated once and filled through lookup tables.
+ * On x86 the bulk of the data goes through SSSE3 or AVX2 code, chosen at
+ * run time by the CPU features, the remainder through the scalar code.
+ */
+namespace base64 {
+
+//! Length of the base64 text of \p size bytes
+inline size_t encodedSize(size_t size)
+{
+    return (size + 2) / 3 * 4;
+}
+
+//! Writes encodedSize(size) characters to \p out
+void encode(const char* data, size_t size, char* out);
+
+//! Appends the base64 text of \p data to \p s
+void append(std::string& s, const char* data, size_t size);
+
+//! Decodes padded base64 text, throws IncorrectParamException on malformed input
+umf_rawbuffer decode(const char* text, size_t size);
+
+}
+
+}
+
+#endif // UMF_BASE64_HPP
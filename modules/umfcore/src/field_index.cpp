@@ -0,0 +1,130 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "field_index.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace umf {
+
+FieldIndex::FieldIndex(Variant::Type type, size_t slot)
+    : m_type(type), m_slot(slot), m_strings(true, false), m_integers(true, true), m_reals(false, true)
+{
+}
+
+void FieldIndex::erase(IdType id)
+{
+    switch(m_type)
+    {
+    case Variant::type_string:
+        m_strings.erase(id);
+        break;
+    case Variant::type_integer:
+        m_integers.erase(id);
+        break;
+    case Variant::type_real:
+        m_reals.erase(id);
+        break;
+    default:
+        break;
+    }
+    m_others.erase(id);
+}
+
+void FieldIndex::update(IdType id, const FieldValue* pValue)
+{
+    erase(id);
+    if(!pValue)
+        return;
+
+    if(pValue->getType() != m_type)
+    {
+        m_others.insert(id);
+        return;
+    }
+
+    switch(m_type)
+    {
+    case Variant::type_string:
+        m_strings.insert(id, pValue->get_string());
+        break;
+    case Variant::type_integer:
+        m_integers.insert(id, pValue->get_integer());
+        break;
+    case Variant::type_real:
+        if(std::isnan(pValue->get_real()))
+            m_others.insert(id);
+        else
+            m_reals.insert(id, pValue->get_real());
+        break;
+    default:
+        m_others.insert(id);
+        break;
+    }
+}
+
+bool FieldIndex::findEqual(const Variant& value, std::vector<IdType>& ids, size_t limit) const
+{
+    if(value.getType() != m_type)
+        return false;
+
+    switch(m_type)
+    {
+    case Variant::type_string:
+        m_strings.findEqual(value.get_string(), ids, limit);
+        break;
+    case Variant::type_integer:
+        m_integers.findEqual(value.get_integer(), ids, limit);
+        break;
+    case Variant::type_real:
+    {
+        // Reals are equal within the tolerance used by Variant::operator==
+        umf_real key = value.get_real(), eps = std::numeric_limits<umf_real>::epsilon();
+        m_reals.findRange(key - eps, key + eps, ids, limit);
+        break;
+    }
+    default:
+        return false;
+    }
+
+    ids.insert(ids.end(), m_others.begin(), m_others.end());
+    return true;
+}
+
+bool FieldIndex::findRange(const Variant& lo, const Variant& hi, std::vector<IdType>& ids, size_t limit) const
+{
+    if(lo.getType() != m_type || hi.getType() != m_type)
+        return false;
+
+    switch(m_type)
+    {
+    case Variant::type_integer:
+        m_integers.findRange(lo.get_integer(), hi.get_integer(), ids, limit);
+        break;
+    case Variant::type_real:
+        m_reals.findRange(lo.get_real(), hi.get_real(), ids, limit);
+        break;
+    default:
+        return false;
+    }
+
+    ids.insert(ids.end(), m_others.begin(), m_others.end());
+    return true;
+}
+
+}
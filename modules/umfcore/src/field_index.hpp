@@ -0,0 +1,168 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef UMF_FIELD_INDEX_HPP
+#define UMF_FIELD_INDEX_HPP
+
+#include "umf/fieldvalue.hpp"
+
+#include <limits>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace umf {
+
+/*!
+ * \class ValueIndex
+ * \brief Maps metadata ids to field values of type T.
+ * \details The values are kept in a hash table for equality lookups and/or
+ * in an ordered set for range lookups.
+ */
+template< typename T >
+class ValueIndex
+{
+public:
+    ValueIndex(bool hashed, bool ordered) : m_hashed(hashed), m_ordered(ordered) {}
+
+    void insert(IdType id, const T& key)
+    {
+        erase(id);
+        m_keys[id] = key;
+        if(m_hashed)
+            m_hash[key].insert(id);
+        if(m_ordered)
+            m_sorted.insert(std::make_pair(key, id));
+    }
+
+    void erase(IdType id)
+    {
+        auto it = m_keys.find(id);
+        if(it == m_keys.end())
+            return;
+        if(m_hashed)
+        {
+            auto itHash = m_hash.find(it->second);
+            itHash->second.erase(id);
+            if(itHash->second.empty())
+                m_hash.erase(itHash);
+        }
+        if(m_ordered)
+            m_sorted.erase(std::make_pair(it->second, id));
+        m_keys.erase(it);
+    }
+
+    void clear()
+    {
+        m_keys.clear();
+        m_hash.clear();
+        m_sorted.clear();
+    }
+
+    bool hashed() const { return m_hashed; }
+    bool ordered() const { return m_ordered; }
+
+    //! Collect ids of values equal to the key, stop after more than limit ids
+    void findEqual(const T& key, std::vector<IdType>& ids, size_t limit = std::numeric_limits<size_t>::max()) const
+    {
+        auto it = m_hash.find(key);
+        if(it == m_hash.end())
+            return;
+        for(auto id : it->second)
+        {
+            ids.push_back(id);
+            if(limit-- == 0)
+                break;
+        }
+    }
+
+    //! Collect ids of values in [lo, hi], stop after more than limit ids
+    void findRange(const T& lo, const T& hi, std::vector<IdType>& ids, size_t limit = std::numeric_limits<size_t>::max()) const
+    {
+        for(auto it = m_sorted.lower_bound(std::make_pair(lo, INVALID_ID)); it != m_sorted.end() && !(hi < it->first); ++it)
+        {
+            ids.push_back(it->second);
+            if(limit-- == 0)
+                break;
+        }
+    }
+
+private:
+    bool m_hashed;
+    bool m_ordered;
+    std::unordered_map< IdType, T > m_keys;
+    std::unordered_map< T, std::unordered_set<IdType> > m_hash;
+    std::set< std::pair<T, IdType> > m_sorted;
+};
+
+/*!
+ * \class FieldIndex
+ * \brief Value index of a single indexed field of a metadata description.
+ * \details String fields are hashed, integer fields are hashed and ordered,
+ * real fields are ordered only, since reals are compared with a tolerance.
+ * Values whose type differs from the declared field type are not indexed
+ * and are returned as candidates of every lookup.
+ */
+class FieldIndex
+{
+public:
+    explicit FieldIndex(Variant::Type type = Variant::type_empty, size_t slot = 0);
+
+    //! Index the current value of the field, pValue is null if the item has no such field
+    void update(IdType id, const FieldValue* pValue);
+
+    void erase(IdType id);
+
+    /*!
+     * \brief Collect candidate ids of items which field may be equal to the value
+     * \details Values are collected until more than limit ids are found
+     * \return false if the index can't be used for the value
+     */
+    bool findEqual(const Variant& value, std::vector<IdType>& ids, size_t limit = std::numeric_limits<size_t>::max()) const;
+
+    /*!
+     * \brief Collect candidate ids of items which field may lie in [lo, hi]
+     * \details The bounds should be of the field type,
+     * values are collected until more than limit ids are found
+     * \return false if the index can't be used for range lookups
+     */
+    bool findRange(const Variant& lo, const Variant& hi, std::vector<IdType>& ids, size_t limit = std::numeric_limits<size_t>::max()) const;
+
+    Variant::Type getType() const { return m_type; }
+
+    //! Slot of the field in its metadata description
+    size_t getSlot() const { return m_slot; }
+
+    static bool isOrderedType(Variant::Type type)
+    {
+        return type == Variant::type_integer || type == Variant::type_real;
+    }
+
+private:
+    Variant::Type m_type;
+    size_t m_slot;
+    ValueIndex< umf_string > m_strings;
+    ValueIndex< umf_integer > m_integers;
+    ValueIndex< umf_real > m_reals;
+    std::unordered_set< IdType > m_others;
+};
+
+}
+
+#endif /* UMF_FIELD_INDEX_HPP */
@@ -72,6 +72,8 @@ static void add(JSONNode& schemaNode, const std::shared_ptr<MetadataSchema>& spS
                 fieldNode.push_back(JSONNode(ATTR_FIELD_OPTIONAL, "true"));
             if(fieldDesc->useEncryption)
                 fieldNode.push_back(JSONNode(ATTR_ENCRYPTED_BOOL, "true"));
+            if (fieldDesc->indexed)
+                fieldNode.push_back(JSONNode(ATTR_FIELD_INDEXED, "true"));
 
             fieldsArrayNode.push_back(fieldNode);
         }
@@ -152,13 +154,14 @@ static void add(JSONNode& metadataNode, const std::shared_ptr<Metadata>& spMetad
 
     JSONNode metadataFieldsArrayNode(JSON_ARRAY);
     metadataFieldsArrayNode.set_name(TAG_FIELDS_ARRAY);
-    auto vFields = spMetadata->getDesc()->getFields();
-    for (auto fieldDesc = vFields.begin(); fieldDesc != vFields.end(); fieldDesc++)
+    const MetadataDesc& desc = *spMetadata->getDesc();
+    for (size_t slot = 0; slot < desc.getSlotCount(); slot++)
     {
-        auto fieldIt = spMetadata->findField(fieldDesc->name);
-        if(fieldIt != spMetadata->end())
+        const FieldValue* fieldIt = spMetadata->tryField(slot);
+        if(fieldIt)
         {
-            Variant val = spMetadata->getFieldValue(fieldDesc->name);
+            const FieldDesc* fieldDesc = &desc.getSlotDesc(slot);
+            const Variant& val = *fieldIt;
             const std::string& encData = fieldIt->getEncryptedData();
             if(!val.isEmpty() || !encData.empty())
             {
@@ -443,8 +446,12 @@ static std::shared_ptr<MetadataSchema> parseSchemaFromNode(const JSONNode& schem
             auto fieldUseEncryptionIter = fieldNode->find(ATTR_ENCRYPTED_BOOL);
             if(fieldUseEncryptionIter != fieldNode->end())
                 field_use_encryption = fieldUseEncryptionIter->as_string() == "true";
+            bool field_indexed = false;
+            auto fieldIndexedIter = fieldNode->find(ATTR_FIELD_INDEXED);
+            if (fieldIndexedIter != fieldNode->end())
+                field_indexed = fieldIndexedIter->as_string() == "true";
             vFields.push_back(FieldDesc(fieldNameIter->as_string(), field_type, field_optional,
-                                        field_use_encryption));
+                                        field_use_encryption, field_indexed));
         }
 
         auto refsArrayIter = descNode->find(TAG_METADATA_REFERENCES_ARRAY);
@@ -84,6 +84,10 @@ static void add(xmlNodePtr schemaNode, const std::shared_ptr<MetadataSchema>& sp
                 if (xmlNewProp(fieldNode, BAD_CAST ATTR_FIELD_OPTIONAL, BAD_CAST "true") == NULL)
                     UMF_EXCEPTION(Exception, "Can't create xmlNode property (field is optional)");
 
+            if (fieldDesc->indexed)
+                if (xmlNewProp(fieldNode, BAD_CAST ATTR_FIELD_INDEXED, BAD_CAST "true") == NULL)
+                    UMF_EXCEPTION(Exception, "Can't create xmlNode property (field is indexed)");
+
             if(fieldDesc->useEncryption)
             {
                 if(xmlNewProp(fieldNode, BAD_CAST ATTR_ENCRYPTED_BOOL, BAD_CAST "true") == NULL)
@@ -155,13 +159,14 @@ static void add(xmlNodePtr metadataNode, const std::shared_ptr<Metadata>& spMeta
         if (xmlNewProp(metadataNode, BAD_CAST ATTR_METADATA_DURATION, BAD_CAST to_string(spMetadata->getDuration()).c_str()) == NULL)
             UMF_EXCEPTION(Exception, "Can't create xmlNode property (metadata duration)");
 
-    auto vFields = spMetadata->getDesc()->getFields();
-    for (auto fieldDesc = vFields.begin(); fieldDesc != vFields.end(); fieldDesc++)
+    const MetadataDesc& desc = *spMetadata->getDesc();
+    for (size_t slot = 0; slot < desc.getSlotCount(); slot++)
     {
-        auto fieldIt = spMetadata->findField(fieldDesc->name);
-        if(fieldIt != spMetadata->end())
+        const FieldValue* fieldIt = spMetadata->tryField(slot);
+        if(fieldIt)
         {
-            Variant val = spMetadata->getFieldValue(fieldDesc->name);
+            const FieldDesc* fieldDesc = &desc.getSlotDesc(slot);
+            const Variant& val = *fieldIt;
             const std::string& encData = fieldIt->getEncryptedData();
 
             if(!val.isEmpty() || !encData.empty())
@@ -461,6 +466,7 @@ static std::shared_ptr<MetadataSchema> parseSchemaFromNode(xmlNodePtr schemaNode
                     umf::Variant::Type field_type = umf::Variant::type_empty;
                     bool field_optional = false;
                     bool fieldUseEncryption = false;
+                    bool field_indexed = false;
                     for (xmlAttrPtr cur_prop = fieldNode->properties; cur_prop; cur_prop = cur_prop->next) //fill field's attributes
                     {
                         if (std::string((char*)cur_prop->name) == std::string(ATTR_NAME))
@@ -484,8 +490,10 @@ static std::shared_ptr<MetadataSchema> parseSchemaFromNode(xmlNodePtr schemaNode
                             std::string encBool = (char*)xmlGetProp(fieldNode, cur_prop->name);
                             fieldUseEncryption = encBool == "true";
                         }
+                        if (std::string((char*)cur_prop->name) == std::string(ATTR_FIELD_INDEXED))
+                            field_indexed = std::string((char*)xmlGetProp(fieldNode, cur_prop->name)) == "true";
                     }
-                    vFields.push_back(FieldDesc(field_name, field_type, field_optional, fieldUseEncryption));
+                    vFields.push_back(FieldDesc(field_name, field_type, field_optional, fieldUseEncryption, field_indexed));
                 }
                 else if (fieldNode->type == XML_ELEMENT_NODE && (char*)fieldNode->name == std::string(TAG_METADATA_REFERENCE))
                 {
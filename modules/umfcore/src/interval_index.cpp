@@ -0,0 +1,187 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "interval_index.hpp"
+
+#include <algorithm>
+
+namespace umf {
+
+static const int nil = -1;
+
+IntervalIndex::IntervalIndex()
+    : m_root(nil), m_seed(2463534242u)
+{
+}
+
+int IntervalIndex::allocate(IdType id, long long lo, long long hi)
+{
+    // xorshift is enough to keep the treap balanced
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+
+    Node node = { lo, hi, hi, id, m_seed, nil, nil };
+    if(m_freeNodes.empty())
+    {
+        m_nodes.push_back(node);
+        return (int)m_nodes.size() - 1;
+    }
+    int n = m_freeNodes.back();
+    m_freeNodes.pop_back();
+    m_nodes[n] = node;
+    return n;
+}
+
+void IntervalIndex::update(int n)
+{
+    Node& node = m_nodes[n];
+    node.maxHi = node.hi;
+    if(node.left != nil)
+        node.maxHi = std::max(node.maxHi, m_nodes[node.left].maxHi);
+    if(node.right != nil)
+        node.maxHi = std::max(node.maxHi, m_nodes[node.right].maxHi);
+}
+
+void IntervalIndex::split(int n, long long lo, IdType id, int& left, int& right)
+{
+    if(n == nil)
+    {
+        left = right = nil;
+        return;
+    }
+    Node& node = m_nodes[n];
+    if(node.lo < lo || (node.lo == lo && node.id < id))
+    {
+        split(node.right, lo, id, m_nodes[n].right, right);
+        left = n;
+    }
+    else
+    {
+        split(node.left, lo, id, left, m_nodes[n].left);
+        right = n;
+    }
+    update(n);
+}
+
+int IntervalIndex::merge(int left, int right)
+{
+    if(left == nil) return right;
+    if(right == nil) return left;
+    if(m_nodes[left].priority > m_nodes[right].priority)
+    {
+        int merged = merge(m_nodes[left].right, right);
+        m_nodes[left].right = merged;
+        update(left);
+        return left;
+    }
+    else
+    {
+        int merged = merge(left, m_nodes[right].left);
+        m_nodes[right].left = merged;
+        update(right);
+        return right;
+    }
+}
+
+void IntervalIndex::insert(IdType id, long long lo, long long hi)
+{
+    erase(id);
+
+    int n = allocate(id, lo, hi);
+    m_byId[id] = n;
+
+    int left, right;
+    split(m_root, lo, id, left, right);
+    m_root = merge(merge(left, n), right);
+}
+
+int IntervalIndex::erase(int n, long long lo, IdType id)
+{
+    if(n == nil)
+        return nil;
+    Node& node = m_nodes[n];
+    if(node.lo == lo && node.id == id)
+    {
+        m_freeNodes.push_back(n);
+        return merge(node.left, node.right);
+    }
+    if(lo < node.lo || (lo == node.lo && id < node.id))
+    {
+        int child = erase(node.left, lo, id);
+        m_nodes[n].left = child;
+    }
+    else
+    {
+        int child = erase(node.right, lo, id);
+        m_nodes[n].right = child;
+    }
+    update(n);
+    return n;
+}
+
+bool IntervalIndex::erase(IdType id)
+{
+    auto it = m_byId.find(id);
+    if(it == m_byId.end())
+        return false;
+
+    m_root = erase(m_root, m_nodes[it->second].lo, id);
+    m_byId.erase(it);
+    return true;
+}
+
+void IntervalIndex::clear()
+{
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_byId.clear();
+    m_root = nil;
+}
+
+//! Returns false once ids reach maxSize
+bool IntervalIndex::query(int n, long long lo, long long hi, std::vector<IdType>& ids, size_t maxSize) const
+{
+    while(n != nil)
+    {
+        const Node& node = m_nodes[n];
+        // Nothing in this subtree ends at or after lo
+        if(node.maxHi < lo)
+            return true;
+        if(!query(node.left, lo, hi, ids, maxSize))
+            return false;
+        // The node and its right subtree start after hi
+        if(node.lo > hi)
+            return true;
+        if(node.hi >= lo)
+        {
+            ids.push_back(node.id);
+            if(ids.size() >= maxSize)
+                return false;
+        }
+        n = node.right;
+    }
+    return true;
+}
+
+void IntervalIndex::query(long long lo, long long hi, std::vector<IdType>& ids, size_t limit) const
+{
+    size_t maxSize = limit < std::numeric_limits<size_t>::max() - ids.size() ? ids.size() + limit + 1 : std::numeric_limits<size_t>::max();
+    query(m_root, lo, hi, ids, maxSize);
+}
+
+}
@@ -0,0 +1,93 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef UMF_INTERVAL_INDEX_HPP
+#define UMF_INTERVAL_INDEX_HPP
+
+#include "umf/global.hpp"
+
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace umf {
+
+/*!
+ * \class IntervalIndex
+ * \brief Dynamic set of closed intervals [lo, hi] keyed by metadata id.
+ * \details Implemented as a treap ordered by (lo, id) where every node keeps
+ * the maximal right bound of its subtree, so insertion and removal take
+ * O(log n) and an overlap query visits O(log n) nodes per reported interval.
+ * Nodes live in a vector and are linked by indexes, which makes the index
+ * copyable by value.
+ */
+class IntervalIndex
+{
+public:
+    IntervalIndex();
+
+    /*!
+     * \brief Add the interval of the item, replacing the previous one if any
+     */
+    void insert(IdType id, long long lo, long long hi);
+
+    /*!
+     * \brief Remove the interval of the item
+     * \return false if the item has no interval in the index
+     */
+    bool erase(IdType id);
+
+    /*!
+     * \brief Remove all intervals
+     */
+    void clear();
+
+    size_t size() const { return m_byId.size(); }
+
+    /*!
+     * \brief Collect ids of all intervals intersecting [lo, hi]
+     * \param ids [out] ids are appended in no particular order
+     * \param limit [in] the lookup stops after more than limit ids are found
+     */
+    void query(long long lo, long long hi, std::vector<IdType>& ids, size_t limit = std::numeric_limits<size_t>::max()) const;
+
+private:
+    struct Node
+    {
+        long long lo, hi, maxHi;
+        IdType id;
+        unsigned int priority;
+        int left, right;
+    };
+
+    int allocate(IdType id, long long lo, long long hi);
+    void update(int n);
+    void split(int n, long long lo, IdType id, int& left, int& right);
+    int merge(int left, int right);
+    int erase(int n, long long lo, IdType id);
+    bool query(int n, long long lo, long long hi, std::vector<IdType>& ids, size_t maxSize) const;
+
+    std::vector<Node> m_nodes;
+    std::vector<int> m_freeNodes;
+    std::unordered_map<IdType, int> m_byId;
+    int m_root;
+    unsigned int m_seed;
+};
+
+}
+
+#endif /* UMF_INTERVAL_INDEX_HPP */
@@ -26,8 +26,6 @@ Metadata::Metadata(const std::shared_ptr< MetadataDesc >& spDescription , bool u
     , m_nNumOfFrames(UNDEFINED_FRAMES_NUMBER)
     , m_nTimestamp(UNDEFINED_TIMESTAMP)
     , m_nDuration(UNDEFINED_DURATION)
-    , m_sName( "" )
-    , m_sSchemaName( "" )
     , m_useEncryption(useEncryption)
     , m_encryptedData("")
     , m_spDesc( spDescription )
@@ -82,6 +80,9 @@ void Metadata::setFrameIndex( long long nFrameIndex, long long nNumOfFrames )
 
     m_nFrameIndex = nFrameIndex;
     m_nNumOfFrames = nNumOfFrames;
+
+    if(m_pStream)
+        m_pStream->onFrameIndexChanged(*this);
 }
 
 void Metadata::setTimestamp(long long timestamp, long long duration)
@@ -98,6 +99,9 @@ void Metadata::setTimestamp(long long timestamp, long long duration)
 
     m_nTimestamp = timestamp;
     m_nDuration = duration;
+
+    if(m_pStream)
+        m_pStream->onTimeChanged(*this);
 }
 
 long long Metadata::getTime() const
@@ -120,26 +124,25 @@ bool Metadata::shiftFrameIndex( long long nTarFrameIndex, long long nSrcFrameInd
     if( m_nNumOfFrames < 0 )
         return false;
 
-    if( m_nFrameIndex + m_nNumOfFrames <= nSrcFrameIndex ||
-        m_nFrameIndex >= nSrcFrameIndex + nNumOfFrames ) 
-    {
-        m_nNumOfFrames = 0;
-        return false;
-    }
-
-    long long nNewFrameIndex = std::max<long long>( 0, m_nFrameIndex - nSrcFrameIndex ) + nTarFrameIndex;
-    long long nNewNumOfFrames = std::min<long long>( m_nNumOfFrames, nTarFrameIndex + nNumOfFrames - nNewFrameIndex );
+    long long nNewFrameIndex = m_nFrameIndex;
+    long long nNewNumOfFrames = 0;
 
-    if( nNewNumOfFrames < 1 )
+    if( m_nFrameIndex + m_nNumOfFrames > nSrcFrameIndex &&
+        m_nFrameIndex < nSrcFrameIndex + nNumOfFrames )
     {
-        m_nNumOfFrames = 0;
-        return false;
+        nNewFrameIndex = std::max<long long>( 0, m_nFrameIndex - nSrcFrameIndex ) + nTarFrameIndex;
+        nNewNumOfFrames = std::min<long long>( m_nNumOfFrames, nTarFrameIndex + nNumOfFrames - nNewFrameIndex );
     }
 
-    m_nFrameIndex = nNewFrameIndex;
-    m_nNumOfFrames = nNewNumOfFrames;
+    bool bShifted = nNewNumOfFrames >= 1;
+    if( bShifted )
+        m_nFrameIndex = nNewFrameIndex;
+    m_nNumOfFrames = bShifted ? nNewNumOfFrames : 0;
 
-    return true;
+    if( m_pStream )
+        m_pStream->onFrameIndexChanged( *this );
+
+    return bShifted;
 }
 std::string Metadata::getName() const
 {
@@ -150,7 +153,7 @@ std::string Metadata::getSchemaName() const
 {
     return m_sSchemaName;
 }
-std::shared_ptr< MetadataDesc > Metadata::getDesc() const
+const std::shared_ptr< MetadataDesc >& Metadata::getDesc() const
 {
     return m_spDesc;
 }
@@ -173,25 +176,54 @@ std::vector< std::string > Metadata::getFieldNames() const
 
 umf::Variant Metadata::getFieldValue( const std::string& sName ) const
 {
-    const_iterator it = const_cast<umf::Metadata*>(this)->findField( sName );
-    if( it != this->end() )
-        return *it;
+    size_t slot = getFieldSlot( sName );
+    if( const FieldValue* pValue = tryField( slot ) )
+        return *pValue;
 
-    FieldDesc fieldDesc;
-    if( !m_spDesc->getFieldDesc( fieldDesc, sName ) )
+    if( m_spDesc->getSlotDesc( slot ).optional )
+        return umf::Variant();
+
+    UMF_EXCEPTION(IncorrectParamException, "Field not found!");
+}
+
+size_t Metadata::getFieldSlot( const std::string& sFieldName ) const
+{
+    size_t slot;
+    if( !m_spDesc->getFieldSlot( sFieldName, slot ) )
     {
         UMF_EXCEPTION(IncorrectParamException, "Metadata field not found in metadata description" );
     }
+    return slot;
+}
 
-    if(fieldDesc.optional)
-        return umf::Variant();
+size_t Metadata::getSlotPosition( size_t slot ) const
+{
+    const Symbol& name = m_spDesc->getSlotName( slot );
 
-    UMF_EXCEPTION(IncorrectParamException, "Field not found!");
+    // Fields are usually set in the order of the description
+    if( slot < this->size() && (*this)[slot].getNameSymbol() == name )
+        return slot;
+
+    return findField( name ) - this->begin();
+}
+
+const FieldValue* Metadata::tryField( size_t slot ) const
+{
+    size_t position = getSlotPosition( slot );
+    return position < this->size() ? &(*this)[position] : nullptr;
+}
+
+const FieldValue& Metadata::field( size_t slot ) const
+{
+    const FieldValue* pValue = tryField( slot );
+    if( !pValue )
+        UMF_EXCEPTION(IncorrectParamException, "Field not found!");
+    return *pValue;
 }
 
 Metadata::iterator Metadata::findField( const std::string& sFieldName )
 {
-    return std::find_if( this->begin(), this->end(), [&]( umf::FieldValue& value )->bool 
+    return std::find_if( this->begin(), this->end(), [&]( umf::FieldValue& value )->bool
     {
         return sFieldName == value.getName();
     });
@@ -205,6 +237,22 @@ Metadata::const_iterator Metadata::findField(const std::string& sFieldName) cons
     });
 }
 
+Metadata::iterator Metadata::findField( const Symbol& name )
+{
+    return std::find_if( this->begin(), this->end(), [&]( umf::FieldValue& value )->bool
+    {
+        return name == value.getNameSymbol();
+    });
+}
+
+Metadata::const_iterator Metadata::findField( const Symbol& name ) const
+{
+    return std::find_if( this->begin(), this->end(), [&]( const umf::FieldValue& value )->bool
+    {
+        return name == value.getNameSymbol();
+    });
+}
+
 bool Metadata::operator == ( const Metadata& oMetadata ) const
 {
     if( this->m_Id == INVALID_ID && oMetadata.m_Id == INVALID_ID )
@@ -232,7 +280,7 @@ std::shared_ptr<Metadata> Metadata::getFirstReference( const std::string& sMetad
         auto spReference = it->getReferenceMetadata().lock();
         if (spReference != nullptr)
         {
-            if (spReference->getName() == sMetadataName)
+            if (spReference->getNameSymbol() == sMetadataName)
             {
                 // Found it, add into the list.
                 return spReference;
@@ -258,7 +306,7 @@ MetadataSet Metadata::getReferencesByMetadata(const std::string& sMetadataName)
             auto spMetadata = ref.getReferenceMetadata().lock();
             if (spMetadata != nullptr)
             {
-                if (spMetadata->getName() == sMetadataName)
+                if (spMetadata->getNameSymbol() == sMetadataName)
                 {
                     mdSet.emplace_back(spMetadata);
                 }
@@ -365,6 +413,9 @@ void Metadata::addReference(const std::shared_ptr<Metadata>& md, const std::stri
         m_vReferences.emplace_back(Reference(spRefDesc, md));
     }
 
+    if (m_pStream != nullptr)
+        m_pStream->onReferenceAdded(*this, md->getId(), refName);
+
     return;
 }
 
@@ -381,6 +432,8 @@ void Metadata::removeReference(const IdType& id, const std::string& refName)
             {
                 // Found reference
                 m_vReferences.erase(it);
+                if (m_pStream != nullptr)
+                    m_pStream->onReferenceRemoved(*this, id, refName);
                 break;
             }
         }
@@ -401,6 +454,8 @@ void Metadata::removeReference(const std::shared_ptr<Metadata>& md, const std::s
             if ((spMetadata == md) && (spDesc->name == refName))
             {
                 m_vReferences.erase(it);
+                if (m_pStream != nullptr)
+                    m_pStream->onReferenceRemoved(*this, md->getId(), refName);
                 break;
             }
         }
@@ -410,6 +465,11 @@ void Metadata::removeReference(const std::shared_ptr<Metadata>& md, const std::s
 }
 
 void Metadata::addValue( const umf::Variant& value )
+{
+    addValue( umf::Variant( value ));
+}
+
+void Metadata::addValue( umf::Variant&& value )
 {
     // Check field against description
     if( m_spDesc == nullptr )
@@ -429,10 +489,18 @@ void Metadata::addValue( const umf::Variant& value )
         UMF_EXCEPTION(TypeCastException, "Field type does not match!" );
     }
 
-    this->emplace_back( FieldValue( "", value ) );
+    this->emplace_back( Symbol(), std::move( value ) );
+
+    if( m_pStream )
+        m_pStream->onFieldChanged( *this, "" );
 }
 
 void Metadata::setFieldValue( const std::string& sFieldName, const umf::Variant& value )
+{
+    setFieldValue( sFieldName, umf::Variant( value ));
+}
+
+void Metadata::setFieldValue( const std::string& sFieldName, umf::Variant&& value )
 {
     // Check field against description
     if( m_spDesc == nullptr )
@@ -440,42 +508,30 @@ void Metadata::setFieldValue( const std::string& sFieldName, const umf::Variant&
         UMF_EXCEPTION(NullPointerException, "Metadata description object is missing!" );
     }
 
-    FieldDesc fieldDesc;
-    if( !m_spDesc->getFieldDesc( fieldDesc, sFieldName ) )
+    size_t slot = getFieldSlot( sFieldName );
+    const FieldDesc& fieldDesc = m_spDesc->getSlotDesc( slot );
+    const Symbol& name = m_spDesc->getSlotName( slot );
+
+    umf::Variant varNew( std::move( value ));
+    // If the field type is not the same, try to convert it to the right type
+    if( fieldDesc.type != varNew.getType() )
     {
-        UMF_EXCEPTION(IncorrectParamException, "Metadata field not found in metadata description" );
+        // This line may throw exception
+        varNew.convertTo( fieldDesc.type );
     }
 
-    iterator it = this->findField( sFieldName );
-
-    // Check field type
-    if( fieldDesc.type == value.getType() )
+    size_t position = getSlotPosition( slot );
+    if( position < this->size() )
     {
-        if( it != this->end() )
-        {
-            *it = umf::FieldValue( sFieldName, value );
-        }
-        else
-        {
-            this->emplace_back(sFieldName, value);
-        }
+        (*this)[position] = umf::FieldValue( name, std::move( varNew ) );
     }
-    // If the field type is not the same, try to convert it to the right type
     else
     {
-        umf::Variant varNew( value );
-        // This line may throw exception
-        varNew.convertTo( fieldDesc.type );
-
-        if( it != this->end() )
-        {
-            *it = umf::FieldValue( sFieldName, varNew );
-        }
-        else
-        {
-            this->emplace_back( FieldValue( sFieldName, varNew ) );
-        }
+        this->emplace_back( name, std::move( varNew ) );
     }
+
+    if( m_pStream )
+        m_pStream->onFieldChanged( *this, sFieldName );
 }
 
 void Metadata::validate() const
@@ -499,70 +555,93 @@ void Metadata::validate() const
     if( this->m_spDesc == nullptr )
         throw std::runtime_error( "Descriptor object was not found!" );
 
-    if(this->getEncryptedData().empty())
+    const MetadataDesc& desc = *m_spDesc;
+    const size_t nSlots = desc.m_vSlotTypes.size();
+
+    // One pass marks the slots having values, the errors found are reported below in the order of their priority
+    uint64_t localSeen[4] = {};
+    std::vector< uint64_t > vSeen;
+    uint64_t* pSeen = localSeen;
+    if( desc.m_vRequiredSlots.size() > 4 )
     {
-        auto fields = this->getDesc()->getFields();
-        for(auto f = fields.begin(); f != fields.end(); f++)
-            if( !f->optional && findField(f->name) == end() )
-                UMF_EXCEPTION(ValidateException,
-                              "All non-optional fields in a structure need to have not-empty field value!" );
+        vSeen.resize( desc.m_vRequiredSlots.size() );
+        pSeen = vSeen.data();
     }
 
-    if( nNumOfValues > 0 )
+    size_t nNumOfFieldNames = 0;
+    bool bDuplicate = false, bWrongType = false;
+    const FieldValue* pUnknown = nullptr;
+    for( size_t i = 0; i < nNumOfValues; i++ )
     {
-        std::vector< std::string > vNames = this->getFieldNames();
-        size_t nNumOfFieldNames = vNames.size();
+        const FieldValue& value = (*this)[i];
+        const Symbol& name = value.getNameSymbol();
+
+        // Fields are usually set in the order of the description
+        size_t slot = i;
+        if( slot >= nSlots || desc.m_vSlotNames[slot] != name )
+            for( slot = 0; slot < nSlots && desc.m_vSlotNames[slot] != name; slot++ );
 
-        // Structure item
-        if( nNumOfFieldNames > 0 )
+        if( !name.empty() )
         {
-            // Make sure the number of non-empty field names matches with the number of values
-            if( nNumOfValues != nNumOfFieldNames )
+            nNumOfFieldNames++;
+            if( slot == nSlots )
             {
-                UMF_EXCEPTION(ValidateException, "All fields in a structure need to have field names!" );
+                if( !pUnknown )
+                    pUnknown = &value;
+                continue;
             }
+            bDuplicate |= (pSeen[slot / 64] >> (slot % 64) & 1) != 0;
+            bWrongType |= desc.m_vSlotTypes[slot] != value.getType();
+        }
+        if( slot < nSlots )
+            pSeen[slot / 64] |= uint64_t( 1 ) << (slot % 64);
+    }
 
-            // Now check to see if there are duplicates in the name vector
-            std::vector< std::string > vUniqueNames = vNames;
-            std::sort( vUniqueNames.begin(), vUniqueNames.end() );
-            vUniqueNames.erase( std::unique( vUniqueNames.begin(), vUniqueNames.end()), vUniqueNames.end() );
-            if( vUniqueNames.size() < vNames.size() )
-                throw std::runtime_error( "A structure cannot have duplicate field names!" );
+    if( this->getEncryptedData().empty() )
+    {
+        for( size_t word = 0; word < desc.m_vRequiredSlots.size(); word++ )
+            if( desc.m_vRequiredSlots[word] & ~pSeen[word] )
+                UMF_EXCEPTION(ValidateException,
+                              "All non-optional fields in a structure need to have not-empty field value!" );
+    }
 
-            // Check field names and field types against field description property.
-            for (const auto& sFieldName : vUniqueNames)
-            {
-                FieldDesc field;
-                if( false == m_spDesc->getFieldDesc( field, sFieldName ))
-                {
-                    UMF_EXCEPTION(ValidateException, "Field specified[" + sFieldName + "] not found!" );
-                }
+    // Structure item
+    if( nNumOfFieldNames > 0 )
+    {
+        // Make sure the number of non-empty field names matches with the number of values
+        if( nNumOfValues != nNumOfFieldNames )
+        {
+            UMF_EXCEPTION(ValidateException, "All fields in a structure need to have field names!" );
+        }
 
-                umf::Variant varValue = this->getFieldValue( sFieldName );
-                if( field.type != varValue.getType() )
-                {
-                    UMF_EXCEPTION(ValidateException, "Field type does not match with the descriptor!" );
-                }
-            }
+        if( bDuplicate )
+            throw std::runtime_error( "A structure cannot have duplicate field names!" );
 
+        if( pUnknown )
+        {
+            UMF_EXCEPTION(ValidateException, "Field specified[" + pUnknown->getName() + "] not found!" );
         }
-        // Array and single item value
-        else if( nNumOfValues >= 1 )
+
+        if( bWrongType )
         {
-            FieldDesc field;
-            if( false == m_spDesc->getFieldDesc( field ))
-                throw std::runtime_error("Field descriptor is not for Array type.");
+            UMF_EXCEPTION(ValidateException, "Field type does not match with the descriptor!" );
+        }
+    }
+    // Array and single item value
+    else if( nNumOfValues >= 1 )
+    {
+        if( nSlots != 1 )
+            throw std::runtime_error("Field descriptor is not for Array type.");
 
-            umf::Variant::Type eFirstValueType = this->at( 0 ).getType();
-            if( field.type != eFirstValueType )
-                throw std::runtime_error( "Value type does not match with type specified in descriptor!" );
+        umf::Variant::Type eFirstValueType = (*this)[0].getType();
+        if( desc.m_vSlotTypes[0] != eFirstValueType )
+            throw std::runtime_error( "Value type does not match with type specified in descriptor!" );
 
-            for( size_t i = 1; i < nNumOfValues; i ++ )
+        for( size_t i = 1; i < nNumOfValues; i ++ )
+        {
+            if( (*this)[i].getType() != eFirstValueType )
             {
-                if( this->at( i ).getType() != eFirstValueType )
-                {
-                    UMF_EXCEPTION(ValidateException, "Metadata without field name should contain values of same type!" );
-                }
+                UMF_EXCEPTION(ValidateException, "Metadata without field name should contain values of same type!" );
             }
         }
     }
@@ -601,6 +680,11 @@ void Metadata::setEncryptedData(const std::string &encData)
     m_encryptedData = encData;
 }
 
+void Metadata::setEncryptedData(std::string&& encData)
+{
+    m_encryptedData = std::move(encData);
+}
+
 bool Metadata::isValid() const
 {
     bool bValid = true;
@@ -629,12 +713,18 @@ void Metadata::removeInvalidReferences()
     });
 
     if( setNew.size() < m_vReferences.size() )
+    {
         std::swap( setNew, m_vReferences );
+        if( m_pStream != nullptr )
+            m_pStream->onReferencesChanged( *this );
+    }
 }
 
 void Metadata::removeAllReferences()
 {
     m_vReferences.clear();
+    if( m_pStream != nullptr )
+        m_pStream->onReferencesChanged( *this );
 }
 
 void Metadata::setDescriptor( const std::shared_ptr< MetadataDesc >& spDescriptor )
@@ -642,7 +732,7 @@ void Metadata::setDescriptor( const std::shared_ptr< MetadataDesc >& spDescripto
     m_spDesc = spDescriptor;
 }
 
-void Metadata::setStreamRef(const MetadataStream* streamPtr)
+void Metadata::setStreamRef(MetadataStream* streamPtr)
 {
     m_pStream = streamPtr;
 }
@@ -0,0 +1,329 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "umf/metadatacolumns.hpp"
+
+#include <algorithm>
+
+namespace umf
+{
+
+//! Number of umf_real values per row, 0 for types stored otherwise
+static size_t realComponents( Variant::Type type )
+{
+    switch( type )
+    {
+    case Variant::type_real:  return 1;
+    case Variant::type_vec2d: return 2;
+    case Variant::type_vec3d: return 3;
+    case Variant::type_vec4d: return 4;
+    default:                  return 0;
+    }
+}
+
+template< typename T > static void insertAt( std::vector< T >& v, size_t pos, const T* values, size_t n )
+{
+    if( pos == v.size() / n )
+        v.insert( v.end(), values, values + n );
+    else
+        v.insert( v.begin() + pos * n, values, values + n );
+}
+
+template< typename T > static void eraseAt( std::vector< T >& v, size_t pos, size_t n )
+{
+    v.erase( v.begin() + pos * n, v.begin() + (pos + 1) * n );
+}
+
+MetadataColumns::MetadataColumns( const std::shared_ptr< MetadataDesc >& spDesc )
+    : m_spDesc( spDesc )
+{
+    if( !m_spDesc )
+        UMF_EXCEPTION(NullPointerException, "Metadata description is null." );
+    if( !isSupported( *m_spDesc ))
+        UMF_EXCEPTION(IncorrectParamException, "Metadata description '" + m_spDesc->getMetadataName() +
+                      "' can't be stored in columns" );
+
+    m_vColumns.resize( m_spDesc->getSlotCount() );
+    for( size_t slot = 0; slot < m_vColumns.size(); slot++ )
+    {
+        const FieldDesc& field = m_spDesc->getSlotDesc( slot );
+        Column& column = m_vColumns[slot];
+        column.type = field.type;
+        column.nComponents = field.type == Variant::type_integer ? 1 : realComponents( field.type );
+        column.optional = field.optional;
+    }
+}
+
+bool MetadataColumns::isSupported( const MetadataDesc& desc )
+{
+    if( desc.getUseEncryption() || desc.getSlotCount() == 0 )
+        return false;
+
+    for( size_t slot = 0; slot < desc.getSlotCount(); slot++ )
+    {
+        const FieldDesc& field = desc.getSlotDesc( slot );
+        if( field.useEncryption )
+            return false;
+        if( field.type != Variant::type_integer && realComponents( field.type ) == 0 )
+            return false;
+    }
+    return true;
+}
+
+void MetadataColumns::reserve( size_t nRows )
+{
+    m_vIds.reserve( nRows );
+    m_vFrameIndexes.reserve( nRows );
+    m_vNumsOfFrames.reserve( nRows );
+    m_vTimestamps.reserve( nRows );
+    m_vDurations.reserve( nRows );
+    for( auto& column : m_vColumns )
+    {
+        if( column.type == Variant::type_integer )
+            column.integers.reserve( nRows );
+        else
+            column.reals.reserve( nRows * column.nComponents );
+        if( column.optional )
+            column.present.reserve( nRows );
+    }
+}
+
+void MetadataColumns::check( const Metadata& md ) const
+{
+    const auto& spDesc = md.getDesc();
+    if( spDesc != m_spDesc && ( !spDesc || spDesc->getMetadataName() != m_spDesc->getMetadataName() ||
+        spDesc->getSchemaName() != m_spDesc->getSchemaName() ))
+        UMF_EXCEPTION(IncorrectParamException, "Metadata item has another description" );
+    if( !md.getAllReferences().empty() )
+        UMF_EXCEPTION(IncorrectParamException, "Metadata item stored in columns can't have references" );
+    if( md.getUseEncryption() || !md.getEncryptedData().empty() )
+        UMF_EXCEPTION(IncorrectParamException, "Metadata item stored in columns can't be encrypted" );
+
+    for( size_t slot = 0; slot < m_vColumns.size(); slot++ )
+    {
+        const FieldValue* pValue = md.tryField( slot );
+        if( pValue && ( pValue->getUseEncryption() || !pValue->getEncryptedData().empty() ))
+            UMF_EXCEPTION(IncorrectParamException, "Metadata item stored in columns can't be encrypted" );
+        if( pValue && pValue->getType() != m_vColumns[slot].type )
+            UMF_EXCEPTION(IncorrectParamException, "Field '" + m_spDesc->getSlotName( slot ).str() + "' has wrong type" );
+        if( !pValue && !m_vColumns[slot].optional )
+            UMF_EXCEPTION(IncorrectParamException, "Field '" + m_spDesc->getSlotName( slot ).str() + "' is missing" );
+    }
+
+    size_t row;
+    if( !m_vIds.empty() && m_vIds.back() >= md.getId() && find( md.getId(), row ))
+        UMF_EXCEPTION(IncorrectParamException, "Duplicated Metadata ID: " + to_string( md.getId() ));
+}
+
+void MetadataColumns::append( const Metadata& md )
+{
+    check( md );
+
+    // Items usually come in the order of their ids
+    IdType id = md.getId();
+    size_t row = m_vIds.size();
+    if( !m_vIds.empty() && m_vIds.back() > id )
+        row = std::lower_bound( m_vIds.begin(), m_vIds.end(), id ) - m_vIds.begin();
+
+    long long frameIndex = md.getFrameIndex(), numOfFrames = md.getNumOfFrames();
+    long long timestamp = md.getTime(), duration = md.getDuration();
+    insertAt( m_vIds, row, &id, 1 );
+    insertAt( m_vFrameIndexes, row, &frameIndex, 1 );
+    insertAt( m_vNumsOfFrames, row, &numOfFrames, 1 );
+    insertAt( m_vTimestamps, row, &timestamp, 1 );
+    insertAt( m_vDurations, row, &duration, 1 );
+
+    for( size_t slot = 0; slot < m_vColumns.size(); slot++ )
+    {
+        Column& column = m_vColumns[slot];
+        const Variant* pValue = md.tryField( slot );
+        if( column.optional )
+        {
+            unsigned char present = pValue ? 1 : 0;
+            insertAt( column.present, row, &present, 1 );
+        }
+
+        if( column.type == Variant::type_integer )
+        {
+            umf_integer value = pValue ? pValue->get_integer() : 0;
+            insertAt( column.integers, row, &value, 1 );
+            continue;
+        }
+
+        umf_real components[4] = { 0, 0, 0, 0 };
+        if( pValue )
+        {
+            switch( column.type )
+            {
+            case Variant::type_real:
+                components[0] = pValue->get_real();
+                break;
+            case Variant::type_vec2d:
+            {
+                const umf_vec2d& v = pValue->get_vec2d();
+                components[0] = v.x; components[1] = v.y;
+                break;
+            }
+            case Variant::type_vec3d:
+            {
+                const umf_vec3d& v = pValue->get_vec3d();
+                components[0] = v.x; components[1] = v.y; components[2] = v.z;
+                break;
+            }
+            default:
+            {
+                const umf_vec4d& v = pValue->get_vec4d();
+                components[0] = v.x; components[1] = v.y; components[2] = v.z; components[3] = v.w;
+                break;
+            }
+            }
+        }
+        insertAt( column.reals, row, components, column.nComponents );
+    }
+}
+
+bool MetadataColumns::remove( const IdType& id )
+{
+    size_t row;
+    if( !find( id, row ))
+        return false;
+
+    eraseAt( m_vIds, row, 1 );
+    eraseAt( m_vFrameIndexes, row, 1 );
+    eraseAt( m_vNumsOfFrames, row, 1 );
+    eraseAt( m_vTimestamps, row, 1 );
+    eraseAt( m_vDurations, row, 1 );
+    for( auto& column : m_vColumns )
+    {
+        if( column.optional )
+            eraseAt( column.present, row, 1 );
+        if( column.type == Variant::type_integer )
+            eraseAt( column.integers, row, 1 );
+        else
+            eraseAt( column.reals, row, column.nComponents );
+    }
+    return true;
+}
+
+void MetadataColumns::clear()
+{
+    m_vIds.clear();
+    m_vFrameIndexes.clear();
+    m_vNumsOfFrames.clear();
+    m_vTimestamps.clear();
+    m_vDurations.clear();
+    for( auto& column : m_vColumns )
+    {
+        column.integers.clear();
+        column.reals.clear();
+        column.present.clear();
+    }
+}
+
+bool MetadataColumns::find( const IdType& id, size_t& row ) const
+{
+    auto it = std::lower_bound( m_vIds.begin(), m_vIds.end(), id );
+    if( it == m_vIds.end() || *it != id )
+        return false;
+
+    row = it - m_vIds.begin();
+    return true;
+}
+
+std::shared_ptr< Metadata > MetadataColumns::materialize( size_t row ) const
+{
+    if( row >= m_vIds.size() )
+        UMF_EXCEPTION(OutOfRangeException, "Row is out of range" );
+
+    auto spMetadata = std::make_shared< Metadata >( m_spDesc );
+    spMetadata->setId( m_vIds[row] );
+    spMetadata->setFrameIndex( m_vFrameIndexes[row], m_vNumsOfFrames[row] );
+    spMetadata->setTimestamp( m_vTimestamps[row], m_vDurations[row] );
+
+    spMetadata->reserve( m_vColumns.size() );
+    Variant value;
+    for( size_t slot = 0; slot < m_vColumns.size(); slot++ )
+        if( getValue( row, slot, value ))
+            spMetadata->emplace_back( m_spDesc->getSlotName( slot ), value );
+
+    return spMetadata;
+}
+
+bool MetadataColumns::getValue( size_t row, size_t slot, Variant& value ) const
+{
+    if( row >= m_vIds.size() )
+        UMF_EXCEPTION(OutOfRangeException, "Row is out of range" );
+
+    const Column& column = getColumn( slot );
+    if( column.optional && !column.present[row] )
+        return false;
+
+    const umf_real* pReals = column.reals.data() + row * column.nComponents;
+    switch( column.type )
+    {
+    case Variant::type_integer:
+        value = Variant( column.integers[row] );
+        break;
+    case Variant::type_real:
+        value = Variant( pReals[0] );
+        break;
+    case Variant::type_vec2d:
+        value = Variant( umf_vec2d( pReals[0], pReals[1] ));
+        break;
+    case Variant::type_vec3d:
+        value = Variant( umf_vec3d( pReals[0], pReals[1], pReals[2] ));
+        break;
+    default:
+        value = Variant( umf_vec4d( pReals[0], pReals[1], pReals[2], pReals[3] ));
+        break;
+    }
+    return true;
+}
+
+size_t MetadataColumns::getComponents( size_t slot ) const
+{
+    return getColumn( slot ).nComponents;
+}
+
+ColumnSpan< umf_integer > MetadataColumns::integers( size_t slot ) const
+{
+    const Column& column = getColumn( slot );
+    if( column.type != Variant::type_integer )
+        UMF_EXCEPTION(TypeCastException, "Field '" + m_spDesc->getSlotName( slot ).str() + "' is not integer" );
+    return span( column.integers );
+}
+
+ColumnSpan< umf_real > MetadataColumns::reals( size_t slot ) const
+{
+    const Column& column = getColumn( slot );
+    if( column.type == Variant::type_integer )
+        UMF_EXCEPTION(TypeCastException, "Field '" + m_spDesc->getSlotName( slot ).str() + "' is neither real nor vector" );
+    return span( column.reals );
+}
+
+ColumnSpan< unsigned char > MetadataColumns::presence( size_t slot ) const
+{
+    return span( getColumn( slot ).present );
+}
+
+const MetadataColumns::Column& MetadataColumns::getColumn( size_t slot ) const
+{
+    if( slot >= m_vColumns.size() )
+        UMF_EXCEPTION(OutOfRangeException, "Slot is out of range" );
+    return m_vColumns[slot];
+}
+
+}
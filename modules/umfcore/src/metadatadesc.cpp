@@ -65,7 +65,9 @@ MetadataDesc::MetadataDesc( const std::string& sMetadataName, Variant::Type type
     }
 
     m_vFields.emplace_back( FieldDesc( "", type ) );
+    m_vSlotNames.emplace_back();
     m_vRefDesc.emplace_back(std::make_shared<ReferenceDesc>("", false));
+    compileValidator();
 }
 
 MetadataDesc::~MetadataDesc(void)
@@ -79,6 +81,11 @@ void MetadataDesc::validate()
         UMF_EXCEPTION(ValidateException, "Metadata name cannot be empty!" );
     }
 
+    m_vSlotNames.clear();
+    for( const auto& field : m_vFields )
+        m_vSlotNames.emplace_back( field.name );
+    compileValidator();
+
     // Check duplicate field names
     std::vector<std::string> vFieldNames;
     std::for_each( m_vFields.begin(), m_vFields.end(), [&]( FieldDesc field )
@@ -104,6 +111,18 @@ void MetadataDesc::validate()
     }
 }
 
+void MetadataDesc::compileValidator()
+{
+    m_vRequiredSlots.assign( (m_vFields.size() + 63) / 64, 0 );
+    m_vSlotTypes.clear();
+    for( size_t slot = 0; slot < m_vFields.size(); slot++ )
+    {
+        if( !m_vFields[slot].optional )
+            m_vRequiredSlots[slot / 64] |= uint64_t( 1 ) << (slot % 64);
+        m_vSlotTypes.push_back( m_vFields[slot].type );
+    }
+}
+
 std::string MetadataDesc::getMetadataName() const
 {
     return m_sMetadataName;
@@ -131,57 +150,58 @@ std::vector<FieldDesc> MetadataDesc::getFields() const
 
 bool MetadataDesc::getFieldDesc( FieldDesc& field, const std::string& sFieldName ) const
 {
-    bool bRet = false;
-
-    if( sFieldName.empty() )
-    {
-        if( m_vFields.size() == 1 )
-        {
-            field = m_vFields[0];
-            bRet = true;
-        }
-    }
-    else
-    {
-        auto it = std::find_if( m_vFields.begin(), m_vFields.end(), [&sFieldName]( FieldDesc fieldDesc )->bool
-        {
-            return fieldDesc.name == sFieldName;
-        });
-
-        if( it != m_vFields.end() )
-        {
-            field = *it;
-            bRet = true;
-        }
-    }
+    size_t slot;
+    if( !getFieldSlot( sFieldName, slot ) )
+        return false;
 
-    return bRet;
+    field = m_vFields[slot];
+    return true;
 }
 
 
 FieldDesc& MetadataDesc::getFieldDesc(const std::string &sFieldName)
+{
+    size_t slot;
+    if( !getFieldSlot( sFieldName, slot ) )
+        UMF_EXCEPTION(IncorrectParamException, "No field description found: \"" + sFieldName + "\"");
+
+    return m_vFields[slot];
+}
+
+bool MetadataDesc::getFieldSlot( const std::string& sFieldName, size_t& slot ) const
 {
     if( sFieldName.empty() )
     {
-        if( m_vFields.size() == 1 )
-        {
-            return m_vFields[0];
-        }
+        if( m_vFields.size() != 1 )
+            return false;
+        slot = 0;
+        return true;
     }
-    else
-    {
-        auto it = std::find_if( m_vFields.begin(), m_vFields.end(), [&sFieldName]( FieldDesc fieldDesc )->bool
-        {
-            return fieldDesc.name == sFieldName;
-        });
 
-        if( it != m_vFields.end() )
+    for( size_t i = 0; i < m_vFields.size(); i++ )
+        if( m_vFields[i].name == sFieldName )
         {
-            return *it;
+            slot = i;
+            return true;
         }
-    }
 
-    UMF_EXCEPTION(IncorrectParamException, "No field description found: \"" + sFieldName + "\"");
+    return false;
+}
+
+const FieldDesc& MetadataDesc::getSlotDesc( size_t slot ) const
+{
+    if( slot >= m_vFields.size() )
+        UMF_EXCEPTION(IncorrectParamException, "No field description found: slot " + to_string( slot ));
+
+    return m_vFields[slot];
+}
+
+const Symbol& MetadataDesc::getSlotName( size_t slot ) const
+{
+    if( slot >= m_vSlotNames.size() )
+        UMF_EXCEPTION(IncorrectParamException, "No field description found: slot " + to_string( slot ));
+
+    return m_vSlotNames[slot];
 }
 
 
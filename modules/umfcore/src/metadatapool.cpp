@@ -0,0 +1,94 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "umf/metadatapool.hpp"
+
+namespace umf
+{
+
+MetadataPool::MetadataPool( size_t nBlocksPerChunk )
+    : m_nBlocksPerChunk( nBlocksPerChunk ? nBlocksPerChunk : 1 ), m_nBlocks( 0 )
+{
+}
+
+MetadataPool::~MetadataPool()
+{
+    for( void* pChunk : m_chunks )
+        ::operator delete( pChunk );
+}
+
+void* MetadataPool::allocate( size_t nBytes )
+{
+    if( nBytes == 0 || nBytes > getMaxBlockSize() )
+        return ::operator new( nBytes );
+
+    size_t index = ( nBytes - 1 ) / nGranularity;
+    std::lock_guard< std::mutex > lock( m_mutex );
+    SizeClass& sizeClass = m_classes[index];
+    if( sizeClass.pFree )
+    {
+        FreeBlock* pBlock = sizeClass.pFree;
+        sizeClass.pFree = pBlock->pNext;
+        m_nBlocks++;
+        return pBlock;
+    }
+
+    size_t blockSize = ( index + 1 ) * nGranularity;
+    if( sizeClass.pNext == sizeClass.pEnd )
+    {
+        // Chunks are only added, m_chunks is grown before the allocation to stay consistent on failure
+        m_chunks.reserve( m_chunks.size() + 1 );
+        sizeClass.pNext = static_cast< char* >( ::operator new( blockSize * m_nBlocksPerChunk ));
+        sizeClass.pEnd = sizeClass.pNext + blockSize * m_nBlocksPerChunk;
+        m_chunks.push_back( sizeClass.pNext );
+    }
+    void* pBlock = sizeClass.pNext;
+    sizeClass.pNext += blockSize;
+    m_nBlocks++;
+    return pBlock;
+}
+
+void MetadataPool::deallocate( void* p, size_t nBytes )
+{
+    if( !p )
+        return;
+    if( nBytes == 0 || nBytes > getMaxBlockSize() )
+    {
+        ::operator delete( p );
+        return;
+    }
+
+    std::lock_guard< std::mutex > lock( m_mutex );
+    SizeClass& sizeClass = m_classes[( nBytes - 1 ) / nGranularity];
+    FreeBlock* pBlock = static_cast< FreeBlock* >( p );
+    pBlock->pNext = sizeClass.pFree;
+    sizeClass.pFree = pBlock;
+    m_nBlocks--;
+}
+
+size_t MetadataPool::getBlockCount() const
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    return m_nBlocks;
+}
+
+size_t MetadataPool::getChunkCount() const
+{
+    std::lock_guard< std::mutex > lock( m_mutex );
+    return m_chunks.size();
+}
+
+}
@@ -74,21 +74,29 @@ MetadataSet MetadataSet::queryByReference( std::function< bool( const std::share
 
 MetadataSet MetadataSet::queryByName( const std::string& sName ) const
 {
+    Symbol name;
+    if( !Symbol::find( sName, name ) )
+        return MetadataSet();
+
     MetadataSet set = query( [&]( const std::shared_ptr< Metadata >& spItem )->bool
     {
-        return ( spItem->getName() == sName );
+        return ( spItem->getNameSymbol() == name );
     });
 
     return set;
 }
 MetadataSet MetadataSet::queryByNameAndValue( const std::string& sMetadataName, const umf::FieldValue& value ) const
 {
+    Symbol name;
+    if( !Symbol::find( sMetadataName, name ) )
+        return MetadataSet();
+
     MetadataSet set = query([&](const std::shared_ptr< Metadata >& spItem)->bool
     {
-        if ((spItem->getName() != sMetadataName) || (spItem->size() == 0))
+        if ((spItem->getNameSymbol() != name) || (spItem->size() == 0))
             return false;
 
-        auto it = spItem->findField(value.getName());
+        auto it = spItem->findField(value.getNameSymbol());
         return ((it != spItem->end()) && (*it == value));
     });
 
@@ -97,14 +105,17 @@ MetadataSet MetadataSet::queryByNameAndValue( const std::string& sMetadataName,
 
 MetadataSet MetadataSet::queryByNameAndFields( const std::string& sMetadataName, const std::vector< umf::FieldValue>& vFields ) const
 {
+    Symbol name;
+    if( !Symbol::find( sMetadataName, name ) )
+        return MetadataSet();
+
     MetadataSet set = query( [&]( const std::shared_ptr< Metadata >& spItem )->bool
     {
-        if( spItem->getName() == sMetadataName && spItem->size() > 0 )
+        if( spItem->getNameSymbol() == name && spItem->size() > 0 )
         {
             auto itFailed = std::find_if( vFields.begin(), vFields.end(), [&]( const umf::FieldValue& value )->bool
             {
-                std::string sFieldName = value.getName();
-                auto it = spItem->findField( sFieldName );
+                auto it = spItem->findField( value.getNameSymbol() );
                 if( it == spItem->end() || *it != value )
                 {
                     // Found a field that does not exist, or the value is not the same
@@ -127,9 +138,13 @@ MetadataSet MetadataSet::queryByNameAndFields( const std::string& sMetadataName,
 
 MetadataSet MetadataSet::queryBySchema( const std::string& sSchemaName ) const
 {
+    Symbol name;
+    if( !Symbol::find( sSchemaName, name ) )
+        return MetadataSet();
+
     MetadataSet set = query( [&]( const std::shared_ptr< Metadata >& spItem )->bool
     {
-        return ( spItem->getSchemaName() == sSchemaName );
+        return ( spItem->getSchemaNameSymbol() == name );
     });
 
     return set;
@@ -206,7 +221,7 @@ MetadataSet MetadataSet::queryByReference( const std::string& sReferenceName, co
             {
                 auto itReference = std::find_if( referenceSet.begin(), referenceSet.end(), [&]( const std::shared_ptr< Metadata >& spReference )->bool
                 {
-                    auto it = spReference->findField( sFieldName );
+                    auto it = spReference->findField( value.getNameSymbol() );
                     if( it != spReference->end() && *it == value )
                     {
                         return true;
@@ -238,8 +253,7 @@ MetadataSet MetadataSet::queryByReference( const std::string& sReferenceName, co
                 {
                     auto itFailed = std::find_if( vFields.begin(), vFields.end(), [&]( const umf::FieldValue& value )->bool
                     {
-                        std::string sFieldName = value.getName();
-                        auto it = spReference->findField( sFieldName );
+                        auto it = spReference->findField( value.getNameSymbol() );
                         if( it == spReference->end() || *it != value )
                         {
                             // Found a field that does not exist, or the value is not the same
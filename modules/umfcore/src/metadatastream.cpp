@@ -18,20 +18,94 @@
 #include "umf/format.hpp"
 #include "datasource.hpp"
 #include "object_factory.hpp"
+#include "metadatastream_index.hpp"
+#include "query_planner.hpp"
+#include "rwlock.hpp"
 #include <algorithm>
 #include <stdexcept>
 #include <set>
+#include <limits>
+#include <cmath>
+#include <thread>
+#include <exception>
+#include <iterator>
+#include <unordered_set>
 
 #include <iostream>
 
 namespace umf
 {
+static bool isLessById( const std::shared_ptr<Metadata>& a, const std::shared_ptr<Metadata>& b )
+{
+    return a->getId() < b->getId();
+}
+
+//! Merges two sets ordered by id
+static MetadataSet mergeById( const MetadataSet& a, const MetadataSet& b )
+{
+    if( b.empty() )
+        return a;
+
+    MetadataSet set;
+    set.reserve( a.size() + b.size() );
+    std::merge( a.begin(), a.end(), b.begin(), b.end(), std::back_inserter( set ), isLessById );
+    return set;
+}
+
+//! Checks whether the row has any field, as an item without fields doesn't match field queries
+static bool hasValues( const MetadataColumns& columns, size_t row )
+{
+    for( size_t slot = 0; slot < columns.getDesc()->getSlotCount(); slot++ )
+    {
+        ColumnSpan< unsigned char > present = columns.presence( slot );
+        if( present.empty() || present[row] )
+            return true;
+    }
+    return false;
+}
+
+//! Brings the bounds to the field type, an integer range shrinks to the integers it contains
+static void toFieldRange( Variant::Type type, const Variant& lo, const Variant& hi, Variant& vLo, Variant& vHi )
+{
+    vLo = lo;
+    vHi = hi;
+    if( type == Variant::type_integer )
+    {
+        if( lo.getType() == Variant::type_real )
+            vLo = Variant( (umf_integer)std::ceil( lo.get_real() ));
+        if( hi.getType() == Variant::type_real )
+            vHi = Variant( (umf_integer)std::floor( hi.get_real() ));
+    }
+    else
+    {
+        if( lo.getType() == Variant::type_integer )
+            vLo = Variant( (umf_real)lo.get_integer() );
+        if( hi.getType() == Variant::type_integer )
+            vHi = Variant( (umf_real)hi.get_integer() );
+    }
+}
+
 MetadataStream::MetadataStream(void)
-    : m_eMode( InMemory ), dataSource(nullptr), nextId(0), m_sChecksumMedia(""),
+    : m_eMode( InMemory ), m_index( new Index ), m_bTrusted( false ), dataSource(nullptr), nextId(0), m_sChecksumMedia(""),
       m_useEncryption(false), m_encryptor(nullptr), m_hintEncryption("")
 {
 }
 
+MetadataStream::MetadataStream(const MetadataStream& other)
+    : m_eMode( other.m_eMode ), m_sFilePath( other.m_sFilePath ), m_oMetadataSet( other.m_oMetadataSet ),
+      m_mapMetadataById( other.m_mapMetadataById ), m_index( new Index( *other.m_index )),
+      m_spPool( other.m_spPool ), m_bTrusted( other.m_bTrusted ),
+      m_pendingReferences( other.m_pendingReferences ), m_mapSchemas( other.m_mapSchemas ),
+      removedSchemas( other.removedSchemas ), videoSegments( other.videoSegments ),
+      removedIds( other.removedIds ), addedIds( other.addedIds ), dataSource( other.dataSource ),
+      nextId( other.nextId ), m_sChecksumMedia( other.m_sChecksumMedia ),
+      m_useEncryption( other.m_useEncryption ), m_encryptor( other.m_encryptor ),
+      m_hintEncryption( other.m_hintEncryption ), m_stats( other.m_stats )
+{
+    for( const auto& spColumns : other.m_columns )
+        m_columns.push_back( std::make_shared< MetadataColumns >( *spColumns ));
+}
+
 MetadataStream::~MetadataStream(void)
 {
     close();
@@ -50,7 +124,11 @@ bool MetadataStream::open(const std::string& sFilePath, MetadataStream::OpenMode
             UMF_EXCEPTION(InternalErrorException, "Failed to get datasource instance. Possible, call of umf::initialize is missed");
         }
         //don't call clear(), reset exactly the things needed to be reset
+        for (auto& spItem : m_oMetadataSet)
+            if (spItem->m_pStream == this) spItem->setStreamRef(nullptr);
         m_oMetadataSet.clear();
+        m_mapMetadataById.clear();
+        m_index->clear();
         m_mapSchemas.clear();
         removedIds.clear();
         addedIds.clear();
@@ -82,6 +160,7 @@ bool MetadataStream::open(const std::string& sFilePath, MetadataStream::OpenMode
 
 bool MetadataStream::load( const std::string& sSchemaName )
 {
+    RWLock::ExclusiveGuard guard( m_lock.get() );
     dataSourceCheck();
     try
     {
@@ -111,6 +190,7 @@ bool MetadataStream::load( const std::string& sSchemaName )
 
 bool MetadataStream::load(const std::string& sSchemaName, const std::string& sMetadataName)
 {
+    RWLock::ExclusiveGuard guard( m_lock.get() );
     dataSourceCheck();
     try
     {
@@ -131,6 +211,7 @@ bool MetadataStream::load(const std::string& sSchemaName, const std::string& sMe
 
 bool MetadataStream::save(const umf_string &compressorId)
 {
+    RWLock::ExclusiveGuard guard( m_lock.get() );
     dataSourceCheck();
     try
     {
@@ -140,6 +221,7 @@ bool MetadataStream::save(const umf_string &compressorId)
             MetadataStream encryptedStream;
             encryptedStream.m_encryptor = m_encryptor;
             encryptedStream.m_oMetadataSet = MetadataSet(m_oMetadataSet);
+            encryptedStream.m_columns = m_columns;
             encryptedStream.m_mapSchemas = m_mapSchemas;
             encryptedStream.encrypt();
 
@@ -169,7 +251,7 @@ bool MetadataStream::save(const umf_string &compressorId)
 
             for(auto& p : m_mapSchemas)
             {
-                dataSource->saveSchema(p.second, encryptedStream.getAll());
+                dataSource->saveSchema(p.second, encryptedStream);
                 dataSource->save(p.second);
             }
 
@@ -226,6 +308,7 @@ bool MetadataStream::reopen( OpenMode eMode )
 
 bool MetadataStream::saveTo(const std::string& sFilePath, const umf_string& compressorId)
 {
+    RWLock::ExclusiveGuard guard( m_lock.get() );
     if((m_eMode & ReadOnly) || (m_eMode & Update))
         UMF_EXCEPTION(umf::IncorrectParamException, "The previous file has not been closed!");
 
@@ -277,68 +360,115 @@ void MetadataStream::close()
 
 std::shared_ptr< Metadata > MetadataStream::getById( const IdType& id ) const
 {
-    MetadataSet::const_iterator it = std::find_if( m_oMetadataSet.begin(), m_oMetadataSet.end(), [id]( const std::shared_ptr< Metadata >& spItem )->bool 
-    {
-        return spItem->getId() == id; 
-    });
+    RWLock::SharedGuard guard( m_lock.get() );
+    auto it = m_mapMetadataById.find( id );
+    if( it != m_mapMetadataById.end() )
+        return it->second;
 
-    if( it != m_oMetadataSet.end() )
-        return *it;
+    for( const auto& spColumns : m_columns )
+    {
+        size_t row;
+        if( spColumns->find( id, row ))
+            return spColumns->materialize( row );
+    }
 
     return nullptr;
 }
 
 IdType MetadataStream::add( std::shared_ptr< Metadata > spMetadata )
 {
+    RWLock::ExclusiveGuard guard( m_lock.get() );
     if( !this->getSchema(spMetadata->getDesc()->getSchemaName()) )
         UMF_EXCEPTION(umf::NotFoundException, "Metadata schema is not in the stream");
 
     IdType id = nextId++;
     spMetadata->setId(id);
     internalAdd(spMetadata);
-    addedIds.push_back(id);
+    addedIds.insert(id);
     return id;
 }
 
+//! Fills the fields of the item in the slot order of the description, string values and
+//! encrypted data are moved out of the item if bMoveValues is set
+static void setFields(Metadata& md, const MetadataDesc& desc, MetadataInternal& mdi, bool bMoveValues)
+{
+    md.reserve(mdi.fields.size());
+    size_t nFound = 0;
+    Variant val;
+    for (size_t slot = 0; slot < desc.getSlotCount() && nFound < mdi.fields.size(); slot++)
+    {
+        auto it = mdi.fields.find(desc.getSlotName(slot).str());
+        if (it == mdi.fields.end())
+            continue;
+        nFound++;
+
+        MetadataInternal::FieldInternal& field = it->second;
+        Variant::Type type = desc.getSlotDesc(slot).type;
+        if (bMoveValues && type == Variant::type_string)
+            val = std::move(field.value);
+        else
+            val.fromString(type, field.value);
+        md.emplace_back(desc.getSlotName(slot), std::move(val), field.useEncryption);
+        if (bMoveValues)
+            md.back().setEncryptedData(std::move(field.encryptedData));
+        else
+            md.back().setEncryptedData(field.encryptedData);
+    }
+
+    if (nFound < mdi.fields.size())
+    {
+        size_t slot;
+        for (const auto& field : mdi.fields)
+            if (!desc.getFieldSlot(field.first, slot))
+                UMF_EXCEPTION(IncorrectParamException, "Unknown Metadat field name: " + field.first);
+    }
+}
+
 IdType MetadataStream::add(MetadataInternal& mdi)
 {
+    return internalAdd(mdi, false);
+}
+
+IdType MetadataStream::add(MetadataInternal&& mdi)
+{
+    return internalAdd(mdi, true);
+}
+
+IdType MetadataStream::internalAdd(MetadataInternal& mdi, bool bMoveValues)
+{
+    RWLock::ExclusiveGuard guard( m_lock.get() );
     auto schema = getSchema(mdi.schemaName);
     if (!schema) UMF_EXCEPTION(umf::NotFoundException, "Unknown Metadata Schema: " + mdi.schemaName);
 
     auto desc = schema->findMetadataDesc(mdi.descName);
     if (!desc) UMF_EXCEPTION(umf::NotFoundException, "Unknown Metadata Description: " + mdi.descName);
 
+    bool bColumnar = findColumns(*desc) != nullptr;
+    if (bColumnar && !mdi.refs.empty())
+        UMF_EXCEPTION(IncorrectParamException, "Metadata stored in columns can't have references");
+
     if (mdi.id != INVALID_ID)
         if (!getById(mdi.id)) nextId = std::max(nextId, mdi.id + 1);
         else UMF_EXCEPTION(IncorrectParamException, "Duplicated Metadata ID: " + to_string(mdi.id));
     else
         mdi.id = nextId++;
 
-    auto spMd = std::make_shared<Metadata>(desc);
+    auto spMd = createMetadata(desc);
     spMd->setId(mdi.id);
-    FieldDesc fd;
-    Variant val;
-    for (const auto& f : mdi.fields)
-    {
-        if (desc->getFieldDesc(fd, f.first))
-        {
-            val.fromString(fd.type, f.second.value);
-            spMd->setFieldValue(f.first, val);
-            auto fieldIt = spMd->findField(f.first);
-            fieldIt->setUseEncryption(f.second.useEncryption);
-            fieldIt->setEncryptedData(f.second.encryptedData);
-        }
-        else
-            UMF_EXCEPTION(IncorrectParamException, "Unknown Metadat field name: " + f.first);
-    }
+    setFields(*spMd, *desc, mdi, bMoveValues);
     spMd->setFrameIndex(mdi.frameIndex, mdi.frameNum);
     spMd->setTimestamp(mdi.timestamp, mdi.duration);
 
     spMd->setUseEncryption(mdi.useEncryption);
-    spMd->setEncryptedData(mdi.encryptedData);
+    if (bMoveValues)
+        spMd->setEncryptedData(std::move(mdi.encryptedData));
+    else
+        spMd->setEncryptedData(mdi.encryptedData);
 
     internalAdd(spMd);
-    addedIds.push_back(spMd->getId());
+    addedIds.insert(spMd->getId());
+    if (bColumnar)
+        return mdi.id;
 
     if (!mdi.refs.empty())
     {
@@ -351,17 +481,179 @@ IdType MetadataStream::add(MetadataInternal& mdi)
                 m_pendingReferences[ref.first].push_back(std::make_pair(mdi.id, ref.second));
         }
     }
-    for (const auto& pendingId : m_pendingReferences[mdi.id])
-        getById(pendingId.first)->addReference(spMd, pendingId.second);
-
-    m_pendingReferences.erase(mdi.id);
+    auto itPending = m_pendingReferences.find(mdi.id);
+    if (itPending != m_pendingReferences.end())
+    {
+        for (const auto& pendingId : itPending->second)
+            getById(pendingId.first)->addReference(spMd, pendingId.second);
+        m_pendingReferences.erase(itPending);
+    }
 
     return mdi.id;
 }
 
+std::vector<IdType> MetadataStream::addBatch(std::vector<MetadataInternal>&& items, unsigned nValidationThreads)
+{
+    RWLock::ExclusiveGuard guard( m_lock.get() );
+    // Descriptions are resolved once per description
+    struct DescInfo
+    {
+        std::shared_ptr<MetadataDesc> spDesc;
+        bool bColumnar;
+    };
+    std::unordered_map<std::string, DescInfo> descs;
+
+    std::vector<IdType> vIds;
+    vIds.reserve(items.size());
+    MetadataSet batch;
+    batch.reserve(items.size());
+    std::unordered_set<IdType> batchIds;
+    batchIds.reserve(items.size());
+    IdType prevNextId = nextId;
+    try
+    {
+        const DescInfo* pInfo = nullptr;
+        const MetadataInternal* pPrev = nullptr;
+        for (auto& mdi : items)
+        {
+            // Items of a batch usually share the description, it's looked up when it changes
+            if (!pPrev || mdi.descName != pPrev->descName || mdi.schemaName != pPrev->schemaName)
+            {
+                auto itDesc = descs.find(mdi.schemaName + '\n' + mdi.descName);
+                if (itDesc == descs.end())
+                {
+                    auto schema = getSchema(mdi.schemaName);
+                    if (!schema) UMF_EXCEPTION(umf::NotFoundException, "Unknown Metadata Schema: " + mdi.schemaName);
+
+                    DescInfo info;
+                    info.spDesc = schema->findMetadataDesc(mdi.descName);
+                    if (!info.spDesc) UMF_EXCEPTION(umf::NotFoundException, "Unknown Metadata Description: " + mdi.descName);
+                    info.bColumnar = findColumns(*info.spDesc) != nullptr;
+                    itDesc = descs.emplace(mdi.schemaName + '\n' + mdi.descName, std::move(info)).first;
+                }
+                pInfo = &itDesc->second;
+            }
+            pPrev = &mdi;
+            const DescInfo& info = *pInfo;
+            if (info.bColumnar && !mdi.refs.empty())
+                UMF_EXCEPTION(IncorrectParamException, "Metadata stored in columns can't have references");
+            for (const auto& ref : mdi.refs)
+            {
+                size_t row;
+                for (const auto& spColumns : m_columns)
+                    if (spColumns->find(ref.first, row))
+                        UMF_EXCEPTION(IncorrectParamException, "Metadata stored in columns can't be referenced.");
+            }
+
+            if (mdi.id != INVALID_ID)
+            {
+                if (m_mapMetadataById.count(mdi.id) || (!m_columns.empty() && getById(mdi.id)) || !batchIds.insert(mdi.id).second)
+                    UMF_EXCEPTION(IncorrectParamException, "Duplicated Metadata ID: " + to_string(mdi.id));
+                nextId = std::max(nextId, mdi.id + 1);
+            }
+            else
+            {
+                mdi.id = nextId++;
+                batchIds.insert(mdi.id);
+            }
+
+            auto spMd = createMetadata(info.spDesc);
+            spMd->setId(mdi.id);
+            setFields(*spMd, *info.spDesc, mdi, true);
+            spMd->setFrameIndex(mdi.frameIndex, mdi.frameNum);
+            spMd->setTimestamp(mdi.timestamp, mdi.duration);
+
+            spMd->setUseEncryption(mdi.useEncryption);
+            spMd->setEncryptedData(std::move(mdi.encryptedData));
+
+            batch.push_back(spMd);
+            vIds.push_back(mdi.id);
+        }
+
+        internalAddBatch(batch, nValidationThreads);
+    }
+    catch (...)
+    {
+        nextId = prevNextId;
+        throw;
+    }
+    addedIds.insert(vIds.begin(), vIds.end());
+
+    // The whole batch is in the stream now, so only references to unknown items stay pending
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        for (const auto& ref : items[i].refs)
+        {
+            auto itRef = m_mapMetadataById.find(ref.first);
+            if (itRef != m_mapMetadataById.end())
+                batch[i]->addReference(itRef->second, ref.second);
+            else
+                m_pendingReferences[ref.first].push_back(std::make_pair(vIds[i], ref.second));
+        }
+    }
+    if (!m_pendingReferences.empty())
+    {
+        for (const auto& spMd : batch)
+        {
+            // Items stored in columns can't be referenced
+            if (spMd->m_pStream != this)
+                continue;
+            auto itPending = m_pendingReferences.find(spMd->getId());
+            if (itPending != m_pendingReferences.end())
+            {
+                for (const auto& pendingId : itPending->second)
+                    getById(pendingId.first)->addReference(spMd, pendingId.second);
+                m_pendingReferences.erase(itPending);
+            }
+        }
+    }
+
+    return vIds;
+}
+
+void MetadataStream::addBatch(MetadataSet&& items, unsigned nValidationThreads)
+{
+    RWLock::ExclusiveGuard guard( m_lock.get() );
+    std::unordered_set<const MetadataDesc*> checkedDescs;
+    for (const auto& spMetadata : items)
+    {
+        if (checkedDescs.insert(spMetadata->getDesc().get()).second &&
+            !this->getSchema(spMetadata->getDesc()->getSchemaName()))
+            UMF_EXCEPTION(umf::NotFoundException, "Metadata schema is not in the stream");
+    }
+
+    IdType prevNextId = nextId;
+    for (auto& spMetadata : items)
+        spMetadata->setId(nextId++);
+    try
+    {
+        internalAddBatch(items, nValidationThreads);
+    }
+    catch (...)
+    {
+        nextId = prevNextId;
+        for (auto& spMetadata : items)
+            spMetadata->setId(INVALID_ID);
+        throw;
+    }
+
+    for (const auto& spMetadata : items)
+        addedIds.insert(spMetadata->getId());
+}
+
 void MetadataStream::internalAdd(const std::shared_ptr<Metadata>& spMetadata)
 {
-    spMetadata->validate();
+    if (!m_bTrusted)
+        spMetadata->validate();
+
+    // The columns keep a copy, the item stays detached from the stream
+    if (MetadataColumns* pColumns = findColumns(*spMetadata->getDesc()))
+    {
+        pColumns->append(*spMetadata);
+        notifyStat(spMetadata);
+        return;
+    }
+
     spMetadata->setStreamRef(this);
 
     // Make sure all referenced metadata are from the same stream
@@ -371,65 +663,248 @@ void MetadataStream::internalAdd(const std::shared_ptr<Metadata>& spMetadata)
         if(spRef.getReferenceMetadata().lock()->m_pStream != this)
             UMF_EXCEPTION(IncorrectParamException, "Referenced metadata is from different metadata stream.");
     }
-    m_oMetadataSet.push_back(spMetadata);
+    insertItem(spMetadata);
 
     notifyStat(spMetadata);
 }
 
-bool MetadataStream::remove( const IdType& id )
+static void validateItems(const MetadataSet& items, unsigned nThreads)
 {
-    bool bRet = false;
+    if (nThreads == 0)
+        nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    nThreads = (unsigned)std::min<size_t>(nThreads, items.size());
 
-    // Locate the item in the vector
-    MetadataSet::iterator it = std::find_if( m_oMetadataSet.begin(), m_oMetadataSet.end(), [id]( const std::shared_ptr< Metadata >& spItem )->bool 
-    { 
-        return spItem->getId() == id; 
-    });
-
-    // Found it, let's remove it
-    if( it != m_oMetadataSet.end() )
+    if (nThreads <= 1)
     {
-        std::shared_ptr< Metadata > spMetadata = *it;
-
-        notifyStat(spMetadata, Stat::Action::Remove);
-
-        spMetadata->setStreamRef(nullptr);
-        m_oMetadataSet.erase( it );
+        for (const auto& spMetadata : items)
+            spMetadata->validate();
+        return;
+    }
 
-        // Also remove any reference to it. There might be other shared pointers pointing to this object, so that
-        // we cannot rely on weak_ptr being nullptr.
-        std::for_each( m_oMetadataSet.begin(), m_oMetadataSet.end(), [id]( std::shared_ptr< Metadata >& spItem )
+    // Each thread validates a contiguous chunk, the first failure in batch order is reported
+    size_t chunk = (items.size() + nThreads - 1) / nThreads;
+    std::vector<std::exception_ptr> errors(nThreads);
+    std::vector<std::thread> threads;
+    threads.reserve(nThreads);
+    for (unsigned t = 0; t < nThreads; t++)
+    {
+        threads.emplace_back([&items, &errors, chunk, t]()
         {
-            spItem->removeReference( id );
+            try
+            {
+                size_t end = std::min(items.size(), (t + 1) * chunk);
+                for (size_t i = t * chunk; i < end; i++)
+                    items[i]->validate();
+            }
+            catch (...)
+            {
+                errors[t] = std::current_exception();
+            }
         });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    for (auto& error : errors)
+        if (error)
+            std::rethrow_exception(error);
+}
 
-        auto addedItr = std::find(addedIds.begin(), addedIds.end(), id);
+void MetadataStream::internalAddBatch(const MetadataSet& items, unsigned nValidationThreads)
+{
+    if (!m_bTrusted)
+        validateItems(items, nValidationThreads);
 
-        if (addedItr == addedIds.end())
+    // Make sure all referenced metadata are from the same stream or from the batch itself
+    std::unordered_set<const Metadata*> batchItems;
+    for (const auto& spMetadata : items)
+        batchItems.insert(spMetadata.get());
+    std::vector<MetadataColumns*> itemColumns(items.size(), nullptr);
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        const auto& spMetadata = items[i];
+        if (!m_columns.empty() && (itemColumns[i] = findColumns(*spMetadata->getDesc())) != nullptr)
+            itemColumns[i]->check(*spMetadata);
+        for (auto& spRef : spMetadata->getAllReferences())
         {
-            removedIds.push_back(id);
+            auto spTarget = spRef.getReferenceMetadata().lock();
+            if (spTarget->m_pStream != this && !batchItems.count(spTarget.get()))
+                UMF_EXCEPTION(IncorrectParamException, "Referenced metadata is from different metadata stream.");
+            if (!m_columns.empty() && findColumns(*spTarget->getDesc()))
+                UMF_EXCEPTION(IncorrectParamException, "Metadata stored in columns can't be referenced.");
         }
-        else
+    }
+
+    m_oMetadataSet.reserve(m_oMetadataSet.size() + items.size());
+    m_mapMetadataById.reserve(m_mapMetadataById.size() + items.size());
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        if (itemColumns[i])
         {
-            addedIds.erase(addedItr);
+            itemColumns[i]->append(*items[i]);
+            continue;
         }
-
-        bRet = true;
+        items[i]->setStreamRef(this);
+        insertItem(items[i]);
     }
 
-    return bRet;
+    notifyStat(items);
+}
+
+void MetadataStream::insertItem(const std::shared_ptr<Metadata>& spMetadata)
+{
+    m_oMetadataSet.push_back(spMetadata);
+    m_mapMetadataById[spMetadata->getId()] = spMetadata;
+    m_index->add(spMetadata);
+}
+
+void MetadataStream::onTimeChanged(const Metadata& md)
+{
+    RWLock::ExclusiveGuard guard( m_lock.get() );
+    m_index->updateTime(md);
+}
+
+void MetadataStream::onFrameIndexChanged(const Metadata& md)
+{
+    RWLock::ExclusiveGuard guard( m_lock.get() );
+    m_index->updateFrames(md);
+}
+
+void MetadataStream::onFieldChanged(const Metadata& md, const std::string& sFieldName)
+{
+    RWLock::ExclusiveGuard guard( m_lock.get() );
+    m_index->updateField(md, sFieldName);
+    if (md.getDesc())
+        for (auto& stat : m_stats)
+            stat->onFieldChanged(*md.getDesc(), sFieldName);
+}
+
+void MetadataStream::onReferenceAdded(const Metadata& md, const IdType& id, const std::string& sRefName)
+{
+    RWLock::ExclusiveGuard guard( m_lock.get() );
+    m_index->addReference(md.getId(), id, sRefName);
+}
+
+void MetadataStream::onReferenceRemoved(const Metadata& md, const IdType& id, const std::string& sRefName)
+{
+    RWLock::ExclusiveGuard guard( m_lock.get() );
+    m_index->removeReference(md.getId(), id, sRefName);
+}
+
+void MetadataStream::onReferencesChanged(const Metadata& md)
+{
+    RWLock::ExclusiveGuard guard( m_lock.get() );
+    m_index->updateReferences(md);
+}
+
+bool MetadataStream::remove( const IdType& id )
+{
+    RWLock::ExclusiveGuard guard( m_lock.get() );
+    // Locate the item through the id index
+    auto itId = m_mapMetadataById.find( id );
+    if( itId == m_mapMetadataById.end() )
+        return removeRow( id );
+
+    MetadataSet items;
+    items.push_back( itId->second );
+    removeItems( std::move( items ));
+
+    return true;
 }
 
 void MetadataStream::remove( const MetadataSet& set )
 {
-    std::for_each( set.begin(), set.end(), [&]( const std::shared_ptr<Metadata>& spMetadata )
+    RWLock::ExclusiveGuard guard( m_lock.get() );
+    // Pick the items of the stream, each one once
+    std::unordered_set< IdType > ids;
+    ids.reserve( set.size() );
+    MetadataSet items;
+    items.reserve( set.size() );
+    for( const auto& spMetadata : set )
     {
-        this->remove( spMetadata->getId() );
-    });
+        auto itId = m_mapMetadataById.find( spMetadata->getId() );
+        if( itId != m_mapMetadataById.end() )
+        {
+            if( ids.insert( itId->first ).second )
+                items.push_back( itId->second );
+        }
+        else if( !m_columns.empty() )
+            removeRow( spMetadata->getId() );
+    }
+
+    if( !items.empty() )
+        removeItems( std::move( items ));
+}
+
+void MetadataStream::removeItems( MetadataSet&& items )
+{
+    std::unordered_set< IdType > ids;
+    ids.reserve( items.size() );
+    for( const auto& spMetadata : items )
+    {
+        ids.insert( spMetadata->getId() );
+        m_mapMetadataById.erase( spMetadata->getId() );
+        m_index->remove( *spMetadata );
+    }
+
+    // Compact the item list in a single pass, the remaining items keep their order
+    if( items.size() == 1 )
+    {
+        MetadataSet::iterator it = std::find( m_oMetadataSet.begin(), m_oMetadataSet.end(), items.front() );
+        if( it != m_oMetadataSet.end() )
+            m_oMetadataSet.erase( it );
+    }
+    else
+    {
+        m_oMetadataSet.erase( std::remove_if( m_oMetadataSet.begin(), m_oMetadataSet.end(), [&]( const std::shared_ptr< Metadata >& spItem )
+        {
+            return ids.count( spItem->getId() ) != 0;
+        }), m_oMetadataSet.end() );
+    }
+
+    for( const auto& spMetadata : items )
+    {
+        IdType id = spMetadata->getId();
+        spMetadata->setStreamRef( nullptr );
+
+        // Also remove any reference to it. There might be other shared pointers pointing to this object, so that
+        // we cannot rely on weak_ptr being nullptr. Only the remaining items actually referencing it are visited.
+        if( const Index::Edges* pReferrers = m_index->findReferrers( id ))
+        {
+            Index::Edges referrers( *pReferrers );
+            for( const auto& referrer : referrers )
+            {
+                auto itReferrer = m_mapMetadataById.find( referrer.first );
+                if( itReferrer != m_mapMetadataById.end() )
+                    itReferrer->second->removeReference( id, referrer.second );
+            }
+            m_index->dropReferrers( id );
+        }
+
+        if( addedIds.erase( id ) == 0 )
+            removedIds.push_back( id );
+    }
+
+    // References of the removed items still waiting for their target are dropped
+    if( !m_pendingReferences.empty() )
+    {
+        for( auto itPending = m_pendingReferences.begin(); itPending != m_pendingReferences.end(); )
+        {
+            auto& referrers = itPending->second;
+            referrers.erase( std::remove_if( referrers.begin(), referrers.end(), [&]( const std::pair< IdType, std::string >& referrer )
+            {
+                return ids.count( referrer.first ) != 0;
+            }), referrers.end() );
+            itPending = referrers.empty() ? m_pendingReferences.erase( itPending ) : std::next( itPending );
+        }
+    }
+
+    // The statistics take the removed items over
+    notifyStat( std::move( items ), Stat::Action::Remove );
 }
 
 void MetadataStream::remove(std::shared_ptr< MetadataSchema > spSchema)
 {
+    RWLock::ExclusiveGuard guard( m_lock.get() );
     if( spSchema == nullptr )
     {
         UMF_EXCEPTION(NullPointerException, "Metadata Schema is null." );
@@ -449,6 +924,10 @@ void MetadataStream::remove(std::shared_ptr< MetadataSchema > spSchema)
 
     auto items = this->queryBySchema(sSchemaName);
     remove(items);
+    m_columns.erase(std::remove_if(m_columns.begin(), m_columns.end(), [&](const std::shared_ptr<MetadataColumns>& spColumns)
+    {
+        return spColumns->getDesc()->getSchemaName() == sSchemaName;
+    }), m_columns.end());
 
     auto removedItr = m_mapSchemas.find(sSchemaName);
 
@@ -460,14 +939,17 @@ void MetadataStream::remove(std::shared_ptr< MetadataSchema > spSchema)
 
 void MetadataStream::remove()
 {
+    RWLock::ExclusiveGuard guard( m_lock.get() );
     std::shared_ptr<umf::MetadataSchema> emptySchema;
     removedSchemas[""] = emptySchema;
     this->remove(this->getAll());
     m_mapSchemas.clear();
+    m_columns.clear();
 }
 
 void MetadataStream::addSchema( std::shared_ptr< MetadataSchema > spSchema )
 {
+    RWLock::ExclusiveGuard guard( m_lock.get() );
     if( spSchema == nullptr )
     {
         UMF_EXCEPTION(NullPointerException, "Metadata Schema is null." );
@@ -490,6 +972,7 @@ void MetadataStream::addSchema( std::shared_ptr< MetadataSchema > spSchema )
 
 const std::shared_ptr< MetadataSchema > MetadataStream::getSchema( const std::string& sSchemaName ) const
 {
+    RWLock::SharedGuard guard( m_lock.get() );
     auto it = m_mapSchemas.find( sSchemaName );
     if( it != m_mapSchemas.end())
         return it->second;
@@ -499,6 +982,7 @@ const std::shared_ptr< MetadataSchema > MetadataStream::getSchema( const std::st
 
 std::vector< std::string > MetadataStream::getAllSchemaNames() const
 {
+    RWLock::SharedGuard guard( m_lock.get() );
     std::vector< std::string > vAllSchemaNames;
 
     std::for_each( m_mapSchemas.begin(), m_mapSchemas.end(), [&]( const std::pair< std::string, std::shared_ptr< MetadataSchema >>& pair )
@@ -509,6 +993,160 @@ std::vector< std::string > MetadataStream::getAllSchemaNames() const
     return vAllSchemaNames;
 }
 
+void MetadataStream::setColumnar( const std::string& sSchemaName, const std::string& sMetadataName )
+{
+    RWLock::ExclusiveGuard guard( m_lock.get() );
+    auto spSchema = getSchema( sSchemaName );
+    if( !spSchema )
+        UMF_EXCEPTION(NotFoundException, "Unknown Metadata Schema: " + sSchemaName );
+    auto spDesc = spSchema->findMetadataDesc( sMetadataName );
+    if( !spDesc )
+        UMF_EXCEPTION(NotFoundException, "Unknown Metadata Description: " + sMetadataName );
+    if( findColumns( *spDesc ))
+        return;
+    if( spSchema->getUseEncryption() )
+        UMF_EXCEPTION(IncorrectParamException, "Metadata of encrypted schema can't be stored in columns" );
+
+    auto spColumns = std::make_shared< MetadataColumns >( spDesc );
+
+    // Copy the items of the description first, so that the stream is unchanged if one of them doesn't fit
+    MetadataSet items = viewBySchemaAndName( sSchemaName, sMetadataName ).materialize();
+    spColumns->reserve( items.size() );
+    for( const auto& spItem : items )
+    {
+        const Index::Edges* pReferrers = m_index->findReferrers( spItem->getId() );
+        if( pReferrers && !pReferrers->empty() )
+            UMF_EXCEPTION(IncorrectParamException, "Referenced metadata can't be stored in columns" );
+        spColumns->append( *spItem );
+    }
+
+    if( !items.empty() )
+    {
+        std::unordered_set< const Metadata* > moved;
+        for( const auto& spItem : items )
+        {
+            moved.insert( spItem.get() );
+            m_mapMetadataById.erase( spItem->getId() );
+            m_index->remove( *spItem );
+            spItem->setStreamRef( nullptr );
+        }
+        m_oMetadataSet.erase( std::remove_if( m_oMetadataSet.begin(), m_oMetadataSet.end(), [&]( const std::shared_ptr< Metadata >& spItem )
+        {
+            return moved.count( spItem.get() ) != 0;
+        }), m_oMetadataSet.end() );
+    }
+
+    m_columns.push_back( spColumns );
+}
+
+std::shared_ptr< const MetadataColumns > MetadataStream::getColumns( const std::string& sSchemaName, const std::string& sMetadataName ) const
+{
+    RWLock::SharedGuard guard( m_lock.get() );
+    for( const auto& spColumns : m_columns )
+        if( spColumns->getDesc()->getSchemaName() == sSchemaName && spColumns->getDesc()->getMetadataName() == sMetadataName )
+            return spColumns;
+
+    return nullptr;
+}
+
+MetadataColumns* MetadataStream::findColumns( const MetadataDesc& desc ) const
+{
+    for( const auto& spColumns : m_columns )
+    {
+        const MetadataDesc& columnsDesc = *spColumns->getDesc();
+        if( &columnsDesc == &desc || ( columnsDesc.getMetadataName() == desc.getMetadataName() &&
+                                       columnsDesc.getSchemaName() == desc.getSchemaName() ))
+            return spColumns.get();
+    }
+    return nullptr;
+}
+
+//! Checks whether the columns hold items of the schema and the name, null names match any
+static bool isColumnsOf( const MetadataColumns& columns, const std::string* pSchemaName, const std::string* pName )
+{
+    return ( !pSchemaName || columns.getDesc()->getSchemaName() == *pSchemaName ) &&
+           ( !pName || columns.getDesc()->getMetadataName() == *pName );
+}
+
+bool MetadataStream::hasRows( const std::string* pSchemaName, const std::string* pName ) const
+{
+    for( const auto& spColumns : m_columns )
+        if( !spColumns->empty() && isColumnsOf( *spColumns, pSchemaName, pName ))
+            return true;
+    return false;
+}
+
+MetadataSet MetadataStream::getRows( const std::string* pSchemaName, const std::string* pName, const RowSelector& select ) const
+{
+    MetadataSet set;
+    size_t nColumns = 0;
+    std::vector< size_t > rows;
+    for( const auto& spColumns : m_columns )
+    {
+        if( spColumns->empty() || !isColumnsOf( *spColumns, pSchemaName, pName ))
+            continue;
+
+        rows.clear();
+        if( select )
+            select( *spColumns, rows );
+        else
+            for( size_t row = 0; row < spColumns->size(); row++ )
+                rows.push_back( row );
+        if( rows.empty() )
+            continue;
+
+        nColumns++;
+        set.reserve( set.size() + rows.size() );
+        for( size_t row : rows )
+            set.push_back( spColumns->materialize( row ));
+    }
+
+    // Rows of each columns are ordered by id already
+    if( nColumns > 1 )
+        std::sort( set.begin(), set.end(), isLessById );
+    return set;
+}
+
+MetadataView MetadataStream::withRows( const MetadataView& view, const std::string* pSchemaName, const std::string* pName, const RowSelector& select ) const
+{
+    if( !hasRows( pSchemaName, pName ))
+        return view;
+
+    MetadataSet rows = getRows( pSchemaName, pName, select );
+    if( rows.empty() )
+        return view;
+    return MetadataView( mergeById( view.materialize(), rows ));
+}
+
+MetadataSet MetadataStream::getAllItems() const
+{
+    if( !hasRows( nullptr, nullptr ))
+        return m_oMetadataSet;
+
+    MetadataSet set( m_oMetadataSet );
+    MetadataSet rows = getRows( nullptr, nullptr );
+    set.insert( set.end(), rows.begin(), rows.end() );
+    return set;
+}
+
+bool MetadataStream::removeRow( const IdType& id )
+{
+    for( const auto& spColumns : m_columns )
+    {
+        size_t row;
+        if( !spColumns->find( id, row ))
+            continue;
+
+        if( !m_stats.empty() )
+            notifyStat( spColumns->materialize( row ), Stat::Action::Remove );
+        spColumns->remove( id );
+        if( addedIds.erase( id ) == 0 )
+            removedIds.push_back( id );
+        return true;
+    }
+    return false;
+}
+
 std::shared_ptr<Metadata> MetadataStream::import( MetadataStream& srcStream, std::shared_ptr< Metadata >& spMetadata, std::map< IdType, IdType >& mapIds, long long nTarFrameIndex, long long nSrcFrameIndex, long long nNumOfFrames )
 {
     auto nSrcMetadataId = spMetadata->getId();
@@ -569,6 +1207,7 @@ std::shared_ptr<Metadata> MetadataStream::import( MetadataStream& srcStream, std
 
 bool MetadataStream::import( MetadataStream& srcStream, MetadataSet& srcSet, long long nTarFrameIndex, long long nSrcFrameIndex, long long nNumOfFrames, MetadataSet* pSetFailure )
 {
+    RWLock::ExclusiveGuard guard( m_lock.get() );
     // Find all schemes used by the source metadata set
     std::vector< std::string > vSchemaNames;
     std::for_each( srcSet.begin(), srcSet.end(), [&vSchemaNames]( std::shared_ptr<Metadata>& spMetadata )
@@ -613,10 +1252,16 @@ bool MetadataStream::import( MetadataStream& srcStream, MetadataSet& srcSet, lon
 
 void MetadataStream::clear()
 {
+    RWLock::ExclusiveGuard guard( m_lock.get() );
     m_eMode = InMemory;
     m_sFilePath = "";
     m_useEncryption = false;
+    for (auto& spItem : m_oMetadataSet)
+        if (spItem->m_pStream == this) spItem->setStreamRef(nullptr);
     m_oMetadataSet.clear();
+    m_mapMetadataById.clear();
+    m_index->clear();
+    m_columns.clear();
     m_mapSchemas.clear();
     removedIds.clear();
     addedIds.clear();
@@ -636,65 +1281,537 @@ void MetadataStream::dataSourceCheck()
 
 MetadataSet MetadataStream::getAll() const
 {
-    return m_oMetadataSet;
+    RWLock::SharedGuard guard( m_lock.get() );
+    return getAllItems();
 }
 
 MetadataSet MetadataStream::query( std::function< bool( const std::shared_ptr<Metadata>& spMetadata )> filter ) const
 {
-    return m_oMetadataSet.query( filter );
+    RWLock::SharedGuard guard( m_lock.get() );
+    MetadataSet set = m_oMetadataSet.query( filter );
+    if( hasRows( nullptr, nullptr ))
+    {
+        MetadataSet rows = getRows( nullptr, nullptr ).query( filter );
+        set.insert( set.end(), rows.begin(), rows.end() );
+    }
+    return set;
 }
 
 MetadataSet MetadataStream::queryByReference( std::function< bool( const std::shared_ptr<Metadata>& spMetadata, const std::shared_ptr<Metadata>& spReference )> filter ) const
 {
+    RWLock::SharedGuard guard( m_lock.get() );
     return m_oMetadataSet.queryByReference( filter );
 }
 MetadataSet MetadataStream::queryByName( const std::string& sName ) const
 {
-    return m_oMetadataSet.queryByName( sName );
+    RWLock::SharedGuard guard( m_lock.get() );
+    return viewByName( sName ).materialize();
 }
 
 MetadataSet MetadataStream::queryBySchema( const std::string& sSchemaName ) const
 {
-    return m_oMetadataSet.queryBySchema( sSchemaName );
+    RWLock::SharedGuard guard( m_lock.get() );
+    return viewBySchema( sSchemaName ).materialize();
+}
+
+MetadataSet MetadataStream::queryBySchemaAndName( const std::string& sSchemaName, const std::string& sName ) const
+{
+    RWLock::SharedGuard guard( m_lock.get() );
+    return viewBySchemaAndName( sSchemaName, sName ).materialize();
 }
 
 MetadataSet MetadataStream::queryByFrameIndex( size_t index ) const
 {
-    return m_oMetadataSet.queryByFrameIndex( index );
+    RWLock::SharedGuard guard( m_lock.get() );
+    return viewByFrameIndex( index ).materialize();
 }
 
 MetadataSet MetadataStream::queryByTime( long long startTime, long long endTime ) const
 {
-    return m_oMetadataSet.queryByTime(startTime, endTime);
+    RWLock::SharedGuard guard( m_lock.get() );
+    return viewByTime( startTime, endTime ).materialize();
+}
+
+MetadataView MetadataStream::view() const
+{
+    RWLock::SharedGuard guard( m_lock.get() );
+    if( hasRows( nullptr, nullptr ))
+        return MetadataView( getAllItems() );
+    return MetadataView( m_oMetadataSet.data(), m_oMetadataSet.data() + m_oMetadataSet.size() );
+}
+
+MetadataView MetadataStream::viewByName( const std::string& sName ) const
+{
+    RWLock::SharedGuard guard( m_lock.get() );
+    const Index::Bucket* pFirst = nullptr;
+    MetadataView::ItemList items;
+    for( const auto& schema : m_index->schemas )
+    {
+        auto itDesc = schema.second.descs.find( sName );
+        if( itDesc == schema.second.descs.end() )
+            continue;
+
+        if( !pFirst )
+        {
+            pFirst = &itDesc->second.items;
+            continue;
+        }
+
+        // Items of the same name come from several schemas, merge them by id
+        if( items.empty() )
+            for( const auto& item : *pFirst )
+                items.push_back( &item.second );
+        for( const auto& item : itDesc->second.items )
+            items.push_back( &item.second );
+    }
+
+    MetadataView view = pFirst ? MetadataView( *pFirst ) : MetadataView();
+    if( !items.empty() )
+    {
+        std::sort( items.begin(), items.end(), []( const std::shared_ptr<Metadata>* a, const std::shared_ptr<Metadata>* b )
+        {
+            return (*a)->getId() < (*b)->getId();
+        });
+        view = MetadataView( std::move( items ));
+    }
+
+    return withRows( view, nullptr, &sName );
+}
+
+MetadataView MetadataStream::viewBySchema( const std::string& sSchemaName ) const
+{
+    RWLock::SharedGuard guard( m_lock.get() );
+    const Index::Bucket* pBucket = m_index->findSchema( sSchemaName );
+    return withRows( pBucket ? MetadataView( *pBucket ) : MetadataView(), &sSchemaName, nullptr );
+}
+
+MetadataView MetadataStream::viewBySchemaAndName( const std::string& sSchemaName, const std::string& sName ) const
+{
+    RWLock::SharedGuard guard( m_lock.get() );
+    const Index::DescBucket* pDesc = m_index->findDesc( sSchemaName, sName );
+    return withRows( pDesc ? MetadataView( pDesc->items ) : MetadataView(), &sSchemaName, &sName );
+}
+
+MetadataView MetadataStream::viewByFrameIndex( size_t index ) const
+{
+    RWLock::SharedGuard guard( m_lock.get() );
+    if( index > (size_t)std::numeric_limits<long long>::max() )
+        return MetadataView();
+
+    long long frame = (long long)index;
+    std::vector< IdType > vIds;
+    m_index->frames.query( frame, frame, vIds );
+
+    return withRows( viewByIds( vIds ), nullptr, nullptr, [frame]( const MetadataColumns& columns, std::vector< size_t >& rows )
+    {
+        ColumnSpan< long long > frames = columns.frameIndexes(), counts = columns.numsOfFrames();
+        for( size_t row = 0; row < frames.size(); row++ )
+            if( frames[row] >= 0 && frames[row] <= frame && frame - frames[row] < counts[row] )
+                rows.push_back( row );
+    });
+}
+
+MetadataView MetadataStream::viewByTime( long long startTime, long long endTime ) const
+{
+    RWLock::SharedGuard guard( m_lock.get() );
+    std::vector< IdType > vIds;
+    m_index->time.query( startTime, endTime, vIds );
+
+    return withRows( viewByIds( vIds ), nullptr, nullptr, [startTime, endTime]( const MetadataColumns& columns, std::vector< size_t >& rows )
+    {
+        ColumnSpan< long long > times = columns.timestamps(), durations = columns.durations();
+        for( size_t row = 0; row < times.size(); row++ )
+            if( times[row] >= 0 && times[row] + durations[row] >= startTime && times[row] <= endTime )
+                rows.push_back( row );
+    });
+}
+
+MetadataSet MetadataStream::getByIds( std::vector< IdType >& vIds ) const
+{
+    return viewByIds( vIds ).materialize();
+}
+
+MetadataView MetadataStream::viewByIds( std::vector< IdType >& vIds ) const
+{
+    // Report items ordered by their identifiers, each item once
+    std::sort( vIds.begin(), vIds.end() );
+    vIds.erase( std::unique( vIds.begin(), vIds.end() ), vIds.end() );
+
+    MetadataView::ItemList items;
+    items.reserve( vIds.size() );
+    for( auto id : vIds )
+    {
+        auto it = m_mapMetadataById.find( id );
+        if( it != m_mapMetadataById.end() )
+            items.push_back( &it->second );
+    }
+
+    return MetadataView( std::move( items ));
 }
 
 MetadataSet MetadataStream::queryByNameAndValue( const std::string& sMetadataName, const umf::FieldValue& value ) const
 {
-    return m_oMetadataSet.queryByNameAndValue( sMetadataName, value );
+    RWLock::SharedGuard guard( m_lock.get() );
+    return queryByNameAndFields( sMetadataName, std::vector< umf::FieldValue >( 1, value ));
 }
 
 MetadataSet MetadataStream::queryByNameAndFields( const std::string& sMetadataName, const std::vector< umf::FieldValue>& vFields ) const
 {
-    return m_oMetadataSet.queryByNameAndFields( sMetadataName, vFields );
+    RWLock::SharedGuard guard( m_lock.get() );
+    auto isMatched = [&]( const Metadata& md )->bool
+    {
+        if( md.size() == 0 )
+            return false;
+
+        for( const auto& value : vFields )
+        {
+            auto it = md.findField( value.getNameSymbol() );
+            if( it == md.end() || *it != value )
+                return false;
+        }
+        return true;
+    };
+
+    std::vector< IdType > vIds;
+    for( const auto& schema : m_index->schemas )
+    {
+        auto itDesc = schema.second.descs.find( sMetadataName );
+        if( itDesc == schema.second.descs.end() )
+            continue;
+        const Index::DescBucket& desc = itDesc->second;
+
+        // Take the smallest set of candidates provided by the indexed fields
+        std::vector< IdType > vCandidates;
+        bool bIndexed = false;
+        for( const auto& value : vFields )
+        {
+            auto itField = desc.fields.find( value.getName() );
+            std::vector< IdType > vFieldIds;
+            if( itField != desc.fields.end() && itField->second.findEqual( value, vFieldIds ))
+            {
+                if( !bIndexed || vFieldIds.size() < vCandidates.size() )
+                    vCandidates.swap( vFieldIds );
+                bIndexed = true;
+                if( vCandidates.empty() )
+                    break;
+            }
+        }
+
+        if( bIndexed )
+        {
+            for( auto id : vCandidates )
+                if( isMatched( *desc.items.at( id )))
+                    vIds.push_back( id );
+        }
+        else
+        {
+            for( const auto& item : desc.items )
+                if( isMatched( *item.second ))
+                    vIds.push_back( item.first );
+        }
+    }
+
+    if( !hasRows( nullptr, &sMetadataName ))
+        return getByIds( vIds );
+
+    return mergeById( getByIds( vIds ), getRows( nullptr, &sMetadataName, [&]( const MetadataColumns& columns, std::vector< size_t >& rows )
+    {
+        std::vector< size_t > slots;
+        for( const auto& value : vFields )
+        {
+            size_t slot;
+            if( value.getUseEncryption() || !columns.getDesc()->getFieldSlot( value.getName(), slot ))
+                return;
+            slots.push_back( slot );
+        }
+
+        Variant fieldValue;
+        for( size_t row = 0; row < columns.size(); row++ )
+        {
+            bool bMatched = hasValues( columns, row );
+            for( size_t i = 0; bMatched && i < slots.size(); i++ )
+                bMatched = columns.getValue( row, slots[i], fieldValue ) && fieldValue == vFields[i];
+            if( bMatched )
+                rows.push_back( row );
+        }
+    }));
+}
+
+MetadataSet MetadataStream::queryByNameAndRange( const std::string& sMetadataName, const std::string& sFieldName, const Variant& lo, const Variant& hi ) const
+{
+    RWLock::SharedGuard guard( m_lock.get() );
+    if( !FieldIndex::isOrderedType( lo.getType() ) || !FieldIndex::isOrderedType( hi.getType() ))
+        UMF_EXCEPTION( IncorrectParamException, "Range bounds should be integer or real values" );
+
+    std::vector< IdType > vIds;
+    for( const auto& schema : m_index->schemas )
+    {
+        auto itDesc = schema.second.descs.find( sMetadataName );
+        if( itDesc == schema.second.descs.end() )
+            continue;
+        const Index::DescBucket& desc = itDesc->second;
+
+        // All items of a bucket share the description, so its field type applies to the whole bucket
+        FieldDesc fieldDesc;
+        const auto& spDesc = desc.items.begin()->second->getDesc();
+        if( !spDesc || !spDesc->getFieldDesc( fieldDesc, sFieldName ))
+            continue;
+        if( !FieldIndex::isOrderedType( fieldDesc.type ))
+            UMF_EXCEPTION( IncorrectParamException, "Field '" + sFieldName + "' is neither integer nor real" );
+
+        Variant vLo, vHi;
+        toFieldRange( fieldDesc.type, lo, hi, vLo, vHi );
+
+        auto isInRange = [&]( const Metadata& md )->bool
+        {
+            auto it = md.findField( sFieldName );
+            if( it == md.end() )
+                return false;
+            if( it->getType() == Variant::type_integer && fieldDesc.type == Variant::type_integer )
+                return vLo.get_integer() <= it->get_integer() && it->get_integer() <= vHi.get_integer();
+            if( it->getType() == Variant::type_real && fieldDesc.type == Variant::type_real )
+                return vLo.get_real() <= it->get_real() && it->get_real() <= vHi.get_real();
+            return false;
+        };
+
+        std::vector< IdType > vCandidates;
+        auto itField = desc.fields.find( sFieldName );
+        if( itField != desc.fields.end() && itField->second.findRange( vLo, vHi, vCandidates ))
+        {
+            for( auto id : vCandidates )
+                if( isInRange( *desc.items.at( id )))
+                    vIds.push_back( id );
+        }
+        else
+        {
+            for( const auto& item : desc.items )
+                if( isInRange( *item.second ))
+                    vIds.push_back( item.first );
+        }
+    }
+
+    if( !hasRows( nullptr, &sMetadataName ))
+        return getByIds( vIds );
+
+    // Columns of the field are scanned directly
+    return mergeById( getByIds( vIds ), getRows( nullptr, &sMetadataName, [&]( const MetadataColumns& columns, std::vector< size_t >& rows )
+    {
+        size_t slot;
+        if( !columns.getDesc()->getFieldSlot( sFieldName, slot ))
+            return;
+        Variant::Type type = columns.getDesc()->getSlotDesc( slot ).type;
+        if( !FieldIndex::isOrderedType( type ))
+            UMF_EXCEPTION( IncorrectParamException, "Field '" + sFieldName + "' is neither integer nor real" );
+
+        Variant vLo, vHi;
+        toFieldRange( type, lo, hi, vLo, vHi );
+        ColumnSpan< unsigned char > present = columns.presence( slot );
+        if( type == Variant::type_integer )
+        {
+            ColumnSpan< umf_integer > values = columns.integers( slot );
+            umf_integer nLo = vLo.get_integer(), nHi = vHi.get_integer();
+            for( size_t row = 0; row < values.size(); row++ )
+                if( nLo <= values[row] && values[row] <= nHi && ( present.empty() || present[row] ))
+                    rows.push_back( row );
+        }
+        else
+        {
+            ColumnSpan< umf_real > values = columns.reals( slot );
+            umf_real dLo = vLo.get_real(), dHi = vHi.get_real();
+            for( size_t row = 0; row < values.size(); row++ )
+                if( dLo <= values[row] && values[row] <= dHi && ( present.empty() || present[row] ))
+                    rows.push_back( row );
+        }
+    }));
 }
 
 MetadataSet MetadataStream::queryByReference( const std::string& sReferenceName ) const
 {
-    return m_oMetadataSet.queryByReference( sReferenceName );
+    RWLock::SharedGuard guard( m_lock.get() );
+    return queryByReferenceTo( sReferenceName, []( const Metadata& )->bool { return true; } );
 }
 
 MetadataSet MetadataStream::queryByReference( const std::string& sReferenceName, const umf::FieldValue& value ) const
 {
-    return m_oMetadataSet.queryByReference( sReferenceName, value );
+    RWLock::SharedGuard guard( m_lock.get() );
+    std::string sFieldName = value.getName();
+
+    // For anonymous field, check the first field only
+    if( sFieldName.empty() )
+        return queryByReferenceTo( sReferenceName, [&]( const Metadata& reference )->bool
+        {
+            return reference.size() > 0 && reference.at( 0 ) == value;
+        });
+
+    return queryByReferenceTo( sReferenceName, [&]( const Metadata& reference )->bool
+    {
+        auto it = reference.findField( sFieldName );
+        return it != reference.end() && *it == value;
+    });
 }
 
 MetadataSet MetadataStream::queryByReference( const std::string& sReferenceName, const std::vector< umf::FieldValue>& vFields ) const
 {
-    return m_oMetadataSet.queryByReference( sReferenceName, vFields );
+    RWLock::SharedGuard guard( m_lock.get() );
+    if( vFields.empty() )
+        return MetadataSet();
+
+    return queryByReferenceTo( sReferenceName, [&]( const Metadata& reference )->bool
+    {
+        for( const auto& value : vFields )
+        {
+            auto it = reference.findField( value.getNameSymbol() );
+            if( it == reference.end() || *it != value )
+                return false;
+        }
+        return true;
+    });
+}
+
+MetadataSet MetadataStream::queryByReferenceTo( const std::string& sMetadataName, std::function< bool( const Metadata& reference )> filter ) const
+{
+    if( sMetadataName.empty() && !m_oMetadataSet.empty() )
+        UMF_EXCEPTION(ValidateException, "MetadataName is empty!");
+
+    std::vector< IdType > vIds;
+    for( const auto& schema : m_index->schemas )
+    {
+        auto itDesc = schema.second.descs.find( sMetadataName );
+        if( itDesc == schema.second.descs.end() )
+            continue;
+
+        for( const auto& item : itDesc->second.items )
+        {
+            const Index::Edges* pReferrers = m_index->findReferrers( item.first );
+            if( pReferrers && filter( *item.second ))
+                for( const auto& referrer : *pReferrers )
+                    vIds.push_back( referrer.first );
+        }
+    }
+
+    return getByIds( vIds );
+}
+
+MetadataSet MetadataStream::queryReferrers( const IdType& id ) const
+{
+    RWLock::SharedGuard guard( m_lock.get() );
+    std::vector< IdType > vIds;
+    if( const Index::Edges* pReferrers = m_index->findReferrers( id ))
+        for( const auto& referrer : *pReferrers )
+            vIds.push_back( referrer.first );
+
+    return getByIds( vIds );
+}
+
+MetadataSet MetadataStream::queryReferrers( const IdType& id, const std::string& sRefName ) const
+{
+    RWLock::SharedGuard guard( m_lock.get() );
+    std::vector< IdType > vIds;
+    if( const Index::Edges* pReferrers = m_index->findReferrers( id ))
+        for( const auto& referrer : *pReferrers )
+            if( referrer.second == sRefName )
+                vIds.push_back( referrer.first );
+
+    return getByIds( vIds );
+}
+
+MetadataView MetadataStream::select( const QueryExpr& expr ) const
+{
+    RWLock::SharedGuard guard( m_lock.get() );
+    QueryPlanner planner( *this );
+    MetadataView view = planner.select( expr );
+    if( !hasRows( nullptr, nullptr ))
+        return view;
+
+    // Items stored in columns have no index, each of them is checked
+    MetadataSet items = view.materialize();
+    std::sort( items.begin(), items.end(), isLessById );
+    return MetadataView( mergeById( items, getRows( nullptr, nullptr, [&]( const MetadataColumns& columns, std::vector< size_t >& rows )
+    {
+        for( size_t row = 0; row < columns.size(); row++ )
+            if( planner.matches( expr, columns.materialize( row )))
+                rows.push_back( row );
+    })));
+}
+
+std::string MetadataStream::explain( const QueryExpr& expr ) const
+{
+    RWLock::SharedGuard guard( m_lock.get() );
+    return QueryPlanner( *this ).explain( expr );
+}
+
+void MetadataStream::sortById()
+{
+    RWLock::ExclusiveGuard guard( m_lock.get() );
+    std::sort( m_oMetadataSet.begin(), m_oMetadataSet.end(),
+        []( const std::shared_ptr<Metadata>& a, const std::shared_ptr<Metadata>& b ){ return a->getId() < b->getId(); });
+}
+
+void MetadataStream::setConcurrent( bool bConcurrent )
+{
+    if( bConcurrent && !m_lock )
+        m_lock.reset( new RWLock );
+    else if( !bConcurrent )
+        m_lock.reset();
+}
+
+bool MetadataStream::isConcurrent() const
+{
+    return (bool)m_lock;
+}
+
+void MetadataStream::setPooled( bool bPooled )
+{
+    RWLock::ExclusiveGuard guard( m_lock.get() );
+    if( bPooled == (bool)m_spPool )
+        return;
+
+    m_spPool = bPooled ? std::make_shared< MetadataPool >() : nullptr;
+    // The id index takes its entries from the new pool, the items stay where they are
+    IdMap mapById( m_mapMetadataById.bucket_count(), IdMap::hasher(), IdMap::key_equal(),
+                   IdMap::allocator_type( m_spPool ));
+    mapById.insert( m_mapMetadataById.begin(), m_mapMetadataById.end() );
+    m_mapMetadataById = std::move( mapById );
+    m_index->setPool( m_spPool );
+}
+
+bool MetadataStream::isPooled() const
+{
+    return (bool)m_spPool;
+}
+
+void MetadataStream::setTrusted( bool bTrusted )
+{
+    m_bTrusted = bTrusted;
+}
+
+bool MetadataStream::isTrusted() const
+{
+    return m_bTrusted;
+}
+
+std::shared_ptr< Metadata > MetadataStream::createMetadata( const std::shared_ptr< MetadataDesc >& spDesc ) const
+{
+    if( !m_spPool )
+        return std::make_shared< Metadata >( spDesc );
+    return std::allocate_shared< Metadata >( PoolAllocator< Metadata >( m_spPool ), spDesc );
+}
+
+MetadataStream::ReadLock::ReadLock( const MetadataStream& stream ) : m_pLock( stream.m_lock.get() )
+{
+    if( m_pLock )
+        m_pLock->lockShared();
+}
+
+MetadataStream::ReadLock::~ReadLock()
+{
+    if( m_pLock )
+        m_pLock->unlockShared();
 }
 
 std::string MetadataStream::serialize(Format& format)
 {
+    RWLock::SharedGuard guard( m_lock.get() );
     MetadataStream encryptedStream(*this);
     encryptedStream.encrypt();
 
@@ -706,11 +1823,12 @@ std::string MetadataStream::serialize(Format& format)
                                { "filepath", m_sFilePath },
                                { "checksum", m_sChecksumMedia },
                                { "hint", m_hintEncryption }, };
-    return format.store(encryptedStream.m_oMetadataSet, schemas, videoSegments, m_stats, attribs);
+    return format.store(encryptedStream.getAllItems(), schemas, videoSegments, m_stats, attribs);
 }
 
 void MetadataStream::deserialize(const std::string& text, Format& format)
 {
+    RWLock::ExclusiveGuard guard( m_lock.get() );
     std::vector<std::shared_ptr<VideoSegment>> segments;
     std::vector<std::shared_ptr<MetadataSchema>> schemas;
     std::vector<MetadataInternal> metadata;
@@ -722,7 +1840,7 @@ void MetadataStream::deserialize(const std::string& text, Format& format)
     m_hintEncryption = attribs["hint"];
     for (const auto& spSegment : segments) addVideoSegment(spSegment);
     for (const auto& spSchema : schemas) addSchema(spSchema);
-    for (auto& mdi : metadata) add(mdi);
+    addBatch(std::move(metadata));
 
     decrypt();
 }
@@ -812,6 +1930,8 @@ void MetadataStream::encrypt()
     {
         //clone those SPs to MD records which need to be encrypted
         meta = std::make_shared<Metadata>(*meta);
+        m_mapMetadataById[meta->getId()] = meta;
+        m_index->add(meta);
         if(meta->getUseEncryption() ||
            toEncrypt[SubsetKey(meta->getSchemaName(), "", "")] ||
            toEncrypt[SubsetKey(meta->getSchemaName(), meta->getName(), "")])
@@ -986,7 +2106,9 @@ void MetadataStream::decrypt()
             }
         }
         //validate resulting metadata
-        meta->validate();
+        if (!m_bTrusted)
+            meta->validate();
+        m_index->updateFields(*meta);
     }
 }
 
@@ -1150,32 +2272,68 @@ void MetadataStream::convertFrameIndexToTimestamp(
 }
 
 void MetadataStream::notifyStat(std::shared_ptr< Metadata > spMetadata, Stat::Action::Type action)
+{
+    for( size_t i = 0; i < m_stats.size(); i++ )
+    {
+        if( i + 1 < m_stats.size() )
+            m_stats[i]->notify(spMetadata, action);
+        else
+            m_stats[i]->notify(std::move(spMetadata), action);
+    }
+}
+
+void MetadataStream::notifyStat(const MetadataSet& items, Stat::Action::Type action)
 {
     for( auto& stat : m_stats )
     {
-        stat->notify(spMetadata, action);
+        stat->notify(items, action);
+    }
+}
+
+void MetadataStream::notifyStat(MetadataSet&& items, Stat::Action::Type action)
+{
+    // The last statistics object takes the items over
+    for( size_t i = 0; i < m_stats.size(); i++ )
+    {
+        if( i + 1 < m_stats.size() )
+            m_stats[i]->notify(items, action);
+        else
+            m_stats[i]->notify(std::move(items), action);
     }
 }
 
 void MetadataStream::recalcStat()
 {
+    RWLock::ExclusiveGuard guard( m_lock.get() );
     for (auto& stat : m_stats)
         stat->clear();
 
-    for (const auto& m : m_oMetadataSet)
+    for (const auto& m : getAllItems())
         notifyStat(m);
 }
 
 void MetadataStream::addStat(std::shared_ptr<Stat> stat)
 {
+    RWLock::ExclusiveGuard guard( m_lock.get() );
     const std::string& name = stat->getName();
     auto it = std::find_if(m_stats.begin(), m_stats.end(), [&name](std::shared_ptr<Stat> s){return s->getName() == name; });
     if (it != m_stats.end()) UMF_EXCEPTION(IncorrectParamException, "Statistics object already exists: " + name);
+
+    // Resolve the fields against the descriptions known so far, later ones are resolved on first use
+    std::vector< std::shared_ptr< MetadataDesc >> descs;
+    for (const auto& schema : m_mapSchemas)
+    {
+        std::vector< std::shared_ptr< MetadataDesc >> schemaDescs = schema.second->getAll();
+        descs.insert(descs.end(), schemaDescs.begin(), schemaDescs.end());
+    }
+    stat->bind(descs);
+
     m_stats.push_back(stat);
 }
 
 std::shared_ptr<Stat> MetadataStream::getStat(const std::string& name) const
 {
+    RWLock::SharedGuard guard( m_lock.get() );
     auto it = std::find_if(m_stats.begin(), m_stats.end(), [&name](std::shared_ptr<Stat> s){return s->getName() == name; });
     if (it == m_stats.end()) UMF_EXCEPTION(umf::NotFoundException, "Statistics object not found: " + name);
     return *it;
@@ -1183,6 +2341,7 @@ std::shared_ptr<Stat> MetadataStream::getStat(const std::string& name) const
 
 std::vector< std::string > MetadataStream::getAllStatNames() const
 {
+    RWLock::SharedGuard guard( m_lock.get() );
     std::vector< std::string > names;
     for (auto& stat : m_stats)
         names.push_back(stat->getName());
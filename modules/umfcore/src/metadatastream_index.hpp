@@ -0,0 +1,287 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef UMF_METADATASTREAM_INDEX_HPP
+#define UMF_METADATASTREAM_INDEX_HPP
+
+#include "umf/metadatastream.hpp"
+#include "interval_index.hpp"
+#include "field_index.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace umf {
+
+/*!
+ * \class MetadataStream::Index
+ * \brief Secondary indexes over the metadata items of a stream.
+ * \details Every item added to the stream is registered here and every
+ * in-place change of an indexed property is reported by the item itself,
+ * so the indexes always reflect the current state of the stream.
+ */
+class MetadataStream::Index
+{
+public:
+    //! Items of a schema or a description ordered by id
+    typedef MetadataView::Bucket Bucket;
+
+    //! Items of a description and value indexes of its indexed fields
+    struct DescBucket
+    {
+        explicit DescBucket(const std::shared_ptr<MetadataPool>& spPool) : items(std::less<IdType>(), Bucket::allocator_type(spPool)) {}
+
+        Bucket items;
+        std::unordered_map< std::string, FieldIndex > fields;
+    };
+
+    //! Reference edges of an item: pairs of the other item id and the reference name
+    typedef std::multiset< std::pair<IdType, std::string> > Edges;
+
+    struct SchemaBucket
+    {
+        explicit SchemaBucket(const std::shared_ptr<MetadataPool>& spPool) : items(std::less<IdType>(), Bucket::allocator_type(spPool)) {}
+
+        Bucket items;
+        std::unordered_map< std::string, DescBucket > descs;
+    };
+
+    //! Registers the item or replaces the indexed instance having the same id
+    void add(const std::shared_ptr<Metadata>& spMd)
+    {
+        auto itSchema = schemas.find(spMd->m_sSchemaName);
+        if(itSchema == schemas.end())
+            itSchema = schemas.emplace(spMd->m_sSchemaName, SchemaBucket(spPool)).first;
+        SchemaBucket& schema = itSchema->second;
+        schema.items[spMd->getId()] = spMd;
+        auto itDesc = schema.descs.find(spMd->m_sName);
+        if(itDesc == schema.descs.end())
+        {
+            itDesc = schema.descs.emplace(spMd->m_sName, DescBucket(spPool)).first;
+            if(const MetadataDesc* pDesc = spMd->getDesc().get())
+                for(size_t slot = 0; slot < pDesc->getSlotCount(); slot++)
+                {
+                    const FieldDesc& field = pDesc->getSlotDesc(slot);
+                    if(field.indexed)
+                        itDesc->second.fields.emplace(field.name, FieldIndex(field.type, slot));
+                }
+        }
+        itDesc->second.items[spMd->getId()] = spMd;
+        updateFields(itDesc->second, *spMd);
+        updateTime(*spMd);
+        updateFrames(*spMd);
+        updateReferences(*spMd);
+    }
+
+    void remove(const Metadata& md)
+    {
+        auto itSchema = schemas.find(md.m_sSchemaName);
+        if(itSchema != schemas.end())
+        {
+            itSchema->second.items.erase(md.getId());
+            auto itDesc = itSchema->second.descs.find(md.m_sName);
+            if(itDesc != itSchema->second.descs.end())
+            {
+                itDesc->second.items.erase(md.getId());
+                for(auto& field : itDesc->second.fields)
+                    field.second.erase(md.getId());
+                if(itDesc->second.items.empty())
+                    itSchema->second.descs.erase(itDesc);
+            }
+            if(itSchema->second.items.empty())
+                schemas.erase(itSchema);
+        }
+        time.erase(md.getId());
+        frames.erase(md.getId());
+        dropReferences(md.getId());
+    }
+
+    void clear()
+    {
+        schemas.clear();
+        time.clear();
+        frames.clear();
+        referencesFrom.clear();
+        referencesTo.clear();
+    }
+
+    const Bucket* findSchema(const std::string& schemaName) const
+    {
+        auto it = schemas.find(schemaName);
+        return it != schemas.end() ? &it->second.items : nullptr;
+    }
+
+    const DescBucket* findDesc(const std::string& schemaName, const std::string& metadataName) const
+    {
+        auto itSchema = schemas.find(schemaName);
+        if(itSchema == schemas.end())
+            return nullptr;
+        auto itDesc = itSchema->second.descs.find(metadataName);
+        return itDesc != itSchema->second.descs.end() ? &itDesc->second : nullptr;
+    }
+
+    //! Reindexes the field of the item if the field is indexed
+    void updateField(const Metadata& md, const std::string& fieldName)
+    {
+        DescBucket* desc = findDesc(md);
+        if(!desc)
+            return;
+        auto itField = desc->fields.find(fieldName);
+        if(itField != desc->fields.end())
+            itField->second.update(md.getId(), md.tryField(itField->second.getSlot()));
+    }
+
+    //! Reindexes all indexed fields of the item
+    void updateFields(const Metadata& md)
+    {
+        DescBucket* desc = findDesc(md);
+        if(desc)
+            updateFields(*desc, md);
+    }
+
+    //! Time interval is [timestamp, timestamp + duration], items without timestamp are skipped
+    void updateTime(const Metadata& md)
+    {
+        long long timestamp = md.getTime();
+        if(timestamp >= 0)
+            time.insert(md.getId(), timestamp, timestamp + md.getDuration());
+        else
+            time.erase(md.getId());
+    }
+
+    //! Frame interval is [frameIndex, frameIndex + numOfFrames - 1], empty intervals are skipped
+    void updateFrames(const Metadata& md)
+    {
+        long long frameIndex = md.getFrameIndex(), numOfFrames = md.getNumOfFrames();
+        if(frameIndex >= 0 && numOfFrames > 0)
+            frames.insert(md.getId(), frameIndex, frameIndex + numOfFrames - 1);
+        else
+            frames.erase(md.getId());
+    }
+
+    void addReference(IdType from, IdType to, const std::string& refName)
+    {
+        referencesFrom[from].insert(std::make_pair(to, refName));
+        referencesTo[to].insert(std::make_pair(from, refName));
+    }
+
+    void removeReference(IdType from, IdType to, const std::string& refName)
+    {
+        eraseEdge(referencesFrom, from, std::make_pair(to, refName));
+        eraseEdge(referencesTo, to, std::make_pair(from, refName));
+    }
+
+    //! Replaces the outgoing edges of the item by its current references
+    void updateReferences(const Metadata& md)
+    {
+        dropReferences(md.getId());
+        for(const auto& ref : md.getAllReferences())
+        {
+            auto spTarget = ref.getReferenceMetadata().lock();
+            auto spRefDesc = ref.getReferenceDescription();
+            if(spTarget && spRefDesc)
+                addReference(md.getId(), spTarget->getId(), spRefDesc->name);
+        }
+    }
+
+    //! Forgets all edges pointing to the item
+    void dropReferrers(IdType to)
+    {
+        auto it = referencesTo.find(to);
+        if(it == referencesTo.end())
+            return;
+        for(const auto& edge : it->second)
+            eraseEdge(referencesFrom, edge.first, std::make_pair(to, edge.second));
+        referencesTo.erase(it);
+    }
+
+    //! Items referencing the given one along with the reference names, ordered by referrer id
+    const Edges* findReferrers(IdType to) const
+    {
+        auto it = referencesTo.find(to);
+        return it != referencesTo.end() ? &it->second : nullptr;
+    }
+
+    //! Buckets made from now on take their entries from the pool, the existing ones are moved there
+    void setPool(const std::shared_ptr<MetadataPool>& spNewPool)
+    {
+        spPool = spNewPool;
+        for(auto& schema : schemas)
+        {
+            rebuild(schema.second.items);
+            for(auto& desc : schema.second.descs)
+                rebuild(desc.second.items);
+        }
+    }
+
+    std::unordered_map< std::string, SchemaBucket > schemas;
+    IntervalIndex time;
+    IntervalIndex frames;
+    std::unordered_map< IdType, Edges > referencesFrom;
+    std::unordered_map< IdType, Edges > referencesTo;
+    std::shared_ptr< MetadataPool > spPool;
+
+private:
+    void rebuild(Bucket& bucket) const
+    {
+        Bucket items(bucket.begin(), bucket.end(), std::less<IdType>(), Bucket::allocator_type(spPool));
+        bucket = std::move(items);
+    }
+
+    static void eraseEdge(std::unordered_map< IdType, Edges >& edges, IdType id, const std::pair<IdType, std::string>& edge)
+    {
+        auto it = edges.find(id);
+        if(it == edges.end())
+            return;
+        auto itEdge = it->second.find(edge);
+        if(itEdge != it->second.end())
+            it->second.erase(itEdge);
+        if(it->second.empty())
+            edges.erase(it);
+    }
+
+    void dropReferences(IdType from)
+    {
+        auto it = referencesFrom.find(from);
+        if(it == referencesFrom.end())
+            return;
+        for(const auto& edge : it->second)
+            eraseEdge(referencesTo, edge.first, std::make_pair(from, edge.second));
+        referencesFrom.erase(it);
+    }
+
+    DescBucket* findDesc(const Metadata& md)
+    {
+        auto itSchema = schemas.find(md.m_sSchemaName);
+        if(itSchema == schemas.end())
+            return nullptr;
+        auto itDesc = itSchema->second.descs.find(md.m_sName);
+        return itDesc != itSchema->second.descs.end() ? &itDesc->second : nullptr;
+    }
+
+    void updateFields(DescBucket& desc, const Metadata& md)
+    {
+        for(auto& field : desc.fields)
+            field.second.update(md.getId(), md.tryField(field.second.getSlot()));
+    }
+};
+
+}
+
+#endif /* UMF_METADATASTREAM_INDEX_HPP */
@@ -0,0 +1,193 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "umf/metadataview.hpp"
+#include "umf/metadataset.hpp"
+
+#include <limits>
+
+namespace umf
+{
+
+MetadataView::const_iterator::const_iterator()
+    : m_pView(nullptr), m_nPos(0), m_nYielded(0), m_pCurrent(nullptr)
+{
+}
+
+MetadataView::const_iterator::const_iterator(const MetadataView* pView)
+    : m_pView(pView), m_nPos(0), m_nYielded(0), m_pCurrent(nullptr)
+{
+    if(m_pView->m_source == Source::Bucket)
+        m_itBucket = m_pView->m_pBucket->begin();
+    seek();
+}
+
+const std::shared_ptr<Metadata>* MetadataView::const_iterator::source() const
+{
+    switch(m_pView->m_source)
+    {
+    case Source::Range:
+        return m_nPos < m_pView->m_nSize ? m_pView->m_pFirst + m_nPos : nullptr;
+    case Source::Bucket:
+        return m_itBucket != m_pView->m_pBucket->end() ? &m_itBucket->second : nullptr;
+    case Source::List:
+        return m_nPos < m_pView->m_spItems->size() ? (*m_pView->m_spItems)[m_nPos] : nullptr;
+    }
+    return nullptr;
+}
+
+void MetadataView::const_iterator::seek()
+{
+    // Stop at the current source item if it passes all filters, otherwise advance
+    m_pCurrent = nullptr;
+    if(m_nYielded >= m_pView->m_nLimit)
+        return;
+
+    for(;;)
+    {
+        const std::shared_ptr<Metadata>* pItem = source();
+        if(!pItem)
+            return;
+
+        bool bPassed = true;
+        for(const auto& filter : m_pView->m_filters)
+        {
+            if(!filter(*pItem))
+            {
+                bPassed = false;
+                break;
+            }
+        }
+        if(bPassed)
+        {
+            m_pCurrent = pItem;
+            return;
+        }
+
+        if(m_pView->m_source == Source::Bucket)
+            ++m_itBucket;
+        else
+            ++m_nPos;
+    }
+}
+
+MetadataView::const_iterator& MetadataView::const_iterator::operator++()
+{
+    if(m_pView->m_source == Source::Bucket)
+        ++m_itBucket;
+    else
+        ++m_nPos;
+    ++m_nYielded;
+    seek();
+    return *this;
+}
+
+MetadataView::const_iterator MetadataView::const_iterator::operator++(int)
+{
+    const_iterator it(*this);
+    ++(*this);
+    return it;
+}
+
+MetadataView::MetadataView()
+    : m_source(Source::Range), m_pFirst(nullptr), m_nSize(0), m_pBucket(nullptr),
+      m_nLimit(std::numeric_limits<size_t>::max())
+{
+}
+
+MetadataView::MetadataView(const std::shared_ptr<Metadata>* first, const std::shared_ptr<Metadata>* last)
+    : m_source(Source::Range), m_pFirst(first), m_nSize(last - first), m_pBucket(nullptr),
+      m_nLimit(std::numeric_limits<size_t>::max())
+{
+}
+
+MetadataView::MetadataView(const Bucket& bucket)
+    : m_source(Source::Bucket), m_pFirst(nullptr), m_nSize(0), m_pBucket(&bucket),
+      m_nLimit(std::numeric_limits<size_t>::max())
+{
+}
+
+MetadataView::MetadataView(ItemList&& items)
+    : m_source(Source::List), m_pFirst(nullptr), m_nSize(0), m_pBucket(nullptr),
+      m_spItems(std::make_shared<ItemList>(std::move(items))), m_nLimit(std::numeric_limits<size_t>::max())
+{
+}
+
+MetadataView::MetadataView(std::vector< std::shared_ptr<Metadata> >&& items)
+    : m_source(Source::Range), m_pFirst(nullptr), m_nSize(items.size()), m_pBucket(nullptr),
+      m_spOwned(std::make_shared< std::vector< std::shared_ptr<Metadata> > >(std::move(items))),
+      m_nLimit(std::numeric_limits<size_t>::max())
+{
+    m_pFirst = m_spOwned->data();
+}
+
+MetadataView::const_iterator MetadataView::begin() const
+{
+    return const_iterator(this);
+}
+
+MetadataView::const_iterator MetadataView::end() const
+{
+    return const_iterator();
+}
+
+MetadataView MetadataView::where(Filter filter) const
+{
+    MetadataView view(*this);
+    view.m_filters.push_back(filter);
+    return view;
+}
+
+MetadataView MetadataView::limit(size_t n) const
+{
+    MetadataView view(*this);
+    view.m_nLimit = std::min(m_nLimit, n);
+    return view;
+}
+
+size_t MetadataView::count() const
+{
+    // Unfiltered sources know their size
+    if(m_filters.empty())
+    {
+        size_t nSize = m_source == Source::Range ? m_nSize :
+                       m_source == Source::Bucket ? m_pBucket->size() : m_spItems->size();
+        return std::min(nSize, m_nLimit);
+    }
+
+    size_t n = 0;
+    for(auto it = begin(); it != end(); ++it)
+        n++;
+    return n;
+}
+
+std::shared_ptr<Metadata> MetadataView::first() const
+{
+    auto it = begin();
+    return it != end() ? *it : nullptr;
+}
+
+MetadataSet MetadataView::materialize() const
+{
+    MetadataSet set;
+    if(m_filters.empty())
+        set.reserve(count());
+    for(const auto& spMetadata : *this)
+        set.push_back(spMetadata);
+    return set;
+}
+
+}
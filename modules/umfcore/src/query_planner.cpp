@@ -0,0 +1,550 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "query_planner.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+
+namespace umf {
+
+namespace {
+
+//! Three-way comparison of numeric values, false if any of them isn't a number
+bool compareNumbers(const Variant& a, const Variant& b, int& result)
+{
+    if(a.getType() == Variant::type_integer && b.getType() == Variant::type_integer)
+    {
+        result = a.get_integer() < b.get_integer() ? -1 : a.get_integer() > b.get_integer() ? 1 : 0;
+        return true;
+    }
+
+    umf_real x, y;
+    if(a.getType() == Variant::type_integer)
+        x = (umf_real)a.get_integer();
+    else if(a.getType() == Variant::type_real)
+        x = a.get_real();
+    else
+        return false;
+    if(b.getType() == Variant::type_integer)
+        y = (umf_real)b.get_integer();
+    else if(b.getType() == Variant::type_real)
+        y = b.get_real();
+    else
+        return false;
+
+    result = x < y ? -1 : x > y ? 1 : 0;
+    return true;
+}
+
+//! Bound of the given type not excluding any value allowed by the numeric bound
+Variant toBound(const Variant& value, Variant::Type type, bool bLower)
+{
+    if(type == Variant::type_real)
+        return Variant(value.getType() == Variant::type_integer ? (umf_real)value.get_integer() : value.get_real());
+    if(value.getType() == Variant::type_integer)
+        return value;
+
+    const umf_real rounded = bLower ? std::ceil(value.get_real()) : std::floor(value.get_real());
+    if(rounded <= (umf_real)std::numeric_limits<umf_integer>::min())
+        return Variant(std::numeric_limits<umf_integer>::min());
+    if(rounded >= (umf_real)std::numeric_limits<umf_integer>::max())
+        return Variant(std::numeric_limits<umf_integer>::max());
+    return Variant((umf_integer)rounded);
+}
+
+Variant minBound(Variant::Type type)
+{
+    return type == Variant::type_real ? Variant(-std::numeric_limits<umf_real>::infinity())
+                                      : Variant(std::numeric_limits<umf_integer>::min());
+}
+
+Variant maxBound(Variant::Type type)
+{
+    return type == Variant::type_real ? Variant(std::numeric_limits<umf_real>::infinity())
+                                      : Variant(std::numeric_limits<umf_integer>::max());
+}
+
+}
+
+QueryPlanner::QueryPlanner(const MetadataStream& stream)
+    : m_stream(stream), m_index(*stream.m_index)
+{
+}
+
+MetadataView QueryPlanner::select(const QueryExpr& expr) const
+{
+    Access access = plan(expr.m_spNode, Context(), std::numeric_limits<size_t>::max());
+
+    MetadataView view;
+    if(access.scan)
+        view = m_stream.view();
+    else if(access.ids.empty() && access.buckets.size() == 1)
+        view = MetadataView(*access.buckets.front());
+    else
+    {
+        for(auto pBucket : access.buckets)
+            for(const auto& item : *pBucket)
+                access.ids.push_back(item.first);
+        view = m_stream.viewByIds(access.ids);
+    }
+
+    if(access.residual.empty())
+        return view;
+
+    const MetadataStream::Index* pIndex = &m_index;
+    Residual residual(std::move(access.residual));
+    return view.where([pIndex, residual](const std::shared_ptr<Metadata>& spMd)
+    {
+        for(const auto& spNode : residual)
+            if(!matches(*spNode, spMd, *pIndex))
+                return false;
+        return true;
+    });
+}
+
+bool QueryPlanner::matches(const QueryExpr& expr, const std::shared_ptr<Metadata>& spMd) const
+{
+    return matches(*expr.m_spNode, spMd, m_index);
+}
+
+std::string QueryPlanner::explain(const QueryExpr& expr) const
+{
+    Access access = plan(expr.m_spNode, Context(), std::numeric_limits<size_t>::max());
+
+    std::string sFilter;
+    for(const auto& spNode : access.residual)
+        sFilter += (sFilter.empty() ? "" : " AND ") + QueryExpr::toString(*spNode);
+
+    return "access: " + access.description + " (" + to_string(access.cost) + " candidates)\n"
+           "filter: " + (sFilter.empty() ? std::string("none") : sFilter);
+}
+
+QueryPlanner::Access QueryPlanner::plan(const std::shared_ptr<const Node>& spNode, const Context& context, size_t limit) const
+{
+    const Node& node = *spNode;
+    Access access;
+
+    switch(node.kind)
+    {
+    case Kind::All:
+        access = scan(limit);
+        return access;
+
+    case Kind::Id:
+        if(m_stream.m_mapMetadataById.count(node.id))
+            access.ids.push_back(node.id);
+        access.description = "id " + to_string(node.id);
+        break;
+
+    case Kind::Schema:
+        if(const MetadataStream::Index::Bucket* pBucket = m_index.findSchema(node.sName))
+            access.buckets.push_back(pBucket);
+        access.description = "schema bucket \"" + node.sName.str() + "\"";
+        break;
+
+    case Kind::Name:
+        for(const auto& schema : m_index.schemas)
+        {
+            auto itDesc = schema.second.descs.find(node.sName);
+            if(itDesc != schema.second.descs.end())
+                access.buckets.push_back(&itDesc->second.items);
+        }
+        access.description = "name buckets \"" + node.sName.str() + "\"";
+        break;
+
+    case Kind::Time:
+        m_index.time.query(node.lo, node.hi, access.ids, limit);
+        access.description = "time index " + QueryExpr::toString(node);
+        break;
+
+    case Kind::Frames:
+        m_index.frames.query(node.lo, node.hi, access.ids, limit);
+        access.description = "frame index " + QueryExpr::toString(node);
+        break;
+
+    case Kind::Field:
+    case Kind::FieldRange:
+        return planField(spNode, context, limit);
+
+    case Kind::HasReference:
+        for(const auto& edges : m_index.referencesFrom)
+            if(hasEdge(m_index.referencesFrom, edges.first, 0, true, node.sName, false))
+            {
+                access.ids.push_back(edges.first);
+                if(access.ids.size() > limit)
+                    break;
+            }
+        access.description = "reference index " + QueryExpr::toString(node);
+        break;
+
+    case Kind::ReferencesTo:
+        if(const MetadataStream::Index::Edges* pReferrers = m_index.findReferrers(node.id))
+            for(const auto& edge : *pReferrers)
+                if(node.bAnyName || edge.second == node.sName)
+                    access.ids.push_back(edge.first);
+        access.description = "reference index " + QueryExpr::toString(node);
+        break;
+
+    case Kind::ReferencedBy:
+    {
+        auto it = m_index.referencesFrom.find(node.id);
+        if(it != m_index.referencesFrom.end())
+            for(const auto& edge : it->second)
+                if(node.bAnyName || edge.second == node.sName)
+                    access.ids.push_back(edge.first);
+        access.description = "reference index " + QueryExpr::toString(node);
+        break;
+    }
+
+    case Kind::Predicate:
+    case Kind::Not:
+        access = scan(limit);
+        access.residual.push_back(spNode);
+        return access;
+
+    case Kind::And:
+        return planAnd(spNode, context, limit);
+
+    case Kind::Or:
+        return planOr(spNode, context, limit);
+    }
+
+    access.cost = access.ids.size();
+    for(auto pBucket : access.buckets)
+        access.cost += pBucket->size();
+    access.overflow = access.cost > limit;
+    return access;
+}
+
+QueryPlanner::Access QueryPlanner::planAnd(const std::shared_ptr<const Node>& spNode, const Context& context, size_t limit) const
+{
+    const auto& children = spNode->children;
+
+    // Names required by this conjunction narrow down the field lookups of its operands
+    Context inner = context;
+    size_t nSchema = children.size(), nName = children.size();
+    for(size_t i = 0; i < children.size(); i++)
+    {
+        if(children[i]->kind == Kind::Schema && nSchema == children.size())
+        {
+            nSchema = i;
+            inner.pSchemaName = &children[i]->sName.str();
+        }
+        else if(children[i]->kind == Kind::Name && nName == children.size())
+        {
+            nName = i;
+            inner.pName = &children[i]->sName.str();
+        }
+    }
+
+    // Operands with known size go first, so lookups of the others stop as soon as they lose
+    std::vector< size_t > order;
+    for(size_t i = 0; i < children.size(); i++)
+        if(isSized(children[i]->kind))
+            order.push_back(i);
+    const size_t nSized = order.size();
+    for(size_t i = 0; i < children.size(); i++)
+        if(!isSized(children[i]->kind))
+            order.push_back(i);
+
+    Access best;
+    std::vector< size_t > bestCovered;
+    bool bFound = false;
+
+    // The fewest candidates win, ties go to an index resolving more operands completely
+    auto consider = [&](Access& access, const std::vector< size_t >& covered)
+    {
+        if(access.overflow)
+            return;
+        auto rank = [&](const Access& a, size_t nCovered)
+        {
+            return std::make_tuple(a.cost, a.scan, a.residual.size(), children.size() - nCovered);
+        };
+        if(!bFound || rank(access, covered.size()) < rank(best, bestCovered.size()))
+        {
+            best = std::move(access);
+            bestCovered = covered;
+            bFound = true;
+            limit = std::min(limit, best.cost);
+        }
+    };
+
+    for(size_t n = 0; n <= order.size(); n++)
+    {
+        // Schema and name together select a single description bucket
+        if(n == nSized && nSchema < children.size() && nName < children.size())
+        {
+            Access access;
+            if(const MetadataStream::Index::DescBucket* pDesc = m_index.findDesc(*inner.pSchemaName, *inner.pName))
+            {
+                access.buckets.push_back(&pDesc->items);
+                access.cost = pDesc->items.size();
+            }
+            access.description = "description bucket \"" + *inner.pSchemaName + "\" \"" + *inner.pName + "\"";
+            consider(access, { nSchema, nName });
+        }
+
+        if(n < order.size())
+        {
+            Access access = plan(children[order[n]], inner, limit);
+            consider(access, std::vector< size_t >(1, order[n]));
+        }
+    }
+
+    if(!bFound)
+    {
+        Access access = scan(limit);
+        access.residual = children;
+        return access;
+    }
+
+    for(size_t i = 0; i < children.size(); i++)
+        if(std::find(bestCovered.begin(), bestCovered.end(), i) == bestCovered.end())
+            best.residual.push_back(children[i]);
+    return best;
+}
+
+QueryPlanner::Access QueryPlanner::planOr(const std::shared_ptr<const Node>& spNode, const Context& context, size_t limit) const
+{
+    Access access;
+    bool bExact = true;
+    for(const auto& spChild : spNode->children)
+    {
+        Access child = plan(spChild, context, limit - access.cost);
+        if(child.scan || child.overflow)
+        {
+            access = scan(limit);
+            access.residual.push_back(spNode);
+            return access;
+        }
+
+        access.buckets.insert(access.buckets.end(), child.buckets.begin(), child.buckets.end());
+        access.ids.insert(access.ids.end(), child.ids.begin(), child.ids.end());
+        access.cost += child.cost;
+        access.description += (access.description.empty() ? "union of " : " + ") + child.description;
+        bExact = bExact && child.residual.empty();
+    }
+
+    if(!bExact)
+        access.residual.push_back(spNode);
+    return access;
+}
+
+QueryPlanner::Access QueryPlanner::planField(const std::shared_ptr<const Node>& spNode, const Context& context, size_t limit) const
+{
+    const Node& node = *spNode;
+    Access access;
+    size_t nIndexed = 0;
+
+    for(const auto& schema : m_index.schemas)
+    {
+        if(context.pSchemaName && schema.first != *context.pSchemaName)
+            continue;
+        for(const auto& desc : schema.second.descs)
+        {
+            if(context.pName && desc.first != *context.pName)
+                continue;
+
+            // Items of a description without such field can't match
+            FieldDesc fieldDesc;
+            const auto& spDesc = desc.second.items.begin()->second->getDesc();
+            if(spDesc && !spDesc->getFieldDesc(fieldDesc, node.sName))
+                continue;
+
+            auto itField = desc.second.fields.find(node.sName);
+            size_t nFound = access.ids.size();
+            if(itField != desc.second.fields.end() && lookup(node, itField->second, access.ids, limit - access.cost))
+            {
+                access.cost += access.ids.size() - nFound;
+                nIndexed++;
+            }
+            else
+            {
+                access.buckets.push_back(&desc.second.items);
+                access.cost += desc.second.items.size();
+            }
+
+            if(access.cost > limit)
+            {
+                access.overflow = true;
+                return access;
+            }
+        }
+    }
+
+    if(access.buckets.empty())
+        access.description = "field index " + QueryExpr::toString(node);
+    else if(nIndexed)
+        access.description = "field index " + QueryExpr::toString(node) + " + " + to_string(access.buckets.size()) + " buckets";
+    else
+        access.description = "buckets having field \"" + node.sName.str() + "\"";
+
+    // Index lookups return candidates, the values are compared again
+    access.residual.push_back(spNode);
+    return access;
+}
+
+QueryPlanner::Access QueryPlanner::scan(size_t limit) const
+{
+    Access access;
+    access.scan = true;
+    access.cost = m_stream.m_oMetadataSet.size();
+    access.overflow = access.cost > limit;
+    access.description = "full scan";
+    return access;
+}
+
+bool QueryPlanner::isSized(Kind kind)
+{
+    return kind == Kind::Id || kind == Kind::Schema || kind == Kind::Name ||
+           kind == Kind::ReferencesTo || kind == Kind::ReferencedBy;
+}
+
+bool QueryPlanner::hasEdge(const std::unordered_map< IdType, MetadataStream::Index::Edges >& edges, IdType id,
+                           IdType other, bool bAnyOther, const std::string& refName, bool bAnyName)
+{
+    auto it = edges.find(id);
+    if(it == edges.end())
+        return false;
+    for(const auto& edge : it->second)
+        if((bAnyOther || edge.first == other) && (bAnyName || edge.second == refName))
+            return true;
+    return false;
+}
+
+
+bool QueryPlanner::lookup(const Node& node, const FieldIndex& index, std::vector<IdType>& ids, size_t limit)
+{
+    const Variant::Type type = index.getType();
+    if(node.kind == Kind::Field && node.compare == QueryExpr::Compare::Equal)
+        return index.findEqual(node.value, ids, limit);
+    if(!FieldIndex::isOrderedType(type))
+        return false;
+
+    Variant lo = minBound(type), hi = maxBound(type);
+    if(node.kind == Kind::FieldRange)
+    {
+        lo = toBound(node.value, type, true);
+        hi = toBound(node.bound, type, false);
+    }
+    else if(node.compare == QueryExpr::Compare::Greater || node.compare == QueryExpr::Compare::GreaterOrEqual)
+        lo = toBound(node.value, type, true);
+    else if(node.compare == QueryExpr::Compare::Less || node.compare == QueryExpr::Compare::LessOrEqual)
+        hi = toBound(node.value, type, false);
+    else
+        return false;
+
+    return index.findRange(lo, hi, ids, limit);
+}
+
+bool QueryPlanner::matches(const Node& node, const std::shared_ptr<Metadata>& spMd, const MetadataStream::Index& index)
+{
+    const Metadata& md = *spMd;
+
+    switch(node.kind)
+    {
+    case Kind::All:
+        return true;
+
+    case Kind::Id:
+        return md.getId() == node.id;
+
+    case Kind::Schema:
+        return md.getSchemaNameSymbol() == node.sName;
+
+    case Kind::Name:
+        return md.getNameSymbol() == node.sName;
+
+    case Kind::Time:
+    {
+        long long timestamp = md.getTime();
+        return timestamp >= 0 && timestamp <= node.hi && timestamp + md.getDuration() >= node.lo;
+    }
+
+    case Kind::Frames:
+    {
+        long long frameIndex = md.getFrameIndex(), numOfFrames = md.getNumOfFrames();
+        return frameIndex >= 0 && numOfFrames > 0 && frameIndex <= node.hi && frameIndex + numOfFrames - 1 >= node.lo;
+    }
+
+    case Kind::Field:
+    {
+        auto it = md.findField(node.sName);
+        if(it == md.end())
+            return false;
+
+        const Variant& value = *it;
+        int result = 0;
+        switch(node.compare)
+        {
+        case QueryExpr::Compare::Equal:
+            return value == node.value;
+        case QueryExpr::Compare::NotEqual:
+            return value != node.value;
+        case QueryExpr::Compare::Less:
+            return compareNumbers(value, node.value, result) && result < 0;
+        case QueryExpr::Compare::LessOrEqual:
+            return compareNumbers(value, node.value, result) && result <= 0;
+        case QueryExpr::Compare::Greater:
+            return compareNumbers(value, node.value, result) && result > 0;
+        case QueryExpr::Compare::GreaterOrEqual:
+            return compareNumbers(value, node.value, result) && result >= 0;
+        }
+        return false;
+    }
+
+    case Kind::FieldRange:
+    {
+        auto it = md.findField(node.sName);
+        int lo = 0, hi = 0;
+        return it != md.end() && compareNumbers(*it, node.value, lo) && compareNumbers(*it, node.bound, hi) && lo >= 0 && hi <= 0;
+    }
+
+    case Kind::HasReference:
+        return hasEdge(index.referencesFrom, md.getId(), 0, true, node.sName, false);
+
+    case Kind::ReferencesTo:
+        return hasEdge(index.referencesFrom, md.getId(), node.id, false, node.sName, node.bAnyName);
+
+    case Kind::ReferencedBy:
+        return hasEdge(index.referencesTo, md.getId(), node.id, false, node.sName, node.bAnyName);
+
+    case Kind::Predicate:
+        return node.filter(spMd);
+
+    case Kind::Not:
+        return !matches(*node.children.front(), spMd, index);
+
+    case Kind::And:
+        for(const auto& spChild : node.children)
+            if(!matches(*spChild, spMd, index))
+                return false;
+        return true;
+
+    case Kind::Or:
+        for(const auto& spChild : node.children)
+            if(matches(*spChild, spMd, index))
+                return true;
+        return false;
+    }
+
+    return false;
+}
+
+}
@@ -0,0 +1,98 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef UMF_QUERY_PLANNER_HPP
+#define UMF_QUERY_PLANNER_HPP
+
+#include "umf/queryexpr.hpp"
+#include "metadatastream_index.hpp"
+
+#include <string>
+#include <vector>
+
+namespace umf {
+
+/*!
+ * \class QueryPlanner
+ * \brief Evaluates query expressions over the indexes of a metadata stream.
+ * \details Every condition is mapped to the index able to produce its
+ * candidates: id map, time and frame intervals, schema and name buckets,
+ * field value indexes and reference edges. A conjunction takes the cheapest
+ * candidate source of its operands and checks the remaining operands on
+ * each candidate, a disjunction unites the candidates of its operands when
+ * all of them have an index, otherwise the stream is scanned.
+ */
+class QueryPlanner
+{
+public:
+    explicit QueryPlanner(const MetadataStream& stream);
+
+    MetadataView select(const QueryExpr& expr) const;
+
+    std::string explain(const QueryExpr& expr) const;
+
+    //! Checks the expression on an item without looking for candidates
+    bool matches(const QueryExpr& expr, const std::shared_ptr<Metadata>& spMd) const;
+
+private:
+    typedef QueryExpr::Node Node;
+    typedef QueryExpr::Kind Kind;
+    typedef std::vector< std::shared_ptr<const Node> > Residual;
+
+    //! Source of candidates of an expression and the conditions left to check on them
+    struct Access
+    {
+        Access() : scan(false), overflow(false), cost(0) {}
+
+        bool scan;
+        bool overflow;          //!< more candidates than allowed, the access is incomplete
+        std::vector< const MetadataStream::Index::Bucket* > buckets;
+        std::vector< IdType > ids;
+        size_t cost;
+        Residual residual;
+        std::string description;
+    };
+
+    //! Schema and metadata names required by the enclosing conjunction
+    struct Context
+    {
+        Context() : pSchemaName(nullptr), pName(nullptr) {}
+
+        const std::string* pSchemaName;
+        const std::string* pName;
+    };
+
+    //! Candidates of the expression, lookups give up after more than limit candidates
+    Access plan(const std::shared_ptr<const Node>& spNode, const Context& context, size_t limit) const;
+    Access planAnd(const std::shared_ptr<const Node>& spNode, const Context& context, size_t limit) const;
+    Access planOr(const std::shared_ptr<const Node>& spNode, const Context& context, size_t limit) const;
+    Access planField(const std::shared_ptr<const Node>& spNode, const Context& context, size_t limit) const;
+    Access scan(size_t limit) const;
+
+    //! Conditions which number of candidates is known without a lookup
+    static bool isSized(Kind kind);
+    static bool lookup(const Node& node, const FieldIndex& index, std::vector<IdType>& ids, size_t limit);
+    static bool hasEdge(const std::unordered_map< IdType, MetadataStream::Index::Edges >& edges, IdType id,
+                        IdType other, bool bAnyOther, const std::string& refName, bool bAnyName);
+    static bool matches(const Node& node, const std::shared_ptr<Metadata>& spMd, const MetadataStream::Index& index);
+
+    const MetadataStream& m_stream;
+    const MetadataStream::Index& m_index;
+};
+
+}
+
+#endif /* UMF_QUERY_PLANNER_HPP */
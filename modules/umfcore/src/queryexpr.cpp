@@ -0,0 +1,247 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "umf/queryexpr.hpp"
+#include "umf/exceptions.hpp"
+
+namespace umf
+{
+
+static bool isNumeric( const Variant& value )
+{
+    return value.getType() == Variant::type_integer || value.getType() == Variant::type_real;
+}
+
+QueryExpr::QueryExpr() : m_spNode( std::make_shared<Node>( Kind::All ))
+{
+}
+
+QueryExpr QueryExpr::all()
+{
+    return QueryExpr();
+}
+
+QueryExpr QueryExpr::id( IdType id )
+{
+    auto spNode = std::make_shared<Node>( Kind::Id );
+    spNode->id = id;
+    return QueryExpr( spNode );
+}
+
+QueryExpr QueryExpr::schema( const std::string& sSchemaName )
+{
+    auto spNode = std::make_shared<Node>( Kind::Schema );
+    spNode->sName = sSchemaName;
+    return QueryExpr( spNode );
+}
+
+QueryExpr QueryExpr::name( const std::string& sName )
+{
+    auto spNode = std::make_shared<Node>( Kind::Name );
+    spNode->sName = sName;
+    return QueryExpr( spNode );
+}
+
+QueryExpr QueryExpr::time( long long startTime, long long endTime )
+{
+    auto spNode = std::make_shared<Node>( Kind::Time );
+    spNode->lo = startTime;
+    spNode->hi = endTime;
+    return QueryExpr( spNode );
+}
+
+QueryExpr QueryExpr::frames( long long firstFrame, long long lastFrame )
+{
+    auto spNode = std::make_shared<Node>( Kind::Frames );
+    spNode->lo = firstFrame;
+    spNode->hi = lastFrame;
+    return QueryExpr( spNode );
+}
+
+QueryExpr QueryExpr::field( const std::string& sFieldName, const Variant& value )
+{
+    return field( sFieldName, Compare::Equal, value );
+}
+
+QueryExpr QueryExpr::field( const std::string& sFieldName, Compare compare, const Variant& value )
+{
+    if( sFieldName.empty() )
+        UMF_EXCEPTION( IncorrectParamException, "Field name is empty" );
+    if( compare != Compare::Equal && compare != Compare::NotEqual && !isNumeric( value ))
+        UMF_EXCEPTION( IncorrectParamException, "Ordered comparison requires integer or real value" );
+
+    auto spNode = std::make_shared<Node>( Kind::Field );
+    spNode->sName = sFieldName;
+    spNode->compare = compare;
+    spNode->value = value;
+    return QueryExpr( spNode );
+}
+
+QueryExpr QueryExpr::fieldRange( const std::string& sFieldName, const Variant& lo, const Variant& hi )
+{
+    if( sFieldName.empty() )
+        UMF_EXCEPTION( IncorrectParamException, "Field name is empty" );
+    if( !isNumeric( lo ) || !isNumeric( hi ))
+        UMF_EXCEPTION( IncorrectParamException, "Range bounds should be integer or real values" );
+
+    auto spNode = std::make_shared<Node>( Kind::FieldRange );
+    spNode->sName = sFieldName;
+    spNode->value = lo;
+    spNode->bound = hi;
+    return QueryExpr( spNode );
+}
+
+QueryExpr QueryExpr::hasReference( const std::string& sRefName )
+{
+    auto spNode = std::make_shared<Node>( Kind::HasReference );
+    spNode->sName = sRefName;
+    return QueryExpr( spNode );
+}
+
+QueryExpr QueryExpr::referencesTo( IdType id )
+{
+    auto spNode = std::make_shared<Node>( Kind::ReferencesTo );
+    spNode->id = id;
+    spNode->bAnyName = true;
+    return QueryExpr( spNode );
+}
+
+QueryExpr QueryExpr::referencesTo( IdType id, const std::string& sRefName )
+{
+    auto spNode = std::make_shared<Node>( Kind::ReferencesTo );
+    spNode->id = id;
+    spNode->sName = sRefName;
+    return QueryExpr( spNode );
+}
+
+QueryExpr QueryExpr::referencedBy( IdType id )
+{
+    auto spNode = std::make_shared<Node>( Kind::ReferencedBy );
+    spNode->id = id;
+    spNode->bAnyName = true;
+    return QueryExpr( spNode );
+}
+
+QueryExpr QueryExpr::referencedBy( IdType id, const std::string& sRefName )
+{
+    auto spNode = std::make_shared<Node>( Kind::ReferencedBy );
+    spNode->id = id;
+    spNode->sName = sRefName;
+    return QueryExpr( spNode );
+}
+
+QueryExpr QueryExpr::predicate( Filter filter )
+{
+    if( !filter )
+        UMF_EXCEPTION( IncorrectParamException, "Predicate is empty" );
+
+    auto spNode = std::make_shared<Node>( Kind::Predicate );
+    spNode->filter = filter;
+    return QueryExpr( spNode );
+}
+
+QueryExpr QueryExpr::combine( Kind kind, const QueryExpr& left, const QueryExpr& right )
+{
+    // Nested operations of the same kind are flattened, so "a && b && c" is a single node
+    auto spNode = std::make_shared<Node>( kind );
+    for( const auto& spOperand : { left.m_spNode, right.m_spNode } )
+    {
+        if( spOperand->kind == kind )
+            spNode->children.insert( spNode->children.end(), spOperand->children.begin(), spOperand->children.end() );
+        else
+            spNode->children.push_back( spOperand );
+    }
+    return QueryExpr( spNode );
+}
+
+QueryExpr operator && ( const QueryExpr& left, const QueryExpr& right )
+{
+    return QueryExpr::combine( QueryExpr::Kind::And, left, right );
+}
+
+QueryExpr operator || ( const QueryExpr& left, const QueryExpr& right )
+{
+    return QueryExpr::combine( QueryExpr::Kind::Or, left, right );
+}
+
+QueryExpr operator ! ( const QueryExpr& expr )
+{
+    if( expr.m_spNode->kind == QueryExpr::Kind::Not )
+        return QueryExpr( expr.m_spNode->children.front() );
+
+    auto spNode = std::make_shared<QueryExpr::Node>( QueryExpr::Kind::Not );
+    spNode->children.push_back( expr.m_spNode );
+    return QueryExpr( spNode );
+}
+
+std::string QueryExpr::toString() const
+{
+    return toString( *m_spNode );
+}
+
+std::string QueryExpr::toString( const Node& node )
+{
+    static const char* const compareNames[] = { "=", "!=", "<", "<=", ">", ">=" };
+    auto interval = []( long long lo, long long hi )
+    {
+        return "[" + to_string( lo ) + ", " + to_string( hi ) + "]";
+    };
+    auto refName = [&]()
+    {
+        return node.bAnyName ? std::string() : " as \"" + node.sName.str() + "\"";
+    };
+
+    switch( node.kind )
+    {
+    case Kind::All:
+        return "all";
+    case Kind::Id:
+        return "id = " + to_string( node.id );
+    case Kind::Schema:
+        return "schema = \"" + node.sName.str() + "\"";
+    case Kind::Name:
+        return "name = \"" + node.sName.str() + "\"";
+    case Kind::Time:
+        return "time in " + interval( node.lo, node.hi );
+    case Kind::Frames:
+        return "frame in " + interval( node.lo, node.hi );
+    case Kind::Field:
+        return node.sName.str() + " " + compareNames[(int)node.compare] + " " + node.value.toString();
+    case Kind::FieldRange:
+        return node.sName.str() + " in [" + node.value.toString() + ", " + node.bound.toString() + "]";
+    case Kind::HasReference:
+        return "has reference \"" + node.sName.str() + "\"";
+    case Kind::ReferencesTo:
+        return "references " + to_string( node.id ) + refName();
+    case Kind::ReferencedBy:
+        return "referenced by " + to_string( node.id ) + refName();
+    case Kind::Predicate:
+        return "predicate";
+    case Kind::Not:
+        return "NOT " + toString( *node.children.front() );
+    case Kind::And:
+    case Kind::Or:
+    {
+        std::string s;
+        for( const auto& spChild : node.children )
+            s += ( s.empty() ? "(" : node.kind == Kind::And ? " AND " : " OR " ) + toString( *spChild );
+        return s + ")";
+    }
+    }
+    return std::string();
+}
+
+}
@@ -0,0 +1,125 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "rwlock.hpp"
+#include "umf/exceptions.hpp"
+
+#include <vector>
+
+namespace umf {
+
+thread_local std::vector<RWLock::Holder> RWLock::t_holders;
+
+RWLock::RWLock() : m_nReaders(0), m_nWriters(0), m_bWriting(false)
+{
+}
+
+RWLock::Holder& RWLock::holder()
+{
+    for(auto& h : t_holders)
+        if(h.pLock == this)
+            return h;
+    Holder h = { this, 0, 0 };
+    t_holders.push_back(h);
+    return t_holders.back();
+}
+
+void RWLock::release(Holder& h)
+{
+    if(h.nShared || h.nExclusive)
+        return;
+    h = t_holders.back();
+    t_holders.pop_back();
+}
+
+void RWLock::lockShared()
+{
+    Holder& h = holder();
+    if(h.nShared || h.nExclusive)
+    {
+        h.nShared++;
+        return;
+    }
+
+    for(;;)
+    {
+        if(m_nWriters.load() == 0)
+        {
+            m_nReaders.fetch_add(1);
+            // A writer could come between the check and the increment, let it go first
+            if(m_nWriters.load() == 0)
+                break;
+            releaseShared();
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this]() { return m_nWriters.load() == 0; });
+    }
+    h.nShared++;
+}
+
+void RWLock::unlockShared()
+{
+    Holder& h = holder();
+    if(--h.nShared == 0 && h.nExclusive == 0)
+        releaseShared();
+    release(h);
+}
+
+void RWLock::releaseShared()
+{
+    if(m_nReaders.fetch_sub(1) == 1 && m_nWriters.load() > 0)
+    {
+        // Taking the mutex ensures the writer is either waiting or yet to check the readers
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cond.notify_all();
+    }
+}
+
+void RWLock::lock()
+{
+    Holder& h = holder();
+    if(h.nExclusive)
+    {
+        h.nExclusive++;
+        return;
+    }
+    if(h.nShared)
+        UMF_EXCEPTION(InternalErrorException, "Can't lock for writing while holding the lock for reading");
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_nWriters.fetch_add(1);
+    m_cond.wait(lock, [this]() { return !m_bWriting && m_nReaders.load() == 0; });
+    m_bWriting = true;
+    h.nExclusive++;
+}
+
+void RWLock::unlock()
+{
+    Holder& h = holder();
+    if(--h.nExclusive)
+        return;
+    release(h);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bWriting = false;
+        m_nWriters.fetch_sub(1);
+    }
+    m_cond.notify_all();
+}
+
+}
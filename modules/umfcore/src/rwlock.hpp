@@ -0,0 +1,97 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef UMF_RWLOCK_HPP
+#define UMF_RWLOCK_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace umf {
+
+/*!
+ * \class RWLock
+ * \brief Reader-writer lock admitting any number of readers or a single writer.
+ * \details A reader enters with one atomic increment unless a writer holds or
+ * waits for the lock, waiting writers block new readers so writers don't starve.
+ * Locking is recursive per thread and a writer may also lock for reading,
+ * upgrading a read lock to the write one throws InternalErrorException.
+ */
+class RWLock
+{
+public:
+    RWLock();
+
+    void lockShared();
+    void unlockShared();
+    void lock();
+    void unlock();
+
+    //! Holds the lock for reading in its scope, does nothing for null lock
+    class SharedGuard
+    {
+    public:
+        explicit SharedGuard(RWLock* pLock) : m_pLock(pLock) { if(m_pLock) m_pLock->lockShared(); }
+        ~SharedGuard() { if(m_pLock) m_pLock->unlockShared(); }
+    private:
+        SharedGuard(const SharedGuard&) = delete;
+        SharedGuard& operator=(const SharedGuard&) = delete;
+        RWLock* m_pLock;
+    };
+
+    //! Holds the lock for writing in its scope, does nothing for null lock
+    class ExclusiveGuard
+    {
+    public:
+        explicit ExclusiveGuard(RWLock* pLock) : m_pLock(pLock) { if(m_pLock) m_pLock->lock(); }
+        ~ExclusiveGuard() { if(m_pLock) m_pLock->unlock(); }
+    private:
+        ExclusiveGuard(const ExclusiveGuard&) = delete;
+        ExclusiveGuard& operator=(const ExclusiveGuard&) = delete;
+        RWLock* m_pLock;
+    };
+
+private:
+    RWLock(const RWLock&) = delete;
+    RWLock& operator=(const RWLock&) = delete;
+
+    //! Recursion depths of the current thread for a lock
+    struct Holder
+    {
+        const RWLock* pLock;
+        unsigned nShared;
+        unsigned nExclusive;
+    };
+
+    //! Locks held by the current thread, usually none or one
+    static thread_local std::vector<Holder> t_holders;
+
+    Holder& holder();
+    static void release(Holder& h);
+    void releaseShared();
+
+    std::atomic<int> m_nReaders;    //!< readers inside, including the ones backing off
+    std::atomic<int> m_nWriters;    //!< writers inside or waiting
+    bool m_bWriting;                //!< guarded by m_mutex
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+};
+
+}
+
+#endif /* UMF_RWLOCK_HPP */
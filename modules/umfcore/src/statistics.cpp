@@ -17,70 +17,178 @@
 #include "umf/statistics.hpp"
 #include "umf/metadata.hpp"
 #include "umf/metadatastream.hpp"
+#include "text_codec.hpp"
 
+#include <algorithm>
 #include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <unordered_map>
 
 #include<stdio.h>
 
 namespace umf
 {
 
-// class StatOpBase: builtin operations
+// visitors for builtin numeric operations, the operand has the type of the visited value
+
+namespace
+{
+
+struct IsLess
+{
+    template< class T > bool operator()( const T& a, const T& b ) const
+        { return a < b; }
+};
 
-class StatOpMin: public StatOpBase
+struct IsGreater
+{
+    template< class T > bool operator()( const T& a, const T& b ) const
+        { return a > b; }
+};
+
+template< class Compare > class ReplacedBy
 {
 public:
-    StatOpMin()
-        {}
-    virtual ~StatOpMin()
-        {}
+    explicit ReplacedBy( const Variant& candidate )
+        : m_candidate( candidate ) {}
+
+    bool operator()( const umf_integer& value ) const
+        { return Compare()( *m_candidate.try_get< umf_integer >(), value ); }
+    bool operator()( const umf_real& value ) const
+        { return Compare()( *m_candidate.try_get< umf_real >(), value ); }
+    template< class T > bool operator()( const T& ) const
+        { UMF_EXCEPTION( umf::NotImplementedException, "Operation not applicable to this data type" ); }
+
+private:
+    const Variant& m_candidate;
+};
 
+class Plus
+{
+public:
+    explicit Plus( const Variant& operand )
+        : m_operand( operand ) {}
+
+    Variant operator()( const umf_integer& value ) const
+        { return Variant( value + *m_operand.try_get< umf_integer >() ); }
+    Variant operator()( const umf_real& value ) const
+        { return Variant( value + *m_operand.try_get< umf_real >() ); }
+    template< class T > Variant operator()( const T& ) const
+        { UMF_EXCEPTION( umf::NotImplementedException, "Operation not applicable to this data type" ); }
+
+private:
+    const Variant& m_operand;
+};
+
+class Minus
+{
+public:
+    explicit Minus( const Variant& operand )
+        : m_operand( operand ) {}
+
+    Variant operator()( const umf_integer& value ) const
+        { return Variant( value - *m_operand.try_get< umf_integer >() ); }
+    Variant operator()( const umf_real& value ) const
+        { return Variant( value - *m_operand.try_get< umf_real >() ); }
+    template< class T > Variant operator()( const T& ) const
+        { UMF_EXCEPTION( umf::NotImplementedException, "Operation not applicable to this data type" ); }
+
+private:
+    const Variant& m_operand;
+};
+
+} // anonymous namespace
+
+// class StatOpBase
+
+void StatOpBase::unhandle( const Variant& /*fieldValue*/ )
+{
+    UMF_EXCEPTION( umf::NotImplementedException, "Operation isn't reversible: " + name() );
+}
+
+// class StatOpBase: builtin operations
+
+// Min and Max keep the number of occurrences of each distinct value,
+// so that the extreme one is known again once a value is removed
+class StatOpOrdered: public StatOpBase
+{
 public:
-    virtual std::string name() const
-        { return StatOpFactory::builtinName( StatOpFactory::BuiltinOp::Min ); }
     virtual void reset()
         {
             std::unique_lock< std::mutex > lock( m_lock );
-            m_value = Variant();
+            m_values.clear();
         }
     virtual void handle( const Variant& fieldValue )
         {
             std::unique_lock< std::mutex > lock( m_lock );
-            if( m_value.isEmpty() )
-                m_value = fieldValue;
-            else if( m_value.getType() != fieldValue.getType() )
-                UMF_EXCEPTION( umf::TypeCastException, "Type mismatch" );
-            else
-                switch( m_value.getType() )
-                {
-                case Variant::type_integer:
-                    if( fieldValue.get_integer() < m_value.get_integer() )
-                        m_value = fieldValue;
-                    break;
-                case Variant::type_real:
-                    if( fieldValue.get_real() < m_value.get_real() )
-                        m_value = fieldValue;
-                    break;
-                default:
-                    UMF_EXCEPTION( umf::NotImplementedException, "Operation not applicable to this data type" );
-                }
+            add( fieldValue );
         }
-    virtual Variant value() const
+    virtual void handle( const Variant* const* fieldValues, size_t count )
         {
             std::unique_lock< std::mutex > lock( m_lock );
-            return m_value;
+            for( size_t i = 0; i < count; i++ )
+                add( *fieldValues[i] );
+        }
+    virtual bool isReversible() const
+        { return true; }
+    virtual void unhandle( const Variant& fieldValue )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            checkType( fieldValue );
+            auto it = m_values.find( fieldValue );
+            if( it != m_values.end() && --it->second == 0 )
+                m_values.erase( it );
+        }
+
+protected:
+    struct Less
+    {
+        bool operator()( const Variant& a, const Variant& b ) const
+            { return b.visit( ReplacedBy< IsLess >( a )); }
+    };
+
+    void checkType( const Variant& fieldValue ) const
+        {
+            if( !m_values.empty() && m_values.begin()->first.getType() != fieldValue.getType() )
+                UMF_EXCEPTION( umf::TypeCastException, "Type mismatch" );
+        }
+    void add( const Variant& fieldValue )
+        {
+            checkType( fieldValue );
+            ++m_values[ fieldValue ];
         }
 
-private:
     mutable std::mutex m_lock;
-    Variant m_value;
+    std::map< Variant, size_t, Less > m_values;
+};
+
+class StatOpMin: public StatOpOrdered
+{
+public:
+    StatOpMin()
+        {}
+    virtual ~StatOpMin()
+        {}
+
+public:
+    virtual std::string name() const
+        { return StatOpFactory::builtinName( StatOpFactory::BuiltinOp::Min ); }
+    virtual Variant value() const
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            return m_values.empty() ? Variant() : m_values.begin()->first;
+        }
 
 public:
     static StatOpBase* createInstance()
         { return new StatOpMin(); }
 };
 
-class StatOpMax: public StatOpBase
+class StatOpMax: public StatOpOrdered
 {
 public:
     StatOpMax()
@@ -91,43 +199,12 @@ public:
 public:
     virtual std::string name() const
         { return StatOpFactory::builtinName( StatOpFactory::BuiltinOp::Max ); }
-    virtual void reset()
-        {
-            std::unique_lock< std::mutex > lock( m_lock );
-            m_value = Variant();
-        }
-    virtual void handle( const Variant& fieldValue )
-        {
-            std::unique_lock< std::mutex > lock( m_lock );
-            if( m_value.isEmpty() )
-                m_value = fieldValue;
-            else if( m_value.getType() != fieldValue.getType() )
-                UMF_EXCEPTION( umf::TypeCastException, "Type mismatch" );
-            else
-                switch( m_value.getType() )
-                {
-                case Variant::type_integer:
-                    if( fieldValue.get_integer() > m_value.get_integer() )
-                        m_value = fieldValue;
-                    break;
-                case Variant::type_real:
-                    if( fieldValue.get_real() > m_value.get_real() )
-                        m_value = fieldValue;
-                    break;
-                default:
-                    UMF_EXCEPTION( umf::NotImplementedException, "Operation not applicable to this data type" );
-                }
-        }
     virtual Variant value() const
         {
             std::unique_lock< std::mutex > lock( m_lock );
-            return m_value;
+            return m_values.empty() ? Variant() : m_values.rbegin()->first;
         }
 
-private:
-    mutable std::mutex m_lock;
-    Variant m_value;
-
 public:
     static StatOpBase* createInstance()
         { return new StatOpMax(); }
@@ -151,24 +228,29 @@ public:
             m_value = Variant();
         }
     virtual void handle( const Variant& fieldValue )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            add( fieldValue );
+        }
+    virtual void handle( const Variant* const* fieldValues, size_t count )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            for( size_t i = 0; i < count; i++ )
+                add( *fieldValues[i] );
+        }
+    virtual bool isReversible() const
+        { return true; }
+    virtual void unhandle( const Variant& fieldValue )
         {
             std::unique_lock< std::mutex > lock( m_lock );
             if( m_value.isEmpty() )
-                { m_count = 1; m_value = fieldValue; }
+                return;
             else if( m_value.getType() != fieldValue.getType() )
                 UMF_EXCEPTION( umf::TypeCastException, "Type mismatch" );
+            else if( --m_count == 0 )
+                m_value = Variant();
             else
-                switch( m_value.getType() )
-                {
-                case Variant::type_integer:
-                    ++m_count; m_value = Variant( m_value.get_integer() + fieldValue.get_integer() );
-                    break;
-                case Variant::type_real:
-                    ++m_count; m_value = Variant( m_value.get_real() + fieldValue.get_real() );
-                    break;
-                default:
-                    UMF_EXCEPTION( umf::NotImplementedException, "Operation not applicable to this data type" );
-                }
+                m_value = m_value.visit( Minus( fieldValue ) );
         }
     virtual Variant value() const
         {
@@ -188,6 +270,16 @@ public:
         }
 
 private:
+    void add( const Variant& fieldValue )
+        {
+            if( m_value.isEmpty() )
+                { m_count = 1; m_value = fieldValue; }
+            else if( m_value.getType() != fieldValue.getType() )
+                UMF_EXCEPTION( umf::TypeCastException, "Type mismatch" );
+            else
+                { m_value = m_value.visit( Plus( fieldValue ) ); ++m_count; }
+        }
+
     mutable std::mutex m_lock;
     Variant m_value;
     umf_integer m_count;
@@ -218,6 +310,19 @@ public:
             std::unique_lock< std::mutex > lock( m_lock );
             ++m_count;
         }
+    virtual void handle( const Variant* const* /*fieldValues*/, size_t count )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            m_count += (umf_integer)count;
+        }
+    virtual bool isReversible() const
+        { return true; }
+    virtual void unhandle( const Variant& /*fieldValue*/ )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            if( m_count > 0 )
+                --m_count;
+        }
     virtual Variant value() const
         {
             std::unique_lock< std::mutex > lock( m_lock );
@@ -237,89 +342,586 @@ class StatOpSum: public StatOpBase
 {
 public:
     StatOpSum()
-        {}
+        : m_count( 0 ) {}
     virtual ~StatOpSum()
         {}
 
 public:
     virtual std::string name() const
         { return StatOpFactory::builtinName( StatOpFactory::BuiltinOp::Sum ); }
+    virtual void reset()
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            m_count = 0;
+            m_value = Variant();
+        }
+    virtual void handle( const Variant& fieldValue )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            add( fieldValue );
+        }
+    virtual void handle( const Variant* const* fieldValues, size_t count )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            for( size_t i = 0; i < count; i++ )
+                add( *fieldValues[i] );
+        }
+    virtual bool isReversible() const
+        { return true; }
+    virtual void unhandle( const Variant& fieldValue )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            if( m_value.isEmpty() )
+                return;
+            else if( m_value.getType() != fieldValue.getType() )
+                UMF_EXCEPTION( umf::TypeCastException, "Type mismatch" );
+            else if( --m_count == 0 )
+                m_value = Variant();
+            else
+                m_value = m_value.visit( Minus( fieldValue ) );
+        }
+    virtual Variant value() const
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            return m_value;
+        }
+
+private:
+    void add( const Variant& fieldValue )
+        {
+            if( m_value.isEmpty() )
+                { m_count = 1; m_value = fieldValue; }
+            else if( m_value.getType() != fieldValue.getType() )
+                UMF_EXCEPTION( umf::TypeCastException, "Type mismatch" );
+            else
+                { m_value = m_value.visit( Plus( fieldValue ) ); ++m_count; }
+        }
+
+    mutable std::mutex m_lock;
+    Variant m_value;
+    umf_integer m_count;
+
+public:
+    static StatOpBase* createInstance()
+        { return new StatOpSum(); }
+};
+
+class StatOpLast: public StatOpBase
+{
+public:
+    StatOpLast()
+        {}
+    virtual ~StatOpLast()
+        {}
+
+public:
+    virtual std::string name() const
+        { return StatOpFactory::builtinName( StatOpFactory::BuiltinOp::Last ); }
     virtual void reset()
         {
             std::unique_lock< std::mutex > lock( m_lock );
             m_value = Variant();
         }
-    virtual void handle( const Variant& fieldValue )
+    virtual void handle( const Variant& fieldValue )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            m_value = fieldValue;
+        }
+    virtual void handle( const Variant* const* fieldValues, size_t count )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            if( count != 0 )
+                m_value = *fieldValues[count - 1];
+        }
+    virtual Variant value() const
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            return m_value;
+        }
+
+private:
+    mutable std::mutex m_lock;
+    Variant m_value;
+
+public:
+    static StatOpBase* createInstance()
+        { return new StatOpLast(); }
+};
+
+// Numeric operations below take integers and reals alike and keep bounded state
+
+namespace
+{
+
+umf_real toReal( const Variant& value )
+{
+    switch( value.getType() )
+    {
+    case Variant::type_integer:
+        return (umf_real)value.get_integer();
+    case Variant::type_real:
+        return value.get_real();
+    default:
+        UMF_EXCEPTION( umf::NotImplementedException, "Operation not applicable to this data type" );
+    }
+}
+
+void checkParamCount( const std::vector< umf_real >& params, size_t count, const std::string& name )
+{
+    if( params.size() != count )
+        UMF_EXCEPTION( umf::IncorrectParamException, "Wrong number of parameters for " + name );
+}
+
+} // anonymous namespace
+
+class StatOpVariance: public StatOpBase
+{
+public:
+    StatOpVariance()
+        : m_type( Variant::type_empty ), m_count( 0 ), m_mean( 0 ), m_m2( 0 ) {}
+    virtual ~StatOpVariance()
+        {}
+
+public:
+    virtual std::string name() const
+        { return StatOpFactory::builtinName( StatOpFactory::BuiltinOp::Variance ); }
+    virtual void reset()
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            m_type = Variant::type_empty; m_count = 0; m_mean = 0; m_m2 = 0;
+        }
+    virtual void handle( const Variant& fieldValue )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            add( input( fieldValue ));
+        }
+    virtual void handle( const Variant* const* fieldValues, size_t count )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            for( size_t i = 0; i < count; i++ )
+                add( input( *fieldValues[i] ));
+        }
+    virtual bool isReversible() const
+        { return true; }
+    virtual void unhandle( const Variant& fieldValue )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            umf_real x = input( fieldValue );
+            if( m_count <= 1 )
+                { m_type = Variant::type_empty; m_count = 0; m_mean = 0; m_m2 = 0; return; }
+            umf_real mean = (m_mean * m_count - x) / (m_count - 1);
+            m_m2 = std::max( m_m2 - (x - mean) * (x - m_mean), (umf_real)0 );
+            m_mean = mean;
+            --m_count;
+        }
+    virtual Variant value() const
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            if( m_count == 0 )
+                return Variant();
+            return Variant( m_m2 / m_count );
+        }
+
+protected:
+    // input type is fixed by the first value, as for Average
+    umf_real input( const Variant& value )
+        {
+            umf_real x = toReal( value );
+            if( m_type == Variant::type_empty )
+                m_type = value.getType();
+            else if( value.getType() != m_type )
+                UMF_EXCEPTION( umf::TypeCastException, "Type mismatch" );
+            return x;
+        }
+    void add( umf_real x )
+        {
+            ++m_count;
+            umf_real delta = x - m_mean;
+            m_mean += delta / m_count;
+            m_m2 += delta * (x - m_mean);
+        }
+
+    mutable std::mutex m_lock;
+    Variant::Type m_type;
+    umf_integer m_count;
+    umf_real m_mean;
+    umf_real m_m2;
+
+public:
+    static StatOpBase* createInstance()
+        { return new StatOpVariance(); }
+};
+
+class StatOpStdDev: public StatOpVariance
+{
+public:
+    virtual std::string name() const
+        { return StatOpFactory::builtinName( StatOpFactory::BuiltinOp::StdDev ); }
+    virtual Variant value() const
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            if( m_count == 0 )
+                return Variant();
+            return Variant( std::sqrt( m_m2 / m_count ));
+        }
+
+public:
+    static StatOpBase* createInstance()
+        { return new StatOpStdDev(); }
+};
+
+class StatOpHistogram: public StatOpBase
+{
+public:
+    StatOpHistogram( const std::vector< umf_real >& params, bool isLog, const std::string& name )
+        : m_name( name ), m_isLog( isLog )
+        {
+            checkParamCount( params, 3, name );
+            m_lower = params[0];
+            m_upper = params[1];
+            umf_real buckets = params[2];
+            if( !(m_lower < m_upper) || (m_isLog && !(m_lower > 0)) )
+                UMF_EXCEPTION( umf::IncorrectParamException, "Wrong histogram range for " + name );
+            if( !(buckets >= 1 && buckets <= 65536) || buckets != std::floor( buckets ))
+                UMF_EXCEPTION( umf::IncorrectParamException, "Wrong number of histogram buckets for " + name );
+            m_scale = m_isLog ? buckets / std::log( m_upper / m_lower ) : buckets / (m_upper - m_lower);
+            m_counts.assign( (size_t)buckets + 2, 0 );
+        }
+    virtual ~StatOpHistogram()
+        {}
+
+public:
+    virtual std::string name() const
+        { return m_name; }
+    virtual void reset()
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            std::fill( m_counts.begin(), m_counts.end(), 0 );
+        }
+    virtual void handle( const Variant& fieldValue )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            ++m_counts[ bucket( toReal( fieldValue )) ];
+        }
+    virtual void handle( const Variant* const* fieldValues, size_t count )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            for( size_t i = 0; i < count; i++ )
+                ++m_counts[ bucket( toReal( *fieldValues[i] )) ];
+        }
+    virtual bool isReversible() const
+        { return true; }
+    virtual void unhandle( const Variant& fieldValue )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            umf_integer& count = m_counts[ bucket( toReal( fieldValue )) ];
+            if( count > 0 )
+                --count;
+        }
+    virtual Variant value() const
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            return Variant( m_counts );
+        }
+
+private:
+    size_t bucket( umf_real x ) const
+        {
+            if( !(x >= m_lower) ) // NaN included
+                return 0;
+            if( x >= m_upper )
+                return m_counts.size() - 1;
+            umf_real pos = m_isLog ? std::log( x / m_lower ) * m_scale : (x - m_lower) * m_scale;
+            return std::min( (size_t)pos, m_counts.size() - 3 ) + 1;
+        }
+
+    const std::string m_name;
+    const bool m_isLog;
+    umf_real m_lower;
+    umf_real m_upper;
+    umf_real m_scale;
+    mutable std::mutex m_lock;
+    std::vector< umf_integer > m_counts;
+
+public:
+    static StatOpBase* createInstance()
+        { return new StatOpHistogram( { 0, 100, 10 }, false, StatOpFactory::builtinName( StatOpFactory::BuiltinOp::Histogram )); }
+};
+
+class StatOpLogHistogram: public StatOpHistogram
+{
+public:
+    static StatOpBase* createInstance()
+        { return new StatOpHistogram( { 1, 1048576, 20 }, true, StatOpFactory::builtinName( StatOpFactory::BuiltinOp::LogHistogram )); }
+};
+
+// Values are counted in buckets of 1/128 of each power of two, as in HDR histograms,
+// for magnitudes from 2^-64 to 2^64; smaller ones count as zero, larger ones are clamped
+class StatOpQuantiles: public StatOpBase
+{
+public:
+    StatOpQuantiles( const std::vector< umf_real >& params, const std::string& name )
+        : m_name( name ), m_probabilities( params ), m_count( 0 )
+        {
+            if( m_probabilities.empty() )
+                UMF_EXCEPTION( umf::IncorrectParamException, "Wrong number of parameters for " + name );
+            for( umf_real p : m_probabilities )
+                if( !(p >= 0 && p <= 1) )
+                    UMF_EXCEPTION( umf::IncorrectParamException, "Quantile probability outside of [0, 1] for " + name );
+        }
+    virtual ~StatOpQuantiles()
+        {}
+
+public:
+    virtual std::string name() const
+        { return m_name; }
+    virtual void reset()
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            m_buckets.clear();
+            m_count = 0;
+        }
+    virtual void handle( const Variant& fieldValue )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            ++m_buckets[ bucket( toReal( fieldValue )) ];
+            ++m_count;
+        }
+    virtual void handle( const Variant* const* fieldValues, size_t count )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            for( size_t i = 0; i < count; i++ )
+                ++m_buckets[ bucket( toReal( *fieldValues[i] )) ];
+            m_count += (umf_integer)count;
+        }
+    virtual bool isReversible() const
+        { return true; }
+    virtual void unhandle( const Variant& fieldValue )
         {
             std::unique_lock< std::mutex > lock( m_lock );
-            if( m_value.isEmpty() )
-                { m_value = fieldValue; }
-            else if( m_value.getType() != fieldValue.getType() )
-                UMF_EXCEPTION( umf::TypeCastException, "Type mismatch" );
-            else
-                switch( m_value.getType() )
-                {
-                case Variant::type_integer:
-                    m_value = Variant( m_value.get_integer() + fieldValue.get_integer() );
-                    break;
-                case Variant::type_real:
-                    m_value = Variant( m_value.get_real() + fieldValue.get_real() );
-                    break;
-                default:
-                    UMF_EXCEPTION( umf::NotImplementedException, "Operation not applicable to this data type" );
-                }
+            auto it = m_buckets.find( bucket( toReal( fieldValue )));
+            if( it == m_buckets.end() )
+                return;
+            if( --it->second == 0 )
+                m_buckets.erase( it );
+            --m_count;
         }
     virtual Variant value() const
         {
             std::unique_lock< std::mutex > lock( m_lock );
-            return m_value;
+            if( m_count == 0 )
+                return Variant();
+            std::vector< umf_real > quantiles;
+            for( umf_real p : m_probabilities )
+            {
+                // nearest rank
+                umf_integer rank = std::max( (umf_integer)std::ceil( p * m_count ), (umf_integer)1 );
+                umf_integer seen = 0;
+                auto it = m_buckets.begin();
+                while( (seen += it->second) < rank )
+                    ++it;
+                quantiles.push_back( middle( it->first ));
+            }
+            return Variant( quantiles );
         }
 
 private:
+    static const int subBuckets = 128;
+    static const int minExponent = -63;
+    static const int maxExponent = 64;
+
+    // ordered as the values: 0 for zero, positive for positive values, negative for negative ones
+    static int bucket( umf_real x )
+        {
+            umf_real magnitude = std::fabs( x );
+            if( !(magnitude >= std::ldexp( 0.5, minExponent )) ) // NaN included
+                return 0;
+            int exponent;
+            umf_real mantissa = std::frexp( magnitude, &exponent ); // [0.5, 1)
+            if( exponent > maxExponent )
+            {
+                exponent = maxExponent;
+                mantissa = 1 - 0.5 / subBuckets;
+            }
+            int sub = std::min( (int)((mantissa - 0.5) * 2 * subBuckets), subBuckets - 1 );
+            int index = (exponent - minExponent) * subBuckets + sub + 1;
+            return x < 0 ? -index : index;
+        }
+    static umf_real middle( int index )
+        {
+            if( index == 0 )
+                return 0;
+            int magnitude = std::abs( index ) - 1;
+            int exponent = magnitude / subBuckets + minExponent;
+            umf_real mantissa = 0.5 + (magnitude % subBuckets + 0.5) / (2 * subBuckets);
+            umf_real value = std::ldexp( mantissa, exponent );
+            return index < 0 ? -value : value;
+        }
+
+    const std::string m_name;
+    const std::vector< umf_real > m_probabilities;
     mutable std::mutex m_lock;
-    Variant m_value;
+    std::map< int, umf_integer > m_buckets;
+    umf_integer m_count;
 
 public:
     static StatOpBase* createInstance()
-        { return new StatOpSum(); }
+        { return new StatOpQuantiles( { 0.5, 0.95, 0.99 }, StatOpFactory::builtinName( StatOpFactory::BuiltinOp::Quantiles )); }
 };
 
-class StatOpLast: public StatOpBase
+// HyperLogLog (Flajolet et al.) with the linear counting correction for small cardinalities
+class StatOpDistinctCount: public StatOpBase
 {
 public:
-    StatOpLast()
-        {}
-    virtual ~StatOpLast()
+    StatOpDistinctCount( const std::vector< umf_real >& params, const std::string& name )
+        : m_name( name )
+        {
+            checkParamCount( params, 1, name );
+            if( !(params[0] >= 4 && params[0] <= 18) || params[0] != std::floor( params[0] ))
+                UMF_EXCEPTION( umf::IncorrectParamException, "HyperLogLog precision outside of [4, 18] for " + name );
+            m_precision = (int)params[0];
+            m_registers.assign( (size_t)1 << m_precision, 0 );
+        }
+    virtual ~StatOpDistinctCount()
         {}
 
 public:
     virtual std::string name() const
-        { return StatOpFactory::builtinName( StatOpFactory::BuiltinOp::Last ); }
+        { return m_name; }
     virtual void reset()
         {
             std::unique_lock< std::mutex > lock( m_lock );
-            m_value = Variant();
+            std::fill( m_registers.begin(), m_registers.end(), 0 );
         }
     virtual void handle( const Variant& fieldValue )
         {
+            uint64_t h = hash( fieldValue );
             std::unique_lock< std::mutex > lock( m_lock );
-            m_value = fieldValue;
+            add( h );
+        }
+    virtual void handle( const Variant* const* fieldValues, size_t count )
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            for( size_t i = 0; i < count; i++ )
+                add( hash( *fieldValues[i] ));
         }
     virtual Variant value() const
         {
             std::unique_lock< std::mutex > lock( m_lock );
-            return m_value;
+            const umf_real m = (umf_real)m_registers.size();
+            umf_real sum = 0;
+            size_t zeros = 0;
+            for( uint8_t r : m_registers )
+            {
+                sum += std::ldexp( 1.0, -(int)r );
+                zeros += (r == 0);
+            }
+            umf_real alpha = m_registers.size() == 16 ? 0.673 : m_registers.size() == 32 ? 0.697 :
+                             m_registers.size() == 64 ? 0.709 : 0.7213 / (1 + 1.079 / m);
+            umf_real estimate = alpha * m * m / sum;
+            if( estimate <= 2.5 * m && zeros != 0 )
+                estimate = m * std::log( m / zeros );
+            return Variant( (umf_integer)std::llround( estimate ));
         }
 
 private:
+    static uint64_t mix( uint64_t x )
+        {
+            // splitmix64 finalizer
+            x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+            x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+            return x ^ (x >> 31);
+        }
+    static uint64_t hash( const Variant& value )
+        {
+            switch( value.getType() )
+            {
+            case Variant::type_integer:
+                return mix( (uint64_t)value.get_integer() );
+            case Variant::type_real:
+            {
+                umf_real x = value.get_real();
+                uint64_t bits = 0;
+                if( x != 0 ) // +0 and -0 are the same value
+                    std::memcpy( &bits, &x, sizeof( bits ));
+                return mix( bits ^ 0x9e3779b97f4a7c15ULL );
+            }
+            default:
+            {
+                // FNV-1a over the text of the value
+                const std::string text = value.getType() == Variant::type_string ? value.get_string() : value.toString();
+                uint64_t h = 0xcbf29ce484222325ULL;
+                for( unsigned char c : text )
+                    h = (h ^ c) * 0x100000001b3ULL;
+                return mix( h );
+            }
+            }
+        }
+    void add( uint64_t h )
+        {
+            size_t index = (size_t)(h >> (64 - m_precision));
+            uint64_t rest = (h << m_precision) | ((uint64_t)1 << (m_precision - 1));
+            uint8_t rank = 1;
+            while( !(rest & 0x8000000000000000ULL) )
+            {
+                rest <<= 1;
+                ++rank;
+            }
+            if( rank > m_registers[index] )
+                m_registers[index] = rank;
+        }
+
+    const std::string m_name;
+    int m_precision;
     mutable std::mutex m_lock;
-    Variant m_value;
+    std::vector< uint8_t > m_registers;
 
 public:
     static StatOpBase* createInstance()
-        { return new StatOpLast(); }
+        { return new StatOpDistinctCount( { 12 }, StatOpFactory::builtinName( StatOpFactory::BuiltinOp::DistinctCount )); }
 };
 
+namespace
+{
+
+// Builtin operation with parameters given after its name: <builtin name>(<p1>,<p2>,...)
+StatOpBase* createWithParams( const std::string& name )
+{
+    size_t open = name.find( '(' );
+    if( open == std::string::npos || name.back() != ')' )
+        return nullptr;
+
+    std::vector< umf_real > params;
+    const char* p = name.data() + open + 1;
+    const char* end = name.data() + name.size() - 1;
+    text_codec::skipSpaces( p, end );
+    while( p != end )
+    {
+        umf_real param;
+        if( !text_codec::parseReal( p, end, param ))
+            UMF_EXCEPTION( umf::IncorrectParamException, "Wrong parameters of builtin operation: " + name );
+        params.push_back( param );
+        text_codec::skipSpaces( p, end );
+        if( p != end && *p++ != ',' )
+            UMF_EXCEPTION( umf::IncorrectParamException, "Wrong parameters of builtin operation: " + name );
+    }
+
+    typedef StatOpFactory::BuiltinOp BuiltinOp;
+    const std::string baseName = name.substr( 0, open );
+
+    if( baseName == StatOpFactory::builtinName( BuiltinOp::Histogram ))
+        return new StatOpHistogram( params, false, StatOpFactory::builtinName( BuiltinOp::Histogram, params ));
+    if( baseName == StatOpFactory::builtinName( BuiltinOp::LogHistogram ))
+        return new StatOpHistogram( params, true, StatOpFactory::builtinName( BuiltinOp::LogHistogram, params ));
+    if( baseName == StatOpFactory::builtinName( BuiltinOp::Quantiles ))
+        return new StatOpQuantiles( params, StatOpFactory::builtinName( BuiltinOp::Quantiles, params ));
+    if( baseName == StatOpFactory::builtinName( BuiltinOp::DistinctCount ))
+        return new StatOpDistinctCount( params, StatOpFactory::builtinName( BuiltinOp::DistinctCount, params ));
+    return nullptr;
+}
+
+} // anonymous namespace
+
 // class StatOpFactory
 
 StatOpBase* StatOpFactory::create( const std::string& name )
@@ -331,6 +933,8 @@ StatOpBase* StatOpFactory::create( const std::string& name )
     auto it = ops.find( name );
     if( it == ops.end() )
     {
+        if( StatOpBase* op = createWithParams( name ))
+            return op;
         UMF_EXCEPTION( umf::NotFoundException, "User operation not registered: " + name );
     }
 
@@ -391,12 +995,18 @@ std::string StatOpFactory::getUserOpName( InstanceCreator createInstance )
 }
 
 #define ALL_BUILTIN_OPS( _op ) \
-        _op( Min );     \
-        _op( Max );     \
-        _op( Average ); \
-        _op( Count );   \
-        _op( Sum );     \
-        _op( Last );
+        _op( Min );           \
+        _op( Max );           \
+        _op( Average );       \
+        _op( Count );         \
+        _op( Sum );           \
+        _op( Last );          \
+        _op( Variance );      \
+        _op( StdDev );        \
+        _op( Histogram );     \
+        _op( LogHistogram );  \
+        _op( Quantiles );     \
+        _op( DistinctCount );
 
 std::mutex& StatOpFactory::getLock()
 {
@@ -434,6 +1044,23 @@ StatOpFactory::UserOpMap& StatOpFactory::getClassMap()
 }
 #undef OP_NAME
 
+/*static*/ std::string StatOpFactory::builtinName( BuiltinOp::Type opType, const std::vector< umf_real >& params )
+{
+    std::string name = builtinName( opType );
+    if( params.empty() )
+        return name;
+
+    name += '(';
+    for( size_t i = 0; i < params.size(); i++ )
+    {
+        if( i != 0 )
+            name += ',';
+        text_codec::appendReal( name, params[i] );
+    }
+    name += ')';
+    return name;
+}
+
 // class StatField (StatFieldDesc)
 
 class StatField::StatFieldDesc
@@ -443,52 +1070,40 @@ public:
                    const std::string& metadataName, const std::string& fieldName,
                    const std::string& opName )
         : m_name( name ), m_schemaName( schemaName ), m_metadataName( metadataName ),
-          m_fieldName(fieldName), m_opName(opName)/*,
-          m_metadataDesc(nullptr), m_fieldDesc(), m_pMetadataStream( nullptr )*/
+          m_fieldName(fieldName), m_opName(opName)
         {}
     StatFieldDesc( const StatFieldDesc& other )
         : m_name( other.m_name ), m_schemaName( other.m_schemaName ), m_metadataName( other.m_metadataName ),
-          m_fieldName(other.m_fieldName), m_opName(other.m_opName)/*,
-          m_metadataDesc(nullptr), m_fieldDesc(), m_pMetadataStream( nullptr )*/
+          m_fieldName(other.m_fieldName), m_opName(other.m_opName)
         {}
     StatFieldDesc( StatFieldDesc&& other )
         : m_name( std::move( other.m_name )), m_schemaName( std::move( other.m_schemaName )),
           m_metadataName(std::move(other.m_metadataName)), m_fieldName(std::move(other.m_fieldName)),
-          m_opName(std::move(other.m_opName))/*,
-          m_metadataDesc(std::move(nullptr)), m_fieldDesc(std::move(other.m_fieldDesc)), m_pMetadataStream(nullptr)*/
+          m_opName(std::move(other.m_opName))
         {}
     StatFieldDesc()
         : m_name( "" ), m_schemaName( "" ), m_metadataName( "" ),
-          m_fieldName(""), m_opName("")/*,
-          m_metadataDesc(nullptr), m_fieldDesc(), m_pMetadataStream( nullptr )*/
+          m_fieldName(""), m_opName("")
         {}
     ~StatFieldDesc()
         {}
 
     StatFieldDesc& operator=( const StatField::StatFieldDesc& other )
         {
-            //setStream( nullptr );
             m_name         = other.m_name;
             m_schemaName   = other.m_schemaName;
             m_metadataName = other.m_metadataName;
-            //m_metadataDesc = nullptr;
             m_fieldName    = other.m_fieldName;
-            //m_fieldDesc    = FieldDesc();
             m_opName       = other.m_opName;
-            //setStream( other.getStream() );
             return *this;
         }
     StatFieldDesc& operator=( StatField::StatFieldDesc&& other )
         {
-            //setStream( nullptr );
             m_name         = std::move( other.m_name );
             m_schemaName   = std::move( other.m_schemaName );
             m_metadataName = std::move( other.m_metadataName );
-            //m_metadataDesc = std::move( other.m_metadataDesc );
             m_fieldName    = std::move( other.m_fieldName );
-            //m_fieldDesc    = std::move( other.m_fieldDesc );
             m_opName       = std::move( other.m_opName );
-            //setStream( other.getStream() );
             return *this;
         }
 
@@ -506,56 +1121,25 @@ public:
         { return m_schemaName; }
     std::string getMetadataName() const
         { return m_metadataName; }
-    /*std::shared_ptr< MetadataDesc > getMetadataDesc() const
-        { return m_metadataDesc; }*/
     std::string getFieldName() const
         { return m_fieldName; }
-    /*FieldDesc getFieldDesc() const
-        { return m_fieldDesc; }*/
     std::string getOpName() const
         { return m_opName; }
 
-public:
-    /*void setStream( MetadataStream* pMetadataStream )
+    // Tells whether metadata of this description carries the field, and in which slot
+    bool resolve( const MetadataDesc& metadataDesc, size_t& slot ) const
         {
-            m_pMetadataStream = pMetadataStream;
-            if( m_pMetadataStream != nullptr )
-            {
-                std::shared_ptr< MetadataSchema > schema = m_pMetadataStream->getSchema( m_schemaName );
-                if( schema == nullptr )
-                {
-                    UMF_EXCEPTION( IncorrectParamException, "Unknown schema '" + m_schemaName + "'" );
-                }
-
-                m_metadataDesc = schema->findMetadataDesc( m_metadataName );
-                if( m_metadataDesc == nullptr )
-                {
-                    UMF_EXCEPTION( IncorrectParamException, "Unknown metadata '" + m_metadataName + "' for schema '" + m_schemaName + "'" );
-                }
-
-                if( m_metadataDesc->getFieldDesc( m_fieldDesc, m_fieldName ) != true )
-                {
-                    UMF_EXCEPTION( IncorrectParamException, "Unknown field '" + m_fieldName + "' for metadata '" + m_metadataName + "' for schema '" + m_schemaName + "'" );
-                }
-            }
-            else
-            {
-                m_metadataDesc = nullptr;
-                m_fieldDesc = FieldDesc();
-            }
+            return metadataDesc.getSchemaName() == m_schemaName &&
+                   metadataDesc.getMetadataName() == m_metadataName &&
+                   metadataDesc.getFieldSlot( m_fieldName, slot );
         }
-    MetadataStream* getStream() const
-        { return m_pMetadataStream; }*/
 
 private:
     std::string m_name;
     std::string m_schemaName;
     std::string m_metadataName;
-    //std::shared_ptr< MetadataDesc > m_metadataDesc;
     std::string m_fieldName;
-    //FieldDesc m_fieldDesc;
     std::string m_opName;
-    //MetadataStream* m_pMetadataStream;
 };
 
 StatField::StatField(
@@ -610,33 +1194,26 @@ bool StatField::operator==(const StatField& rhs) const
     return *m_desc == *rhs.m_desc;
 }
 
-void StatField::handle( std::shared_ptr< Metadata > metadata )
+bool StatField::resolve( const MetadataDesc& metadataDesc, size_t& slot ) const
 {
-    const std::shared_ptr< MetadataDesc > metadataDesc = metadata->getDesc();
-    if( metadataDesc &&
-        (metadataDesc->getSchemaName() == getSchemaName()) &&
-        (metadataDesc->getMetadataName() == getMetadataName()) )
-    {
-        const std::string& fieldName = getFieldName();
-        Metadata::iterator it = metadata->findField( fieldName );
-        if( it != metadata->end() )
-        {
-            m_op->handle( *it );
-        }
-    }
+    return m_desc->resolve( metadataDesc, slot );
 }
 
-void StatField::reset()
+void StatField::handle( const std::vector< const Variant* >& values )
+{
+    m_op->handle( values.data(), values.size() );
+}
+
+void StatField::unhandle( const std::vector< const Variant* >& values )
 {
-    //if( isActive() )
-        m_op->reset();
+    for( const Variant* value : values )
+        m_op->unhandle( *value );
 }
 
-/*void StatField::setStream( MetadataStream* pMetadataStream )
+void StatField::reset()
 {
-    m_desc->setStream( pMetadataStream );
-    m_isActive = bool( pMetadataStream != nullptr );
-}*/
+    m_op->reset();
+}
 
 std::string StatField::getName() const
 {
@@ -653,31 +1230,16 @@ std::string StatField::getMetadataName() const
     return m_desc->getMetadataName();
 }
 
-/*std::shared_ptr< MetadataDesc > StatField::getMetadataDesc() const
-{
-    return m_desc->getMetadataDesc();
-}*/
-
 std::string StatField::getFieldName() const
 {
     return m_desc->getFieldName();
 }
 
-/*FieldDesc StatField::getFieldDesc() const
-{
-    return m_desc->getFieldDesc();
-}*/
-
 std::string StatField::getOpName() const
 {
     return m_desc->getOpName();
 }
 
-/*MetadataStream* StatField::getStream() const
-{
-    return m_desc->getStream();
-}*/
-
 // class Stat (StatDesc, StatWorker)
 
 class Stat::StatDesc
@@ -713,157 +1275,364 @@ private:
     std::string m_name;
 };
 
-class Stat::StatWorker
+namespace
+{
+
+// Thread pool shared by the statistics objects of the process. Threads are
+// created on demand, up to a fixed bound, so objects that never schedule an
+// asynchronous update cost no thread at all. Tasks may be delayed for the
+// OnTimer update mode.
+class StatExecutor
 {
 public:
-    explicit StatWorker( Stat* stat )
-        : m_stat( stat )
-        , m_wakeupForced( false )
-        , m_updateScheduled( false )
-        , m_exitScheduled( false )
-        , m_exitImmediate( false )
+    typedef std::chrono::steady_clock Clock;
+
+    static StatExecutor& instance()
+        {
+            static StatExecutor executor;
+            return executor;
+        }
+
+    ~StatExecutor()
         {
-            m_worker = std::thread( &StatWorker::operator(), this );
+            {
+                std::unique_lock< std::mutex > lock( m_lock );
+                m_exit = true;
+                m_signal.notify_all();
+            }
+            for( auto& thread : m_threads )
+                thread.join();
         }
-    ~StatWorker()
+
+    void post( std::function< void() > task, Clock::duration delay = Clock::duration::zero() )
         {
-            scheduleExit();
-            m_worker.join();
-            m_stat = nullptr;
+            std::unique_lock< std::mutex > lock( m_lock );
+            m_tasks.push( Task{ Clock::now() + delay, m_nextSeq++, std::move( task ) });
+            if( m_idle == 0 && m_threads.size() < m_maxThreads )
+                m_threads.emplace_back( &StatExecutor::operator(), this );
+            else
+                m_signal.notify_one();
         }
+
     void operator()()
         {
-            // worker is starting
-            for(;;)
+            std::unique_lock< std::mutex > lock( m_lock );
+            while( !m_exit )
             {
-                // worker is going to sleep
+                if( m_tasks.empty() )
                 {
-                    std::unique_lock< std::mutex > lock( m_lock );
-                    if( m_stat->getUpdateMode() == UpdateMode::OnTimer )
-                    {
-                        const unsigned tmo = std::max( m_stat->getUpdateTimeout(), (unsigned)10 );
-                        bool awaken = false;
-                        do {
-                            awaken = m_signal.wait_for( lock, std::chrono::milliseconds(tmo), [&]
-                            {
-                                return m_exitScheduled ||
-                                        m_wakeupForced ||
-                                        (m_updateScheduled && !m_items.empty());
-                            });
-                        } while( !awaken );
-                    }
-                    else
-                    {
-                        m_signal.wait( lock, [&]
-                        {
-                            return m_exitScheduled ||
-                                    m_wakeupForced ||
-                                    (m_updateScheduled && !m_items.empty());
-                        });
-                    }
-                    m_wakeupForced = false;
-                    if( m_exitScheduled && m_exitImmediate )
-                        break;
+                    m_idle++;
+                    m_signal.wait( lock );
+                    m_idle--;
+                    continue;
                 }
-                // worker has awaken
-                if( m_updateScheduled )
+                Clock::time_point due = m_tasks.top().due;
+                if( due > Clock::now() )
                 {
-                    std::shared_ptr< Metadata > metadata;
-                    while( tryPop( metadata ))
-                    {
-                        // processing of item
-                        if( m_stat != nullptr )
-                            m_stat->handle( metadata );
-                    }
-                    {
-                        std::unique_lock< std::mutex > lock( m_lock );
-                        m_updateScheduled = false;
-                    }
+                    m_idle++;
+                    m_signal.wait_until( lock, due );
+                    m_idle--;
+                    continue;
+                }
+                std::function< void() > task = std::move( const_cast< Task& >( m_tasks.top() ).fn );
+                m_tasks.pop();
+                lock.unlock();
+                try
+                {
+                    task();
                 }
+                catch( ... )
                 {
-                    std::unique_lock< std::mutex > lock( m_lock );
-                    if( m_exitScheduled && !m_exitImmediate )
-                        break;
+                    // already reported by UMF_EXCEPTION, the pool thread has nobody to rethrow to
                 }
+                lock.lock();
             }
-            // worker is finishing
         }
-    void scheduleUpdate( const std::shared_ptr< Metadata > val, bool doWake = true )
+
+private:
+    StatExecutor()
+        : m_maxThreads( std::min( std::max( std::thread::hardware_concurrency(), 1u ), 4u ))
+        , m_idle( 0 )
+        , m_nextSeq( 0 )
+        , m_exit( false )
+        {}
+
+    struct Task
+    {
+        Clock::time_point due;
+        unsigned long long seq;
+        std::function< void() > fn;
+
+        // earliest due first, in the posting order for the same time
+        bool operator<( const Task& other ) const
+            { return due != other.due ? due > other.due : seq > other.seq; }
+    };
+
+    const size_t m_maxThreads;
+    std::vector< std::thread > m_threads;
+    std::priority_queue< Task > m_tasks;
+    size_t m_idle;
+    unsigned long long m_nextSeq;
+    bool m_exit;
+    std::condition_variable m_signal;
+    std::mutex m_lock;
+};
+
+} // anonymous namespace
+
+// Queue of metadata pending for a statistics object: a bounded ring that
+// any number of threads push to without locking and a single consumer drains
+// in batches. Asynchronous updates are posted to the shared StatExecutor,
+// synchronous ones run in the caller. A producer that finds the ring full
+// drains it itself. Records are routed to the statistics fields through a
+// table resolved once per metadata description.
+class Stat::StatWorker : public std::enable_shared_from_this< StatWorker >
+{
+public:
+    explicit StatWorker( Stat* stat )
+        : m_stat( stat )
+        , m_cells( new Cell[ capacity ] )
+        , m_enqueuePos( 0 )
+        , m_dequeuePos( 0 )
+        , m_posted( false )
+        , m_running( false )
+        , m_batchAction( Action::Add )
+        , m_lastDesc( nullptr )
+        , m_lastRoute( nullptr )
+        {
+            for( size_t i = 0; i < capacity; i++ )
+                m_cells[i].seq.store( i, std::memory_order_relaxed );
+        }
+    void scheduleUpdate( std::shared_ptr< Metadata > val, Action::Type action, bool doWake )
         {
-            std::unique_lock< std::mutex > lock( m_lock );
-            m_items.push( val );
-            if( doWake && !m_updateScheduled && !m_items.empty() )
+            while( !tryPush( val, action ))
+                update();
+            if( doWake )
+                wakeup();
+        }
+    // the pointers are moved into the ring, items is left with empty ones
+    void scheduleUpdate( std::vector< std::shared_ptr< Metadata > >&& items, Action::Type action, bool doWake )
+        {
+            for( auto& val : items )
             {
-                m_updateScheduled = true;
-                m_signal.notify_one();
+                while( !tryPush( val, action ))
+                    update();
             }
+            if( doWake )
+                wakeup();
         }
-    void scheduleExit( bool doImmediate = false )
+    void wakeup()
         {
-            std::unique_lock< std::mutex > lock( m_lock );
-            if( !m_exitScheduled )
+            if( isEmpty() || m_posted.exchange( true ))
+                return;
+            std::chrono::milliseconds delay( 0 );
+            if( m_stat->getUpdateMode() == UpdateMode::OnTimer )
+                delay = std::chrono::milliseconds( m_stat->getUpdateTimeout() );
+            std::shared_ptr< StatWorker > self = shared_from_this();
+            StatExecutor::instance().post( [self]()
             {
-                m_exitScheduled = true;
-                m_exitImmediate = doImmediate;
-                m_signal.notify_one();
+                self->m_posted = false;
+                self->update();
+            }, delay );
+        }
+    void update()
+        {
+            Stat* stat = acquire();
+            try
+            {
+                while( tryPopBatch() )
+                {
+                    if( stat != nullptr )
+                        dispatch( stat );
+                    m_batch.clear();
+                }
+            }
+            catch( ... )
+            {
+                m_batch.clear();
+                finish();
+                throw;
             }
+            finish();
         }
-    void wakeup( bool doForceWakeup = false )
+    void detach()
         {
-            std::unique_lock< std::mutex > lock( m_lock );
-            m_updateScheduled = (m_updateScheduled || !m_items.empty());
-            m_wakeupForced = doForceWakeup;
-            if( m_exitScheduled || m_updateScheduled | m_wakeupForced )
             {
-                m_signal.notify_one();
+                std::unique_lock< std::mutex > lock( m_lock );
+                m_idle.wait( lock, [&] { return !m_running; });
+                m_stat = nullptr;
+            }
+            reset();
+        }
+    void bind( const std::vector< std::shared_ptr< MetadataDesc >>& descs )
+        {
+            Stat* stat = acquire();
+            try
+            {
+                if( stat != nullptr )
+                    for( const auto& desc : descs )
+                        route( stat, desc );
+            }
+            catch( ... )
+            {
+                finish();
+                throw;
             }
+            finish();
         }
     void reset()
         {
             std::unique_lock< std::mutex > lock( m_lock );
-            if( !m_items.empty() )
-                std::queue< std::shared_ptr< Metadata >>().swap( m_items );
-            m_updateScheduled = false;
-            m_exitScheduled = false;
-            m_exitImmediate = false;
+            m_idle.wait( lock, [&] { return !m_running; });
+            while( tryPopBatch() )
+                m_batch.clear();
+            // the fields may be replaced, routes are resolved again on demand
+            m_routes.clear();
+            m_lastDesc = nullptr;
+            m_lastRoute = nullptr;
         }
     State::Type getState() const
         {
             std::unique_lock< std::mutex > lock( m_lock );
-            if( m_updateScheduled || !m_items.empty() )
+            if( m_running || !isEmpty() )
                 return State::NeedUpdate;
             return State::UpToDate;
         }
 
 private:
-    bool tryPop( std::shared_ptr< Metadata >& metadata )
+    static const size_t capacity = 512; // power of two
+    static const size_t batchSize = 256;
+
+    struct Route
+    {
+        std::shared_ptr< MetadataDesc > desc; // keeps the key address from being reused
+        std::vector< std::pair< size_t, size_t >> targets; // statistics field index, metadata field slot
+    };
+
+    struct Cell
+    {
+        std::atomic< size_t > seq;
+        std::shared_ptr< Metadata > metadata;
+        Action::Type action;
+    };
+
+    bool isEmpty() const
+        {
+            return m_enqueuePos.load( std::memory_order_acquire ) == m_dequeuePos.load( std::memory_order_acquire );
+        }
+    bool tryPush( std::shared_ptr< Metadata >& val, Action::Type action )
+        {
+            size_t pos = m_enqueuePos.load( std::memory_order_relaxed );
+            for(;;)
+            {
+                Cell& cell = m_cells[ pos & (capacity - 1) ];
+                intptr_t diff = (intptr_t)cell.seq.load( std::memory_order_acquire ) - (intptr_t)pos;
+                if( diff == 0 )
+                {
+                    if( m_enqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ))
+                    {
+                        cell.metadata = std::move( val );
+                        cell.action = action;
+                        cell.seq.store( pos + 1, std::memory_order_release );
+                        return true;
+                    }
+                }
+                else if( diff < 0 )
+                    return false; // full
+                else
+                    pos = m_enqueuePos.load( std::memory_order_relaxed );
+            }
+        }
+    // consumer side, called only by the thread that owns m_running;
+    // a batch holds consecutive items of the same action
+    bool tryPopBatch()
+        {
+            size_t pos = m_dequeuePos.load( std::memory_order_relaxed );
+            while( m_batch.size() < batchSize )
+            {
+                Cell& cell = m_cells[ pos & (capacity - 1) ];
+                if( cell.seq.load( std::memory_order_acquire ) != pos + 1 )
+                    break; // empty or the producer has not finished writing
+                if( m_batch.empty() )
+                    m_batchAction = cell.action;
+                else if( cell.action != m_batchAction )
+                    break;
+                m_batch.push_back( std::move( cell.metadata ));
+                cell.seq.store( pos + capacity, std::memory_order_release );
+                ++pos;
+            }
+            m_dequeuePos.store( pos, std::memory_order_release );
+            return !m_batch.empty();
+        }
+    Stat* acquire()
         {
             std::unique_lock< std::mutex > lock( m_lock );
-            if( !m_items.empty() ) {
-                metadata = m_items.front();
-                m_items.pop();
-                return true;
+            m_idle.wait( lock, [&] { return !m_running; });
+            m_running = true;
+            return m_stat;
+        }
+    const Route& route( const Stat* stat, const std::shared_ptr< MetadataDesc >& desc )
+        {
+            if( desc.get() != m_lastDesc )
+            {
+                auto it = m_routes.find( desc.get() );
+                if( it == m_routes.end() )
+                {
+                    it = m_routes.insert( std::make_pair( desc.get(), Route() )).first;
+                    it->second.desc = desc;
+                    stat->resolve( *desc, it->second.targets );
+                }
+                m_lastDesc = desc.get();
+                m_lastRoute = &it->second;
             }
-            m_updateScheduled = false;
-            return false;
+            return *m_lastRoute;
+        }
+    // gathers the values of each statistics field from the batch
+    void dispatch( Stat* stat )
+        {
+            m_values.resize( stat->m_fields.size() );
+            for( auto& values : m_values )
+                values.clear();
+            for( const auto& metadata : m_batch )
+            {
+                const std::shared_ptr< MetadataDesc >& desc = metadata->getDesc();
+                if( !desc )
+                    continue;
+                for( const auto& target : route( stat, desc ).targets )
+                    if( const FieldValue* pValue = metadata->tryField( target.second ))
+                        m_values[ target.first ].push_back( pValue );
+            }
+            stat->handle( m_values, m_batchAction );
+        }
+    void finish()
+        {
+            std::unique_lock< std::mutex > lock( m_lock );
+            m_running = false;
+            m_idle.notify_all();
         }
 
 private:
     Stat* m_stat;
-    std::thread m_worker;
-    std::queue< std::shared_ptr< Metadata >> m_items;
-    std::atomic< bool > m_wakeupForced;
-    std::atomic< bool > m_updateScheduled;
-    std::atomic< bool > m_exitScheduled;
-    std::atomic< bool > m_exitImmediate;
-    std::condition_variable m_signal;
+    std::unique_ptr< Cell[] > m_cells;
+    std::atomic< size_t > m_enqueuePos;
+    char m_padding[64]; // keeps producers and the consumer off the same cache line
+    std::atomic< size_t > m_dequeuePos;
+    std::atomic< bool > m_posted;
+    bool m_running;
+    std::vector< std::shared_ptr< Metadata >> m_batch;
+    Action::Type m_batchAction;
+    std::vector< std::vector< const Variant* >> m_values; // point into the records of m_batch
+    std::unordered_map< const MetadataDesc*, Route > m_routes;
+    const MetadataDesc* m_lastDesc;
+    const Route* m_lastRoute;
+    std::condition_variable m_idle;
     mutable std::mutex m_lock;
 };
 
 Stat::Stat( const std::string& name, const std::vector< StatField >& fields, UpdateMode::Type updateMode )
     : m_desc( new StatDesc( name ))
     , m_fields( fields )
-    , m_worker( new StatWorker( this ))
+    , m_worker( std::make_shared< StatWorker >( this ))
     , m_updateMode( updateMode )
     , m_updateTimeout( 0 )
     , m_needRescan(false)
@@ -872,23 +1641,29 @@ Stat::Stat( const std::string& name, const std::vector< StatField >& fields, Upd
 Stat::Stat( const Stat& other )
     : m_desc( new StatDesc( *other.m_desc ))
     , m_fields( other.m_fields )
-    , m_worker( new StatWorker( this ))
+    , m_worker( std::make_shared< StatWorker >( this ))
     , m_updateMode( other.m_updateMode )
     , m_updateTimeout( 0 )
     , m_needRescan(other.m_needRescan)
 {}
 
 Stat::Stat( Stat&& other )
-    : m_desc( std::move( other.m_desc ))
-    , m_fields( std::move( other.m_fields ))
-    , m_worker( new StatWorker( this ))
+    : m_worker( std::make_shared< StatWorker >( this ))
     , m_updateMode( other.m_updateMode )
     , m_updateTimeout( 0 )
     , m_needRescan(other.m_needRescan)
-{}
+{
+    // the records queued by the other object would be routed into the fields moved away
+    other.m_worker->reset();
+
+    m_desc   = std::move( other.m_desc );
+    m_fields = std::move( other.m_fields );
+}
 
 Stat::~Stat()
-{}
+{
+    m_worker->detach();
+}
 
 Stat& Stat::operator=( const Stat& other )
 {
@@ -906,6 +1681,7 @@ Stat& Stat::operator=( const Stat& other )
 Stat& Stat::operator=( Stat&& other )
 {
     m_worker->reset();
+    other.m_worker->reset();
 
     m_desc          = std::move( other.m_desc );
     m_fields        = std::move( other.m_fields );
@@ -926,11 +1702,11 @@ void Stat::notify( std::shared_ptr< Metadata > metadata, Action::Type action )
         case UpdateMode::Disabled:
             break;
         case UpdateMode::Manual:
-            if(!m_needRescan) m_worker->scheduleUpdate( metadata, false );
+            if(!m_needRescan) m_worker->scheduleUpdate( std::move( metadata ), action, false );
             break;
         case UpdateMode::OnAdd:
         case UpdateMode::OnTimer:
-            if (!m_needRescan) m_worker->scheduleUpdate(metadata, true);
+            if (!m_needRescan) m_worker->scheduleUpdate( std::move( metadata ), action, true );
             break;
         }
         break;
@@ -942,6 +1718,13 @@ void Stat::notify( std::shared_ptr< Metadata > metadata, Action::Type action )
         case UpdateMode::Manual:
         case UpdateMode::OnAdd:
         case UpdateMode::OnTimer:
+            if( m_needRescan )
+                break;
+            if( isReversible() )
+            {
+                m_worker->scheduleUpdate( std::move( metadata ), action, m_updateMode != UpdateMode::Manual );
+                break;
+            }
             m_needRescan = true;
             m_worker->reset();
             break;
@@ -950,10 +1733,41 @@ void Stat::notify( std::shared_ptr< Metadata > metadata, Action::Type action )
     }
 }
 
+void Stat::notify( const std::vector< std::shared_ptr< Metadata > >& metadata, Action::Type action )
+{
+    if( !metadata.empty() && m_updateMode != UpdateMode::Disabled && !m_needRescan )
+        notify( std::vector< std::shared_ptr< Metadata > >( metadata ), action );
+}
+
+void Stat::notify( std::vector< std::shared_ptr< Metadata > >&& metadata, Action::Type action )
+{
+    if( metadata.empty() )
+        return;
+
+    switch( m_updateMode )
+    {
+    case UpdateMode::Disabled:
+        break;
+    case UpdateMode::Manual:
+    case UpdateMode::OnAdd:
+    case UpdateMode::OnTimer:
+        if( m_needRescan )
+            break;
+        if( action == Action::Add || isReversible() )
+        {
+            m_worker->scheduleUpdate( std::move( metadata ), action, m_updateMode != UpdateMode::Manual );
+            break;
+        }
+        m_needRescan = true;
+        m_worker->reset();
+        break;
+    }
+}
+
 void Stat::update(bool doWait )
 {
     if (m_needRescan) 
-        UMF_EXCEPTION(IncorrectParamException, "Stat object detected metadata removal, call MetadataStream::recalcStat() before continue using statistics");
+        UMF_EXCEPTION(IncorrectParamException, "Stat object detected metadata removal or change, call MetadataStream::recalcStat() before continue using statistics");
 
     if( getState() != State::UpToDate )
     {
@@ -964,28 +1778,73 @@ void Stat::update(bool doWait )
         case UpdateMode::Manual:
         case UpdateMode::OnAdd:
         case UpdateMode::OnTimer:
-            m_worker->wakeup();
+            if( doWait )
+                m_worker->update();
+            else
+                m_worker->wakeup();
             break;
         }
-        if( doWait )
+    }
+}
+
+void Stat::bind( const std::vector< std::shared_ptr< MetadataDesc >>& descs )
+{
+    m_worker->bind( descs );
+}
+
+void Stat::resolve( const MetadataDesc& metadataDesc, std::vector< std::pair< size_t, size_t >>& targets ) const
+{
+    targets.clear();
+    for( size_t i = 0; i < m_fields.size(); i++ )
+    {
+        size_t slot;
+        if( m_fields[i].resolve( metadataDesc, slot ))
+            targets.emplace_back( i, slot );
+    }
+}
+
+void Stat::handle( const std::vector< std::vector< const Variant* >>& values, Action::Type action )
+{
+    for( size_t i = 0; i < m_fields.size(); i++ )
+    {
+        if( values[i].empty() )
+            continue;
+        if( action == Action::Add )
+            m_fields[i].handle( values[i] );
+        else
+            m_fields[i].unhandle( values[i] );
+    }
+}
+
+// the statistics hold the old value, which a later removal can't take back
+void Stat::onFieldChanged( const MetadataDesc& metadataDesc, const std::string& fieldName )
+{
+    if( m_updateMode == UpdateMode::Disabled || m_needRescan )
+        return;
+
+    for( const auto& statField : m_fields )
+    {
+        size_t slot;
+        if( statField.resolve( metadataDesc, slot ) && statField.getFieldName() == fieldName )
         {
-            /*
-            // TODO: Busy wait loop. Perhaps it would be better to wait on conditional variable.
-            //       Also, it can be potentially dangerous and leads to deadlocks.
-            */
-            while( getState() != State::UpToDate )
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            m_needRescan = true;
+            m_worker->reset();
+            return;
         }
     }
 }
 
-void Stat::handle( const std::shared_ptr< Metadata > metadata )
+bool Stat::isReversible() const
 {
-    for( auto& statField : m_fields ) statField.handle( metadata );
+    for( const auto& statField : m_fields )
+        if( !statField.isReversible() )
+            return false;
+    return true;
 }
 
 void Stat::clear()
 {
+    m_worker->reset();
     for( auto& statField : m_fields )
         statField.reset();
     m_needRescan = false;
@@ -1004,7 +1863,7 @@ void Stat::setUpdateMode( UpdateMode::Type updateMode )
         case UpdateMode::OnAdd:
         case UpdateMode::OnTimer:
             m_updateMode = updateMode;
-            m_worker->wakeup( true );
+            m_worker->wakeup();
             break;
         default:
             UMF_EXCEPTION( umf::IncorrectParamException, "Unknown update mode" );
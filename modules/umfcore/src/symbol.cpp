@@ -0,0 +1,90 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "umf/symbol.hpp"
+
+#include <mutex>
+#include <unordered_set>
+
+namespace umf
+{
+
+namespace
+{
+
+//! Texts of all symbols, node based so the interned strings never move
+class SymbolTable
+{
+public:
+    //! Never destroyed, symbols of static objects stay valid at exit
+    static SymbolTable& instance()
+    {
+        static SymbolTable* table = new SymbolTable();
+        return *table;
+    }
+
+    const std::string* intern(const std::string& name)
+    {
+        if(name.empty())
+            return &m_empty;
+        std::unique_lock<std::mutex> lock(m_lock);
+        return &*m_names.insert(name).first;
+    }
+
+    const std::string* find(const std::string& name)
+    {
+        if(name.empty())
+            return &m_empty;
+        std::unique_lock<std::mutex> lock(m_lock);
+        auto it = m_names.find(name);
+        return it != m_names.end() ? &*it : nullptr;
+    }
+
+    const std::string* empty() const
+    {
+        return &m_empty;
+    }
+
+private:
+    std::mutex m_lock;
+    std::unordered_set<std::string> m_names;
+    const std::string m_empty;
+};
+
+}
+
+Symbol::Symbol()
+    : m_pName(SymbolTable::instance().empty())
+{}
+
+Symbol::Symbol(const std::string& name)
+    : m_pName(SymbolTable::instance().intern(name))
+{}
+
+Symbol::Symbol(const char* name)
+    : m_pName(SymbolTable::instance().intern(name ? std::string(name) : std::string()))
+{}
+
+bool Symbol::find(const std::string& name, Symbol& symbol)
+{
+    const std::string* pName = SymbolTable::instance().find(name);
+    if(!pName)
+        return false;
+    symbol.m_pName = pName;
+    return true;
+}
+
+}
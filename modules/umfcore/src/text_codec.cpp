@@ -0,0 +1,366 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "text_codec.hpp"
+
+#include <cfloat>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <locale>
+#include <sstream>
+
+namespace umf {
+namespace text_codec {
+
+//! Significant digits of the real text form, as set by setprecision(digits10)
+static const int nRealDigits = std::numeric_limits<double>::digits10;
+
+//! Powers of ten exact in double
+static const double pow10d[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+//! Powers of ten exact in an x87 long double, rounded by one ulp at most where long double is double
+static const long double pow10ld[] =
+{
+    1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L, 1e10L, 1e11L, 1e12L, 1e13L,
+    1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L, 1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L
+};
+
+static const int nMaxScale = sizeof(pow10ld) / sizeof(pow10ld[0]) - 1;
+
+static size_t formatUnsigned(char* buf, unsigned long long value)
+{
+    char digits[20];
+    size_t n = 0;
+    do
+    {
+        digits[n++] = char('0' + value % 10);
+        value /= 10;
+    } while(value);
+
+    for(size_t i = 0; i < n; i++)
+        buf[i] = digits[n - 1 - i];
+    return n;
+}
+
+void appendInteger(std::string& s, umf_integer value)
+{
+    char buf[24];
+    size_t n = 0;
+    unsigned long long magnitude = (unsigned long long)value;
+    if(value < 0)
+    {
+        buf[n++] = '-';
+        magnitude = 0ULL - magnitude;
+    }
+    n += formatUnsigned(buf + n, magnitude);
+    s.append(buf, n);
+}
+
+//! printf("%.15g") with the decimal point of the "C" locale
+static void appendPrintf(std::string& s, umf_real value)
+{
+    char buf[32];
+    int n = snprintf(buf, sizeof(buf), "%.*g", nRealDigits, value);
+    const char* pszPoint = localeconv()->decimal_point;
+    if(pszPoint && pszPoint[0] != '.' && pszPoint[0])
+        for(int i = 0; i < n; i++)
+            if(buf[i] == pszPoint[0])
+                buf[i] = '.';
+    s.append(buf, n);
+}
+
+//! Rounds value * 10^scale to an integer, false if the result might differ from the exactly rounded one
+static bool scaleAndRound(double value, int scale, unsigned long long& rounded)
+{
+    if(scale > nMaxScale || scale < -nMaxScale)
+        return false;
+
+    long double scaled = scale >= 0 ? (long double)value * pow10ld[scale] : (long double)value / pow10ld[-scale];
+    // Relative error of the power and of the product or quotient is an ulp each
+    const long double margin = 4 * LDBL_EPSILON * scaled;
+    long double whole = std::floor(scaled);
+    long double fraction = scaled - whole;
+    if(std::fabs(fraction - 0.5L) <= margin)
+        return false;
+    rounded = (unsigned long long)whole + (fraction > 0.5L ? 1 : 0);
+    return true;
+}
+
+void appendReal(std::string& s, umf_real value)
+{
+    if(!std::isfinite(value))
+    {
+        appendPrintf(s, value);
+        return;
+    }
+
+    char buf[32];
+    size_t n = 0;
+    if(std::signbit(value))
+    {
+        buf[n++] = '-';
+        value = -value;
+    }
+
+    // Integers of up to 15 digits are printed by %g without point and exponent
+    if(value < 1e15 && value == std::floor(value))
+    {
+        n += formatUnsigned(buf + n, (unsigned long long)value);
+        s.append(buf, n);
+        return;
+    }
+
+    // value = mantissa * 10^(exponent - 14), mantissa has exactly 15 digits
+    int exponent = (int)std::floor(std::log10(value));
+    unsigned long long mantissa = 0;
+    const unsigned long long mantissaMin = 100000000000000ULL, mantissaMax = 1000000000000000ULL;
+    if(!scaleAndRound(value, nRealDigits - 1 - exponent, mantissa))
+    {
+        s.append(buf, n);
+        appendPrintf(s, value);
+        return;
+    }
+    if(mantissa < mantissaMin)
+    {
+        // log10() came out one too high
+        exponent--;
+        if(!scaleAndRound(value, nRealDigits - 1 - exponent, mantissa))
+        {
+            s.append(buf, n);
+            appendPrintf(s, value);
+            return;
+        }
+    }
+    else if(mantissa > mantissaMax)
+    {
+        // log10() came out one too low
+        exponent++;
+        if(!scaleAndRound(value, nRealDigits - 1 - exponent, mantissa))
+        {
+            s.append(buf, n);
+            appendPrintf(s, value);
+            return;
+        }
+    }
+    if(mantissa == mantissaMax)
+    {
+        // Rounding carried into a new digit
+        mantissa = mantissaMin;
+        exponent++;
+    }
+
+    char digits[nRealDigits];
+    formatUnsigned(digits, mantissa);
+    int nDigits = nRealDigits;
+    while(nDigits > 1 && digits[nDigits - 1] == '0')
+        nDigits--;
+
+    if(exponent < -4 || exponent >= nRealDigits)
+    {
+        buf[n++] = digits[0];
+        if(nDigits > 1)
+        {
+            buf[n++] = '.';
+            memcpy(buf + n, digits + 1, nDigits - 1);
+            n += nDigits - 1;
+        }
+        buf[n++] = 'e';
+        buf[n++] = exponent < 0 ? '-' : '+';
+        unsigned absExponent = exponent < 0 ? -exponent : exponent;
+        if(absExponent < 10)
+            buf[n++] = '0';
+        n += formatUnsigned(buf + n, absExponent);
+    }
+    else if(exponent >= 0)
+    {
+        memcpy(buf + n, digits, exponent + 1);
+        n += exponent + 1;
+        if(nDigits > exponent + 1)
+        {
+            buf[n++] = '.';
+            memcpy(buf + n, digits + exponent + 1, nDigits - exponent - 1);
+            n += nDigits - exponent - 1;
+        }
+    }
+    else
+    {
+        buf[n++] = '0';
+        buf[n++] = '.';
+        for(int i = -1; i > exponent; i--)
+            buf[n++] = '0';
+        memcpy(buf + n, digits, nDigits);
+        n += nDigits;
+    }
+    s.append(buf, n);
+}
+
+bool parseInteger(const char*& p, const char* end, umf_integer& value)
+{
+    skipSpaces(p, end);
+    value = 0;
+    const char* start = p;
+    bool negative = false;
+    if(p != end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    if(p == end || *p < '0' || *p > '9')
+    {
+        p = start;
+        return false;
+    }
+
+    const unsigned long long limit = negative ? 0ULL - (unsigned long long)std::numeric_limits<umf_integer>::min()
+                                              : (unsigned long long)std::numeric_limits<umf_integer>::max();
+    unsigned long long magnitude = 0;
+    bool overflow = false;
+    for(; p != end && *p >= '0' && *p <= '9'; p++)
+    {
+        unsigned digit = *p - '0';
+        if(magnitude > (limit - digit) / 10)
+            overflow = true;
+        else
+            magnitude = magnitude * 10 + digit;
+    }
+
+    if(overflow)
+    {
+        value = negative ? std::numeric_limits<umf_integer>::min() : std::numeric_limits<umf_integer>::max();
+        return false;
+    }
+    value = negative ? (umf_integer)(0ULL - magnitude) : (umf_integer)magnitude;
+    return true;
+}
+
+static bool matchWord(const char*& p, const char* end, const char* word)
+{
+    const char* q = p;
+    for(; *word; word++, q++)
+        if(q == end || (*q | 0x20) != *word)
+            return false;
+    p = q;
+    return true;
+}
+
+bool parseReal(const char*& p, const char* end, umf_real& value)
+{
+    skipSpaces(p, end);
+    value = 0;
+    const char* start = p;
+    bool negative = false;
+    if(p != end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    if(matchWord(p, end, "inf"))
+    {
+        matchWord(p, end, "inity");
+        value = negative ? -std::numeric_limits<umf_real>::infinity() : std::numeric_limits<umf_real>::infinity();
+        return true;
+    }
+    if(matchWord(p, end, "nan"))
+    {
+        value = negative ? -std::numeric_limits<umf_real>::quiet_NaN() : std::numeric_limits<umf_real>::quiet_NaN();
+        return true;
+    }
+
+    // Up to 19 significant digits are kept, the exact value is computed when they fit into a double
+    unsigned long long mantissa = 0;
+    int nDigits = 0, exponent = 0;
+    bool anyDigit = false, truncated = false;
+    for(; p != end && *p >= '0' && *p <= '9'; p++)
+    {
+        anyDigit = true;
+        if(nDigits < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            nDigits += mantissa != 0;
+        }
+        else
+        {
+            exponent++;
+            truncated |= *p != '0';
+        }
+    }
+    if(p != end && *p == '.')
+    {
+        for(p++; p != end && *p >= '0' && *p <= '9'; p++)
+        {
+            anyDigit = true;
+            if(nDigits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                nDigits += mantissa != 0;
+                exponent--;
+            }
+            else
+                truncated |= *p != '0';
+        }
+    }
+    if(!anyDigit)
+    {
+        p = start;
+        return false;
+    }
+
+    if(p != end && (*p == 'e' || *p == 'E'))
+    {
+        const char* q = p + 1;
+        bool negativeExp = false;
+        if(q != end && (*q == '-' || *q == '+'))
+            negativeExp = *q++ == '-';
+        if(q != end && *q >= '0' && *q <= '9')
+        {
+            int exp10 = 0;
+            for(; q != end && *q >= '0' && *q <= '9'; q++)
+                if(exp10 < 100000)
+                    exp10 = exp10 * 10 + (*q - '0');
+            exponent += negativeExp ? -exp10 : exp10;
+            p = q;
+        }
+    }
+
+    if(!truncated && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+    {
+        double result = (double)mantissa;
+        result = exponent < 0 ? result / pow10d[-exponent] : result * pow10d[exponent];
+        value = negative ? -result : result;
+        return true;
+    }
+
+    // Rare long or huge values are left to the standard parser
+    std::istringstream stream(std::string(start, p));
+    stream.imbue(std::locale::classic());
+    stream >> value;
+    return !stream.fail();
+}
+
+bool parseToken(const char*& p, const char* end, const char*& tokenBegin, const char*& tokenEnd)
+{
+    skipSpaces(p, end);
+    tokenBegin = p;
+    while(p != end && !isSpace(*p))
+        p++;
+    tokenEnd = p;
+    return tokenBegin != tokenEnd;
+}
+
+}
+}
@@ -0,0 +1,65 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef UMF_TEXT_CODEC_HPP
+#define UMF_TEXT_CODEC_HPP
+
+#include "umf/types.hpp"
+
+#include <string>
+
+namespace umf {
+
+/*!
+ * \brief Locale independent text form of numbers used by Variant.
+ * \details Integers are written as by std::to_string(), reals exactly as by
+ * printf("%.15g"), so the text stays the same as written by std::ostream with
+ * setprecision(digits10). The parsers accept what std::istream accepts for
+ * these types and give the same values, "inf" and "nan" are accepted as well.
+ * Nothing is allocated unless a real needs more than 15 significant digits
+ * or is out of the exactly computed range.
+ */
+namespace text_codec {
+
+void appendInteger(std::string& s, umf_integer value);
+void appendReal(std::string& s, umf_real value);
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+inline void skipSpaces(const char*& p, const char* end)
+{
+    while(p != end && isSpace(*p))
+        p++;
+}
+
+//! Skips leading spaces and parses an integer, on failure value is 0 or the limit it exceeds
+bool parseInteger(const char*& p, const char* end, umf_integer& value);
+
+//! Skips leading spaces and parses a real, on failure value is 0
+bool parseReal(const char*& p, const char* end, umf_real& value);
+
+//! Skips leading spaces and takes the following non-space characters
+bool parseToken(const char*& p, const char* end, const char*& tokenBegin, const char*& tokenEnd);
+
+}
+
+}
+
+#endif // UMF_TEXT_CODEC_HPP
@@ -15,46 +15,50 @@
  *
  */
 #include "umf/variant.hpp"
+#include "base64.hpp"
+#include "text_codec.hpp"
 #include <cstring>
+#include <cstdio>
 #include <string>
 #include <memory>
 #include <sstream>
 #include <cmath>
 #include <limits>
 #include <iomanip>
+#include <new>
 
 namespace umf
 {
 
-class IData
+//! Values of these types are kept in IData, the rest are stored inline
+static bool isAllocated(Variant::Type type)
 {
-public:
-    virtual ~IData() {}
-    virtual IData* clone() const = 0;
-};
-
-template<class T> class Data : public IData
-{
-public:
-    T content;
-    Data(const T& value) : content(value) {}
-    ~Data() {}
-    IData* clone() const
+    switch(type)
     {
-        return new Data<T>(content);
+    case Variant::type_empty:
+    case Variant::type_integer:
+    case Variant::type_real:
+    case Variant::type_vec2d:
+    case Variant::type_vec3d:
+    case Variant::type_vec4d:
+        return false;
+    default:
+        return true;
     }
-};
-
-
+}
 
-Variant::Variant() : data(nullptr), m_type(type_empty) {}
+Variant::Variant() : m_type(type_empty) {}
 
-Variant::Variant(const Variant& other) : data(other.data ? other.data->clone() : nullptr), m_type(other.getType()) {}
+Variant::Variant(const Variant& other) : m_value(other.m_value), m_type(other.m_type)
+{
+    if(isAllocated(m_type) && m_value.data)
+        m_value.data = m_value.data->clone();
+}
 
-Variant::Variant(Variant&& other)
+Variant::Variant(Variant&& other) : m_value(other.m_value), m_type(other.m_type)
 {
-	data = other.data; other.data = nullptr;
-	m_type = other.m_type; other.m_type = Variant::type_empty;
+    other.m_value.data = nullptr;
+    other.m_type = Variant::type_empty;
 }
 
 Variant::~Variant()
@@ -62,24 +66,56 @@ Variant::~Variant()
     release();
 }
 
+#define IMPLEMENT_INLINE_UMF_TYPE( T )\
+Variant::Variant( const umf_##T& value) : m_type(type_##T)\
+{\
+    new (&m_value.T) umf_##T(value);\
+}\
+Variant& Variant::operator = ( const umf_##T& value )\
+{\
+    release();\
+    m_type = type_##T;\
+    new (&m_value.T) umf_##T(value);\
+    return *this;\
+}\
+const umf_##T& Variant::get_##T() const\
+{\
+    if( type_##T == m_type )\
+    {\
+        return m_value.T;\
+    }\
+    UMF_EXCEPTION(TypeCastException, "bad cast");\
+}\
+Variant::operator const umf_##T& () const\
+{\
+    return get_##T();\
+}
+
+IMPLEMENT_INLINE_UMF_TYPE( integer )
+IMPLEMENT_INLINE_UMF_TYPE( real )
+IMPLEMENT_INLINE_UMF_TYPE( vec2d )
+IMPLEMENT_INLINE_UMF_TYPE( vec3d )
+IMPLEMENT_INLINE_UMF_TYPE( vec4d )
+
 #define IMPLEMENT_UMF_TYPE( T )\
 Variant::Variant( const umf_##T& value)\
 {\
     m_type = type_##T;\
-    data = new Data<umf_##T>(value);\
+    m_value.data = new Data<umf_##T>(value);\
 }\
 Variant& Variant::operator = ( const umf_##T& value )\
 {\
+    IData* pData = new Data<umf_##T>(value);\
     release();\
     m_type = type_##T;\
-    data = new Data<umf_##T>(value);\
+    m_value.data = pData;\
     return *this;\
 }\
 const umf_##T& Variant::get_##T() const\
 {\
     if( type_##T == m_type )\
     {\
-        return dynamic_cast<Data<umf_##T>*>(data)->content;\
+        return ref<umf_##T>();\
     }\
     UMF_EXCEPTION(TypeCastException, "bad cast");\
 }\
@@ -88,32 +124,59 @@ Variant::operator const umf_##T& () const\
     return get_##T();\
 }
 
-IMPLEMENT_UMF_TYPE( integer )
-IMPLEMENT_UMF_TYPE( real )
 IMPLEMENT_UMF_TYPE( string )
-IMPLEMENT_UMF_TYPE( vec2d )
-IMPLEMENT_UMF_TYPE( vec3d )
-IMPLEMENT_UMF_TYPE( vec4d )
 IMPLEMENT_UMF_TYPE( rawbuffer )
 
+#define IMPLEMENT_MOVABLE_UMF_TYPE( T )\
+Variant::Variant( umf_##T&& value)\
+{\
+    m_type = type_##T;\
+    m_value.data = new Data<umf_##T>(std::move(value));\
+}\
+Variant& Variant::operator = ( umf_##T&& value )\
+{\
+    IData* pData = new Data<umf_##T>(std::move(value));\
+    release();\
+    m_type = type_##T;\
+    m_value.data = pData;\
+    return *this;\
+}
+
+IMPLEMENT_MOVABLE_UMF_TYPE( string )
+IMPLEMENT_MOVABLE_UMF_TYPE( rawbuffer )
+
 #define IMPLEMENT_VECTOR_UMF_TYPE( T ) \
 Variant::Variant( const std::vector<umf_##T>& value)\
 {\
     m_type = type_##T##_vector;\
-    data = new Data<std::vector<umf_##T>>(value);\
+    m_value.data = new Data<std::vector<umf_##T>>(value);\
+}\
+Variant::Variant( std::vector<umf_##T>&& value)\
+{\
+    m_type = type_##T##_vector;\
+    m_value.data = new Data<std::vector<umf_##T>>(std::move(value));\
 }\
 Variant& Variant::operator = ( const std::vector<umf_##T>& value )\
 {\
+    IData* pData = new Data<std::vector<umf_##T>>(value);\
+    release();\
+    m_type = type_##T##_vector;\
+    m_value.data = pData;\
+    return *this;\
+}\
+Variant& Variant::operator = ( std::vector<umf_##T>&& value )\
+{\
+    IData* pData = new Data<std::vector<umf_##T>>(std::move(value));\
     release();\
     m_type = type_##T##_vector;\
-    data = new Data<std::vector<umf_##T>>(value);\
+    m_value.data = pData;\
     return *this;\
 }\
 const std::vector<umf_##T>& Variant::get_##T##_vector() const\
 {\
     if( type_##T##_vector == m_type )\
     {\
-        return dynamic_cast<Data<std::vector<umf_##T>>*>(data)->content;\
+        return ref<std::vector<umf_##T>>();\
     }\
     UMF_EXCEPTION(TypeCastException, "bad cast");\
 }\
@@ -129,17 +192,17 @@ IMPLEMENT_VECTOR_UMF_TYPE( vec2d )
 IMPLEMENT_VECTOR_UMF_TYPE( vec3d )
 IMPLEMENT_VECTOR_UMF_TYPE( vec4d )
 
-Variant::Variant(const int& value) : data(new Data<umf_integer>(value)), m_type(type_integer) {}
-Variant::Variant(const unsigned int& value) : data(new Data<umf_integer>(value)), m_type(type_integer) {}
+Variant::Variant(const int& value) : m_type(type_integer) { m_value.integer = value; }
+Variant::Variant(const unsigned int& value) : m_type(type_integer) { m_value.integer = value; }
 
-Variant::Variant(const float& value) : data(new Data<umf_real>(value)), m_type(type_real) {}
+Variant::Variant(const float& value) : m_type(type_real) { m_value.real = value; }
 
 Variant& Variant::operator = ( const int& value )
 {
     release();
 
     m_type = type_integer;
-    data = new Data<umf_integer>(value);
+    m_value.integer = value;
     return *this;
 }
 
@@ -148,7 +211,7 @@ Variant& Variant::operator = (const unsigned int& value)
     release();
 
     m_type = type_integer;
-    data = new Data<umf_integer>(value);
+    m_value.integer = value;
     return *this;
 }
 
@@ -157,46 +220,52 @@ Variant& Variant::operator = (const float& value)
     release();
 
     m_type = type_real;
-    data = new Data<umf_real>(value);
+    m_value.real = value;
     return *this;
 }
 
 Variant::Variant( const std::vector<int>& value ) : m_type(type_integer_vector)
 {
-    data = new Data<std::vector<umf_integer>>(std::vector<umf_integer>(value.begin(), value.end()));
+    m_value.data = new Data<std::vector<umf_integer>>(std::vector<umf_integer>(value.begin(), value.end()));
 }
 
 Variant::Variant( const std::vector<float>& value ) :  m_type(type_real_vector)
 {
-    data = new Data<std::vector<umf_real>>(std::vector<umf_real>(value.begin(), value.end()));
+    m_value.data = new Data<std::vector<umf_real>>(std::vector<umf_real>(value.begin(), value.end()));
 }
 
 Variant& Variant::operator = ( const std::vector<int>& value )
 {
+    IData* pData = new Data<std::vector<umf_integer>>(std::vector<umf_integer>(value.begin(), value.end()));
     release();
 
     m_type = type_integer_vector;
-    data = new Data<std::vector<umf_integer>>(std::vector<umf_integer>(value.begin(), value.end()));
+    m_value.data = pData;
     return *this;
 }
 
 Variant& Variant::operator = (const std::vector<float>& value)
 {
+    IData* pData = new Data<std::vector<umf_real>>(std::vector<umf_real>(value.begin(), value.end()));
     release();
 
     m_type = type_real_vector;
-    data = new Data<std::vector<umf_real>>(std::vector<umf_real>(value.begin(), value.end()));
+    m_value.data = pData;
     return *this;
 }
 
-Variant::Variant(const char* pszString) : data(new Data<umf_string>(std::string(pszString))), m_type(type_string) {}
+Variant::Variant(const char* pszString) : m_type(type_string)
+{
+    m_value.data = new Data<umf_string>(std::string(pszString));
+}
 
 Variant& Variant::operator = ( const char* pszString )
 {
+    IData* pData = new Data<umf_string>(std::string(pszString));
     release();
 
     m_type = type_string;
-    data = new Data<umf_string>(std::string(pszString));
+    m_value.data = pData;
     return *this;
 }
 
@@ -204,13 +273,14 @@ Variant& Variant::operator = (const Variant& other)
 {
     if (this != &other)
     {
-        release();
+        // Copy first, so the value stays intact if the copy throws
+        Storage value = other.m_value;
+        if (isAllocated(other.m_type) && value.data)
+            value.data = value.data->clone();
 
-        m_type = other.getType();
-		if (m_type == type_empty || other.data == nullptr)
-            data = nullptr;
-        else
-            data = other.data->clone();
+        release();
+        m_type = other.m_type;
+        m_value = value;
     }
 
     return *this;
@@ -220,22 +290,27 @@ Variant& Variant::operator = (Variant&& other)
 {
     if(this != &other)
     {
-        std::swap(this->data, other.data);
+        std::swap(this->m_value, other.m_value);
         std::swap(this->m_type, other.m_type);
     }
 
     return *this;
 }
 
+#define COMPARE_INLINE_OBJECT(T) \
+    case type_##T: \
+        bIsEqual = m_value.T == other.get_##T(); \
+        break;
+
 #define COMPARE_OBJECT(T) \
     case type_##T: \
-        bIsEqual = dynamic_cast<Data<umf_##T>*>(data)->content == other.get_##T(); \
+        bIsEqual = ref<umf_##T>() == other.get_##T(); \
         break;
 
 #define COMPARE_VECTOR_OBJECT( T ) \
     case type_##T##_vector: \
     { \
-        auto content = dynamic_cast<Data<std::vector<umf_##T>>*>(data)->content; \
+        const auto& content = ref<std::vector<umf_##T>>(); \
         if( content.size() == other.get_##T##_vector().size() ) \
             bIsEqual = std::equal( content.begin(), content.end(), other.get_##T##_vector().begin() ); \
     } \
@@ -268,19 +343,19 @@ bool Variant::operator == (const Variant& other) const
     bool bIsEqual = false;
     switch(m_type)
     {
-        COMPARE_OBJECT( integer )
+        COMPARE_INLINE_OBJECT( integer )
         case type_real:
-            bIsEqual = DOUBLE_EQ(dynamic_cast<Data<umf_real>*>(data)->content, other.get_real());
+            bIsEqual = DOUBLE_EQ(m_value.real, other.get_real());
         break;
         COMPARE_OBJECT( string )
-        COMPARE_OBJECT( vec2d )
-        COMPARE_OBJECT( vec3d )
-        COMPARE_OBJECT( vec4d )
+        COMPARE_INLINE_OBJECT( vec2d )
+        COMPARE_INLINE_OBJECT( vec3d )
+        COMPARE_INLINE_OBJECT( vec4d )
         COMPARE_OBJECT( rawbuffer )
         COMPARE_VECTOR_OBJECT( integer )
         case type_real_vector:
         {
-            auto content = dynamic_cast<Data<std::vector<umf_real>>*>(data)->content;
+            const auto& content = ref<std::vector<umf_real>>();
             if( content.size() == other.get_real_vector().size() )
                 bIsEqual = std::equal( content.begin(), content.end(), other.get_real_vector().begin(), DOUBLE_EQ );
         }
@@ -305,99 +380,84 @@ bool Variant::operator != ( const Variant& other ) const
     return !( this->operator == ( other ));
 }
 
-#define SIMPLE_TYPE_TO_STRING( VAL ) \
-    ss << VAL;
+static void appendValue(std::string& s, umf_integer value)
+{
+    text_codec::appendInteger(s, value);
+}
 
-#define REAL_TYPE_TO_STRING( VAL ) \
-    ss << std::setprecision(std::numeric_limits<double>::digits10) << VAL;
+static void appendValue(std::string& s, umf_real value)
+{
+    // same text as std::ostream with setprecision(digits10)
+    text_codec::appendReal(s, value);
+}
 
-#define VEC2_TYPE_TO_STRING( VAL ) \
-    ss  << std::setprecision(std::numeric_limits<double>::digits10) << VAL.x << \
-    " " << std::setprecision(std::numeric_limits<double>::digits10) << VAL.y;
+static void appendValue(std::string& s, const umf_vec2d& value)
+{
+    appendValue(s, value.x);
+    s += ' ';
+    appendValue(s, value.y);
+}
 
-#define VEC3_TYPE_TO_STRING(VAL) \
-    VEC2_TYPE_TO_STRING(VAL) \
-    ss << " " << std::setprecision(std::numeric_limits<double>::digits10) << VAL.z;
+static void appendValue(std::string& s, const umf_vec3d& value)
+{
+    appendValue(s, umf_vec2d(value.x, value.y));
+    s += ' ';
+    appendValue(s, value.z);
+}
 
-#define VEC4_TYPE_TO_STRING( VAL ) \
-    VEC3_TYPE_TO_STRING(VAL) \
-    ss << " " << std::setprecision(std::numeric_limits<double>::digits10) << VAL.w;
+static void appendValue(std::string& s, const umf_vec4d& value)
+{
+    appendValue(s, umf_vec3d(value.x, value.y, value.z));
+    s += ' ';
+    appendValue(s, value.w);
+}
 
-#define VECTOR_TYPE_TO_STRING( T , OP ) \
-{ \
-    auto content = dynamic_cast<Data<std::vector<umf_##T>>*>(data)->content; \
-    const char * separator = ""; \
-    for(auto it = content.begin(); it != content.end(); it++) \
-    { \
-        ss << separator; \
-        OP( (*it) ) \
-        separator = " ; "; \
-    } \
+static void appendValue(std::string& s, const umf_string& value)
+{
+    // strings are written as base64 inside arrays, so ';' can't break the list
+    base64::append(s, value.c_str(), value.size() + 1);
 }
 
-std::string Variant::toString(bool withType) const
+template<class T> static void appendVector(std::string& s, const std::vector<T>& content)
+{
+    const char * separator = "";
+    for(auto it = content.begin(); it != content.end(); it++)
+    {
+        s += separator;
+        appendValue(s, *it);
+        separator = " ; ";
+    }
+}
+
+//! Text form of a value as parsed back by fromString()
+class ToStringVisitor
 {
-    std::stringstream ss;
+public:
+    explicit ToStringVisitor(std::string& s) : m_s(s) {}
+
+    void operator()(const Variant::Empty&) const { m_s += "<empty value>"; }
+    void operator()(const umf_string& value) const { m_s += value.c_str(); }
+    void operator()(const umf_rawbuffer& value) const { base64::append(m_s, value.data(), value.size()); }
+    template<class T> void operator()(const T& value) const { appendValue(m_s, value); }
+    template<class T> void operator()(const std::vector<T>& value) const { appendVector(m_s, value); }
 
-    if (withType) ss << '(' << getTypeName() << ')' << ' ';
+private:
+    std::string& m_s;
+};
 
-    switch( m_type )
+std::string Variant::toString(bool withType) const
+{
+    std::string s;
+
+    if (withType)
     {
-    default:
-    case type_empty:
-        ss << "<empty value>";
-        break;
-    case type_integer:
-        SIMPLE_TYPE_TO_STRING(dynamic_cast<Data<umf_integer>*>(data)->content)
-        break;
-    case type_real:
-        REAL_TYPE_TO_STRING(dynamic_cast<Data<umf_real>*>(data)->content)
-            break;
-    case type_string:
-        SIMPLE_TYPE_TO_STRING(dynamic_cast<Data<umf_string>*>(data)->content.c_str())
-        break;
-    case type_vec2d:
-        VEC2_TYPE_TO_STRING(dynamic_cast<Data<umf_vec2d>*>(data)->content)
-        break;
-    case type_vec3d:
-        VEC3_TYPE_TO_STRING(dynamic_cast<Data<umf_vec3d>*>(data)->content)
-        break;
-    case type_vec4d:
-        VEC4_TYPE_TO_STRING(dynamic_cast<Data<umf_vec4d>*>(data)->content)
-        break;
-    case type_rawbuffer:
-        ss << base64encode(dynamic_cast<Data<umf_rawbuffer>*>(data)->content);
-        break;
-    case type_integer_vector:
-        VECTOR_TYPE_TO_STRING(integer, SIMPLE_TYPE_TO_STRING)
-        break;
-    case type_real_vector:
-        VECTOR_TYPE_TO_STRING(real, REAL_TYPE_TO_STRING)
-        break;
-    case type_string_vector:
-        {
-            auto content = dynamic_cast<Data<std::vector<umf_string>>*>(data)->content;
-            const char * separator = "";
-            for (auto it = content.begin(); it != content.end(); it++)
-            {
-                ss << separator;
-                SIMPLE_TYPE_TO_STRING(base64encode(umf_rawbuffer(it->c_str(), it->size() + 1)))
-                separator = " ; ";
-            }
-        }
-        break;
-    case type_vec2d_vector:
-        VECTOR_TYPE_TO_STRING(vec2d, VEC2_TYPE_TO_STRING)
-        break;
-    case type_vec3d_vector:
-        VECTOR_TYPE_TO_STRING(vec3d, VEC3_TYPE_TO_STRING)
-        break;
-    case type_vec4d_vector:
-        VECTOR_TYPE_TO_STRING(vec4d, VEC4_TYPE_TO_STRING)
-        break;
+        s += '(';
+        s += getTypeName();
+        s += ") ";
     }
 
-    return ss.str();
+    visit(ToStringVisitor(s));
+    return s;
 }
 
 void Variant::fromString(const std::string& value)
@@ -409,179 +469,153 @@ void Variant::fromString(const std::string& value)
         size_t j = value.find(')');
         if (j != value.npos)
         {
-            m_type = typeFromString(value.substr(i + 1, j - i - 1));
+            Type type = typeFromString(value.substr(i + 1, j - i - 1));
             if (j + 1 < value.size() && value[j + 1] == ' ') j++;
-            fromString(m_type, value.substr(j + 1));
+            fromString(type, value.substr(j + 1));
             return;
         }
     }
     UMF_EXCEPTION(IncorrectParamException, "Error decoding value string: " + value);
 }
 
-void Variant::fromString(Type eType, const std::string& sValue)
+static bool parseItem(const char*& p, const char* end, umf_integer& value)
 {
-    release();
+    return text_codec::parseInteger(p, end, value);
+}
 
-    m_type = eType;
-    std::string value(sValue);
+static bool parseItem(const char*& p, const char* end, umf_real& value)
+{
+    return text_codec::parseReal(p, end, value);
+}
 
-    // skipping "(type)" if any
-    size_t j = value.find(')');
-    if (j != value.npos) value = value.substr(j + 1);
+// A failed component zeroes the rest, as std::istream leaves them untouched
+static bool parseItem(const char*& p, const char* end, umf_vec2d& value)
+{
+    value = umf_vec2d();
+    return parseItem(p, end, value.x) && parseItem(p, end, value.y);
+}
+
+static bool parseItem(const char*& p, const char* end, umf_vec3d& value)
+{
+    value = umf_vec3d();
+    return parseItem(p, end, value.x) && parseItem(p, end, value.y) && parseItem(p, end, value.z);
+}
 
+static bool parseItem(const char*& p, const char* end, umf_vec4d& value)
+{
+    value = umf_vec4d();
+    return parseItem(p, end, value.x) && parseItem(p, end, value.y) && parseItem(p, end, value.z) && parseItem(p, end, value.w);
+}
 
-    std::stringstream ss(value);
-    switch (m_type)
+static bool parseItem(const char*& p, const char* end, umf_string& value)
+{
+    const char *tokenBegin, *tokenEnd;
+    value.clear();
+    if(!text_codec::parseToken(p, end, tokenBegin, tokenEnd))
+        return false;
+    // written by appendValue() with the terminating zero
+    umf_rawbuffer buf = base64::decode(tokenBegin, tokenEnd - tokenBegin);
+    value.assign(buf.data(), strnlen(buf.data(), buf.size()));
+    return true;
+}
+
+//! Parses "item ; item ; ...", an item that fails to parse is kept and ends the list
+template<class T> static std::vector<T> parseVector(const char* p, const char* end)
+{
+    std::vector<T> vec;
+    for(;;)
+    {
+        T item;
+        bool ok = parseItem(p, end, item);
+        vec.push_back(std::move(item));
+        if(!ok)
+            break;
+        text_codec::skipSpaces(p, end);
+        if(p == end)
+            break;
+        umf_char separator = *p++;
+        if(separator != ';')
+            UMF_EXCEPTION(umf::IncorrectParamException, "Invalid array item separator: " + to_string(separator));
+    }
+    return vec;
+}
+
+void Variant::fromString(Type eType, const std::string& sValue)
+{
+    const char* p = sValue.data();
+    const char* end = p + sValue.size();
+
+    // skipping "(type)" if any
+    const char* pType = (const char*)memchr(p, ')', sValue.size());
+    if (pType) p = pType + 1;
+
+    switch (eType)
     {
     case type_empty:
+        *this = Variant();
         break;
     case type_integer:
         {
             umf_integer temp_integer;
-            ss >> temp_integer;
-            data = new Data<umf_integer>(temp_integer);
+            parseItem(p, end, temp_integer);
+            *this = temp_integer;
         }
         break;
     case type_real:
         {
             umf_real temp_real;
-            ss >> temp_real;
-            data = new Data<umf_real>(temp_real);
+            parseItem(p, end, temp_real);
+            *this = temp_real;
         }
         break;
     case type_string:
-        data = new Data<umf_string>(sValue);
+        *this = sValue;
         break;
     case type_vec2d:
         {
-            umf_real x, y;
-            ss >> x >> y;
-            data = new Data<umf_vec2d>(umf_vec2d(x, y));
+            umf_vec2d temp;
+            parseItem(p, end, temp);
+            *this = temp;
         }
         break;
     case type_vec3d:
         {
-            umf_real x, y, z;
-            ss >> x >> y >> z;
-            data = new Data<umf_vec3d>(umf_vec3d(x, y, z));
+            umf_vec3d temp;
+            parseItem(p, end, temp);
+            *this = temp;
         }
         break;
     case type_vec4d:
         {
-            umf_real x, y, z, w;
-            ss >> x >> y >> z >> w;
-            data = new Data<umf_vec4d>(umf_vec4d(x, y, z, w));
+            umf_vec4d temp;
+            parseItem(p, end, temp);
+            *this = temp;
         }
         break;
     case type_rawbuffer:
         {
-            std::string s;
-            ss >> s;
-            data = new Data<umf_rawbuffer>(umf_rawbuffer(base64decode(s)));
-            break;
+            const char *tokenBegin, *tokenEnd;
+            text_codec::parseToken(p, end, tokenBegin, tokenEnd);
+            *this = base64::decode(tokenBegin, tokenEnd - tokenBegin);
         }
         break;
     case type_integer_vector:
-        {
-            std::vector<umf_integer> vec;
-            while(ss)
-            {
-                umf_integer temp;
-                umf_char separator = ';';
-                ss >> temp;
-                vec.push_back(temp);
-                if(ss)
-                    ss >> separator;
-                if(separator != ';')
-                    UMF_EXCEPTION(umf::IncorrectParamException, "Invalid array item separator: " + to_string(separator));
-            }
-            data = new Data<std::vector<umf_integer>>(vec);
-        }
+        *this = parseVector<umf_integer>(p, end);
         break;
     case type_real_vector:
-        {
-            std::vector<umf_real> vec;
-            while(ss)
-            {
-                umf_real temp;
-                umf_char separator = ';';
-                ss >> temp;
-                vec.push_back(temp);
-                if(ss)
-                    ss >> separator;
-                if(separator != ';')
-                    UMF_EXCEPTION(umf::IncorrectParamException, "Invalid array item separator: " + to_string(separator));
-            }
-            data = new Data<std::vector<umf_real>>(vec);
-        }
+        *this = parseVector<umf_real>(p, end);
         break;
     case type_string_vector:
-        {
-            std::vector<umf_string> vec;
-            while(ss)
-            {
-                umf_string temp;
-                umf_char separator = ';';
-                ss >> temp;
-                vec.push_back( base64decode(temp).data() );
-                if(ss)
-                    ss >> separator;
-                if(separator != ';')
-                    UMF_EXCEPTION(umf::IncorrectParamException, "Invalid array item separator: " + to_string(separator));
-            }
-            data = new Data<std::vector<umf_string>>(vec);
-        }
+        *this = parseVector<umf_string>(p, end);
         break;
     case type_vec2d_vector:
-        {
-            std::vector<umf_vec2d> vec;
-            umf_char separator = ';';
-            while(ss)
-            {
-                umf_real x, y;
-                ss >> x >> y;
-                vec.push_back( umf_vec2d(x,y) );
-                if(ss)
-                    ss >> separator;
-                if(separator != ';')
-                    UMF_EXCEPTION(umf::IncorrectParamException, "Invalid array item separator: " + to_string(separator));
-            }
-            data = new Data<std::vector<umf_vec2d>>(vec);
-        }
+        *this = parseVector<umf_vec2d>(p, end);
         break;
     case type_vec3d_vector:
-        {
-            std::vector<umf_vec3d> vec;
-            umf_char separator = ';';
-            while(ss)
-            {
-                umf_real x, y, z;
-                ss >> x >> y >> z;
-                vec.push_back( umf_vec3d(x, y, z) );
-                if(ss)
-                    ss >> separator;
-                if(separator != ';')
-                    UMF_EXCEPTION(umf::IncorrectParamException, "Invalid array item separator: " + to_string(separator));
-            }
-            data = new Data<std::vector<umf_vec3d>>(vec);
-        }
+        *this = parseVector<umf_vec3d>(p, end);
         break;
     case type_vec4d_vector:
-        {
-            std::vector<umf_vec4d> vec;
-            umf_char separator = ';';
-            while(ss)
-            {
-                umf_real x, y, z, w;
-                ss >> x >> y >> z >> w;
-                vec.push_back( umf_vec4d(x, y, z, w) );
-                if(ss)
-                    ss >> separator;
-                if(separator != ';')
-                    UMF_EXCEPTION(umf::IncorrectParamException, "Invalid array item separator: " + to_string(separator));
-            }
-            data = new Data<std::vector<umf_vec4d>>(vec);
-        }
+        *this = parseVector<umf_vec4d>(p, end);
         break;
     default:
         UMF_EXCEPTION(IncorrectParamException, "unexpected type");
@@ -615,11 +649,18 @@ void Variant::convertTo(Type type)
         UMF_EXCEPTION(TypeCastException, "Cannot convert value to the target type!" );
     }
 
+    // Integer to real is the only numeric conversion and it never leaves the range
+    if (m_type == type_integer && type == type_real)
+    {
+        *this = (umf_real)m_value.integer;
+        return;
+    }
+
     // Convert value to double, and check to see if the value is out of range of what the new type can represent.
     std::string sValue = toString();
     double fValue;
-    std::stringstream ss( sValue );
-    ss >> fValue;
+    const char* p = sValue.data();
+    text_codec::parseReal(p, p + sValue.size(), fValue);
 
     if (fValue < minLimit<double>(type) || fValue > maxLimit<double>(type))
     {
@@ -704,68 +745,21 @@ bool Variant::isConvertible(Type srcType, Type dstType)
 
 std::string Variant::base64encode(const umf_rawbuffer& value)
 {
-    const char base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
     std::string result;
-    int size = (int)value.size();
-    const char * data = value.data();
-
-    while (size > 0)
-    {
-        const char *c0 = data++, *c1 = size > 1 ? data++ : "\0", *c2 = size > 2 ? data++ : "\0";
-
-        result += base64_chars[(*c0 & 0xfc) >> 2];
-        result += base64_chars[((*c0 & 0x03) << 4) | ((*c1 & 0xf0) >> 4)];
-        result += size > 1 ? base64_chars[((*c1 & 0x0f) << 2) | ((*c2 & 0xc0) >> 6)] : '=';
-        result += size > 2 ? base64_chars[*c2 & 0x3f] : '=';
-
-        size -= 3;
-    }
+    base64::append(result, value.data(), value.size());
     return result;
 }
 
 umf_rawbuffer Variant::base64decode(const std::string& base64Str)
 {
-    const std::string base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-
-    if (base64Str.empty())
-        return umf_rawbuffer();
-
-    size_t size = base64Str.size();
-    if (base64Str.size() % 4 != 0)
-        UMF_EXCEPTION(umf::IncorrectParamException, "Invalid base64 string size (isn't multiple of 4)");
-
-    size_t i = 0;
-    auto rit = base64Str.rbegin();
-    while (rit != base64Str.rend() && *rit++ == '=') ++i;
-    if (i > 2)
-        UMF_EXCEPTION(umf::IncorrectParamException, "Invalid base64 string: more than 2 trailing '=' symbols");
-
-    size_t  res_size = size / 4 * 3 - i;
-    std::unique_ptr<char[]> result(new char[res_size]);
-
-    const char * in = base64Str.c_str();
-    i = 0;
-    while (i < res_size)
-    {
-        char c[4];
-        for (int j = 0; j < 4; j++)
-        {
-            c[j] = (char)base64_chars.find(*in++);
-            if (c[j] < 0 && i + j <= res_size)
-                UMF_EXCEPTION(umf::IncorrectParamException, "Input base64 string contains invalid symbol");
-        }
-
-        result[i++] = (c[0] << 2) | (c[1] >> 4);
-        if (i < res_size) result[i++] = (c[1] << 4) | (c[2] >> 2);
-        if (i < res_size) result[i++] = ((c[2] & 0x3) << 6) | c[3];
-    }
-    return umf_rawbuffer(result.get(), res_size);
+    return base64::decode(base64Str.data(), base64Str.size());
 }
 
 void Variant::release()
 {
-    delete data;
-    data = nullptr;
+    if (isAllocated(m_type))
+        delete m_value.data;
+    m_value.data = nullptr;
 };
 
 }//umf
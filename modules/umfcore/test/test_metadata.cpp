@@ -80,6 +80,29 @@ TEST_F(TestMetadata, AddValue)
     EXPECT_NO_THROW(spSki->validate());
 }
 
+TEST_F(TestMetadata, EmplaceField)
+{
+    std::string name(1000, 'n');
+    const char* pName = name.data();
+    spJessica->emplaceField("name", std::move(name));
+    ASSERT_EQ(pName, spJessica->get<umf::umf_string>("name").data());
+
+    std::string email("jessica@example.com");
+    spJessica->emplaceField("email", email);
+    ASSERT_EQ("jessica@example.com", email);
+    spJessica->emplaceField("age", (umf::umf_integer)27);
+    spJessica->emplaceField("sex", "female");
+    ASSERT_EQ(27, spJessica->get<umf::umf_integer>("age"));
+    ASSERT_EQ("female", spJessica->getFieldValue("sex").get_string());
+    ASSERT_NO_THROW(spJessica->validate());
+
+    umf::Variant other(std::string(1000, 'o'));
+    const char* pOther = other.get_string().data();
+    spJessica->setFieldValue("name", std::move(other));
+    ASSERT_EQ(pOther, spJessica->get<umf::umf_string>("name").data());
+    ASSERT_THROW(spJessica->emplaceField("no_such_field", std::string("value")), umf::IncorrectParamException);
+}
+
 TEST_F(TestMetadata, AddValueIncorrectType)
 {
     spDesc = std::shared_ptr< umf::MetadataDesc >( new umf::MetadataDesc( "event", umf::Variant::type_string ));
@@ -94,3 +117,79 @@ TEST_F(TestMetadata, GetSingleFieldValue)
     metadata->addValue(42);
     ASSERT_NO_THROW(metadata->getFieldValue());
 }
+
+TEST_F(TestMetadata, FieldSlots)
+{
+    size_t nameSlot, ageSlot, emailSlot;
+    ASSERT_TRUE(spDesc->getFieldSlot("name", nameSlot));
+    ASSERT_TRUE(spDesc->getFieldSlot("age", ageSlot));
+    ASSERT_TRUE(spDesc->getFieldSlot("email", emailSlot));
+    ASSERT_FALSE(spDesc->getFieldSlot("position", nameSlot));
+    ASSERT_EQ(1u, ageSlot);
+    ASSERT_EQ("age", spDesc->getSlotDesc(ageSlot).name);
+    ASSERT_THROW(spDesc->getSlotDesc(spDesc->getSlotCount()), umf::IncorrectParamException);
+
+    // set out of the description order
+    spJessica->setFieldValue( "email", "jessica@kidsmail.com" );
+    spJessica->setFieldValue( "age", (umf::umf_integer) 12 );
+    spJessica->setFieldValue( "name", "Jessica" );
+    spJessica->setFieldValue( "age", (umf::umf_integer) 13 );
+
+    ASSERT_EQ(13, spJessica->get<umf::umf_integer>(ageSlot));
+    ASSERT_EQ("Jessica", spJessica->get<umf::umf_string>("name"));
+    ASSERT_EQ("jessica@kidsmail.com", spJessica->field(emailSlot).get_string());
+    ASSERT_EQ(&spJessica->field(ageSlot), &*spJessica->findField("age"));
+
+    size_t sexSlot;
+    ASSERT_TRUE(spDesc->getFieldSlot("sex", sexSlot));
+    ASSERT_TRUE(spJessica->tryField(sexSlot) == nullptr);
+    ASSERT_THROW(spJessica->field(sexSlot), umf::IncorrectParamException);
+    ASSERT_THROW(spJessica->get<umf::umf_real>(ageSlot), umf::TypeCastException);
+    ASSERT_THROW(spJessica->get<umf::umf_integer>("position"), umf::IncorrectParamException);
+}
+
+TEST_F(TestMetadata, Validate)
+{
+    spJessica->setFieldValue( "name", "Jessica" );
+    spJessica->setFieldValue( "age", (umf::umf_integer) 12 );
+    spJessica->setFieldValue( "sex", "F" );
+    EXPECT_THROW(spJessica->validate(), umf::ValidateException);
+    spJessica->setFieldValue( "email", "jessica@kidsmail.com" );
+    EXPECT_NO_THROW(spJessica->validate());
+
+    umf::Metadata wrongType( *spJessica );
+    wrongType[1] = umf::FieldValue( "age", umf::Variant( "twelve" ));
+    EXPECT_THROW(wrongType.validate(), umf::ValidateException);
+
+    umf::Metadata unknown( *spJessica );
+    unknown.push_back( umf::FieldValue( "position", umf::Variant( "manager" )));
+    EXPECT_THROW(unknown.validate(), umf::ValidateException);
+
+    umf::Metadata duplicate( *spJessica );
+    duplicate.push_back( umf::FieldValue( "sex", umf::Variant( "M" )));
+    EXPECT_THROW(duplicate.validate(), std::runtime_error);
+
+    umf::Metadata unnamed( *spJessica );
+    unnamed.push_back( umf::FieldValue( "", umf::Variant( "manager" )));
+    EXPECT_THROW(unnamed.validate(), umf::ValidateException);
+}
+
+TEST_F(TestMetadata, ValidateManyFields)
+{
+    std::vector< umf::FieldDesc > fields;
+    for( int i = 0; i < 300; i++ )
+        fields.emplace_back( umf::FieldDesc( "f" + umf::to_string( i ), umf::Variant::type_integer, i == 200 ));
+    auto spWide = std::make_shared< umf::MetadataDesc >( "wide", fields );
+
+    umf::Metadata md( spWide );
+    for( int i = 299; i >= 0; i-- )
+        if( i != 200 )
+            md.setFieldValue( "f" + umf::to_string( i ), (umf::umf_integer) i );
+    EXPECT_NO_THROW(md.validate());
+
+    md.erase( md.findField( "f250" ));
+    EXPECT_THROW(md.validate(), umf::ValidateException);
+    md.setFieldValue( "f250", (umf::umf_integer) 250 );
+    md.setFieldValue( "f200", (umf::umf_integer) 200 );
+    EXPECT_NO_THROW(md.validate());
+}
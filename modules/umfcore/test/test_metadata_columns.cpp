@@ -0,0 +1,360 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "test_precomp.hpp"
+
+class TestMetadataColumns : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        spSchema = std::make_shared<umf::MetadataSchema>("test_schema");
+        std::vector<umf::FieldDesc> fields;
+        fields.emplace_back(umf::FieldDesc("count", umf::Variant::type_integer));
+        fields.emplace_back(umf::FieldDesc("value", umf::Variant::type_real, true));
+        fields.emplace_back(umf::FieldDesc("position", umf::Variant::type_vec3d));
+        spSample = std::make_shared<umf::MetadataDesc>("sample", fields);
+        std::vector<umf::FieldDesc> noteFields;
+        noteFields.emplace_back(umf::FieldDesc("count", umf::Variant::type_integer));
+        noteFields.emplace_back(umf::FieldDesc("text", umf::Variant::type_string, true));
+        spNote = std::make_shared<umf::MetadataDesc>("note", noteFields);
+        spSchema->add(spSample);
+        spSchema->add(spNote);
+        stream.addSchema(spSchema);
+        plain.addSchema(spSchema);
+    }
+
+    std::shared_ptr<umf::Metadata> makeSample(long long i) const
+    {
+        auto spItem = std::make_shared<umf::Metadata>(spSample);
+        spItem->setFieldValue("count", (umf::umf_integer)(i % 7));
+        if(i % 3)
+            spItem->setFieldValue("value", (umf::umf_real)i / 4);
+        spItem->setFieldValue("position", umf::umf_vec3d((double)i, -(double)i, 0.5));
+        spItem->setFrameIndex(i % 20, 1 + i % 3);
+        if(i % 5)
+            spItem->setTimestamp(i * 10, i % 15);
+        return spItem;
+    }
+
+    std::shared_ptr<umf::Metadata> makeNote(long long i) const
+    {
+        auto spItem = std::make_shared<umf::Metadata>(spNote);
+        spItem->setFieldValue("count", (umf::umf_integer)(i % 7));
+        spItem->setFieldValue("text", "note" + std::to_string(i));
+        return spItem;
+    }
+
+    //! Fills the stream under test and the plain stream with the same items
+    void fill(size_t n)
+    {
+        for(size_t i = 0; i < n; i++)
+        {
+            auto spItem = i % 4 == 3 ? makeNote(i) : makeSample(i);
+            stream.add(std::make_shared<umf::Metadata>(*spItem));
+            plain.add(spItem);
+        }
+    }
+
+    //! Sample item with the identifier given by the plain stream
+    std::shared_ptr<umf::Metadata> addedSample(long long i)
+    {
+        while(plain.getAll().size() <= (size_t)i)
+            plain.add(makeSample((long long)plain.getAll().size()));
+        return plain.getById(i);
+    }
+
+    static std::vector<umf::IdType> ids(const umf::MetadataSet& set)
+    {
+        std::vector<umf::IdType> vIds;
+        for(auto& spItem : set)
+            vIds.push_back(spItem->getId());
+        return vIds;
+    }
+
+    static std::vector<umf::IdType> sortedIds(const umf::MetadataSet& set)
+    {
+        std::vector<umf::IdType> vIds = ids(set);
+        std::sort(vIds.begin(), vIds.end());
+        return vIds;
+    }
+
+    void compareWithPlain()
+    {
+        ASSERT_EQ(sortedIds(plain.getAll()), sortedIds(stream.getAll()));
+        for(auto& spItem : plain.getAll())
+        {
+            auto spOther = stream.getById(spItem->getId());
+            ASSERT_TRUE(spOther != nullptr);
+            ASSERT_EQ(spItem->getName(), spOther->getName());
+            ASSERT_EQ(spItem->getFrameIndex(), spOther->getFrameIndex());
+            ASSERT_EQ(spItem->getNumOfFrames(), spOther->getNumOfFrames());
+            ASSERT_EQ(spItem->getTime(), spOther->getTime());
+            ASSERT_EQ(spItem->getDuration(), spOther->getDuration());
+            ASSERT_EQ(spItem->getFieldNames(), spOther->getFieldNames());
+            for(auto& sName : spItem->getFieldNames())
+                ASSERT_TRUE(spItem->getFieldValue(sName) == spOther->getFieldValue(sName));
+        }
+
+        EXPECT_EQ(ids(plain.queryByName("sample")), ids(stream.queryByName("sample")));
+        EXPECT_EQ(ids(plain.queryBySchema("test_schema")), ids(stream.queryBySchema("test_schema")));
+        EXPECT_EQ(ids(plain.queryBySchemaAndName("test_schema", "sample")), ids(stream.queryBySchemaAndName("test_schema", "sample")));
+        EXPECT_EQ(plain.viewByName("sample").count(), stream.viewByName("sample").count());
+        EXPECT_EQ(plain.view().count(), stream.view().count());
+        for(size_t index = 0; index < 25; index++)
+            EXPECT_EQ(ids(plain.queryByFrameIndex(index)), ids(stream.queryByFrameIndex(index))) << "frame " << index;
+        for(long long start = -10; start < 700; start += 37)
+            EXPECT_EQ(ids(plain.queryByTime(start, start + 25)), ids(stream.queryByTime(start, start + 25))) << start;
+        for(umf::umf_integer count = 0; count < 8; count++)
+        {
+            umf::FieldValue value("count", umf::Variant(count));
+            EXPECT_EQ(ids(plain.queryByNameAndValue("sample", value)), ids(stream.queryByNameAndValue("sample", value)));
+            std::vector<umf::FieldValue> vFields(1, value);
+            vFields.emplace_back("value", umf::Variant((umf::umf_real)count / 4));
+            EXPECT_EQ(ids(plain.queryByNameAndFields("sample", vFields)), ids(stream.queryByNameAndFields("sample", vFields)));
+        }
+        EXPECT_EQ(ids(plain.queryByNameAndRange("sample", "count", umf::Variant((umf::umf_integer)2), umf::Variant(4.5))),
+                  ids(stream.queryByNameAndRange("sample", "count", umf::Variant((umf::umf_integer)2), umf::Variant(4.5))));
+        EXPECT_EQ(ids(plain.queryByNameAndRange("sample", "value", umf::Variant(1.0), umf::Variant((umf::umf_integer)7))),
+                  ids(stream.queryByNameAndRange("sample", "value", umf::Variant(1.0), umf::Variant((umf::umf_integer)7))));
+
+        umf::QueryExpr expr = umf::QueryExpr::name("sample") && umf::QueryExpr::time(50, 300) &&
+            umf::QueryExpr::field("count", umf::QueryExpr::Compare::Greater, umf::Variant((umf::umf_integer)2));
+        EXPECT_EQ(sortedIds(plain.select(expr).materialize()), ids(stream.select(expr).materialize()));
+    }
+
+    umf::MetadataStream stream;
+    umf::MetadataStream plain;
+    std::shared_ptr<umf::MetadataSchema> spSchema;
+    std::shared_ptr<umf::MetadataDesc> spSample;
+    std::shared_ptr<umf::MetadataDesc> spNote;
+};
+
+TEST_F(TestMetadataColumns, Spans)
+{
+    umf::MetadataColumns columns(spSample);
+    for(long long i : {4, 1, 2, 6})
+        columns.append(*addedSample(i));
+
+    ASSERT_EQ(4u, columns.size());
+    EXPECT_EQ(std::vector<umf::IdType>({1, 2, 4, 6}), std::vector<umf::IdType>(columns.ids().begin(), columns.ids().end()));
+    EXPECT_EQ(std::vector<umf::umf_integer>({1, 2, 4, 6}), std::vector<umf::umf_integer>(columns.integers(0).begin(), columns.integers(0).end()));
+    EXPECT_EQ(std::vector<unsigned char>({1, 1, 1, 0}), std::vector<unsigned char>(columns.presence(1).begin(), columns.presence(1).end()));
+    EXPECT_TRUE(columns.presence(0).empty());
+    EXPECT_DOUBLE_EQ(0.5, columns.reals(1)[1]);
+    EXPECT_EQ(0.0, columns.reals(1)[3]);
+
+    ASSERT_EQ(3u, columns.getComponents(2));
+    ASSERT_EQ(12u, columns.reals(2).size());
+    EXPECT_EQ(4.0, columns.reals(2)[6]);
+    EXPECT_EQ(-4.0, columns.reals(2)[7]);
+    EXPECT_EQ(0.5, columns.reals(2)[8]);
+    EXPECT_EQ(std::vector<long long>({1, 2, 4, 6}), std::vector<long long>(columns.frameIndexes().begin(), columns.frameIndexes().end()));
+    EXPECT_EQ(60, columns.timestamps()[3]);
+
+    EXPECT_THROW(columns.integers(1), umf::TypeCastException);
+    EXPECT_THROW(columns.reals(0), umf::TypeCastException);
+    EXPECT_THROW(columns.presence(3), umf::OutOfRangeException);
+}
+
+TEST_F(TestMetadataColumns, Materialize)
+{
+    umf::MetadataColumns columns(spSample);
+    auto spItem = addedSample(2);
+    columns.append(*spItem);
+
+    size_t row = 0;
+    ASSERT_TRUE(columns.find(2, row));
+    EXPECT_FALSE(columns.find(3, row));
+    auto spRow = columns.materialize(row);
+    EXPECT_EQ(2, spRow->getId());
+    EXPECT_EQ(spItem->getFieldNames(), spRow->getFieldNames());
+    EXPECT_EQ(2, spRow->getFieldValue("count").get_integer());
+    EXPECT_EQ(0.5, spRow->getFieldValue("value").get_real());
+    EXPECT_EQ(umf::umf_vec3d(2, -2, 0.5), spRow->getFieldValue("position").get_vec3d());
+    EXPECT_EQ(spItem->getFrameIndex(), spRow->getFrameIndex());
+    EXPECT_EQ(spItem->getTime(), spRow->getTime());
+    EXPECT_NO_THROW(spRow->validate());
+
+    // The row is a copy
+    spRow->setFieldValue("count", (umf::umf_integer)100);
+    EXPECT_EQ(2, columns.integers(0)[0]);
+
+    umf::Variant value;
+    umf::Metadata empty(*addedSample(5));
+    empty.erase(empty.findField("value"));
+    columns.append(empty);
+    EXPECT_FALSE(columns.getValue(1, 1, value));
+    EXPECT_EQ(2u, columns.materialize(1)->size());
+    EXPECT_THROW(columns.materialize(2), umf::OutOfRangeException);
+
+    ASSERT_TRUE(columns.remove(2));
+    EXPECT_FALSE(columns.remove(2));
+    ASSERT_EQ(1u, columns.size());
+    EXPECT_EQ(5, columns.ids()[0]);
+    EXPECT_EQ(1u, columns.presence(1).size());
+}
+
+TEST_F(TestMetadataColumns, Unsupported)
+{
+    EXPECT_FALSE(umf::MetadataColumns::isSupported(*spNote));
+    EXPECT_TRUE(umf::MetadataColumns::isSupported(*spSample));
+    EXPECT_THROW(umf::MetadataColumns columns(spNote), umf::IncorrectParamException);
+    EXPECT_THROW(stream.setColumnar("test_schema", "note"), umf::IncorrectParamException);
+    EXPECT_THROW(stream.setColumnar("test_schema", "unknown"), umf::NotFoundException);
+    EXPECT_THROW(stream.setColumnar("unknown", "sample"), umf::NotFoundException);
+
+    umf::MetadataColumns columns(spSample);
+    auto spItem = addedSample(1);
+    columns.append(*spItem);
+    EXPECT_THROW(columns.append(*spItem), umf::IncorrectParamException);
+    auto spNoteItem = makeNote(2);
+    EXPECT_THROW(columns.append(*spNoteItem), umf::IncorrectParamException);
+    EXPECT_EQ(1u, columns.size());
+}
+
+TEST_F(TestMetadataColumns, StreamQueries)
+{
+    stream.setColumnar("test_schema", "sample");
+    EXPECT_EQ(nullptr, stream.getColumns("test_schema", "note"));
+    fill(200);
+    ASSERT_EQ(150u, stream.getColumns("test_schema", "sample")->size());
+    compareWithPlain();
+
+    // Items given to the stream stay detached from it
+    auto spItem = makeSample(5);
+    umf::IdType id = stream.add(spItem);
+    plain.add(std::make_shared<umf::Metadata>(*spItem));
+    spItem->setFieldValue("count", (umf::umf_integer)99);
+    EXPECT_EQ(5, stream.getById(id)->getFieldValue("count").get_integer());
+    compareWithPlain();
+}
+
+TEST_F(TestMetadataColumns, MoveExistingItems)
+{
+    fill(100);
+    auto spBefore = stream.getById(0);
+    stream.setColumnar("test_schema", "sample");
+    ASSERT_EQ(75u, stream.getColumns("test_schema", "sample")->size());
+    EXPECT_NE(spBefore, stream.getById(0));
+    compareWithPlain();
+
+    // Setting it again changes nothing
+    stream.setColumnar("test_schema", "sample");
+    EXPECT_EQ(75u, stream.getColumns("test_schema", "sample")->size());
+}
+
+TEST_F(TestMetadataColumns, Remove)
+{
+    stream.setColumnar("test_schema", "sample");
+    fill(100);
+
+    for(umf::IdType id = 0; id < 100; id += 5)
+    {
+        EXPECT_EQ(plain.remove(id), stream.remove(id));
+        EXPECT_FALSE(stream.remove(id));
+    }
+    compareWithPlain();
+
+    umf::MetadataSet victims = stream.queryByFrameIndex(7);
+    ASSERT_FALSE(victims.empty());
+    stream.remove(victims);
+    plain.remove(plain.queryByFrameIndex(7));
+    compareWithPlain();
+
+    stream.remove(spSchema);
+    EXPECT_EQ(0u, stream.getAll().size());
+    EXPECT_EQ(nullptr, stream.getColumns("test_schema", "sample"));
+}
+
+TEST_F(TestMetadataColumns, BatchAndReferences)
+{
+    std::vector<std::shared_ptr<umf::ReferenceDesc>> refs;
+    refs.emplace_back(std::make_shared<umf::ReferenceDesc>("parent"));
+    std::vector<umf::FieldDesc> fields;
+    fields.emplace_back(umf::FieldDesc("value", umf::Variant::type_integer));
+    auto spNode = std::make_shared<umf::MetadataDesc>("node", fields, refs);
+    auto spOther = std::make_shared<umf::MetadataSchema>("other_schema");
+    spOther->add(spNode);
+    stream.addSchema(spOther);
+    stream.setColumnar("other_schema", "node");
+
+    std::vector<umf::MetadataInternal> items;
+    for(int i = 0; i < 10; i++)
+    {
+        umf::MetadataInternal mdi("node", "other_schema");
+        mdi.fields["value"].value = umf::to_string(i);
+        mdi.frameIndex = i;
+        items.push_back(std::move(mdi));
+    }
+    std::vector<umf::IdType> vIds = stream.addBatch(std::move(items));
+    ASSERT_EQ(10u, vIds.size());
+    EXPECT_EQ(10u, stream.queryByName("node").size());
+    EXPECT_EQ(7, stream.getById(vIds[7])->getFieldValue("value").get_integer());
+
+    // Items in columns can't refer to others or be referred to
+    umf::MetadataInternal withRef("node", "other_schema");
+    withRef.fields["value"].value = "1";
+    withRef.refs.emplace_back(vIds[0], "parent");
+    EXPECT_THROW(stream.add(withRef), umf::IncorrectParamException);
+
+    auto spRow = stream.getById(vIds[1]);
+    auto spReferrer = std::make_shared<umf::Metadata>(spNode);
+    spReferrer->setFieldValue("value", (umf::umf_integer)0);
+    auto spPlainNode = std::make_shared<umf::Metadata>(spNode);
+    spPlainNode->setFieldValue("value", (umf::umf_integer)0);
+    spPlainNode->addReference(spRow, "parent");
+    EXPECT_THROW(stream.add(spPlainNode), umf::IncorrectParamException);
+    EXPECT_EQ(10u, stream.getAll().size());
+
+    std::vector<umf::MetadataInternal> referrers;
+    referrers.emplace_back("note", "test_schema");
+    referrers.back().fields["count"].value = "1";
+    referrers.back().refs.emplace_back(vIds[2], "parent");
+    EXPECT_THROW(stream.addBatch(std::move(referrers)), umf::IncorrectParamException);
+    EXPECT_EQ(10u, stream.getAll().size());
+    EXPECT_TRUE(stream.queryByName("note").empty());
+}
+
+TEST_F(TestMetadataColumns, SerializeAndStat)
+{
+    std::vector<umf::StatField> statFields;
+    statFields.emplace_back("CountSum", "test_schema", "sample", "count", umf::StatOpFactory::builtinName(umf::StatOpFactory::BuiltinOp::Sum));
+    stream.addStat(std::make_shared<umf::Stat>("stat", statFields, umf::Stat::UpdateMode::OnAdd));
+    plain.addStat(std::make_shared<umf::Stat>("stat", statFields, umf::Stat::UpdateMode::OnAdd));
+
+    stream.setColumnar("test_schema", "sample");
+    fill(40);
+    plain.getStat("stat")->update(true);
+    stream.getStat("stat")->update(true);
+    EXPECT_EQ(plain.getStat("stat")->getField("CountSum").getValue().get_integer(),
+              stream.getStat("stat")->getField("CountSum").getValue().get_integer());
+
+    umf::FormatXML format;
+    std::string text = stream.serialize(format);
+    EXPECT_EQ(plain.serialize(format).size(), text.size());
+
+    umf::MetadataStream loaded;
+    loaded.deserialize(text, format);
+    loaded.setColumnar("test_schema", "sample");
+    EXPECT_EQ(30u, loaded.getColumns("test_schema", "sample")->size());
+    EXPECT_EQ(sortedIds(stream.getAll()), sortedIds(loaded.getAll()));
+
+    umf::MetadataStream copy(stream);
+    stream.remove((umf::IdType)0);
+    EXPECT_EQ(30u, copy.getColumns("test_schema", "sample")->size());
+    EXPECT_EQ(29u, stream.getColumns("test_schema", "sample")->size());
+}
@@ -0,0 +1,156 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "test_precomp.hpp"
+
+#include <list>
+
+TEST(TestMetadataPool, ReusesBlocks)
+{
+    umf::MetadataPool pool(4);
+    void* a = pool.allocate(24);
+    void* b = pool.allocate(32);
+    ASSERT_NE(a, b);
+    ASSERT_EQ(2u, pool.getBlockCount());
+    ASSERT_EQ(1u, pool.getChunkCount());
+
+    pool.deallocate(a, 24);
+    ASSERT_EQ(a, pool.allocate(17));
+
+    std::vector<void*> blocks;
+    for(int i = 0; i < 4; i++)
+        blocks.push_back(pool.allocate(32));
+    ASSERT_EQ(2u, pool.getChunkCount());
+    ASSERT_EQ(6u, pool.getBlockCount());
+
+    void* large = pool.allocate(umf::MetadataPool::getMaxBlockSize() + 1);
+    ASSERT_EQ(6u, pool.getBlockCount());
+    pool.deallocate(large, umf::MetadataPool::getMaxBlockSize() + 1);
+
+    for(void* p : blocks)
+        pool.deallocate(p, 32);
+    pool.deallocate(a, 17);
+    pool.deallocate(b, 32);
+    ASSERT_EQ(0u, pool.getBlockCount());
+}
+
+TEST(TestMetadataPool, Allocator)
+{
+    auto spPool = std::make_shared<umf::MetadataPool>();
+    {
+        std::list<int, umf::PoolAllocator<int>> values((umf::PoolAllocator<int>(spPool)));
+        for(int i = 0; i < 100; i++)
+            values.push_back(i);
+        ASSERT_EQ(100u, spPool->getBlockCount());
+        values.clear();
+        ASSERT_EQ(0u, spPool->getBlockCount());
+    }
+
+    umf::PoolAllocator<int> heap;
+    ASSERT_TRUE(heap == umf::PoolAllocator<double>());
+    ASSERT_TRUE(heap != umf::PoolAllocator<int>(spPool));
+    int* p = heap.allocate(1);
+    heap.deallocate(p, 1);
+}
+
+class TestPooledStream : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        auto spSchema = std::make_shared<umf::MetadataSchema>("pool_schema");
+        std::vector<umf::FieldDesc> fields;
+        fields.emplace_back("count", umf::Variant::type_integer);
+        fields.emplace_back("text", umf::Variant::type_string, true);
+        spDesc = std::make_shared<umf::MetadataDesc>("item", fields);
+        spSchema->add(spDesc);
+        stream.addSchema(spSchema);
+    }
+
+    std::vector<umf::MetadataInternal> makeItems(size_t n)
+    {
+        std::vector<umf::MetadataInternal> items;
+        for(size_t i = 0; i < n; i++)
+        {
+            umf::MetadataInternal mdi("item", "pool_schema");
+            mdi.fields["count"].value = umf::to_string(i);
+            if(i % 2)
+                mdi.fields["text"].value = "text " + umf::to_string(i);
+            mdi.frameIndex = (long long)i;
+            if(i > 0)
+                mdi.refs.emplace_back((umf::IdType)i - 1, "");
+            items.push_back(std::move(mdi));
+        }
+        return items;
+    }
+
+    umf::MetadataStream stream;
+    std::shared_ptr<umf::MetadataDesc> spDesc;
+};
+
+TEST_F(TestPooledStream, Mode)
+{
+    ASSERT_FALSE(stream.isPooled());
+    stream.addBatch(makeItems(10));
+    stream.setPooled(true);
+    ASSERT_TRUE(stream.isPooled());
+    ASSERT_EQ(10u, stream.getAll().size());
+    ASSERT_EQ(5, stream.getById(5)->getFieldValue("count").get_integer());
+
+    auto spMd = stream.createMetadata(spDesc);
+    spMd->setFieldValue("count", (umf::umf_integer)42);
+    ASSERT_EQ(10u, stream.add(spMd));
+    ASSERT_EQ(spMd, stream.getById(10));
+
+    stream.setPooled(false);
+    ASSERT_FALSE(stream.isPooled());
+    ASSERT_EQ(spMd, stream.getById(10));
+    ASSERT_TRUE(stream.remove((umf::IdType)10));
+    ASSERT_EQ(10u, stream.getAll().size());
+}
+
+TEST_F(TestPooledStream, MatchesHeapStream)
+{
+    umf::MetadataStream heapStream(stream);
+    stream.setPooled(true);
+    stream.addBatch(makeItems(100));
+    heapStream.addBatch(makeItems(100));
+
+    umf::FormatXML format;
+    ASSERT_EQ(heapStream.serialize(format), stream.serialize(format));
+    for(umf::IdType id = 1; id < 100; id++)
+        ASSERT_TRUE(stream.getById(id)->isReference(id - 1));
+
+    umf::MetadataStream loaded;
+    loaded.setPooled(true);
+    loaded.deserialize(stream.serialize(format), format);
+    ASSERT_EQ(stream.serialize(format), loaded.serialize(format));
+}
+
+TEST_F(TestPooledStream, ItemsOutliveStream)
+{
+    umf::MetadataSet items;
+    {
+        umf::MetadataStream pooled(stream);
+        pooled.setPooled(true);
+        pooled.addBatch(makeItems(50));
+        items = pooled.queryByName("item");
+        pooled.clear();
+    }
+    ASSERT_EQ(50u, items.size());
+    for(size_t i = 0; i < items.size(); i++)
+        ASSERT_EQ((umf::umf_integer)items[i]->getId(), items[i]->getFieldValue("count").get_integer());
+}
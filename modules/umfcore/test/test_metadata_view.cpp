@@ -0,0 +1,137 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "test_precomp.hpp"
+
+class TestMetadataView : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        for(const char* schemaName : {"first_schema", "second_schema"})
+        {
+            auto spSchema = std::make_shared<umf::MetadataSchema>(schemaName);
+            std::vector<umf::FieldDesc> fields;
+            fields.emplace_back(umf::FieldDesc("value", umf::Variant::type_integer));
+            auto spItemDesc = std::make_shared<umf::MetadataDesc>("item", fields);
+            auto spNoteDesc = std::make_shared<umf::MetadataDesc>("note", fields);
+            spSchema->add(spItemDesc);
+            spSchema->add(spNoteDesc);
+            stream.addSchema(spSchema);
+        }
+
+        for(umf::umf_integer i = 0; i < 100; i++)
+        {
+            auto spSchema = stream.getSchema(i % 3 ? "first_schema" : "second_schema");
+            auto spItem = std::make_shared<umf::Metadata>(spSchema->findMetadataDesc(i % 4 ? "item" : "note"));
+            spItem->setFieldValue("value", i);
+            spItem->setFrameIndex(i, 3);
+            stream.add(spItem);
+        }
+    }
+
+    static std::vector<umf::IdType> ids(const umf::MetadataView& view)
+    {
+        std::vector<umf::IdType> vIds;
+        for(const auto& spItem : view)
+            vIds.push_back(spItem->getId());
+        return vIds;
+    }
+
+    static std::vector<umf::IdType> ids(const umf::MetadataSet& set)
+    {
+        std::vector<umf::IdType> vIds;
+        for(const auto& spItem : set)
+            vIds.push_back(spItem->getId());
+        return vIds;
+    }
+
+    static bool isEven(const std::shared_ptr<umf::Metadata>& spItem)
+    {
+        return spItem->getFieldValue("value").get_integer() % 2 == 0;
+    }
+
+    umf::MetadataStream stream;
+};
+
+TEST_F(TestMetadataView, MatchesQueries)
+{
+    EXPECT_EQ(ids(stream.getAll()), ids(stream.view()));
+    EXPECT_EQ(ids(stream.queryBySchema("first_schema")), ids(stream.viewBySchema("first_schema")));
+    EXPECT_EQ(ids(stream.queryBySchemaAndName("second_schema", "note")), ids(stream.viewBySchemaAndName("second_schema", "note")));
+    EXPECT_EQ(ids(stream.getAll().queryByName("item")), ids(stream.viewByName("item")));
+    EXPECT_EQ(ids(stream.getAll().queryByFrameIndex(50)), ids(stream.viewByFrameIndex(50)));
+    EXPECT_EQ(ids(stream.queryByTime(0, 10)), ids(stream.viewByTime(0, 10)));
+    EXPECT_EQ(100u, stream.view().count());
+    EXPECT_EQ(3u, stream.viewByFrameIndex(50).count());
+
+    EXPECT_TRUE(stream.viewBySchema("unknown").empty());
+    EXPECT_EQ(0u, stream.viewByName("unknown").count());
+    EXPECT_FALSE((bool)stream.viewByName("unknown").first());
+}
+
+TEST_F(TestMetadataView, Filters)
+{
+    umf::MetadataView even = stream.viewByName("item").where(isEven);
+    umf::MetadataSet evenItems = stream.getAll().query([](const std::shared_ptr<umf::Metadata>& spItem)
+    {
+        return spItem->getName() == "item" && isEven(spItem);
+    });
+    EXPECT_EQ(ids(evenItems), ids(even));
+    EXPECT_EQ(25u, even.count());
+
+    umf::MetadataView large = even.where([](const std::shared_ptr<umf::Metadata>& spItem)
+    {
+        return spItem->getFieldValue("value").get_integer() > 50;
+    });
+    EXPECT_EQ(54, large.first()->getFieldValue("value").get_integer());
+    EXPECT_EQ(12u, large.count());
+    EXPECT_EQ(25u, even.count());
+
+    umf::MetadataSet set = large.limit(5).materialize();
+    ASSERT_EQ(5u, set.size());
+    EXPECT_EQ(ids(set), ids(large.limit(5)));
+    EXPECT_EQ(2u, large.limit(5).limit(2).count());
+    EXPECT_EQ(12u, large.limit(100).count());
+    EXPECT_TRUE(large.limit(0).empty());
+    EXPECT_EQ(10u, stream.view().limit(10).count());
+
+    umf::MetadataSet notes = stream.queryByName("note");
+    umf::MetadataView eight = notes.view().where([](const std::shared_ptr<umf::Metadata>& spItem)
+    {
+        return spItem->getFieldValue("value").get_integer() == 8;
+    });
+    EXPECT_EQ(ids(notes.queryByNameAndValue("note", umf::FieldValue("value", umf::Variant((umf::umf_integer)8)))), ids(eight));
+}
+
+TEST_F(TestMetadataView, Iterator)
+{
+    umf::MetadataView view = stream.viewBySchema("second_schema").where(isEven);
+    auto it = view.begin();
+    ASSERT_NE(view.end(), it);
+    EXPECT_EQ(0, (*it)->getFieldValue("value").get_integer());
+    auto itPrev = it++;
+    EXPECT_EQ(0, itPrev->get()->getFieldValue("value").get_integer());
+    EXPECT_EQ(6, (*it)->getFieldValue("value").get_integer());
+    EXPECT_EQ(17, std::distance(view.begin(), view.end()));
+
+    // Items are borrowed from the stream, no extra owners appear
+    auto spFirst = stream.view().first();
+    long nOwners = spFirst.use_count();
+    for(const auto& spItem : stream.view())
+        (void)spItem;
+    EXPECT_EQ(nOwners, spFirst.use_count());
+}
@@ -0,0 +1,262 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "test_precomp.hpp"
+
+using umf::QueryExpr;
+
+class TestQueryExpr : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        std::vector<std::shared_ptr<umf::ReferenceDesc>> refs;
+        refs.emplace_back(std::make_shared<umf::ReferenceDesc>("owns"));
+
+        std::vector<umf::FieldDesc> personFields;
+        personFields.emplace_back(umf::FieldDesc("age", umf::Variant::type_integer, false, false, true));
+        personFields.emplace_back(umf::FieldDesc("height", umf::Variant::type_real, false, false, true));
+        std::vector<umf::FieldDesc> carFields;
+        carFields.emplace_back(umf::FieldDesc("speed", umf::Variant::type_integer, false, false, true));
+        carFields.emplace_back(umf::FieldDesc("model", umf::Variant::type_string));
+
+        auto spPeople = std::make_shared<umf::MetadataSchema>("people");
+        spPerson = std::make_shared<umf::MetadataDesc>("person", personFields, refs);
+        spCar = std::make_shared<umf::MetadataDesc>("car", carFields);
+        spPeople->add(spPerson);
+        spPeople->add(spCar);
+        stream.addSchema(spPeople);
+
+        // Same name in another schema, fields aren't indexed there
+        std::vector<umf::FieldDesc> otherFields;
+        otherFields.emplace_back(umf::FieldDesc("age", umf::Variant::type_integer));
+        auto spOther = std::make_shared<umf::MetadataSchema>("other");
+        spOtherPerson = std::make_shared<umf::MetadataDesc>("person", otherFields);
+        spOther->add(spOtherPerson);
+        stream.addSchema(spOther);
+
+        std::vector<std::shared_ptr<umf::Metadata>> cars;
+        for(umf::umf_integer i = 0; i < 50; i++)
+        {
+            auto spItem = std::make_shared<umf::Metadata>(spCar);
+            spItem->setFieldValue("speed", i * 3);
+            spItem->setFieldValue("model", "model_" + umf::to_string(i % 5));
+            stream.add(spItem);
+            cars.push_back(spItem);
+        }
+        for(umf::umf_integer i = 0; i < 200; i++)
+        {
+            auto spItem = std::make_shared<umf::Metadata>(spPerson);
+            spItem->setFieldValue("age", i % 80);
+            spItem->setFieldValue("height", 1.5 + (i % 50) / 100.0);
+            spItem->setTimestamp(i * 10, 5);
+            spItem->setFrameIndex(i, 2);
+            if(i % 4 == 0)
+                spItem->addReference(cars[i / 4], "owns");
+            if(i % 10 == 1)
+                spItem->addReference(cars[i / 10]);
+            stream.add(spItem);
+        }
+        for(umf::umf_integer i = 0; i < 20; i++)
+        {
+            auto spItem = std::make_shared<umf::Metadata>(spOtherPerson);
+            spItem->setFieldValue("age", i * 5);
+            stream.add(spItem);
+        }
+    }
+
+    static std::vector<umf::IdType> ids(const umf::MetadataView& view)
+    {
+        std::vector<umf::IdType> vIds;
+        for(const auto& spItem : view)
+            vIds.push_back(spItem->getId());
+        std::sort(vIds.begin(), vIds.end());
+        return vIds;
+    }
+
+    static std::vector<umf::IdType> ids(const umf::MetadataSet& set)
+    {
+        return ids(set.view());
+    }
+
+    static umf::umf_integer age(const std::shared_ptr<umf::Metadata>& spItem)
+    {
+        auto it = spItem->findField("age");
+        return it != spItem->end() ? it->get_integer() : -1;
+    }
+
+    static bool hasReference(const std::shared_ptr<umf::Metadata>& spItem, const std::string& sRefName)
+    {
+        for(const auto& ref : spItem->getAllReferences())
+            if(ref.getReferenceDescription()->name == sRefName)
+                return true;
+        return false;
+    }
+
+    umf::MetadataStream stream;
+    std::shared_ptr<umf::MetadataDesc> spPerson, spCar, spOtherPerson;
+};
+
+TEST_F(TestQueryExpr, SimpleConditions)
+{
+    umf::MetadataSet all = stream.getAll();
+    EXPECT_EQ(ids(all), ids(stream.select(QueryExpr::all())));
+    EXPECT_EQ(ids(stream.queryBySchema("other")), ids(stream.select(QueryExpr::schema("other"))));
+    EXPECT_EQ(ids(stream.queryByName("person")), ids(stream.select(QueryExpr::name("person"))));
+    EXPECT_EQ(ids(stream.queryByTime(100, 200)), ids(stream.select(QueryExpr::time(100, 200))));
+    EXPECT_EQ(ids(stream.queryByFrameIndex(30)), ids(stream.select(QueryExpr::frame(30))));
+    EXPECT_EQ(1u, stream.select(QueryExpr::id(all[10]->getId())).count());
+    EXPECT_EQ(0u, stream.select(QueryExpr::id(100000)).count());
+    EXPECT_EQ(ids(stream.queryByNameAndValue("person", umf::FieldValue("age", umf::Variant((umf::umf_integer)35)))),
+              ids(stream.select(QueryExpr::field("age", umf::Variant((umf::umf_integer)35)))));
+    EXPECT_EQ(ids(stream.queryByNameAndRange("person", "height", umf::Variant(1.6), umf::Variant(1.7))),
+              ids(stream.select(QueryExpr::fieldRange("height", umf::Variant(1.6), umf::Variant(1.7)))));
+
+    auto spCarItem = all[3];
+    EXPECT_EQ(ids(stream.queryReferrers(spCarItem->getId())), ids(stream.select(QueryExpr::referencesTo(spCarItem->getId()))));
+    EXPECT_EQ(ids(stream.queryReferrers(spCarItem->getId(), "owns")), ids(stream.select(QueryExpr::referencesTo(spCarItem->getId(), "owns"))));
+    EXPECT_EQ(50u, stream.select(QueryExpr::hasReference("owns")).count());
+    EXPECT_EQ(20u, stream.select(QueryExpr::hasReference("")).count());
+
+    auto spOwner = stream.select(QueryExpr::hasReference("owns")).first();
+    ASSERT_TRUE((bool)spOwner);
+    EXPECT_EQ(1u, stream.select(QueryExpr::referencedBy(spOwner->getId())).count());
+    EXPECT_EQ(0u, stream.select(QueryExpr::referencedBy(spOwner->getId(), "unknown")).count());
+}
+
+TEST_F(TestQueryExpr, Combinations)
+{
+    umf::MetadataSet all = stream.getAll();
+    const umf::IdType carId = all[7]->getId();
+
+    std::vector<std::pair<QueryExpr, QueryExpr::Filter>> cases =
+    {
+        {
+            QueryExpr::schema("people") && QueryExpr::name("person") && QueryExpr::time(300, 900) &&
+                QueryExpr::field("age", QueryExpr::Compare::Greater, umf::Variant((umf::umf_integer)40)),
+            [](const std::shared_ptr<umf::Metadata>& sp)
+            {
+                return sp->getSchemaName() == "people" && sp->getName() == "person" &&
+                       sp->getTime() <= 900 && sp->getTime() + 5 >= 300 && age(sp) > 40;
+            }
+        },
+        {
+            QueryExpr::name("person") && QueryExpr::field("age", QueryExpr::Compare::LessOrEqual, umf::Variant(10.5)),
+            [](const std::shared_ptr<umf::Metadata>& sp) { return sp->getName() == "person" && age(sp) >= 0 && age(sp) <= 10; }
+        },
+        {
+            QueryExpr::field("age", QueryExpr::Compare::NotEqual, umf::Variant((umf::umf_integer)0)) && QueryExpr::schema("other"),
+            [](const std::shared_ptr<umf::Metadata>& sp) { return sp->getSchemaName() == "other" && age(sp) > 0; }
+        },
+        {
+            QueryExpr::field("speed", QueryExpr::Compare::Less, umf::Variant((umf::umf_integer)30)) ||
+                QueryExpr::field("age", umf::Variant((umf::umf_integer)75)),
+            [](const std::shared_ptr<umf::Metadata>& sp)
+            {
+                auto it = sp->findField("speed");
+                return (it != sp->end() && it->get_integer() < 30) || age(sp) == 75;
+            }
+        },
+        {
+            QueryExpr::frames(10, 20) || QueryExpr::referencesTo(carId),
+            [&](const std::shared_ptr<umf::Metadata>& sp)
+            {
+                bool bRefers = false;
+                for(const auto& ref : sp->getAllReferences())
+                    bRefers = bRefers || ref.getReferenceMetadata().lock()->getId() == carId;
+                return (sp->getFrameIndex() >= 9 && sp->getFrameIndex() <= 20) || bRefers;
+            }
+        },
+        {
+            QueryExpr::name("person") && !QueryExpr::hasReference("owns") && !QueryExpr::schema("other"),
+            [](const std::shared_ptr<umf::Metadata>& sp)
+            {
+                return sp->getName() == "person" && sp->getSchemaName() == "people" && !hasReference(sp, "owns");
+            }
+        },
+        {
+            QueryExpr::name("car") && (QueryExpr::predicate([](const std::shared_ptr<umf::Metadata>& sp)
+            {
+                return sp->getFieldValue("model").get_string() == "model_2";
+            }) || QueryExpr::fieldRange("speed", umf::Variant((umf::umf_integer)100), umf::Variant(110.0))),
+            [](const std::shared_ptr<umf::Metadata>& sp)
+            {
+                if(sp->getName() != "car")
+                    return false;
+                umf::umf_integer speed = sp->getFieldValue("speed").get_integer();
+                return sp->getFieldValue("model").get_string() == "model_2" || (speed >= 100 && speed <= 110);
+            }
+        },
+        {
+            QueryExpr::name("car") && QueryExpr::name("person"),
+            [](const std::shared_ptr<umf::Metadata>&) { return false; }
+        },
+    };
+
+    for(const auto& c : cases)
+    {
+        umf::MetadataSet expected = all.query(c.second);
+        EXPECT_EQ(ids(expected), ids(stream.select(c.first))) << c.first.toString() << "\n" << stream.explain(c.first);
+        EXPECT_EQ(expected.size(), stream.select(c.first).count()) << c.first.toString();
+    }
+}
+
+TEST_F(TestQueryExpr, Explain)
+{
+    // The field index is more selective than the description bucket
+    QueryExpr expr = QueryExpr::schema("people") && QueryExpr::name("person") &&
+                     QueryExpr::field("age", umf::Variant((umf::umf_integer)7));
+    EXPECT_EQ("(schema = \"people\" AND name = \"person\" AND age = 7)", expr.toString());
+    EXPECT_EQ("access: field index age = 7 (3 candidates)\n"
+              "filter: age = 7 AND schema = \"people\" AND name = \"person\"", stream.explain(expr));
+
+    // The description bucket serves both schema and name
+    expr = QueryExpr::schema("people") && QueryExpr::name("car") &&
+           QueryExpr::field("speed", QueryExpr::Compare::Greater, umf::Variant((umf::umf_integer)0));
+    EXPECT_EQ("access: description bucket \"people\" \"car\" (50 candidates)\n"
+              "filter: speed > 0", stream.explain(expr));
+    EXPECT_EQ(49u, stream.select(expr).count());
+
+    // Not indexed field is checked on the items of its buckets
+    expr = QueryExpr::schema("other") && QueryExpr::field("age", umf::Variant((umf::umf_integer)5));
+    EXPECT_EQ("access: schema bucket \"other\" (20 candidates)\n"
+              "filter: age = 5", stream.explain(expr));
+
+    // Broad field lookup gives up once the time index is known to be cheaper
+    expr = QueryExpr::name("person") && QueryExpr::time(0, 30) &&
+           QueryExpr::field("age", QueryExpr::Compare::GreaterOrEqual, umf::Variant((umf::umf_integer)1));
+    EXPECT_EQ("access: time index time in [0, 30] (4 candidates)\n"
+              "filter: name = \"person\" AND age >= 1", stream.explain(expr));
+    EXPECT_EQ(3u, stream.select(expr).count());
+
+    expr = QueryExpr::time(0, 100) || QueryExpr::id(1);
+    EXPECT_EQ("access: union of time index time in [0, 100] + id 1 (12 candidates)\n"
+              "filter: none", stream.explain(expr));
+
+    expr = QueryExpr::frame(3) || !QueryExpr::name("car");
+    EXPECT_EQ("access: full scan (270 candidates)\n"
+              "filter: (frame in [3, 3] OR NOT name = \"car\")", stream.explain(expr));
+    EXPECT_EQ(220u, stream.select(expr).count());
+}
+
+TEST_F(TestQueryExpr, InvalidConditions)
+{
+    EXPECT_THROW(QueryExpr::field("model", QueryExpr::Compare::Less, umf::Variant("model_1")), umf::IncorrectParamException);
+    EXPECT_THROW(QueryExpr::fieldRange("speed", umf::Variant("a"), umf::Variant((umf::umf_integer)1)), umf::IncorrectParamException);
+    EXPECT_THROW(QueryExpr::field("", umf::Variant((umf::umf_integer)1)), umf::IncorrectParamException);
+    EXPECT_THROW(QueryExpr::predicate(QueryExpr::Filter()), umf::IncorrectParamException);
+    EXPECT_EQ("NOT name = \"car\"", (!!!QueryExpr::name("car")).toString());
+}
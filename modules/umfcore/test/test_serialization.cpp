@@ -609,6 +609,38 @@ TEST_P(TestSerialization, EncryptFieldDesc)
     compareMetadata(toBeEncrypted, encrypted);
 }
 
+TEST_P(TestSerialization, IndexedFieldDesc)
+{
+    SerializerType type         = std::get<0>(GetParam());
+    std::string    compressorId = std::get<1>(GetParam());
+    CryptAlgo      algo         = std::get<2>(GetParam());
+    initFormat(type, compressorId, algo);
+
+    std::shared_ptr< MetadataDesc > metadesc = stream.getSchema(n_schemaPeople)->findMetadataDesc("person");
+    metadesc->getFieldDesc("name").indexed = true;
+
+    MetadataSet people = stream.queryBySchema(n_schemaPeople);
+    ASSERT_EQ(people.size(), 1);
+    FieldValue name = *people[0]->findField("name");
+
+    std::string result = stream.serialize(*format);
+
+    MetadataStream testStream;
+    if(algo != CryptAlgo::NONE)
+    {
+        testStream.setEncryptor(encryptor);
+    }
+    testStream.deserialize(result, *format);
+
+    metadesc = testStream.getSchema(n_schemaPeople)->findMetadataDesc("person");
+    ASSERT_TRUE(metadesc->getFieldDesc("name").indexed);
+    ASSERT_FALSE(metadesc->getFieldDesc("address").indexed);
+
+    MetadataSet found = testStream.queryByNameAndValue("person", name);
+    ASSERT_EQ(found.size(), 1);
+    ASSERT_EQ(found[0]->getId(), people[0]->getId());
+}
+
 
 TEST_P(TestSerialization, EncryptMetaDesc)
 {
@@ -17,6 +17,7 @@
 #include "test_precomp.hpp"
 
 #include <fstream>
+#include <thread>
 
 #if defined(WIN32)
   const char delim = '\\';
@@ -95,6 +96,50 @@ TEST_F( TestStat, EmptyFields )
     EXPECT_THROW( value = (*stat)[ inexistingFieldName ], umf::NotFoundException );
 }
 
+TEST_F( TestStat, MoveWithQueuedRecords )
+{
+    std::vector< umf::FieldDesc > fieldDescs;
+    fieldDescs.emplace_back( "value", umf::Variant::type_integer );
+    auto spDesc = std::make_shared< umf::MetadataDesc >( "item", fieldDescs );
+    auto spSchema = std::make_shared< umf::MetadataSchema >( "schema" );
+    spSchema->add( spDesc );
+
+    std::vector< umf::StatField > fields;
+    fields.emplace_back( "sum", "schema", "item", "value", umf::StatOpFactory::builtinName( umf::StatOpFactory::BuiltinOp::Sum ));
+    auto queue = [&]( umf::Stat& target )
+    {
+        for( umf::umf_integer value : { 10, 20, 30 } )
+        {
+            auto spItem = std::make_shared< umf::Metadata >( spDesc );
+            spItem->setFieldValue( "value", value );
+            target.notify( spItem );
+        }
+    };
+
+    // the moved-from object must not handle its queued records into the moved fields
+    umf::Stat source( statName, fields, umf::Stat::UpdateMode::Manual );
+    queue( source );
+    source.update( true );
+    queue( source );
+    umf::Stat moved( std::move( source ));
+    EXPECT_NO_THROW( source.update( true ));
+    ASSERT_EQ( source.getState(), umf::Stat::State::UpToDate );
+    moved.update( true );
+    ASSERT_EQ( moved.getState(), umf::Stat::State::UpToDate );
+
+    umf::Stat assigned( statName, fields, umf::Stat::UpdateMode::Manual );
+    queue( moved );
+    moved.update( true );
+    queue( moved );
+    assigned = std::move( moved );
+    EXPECT_NO_THROW( moved.update( true ));
+    ASSERT_EQ( moved.getState(), umf::Stat::State::UpToDate );
+    // the handled values move along, the records still queued are dropped
+    queue( assigned );
+    assigned.update( true );
+    ASSERT_EQ( assigned[ "sum" ].get_integer(), 180 );
+}
+
 class TestStatFields : public ::testing::Test
 {
 protected:
@@ -403,6 +448,166 @@ TEST_F( TestStatOperations, BuiltinLast )
                  InputAny | OutputSame | ResetEmpty );
 }
 
+TEST_F( TestStatOperations, Unhandle )
+{
+    typedef umf::StatOpFactory::BuiltinOp BuiltinOp;
+    const umf::Variant val1( (umf::umf_integer)131 ), val2( (umf::umf_integer)-13 ), val3( (umf::umf_integer)75 );
+
+    // values left after removing val2, then val1
+    struct Case { BuiltinOp::Type type; umf::umf_real afterVal2, afterVal1; };
+    const Case cases[] =
+    {
+        { BuiltinOp::Min,     75,  75 },
+        { BuiltinOp::Max,     131, 75 },
+        { BuiltinOp::Average, 103, 75 },
+        { BuiltinOp::Count,   2,   1 },
+        { BuiltinOp::Sum,     206, 75 }
+    };
+    auto toReal = []( const umf::Variant& value )
+    {
+        return value.getType() == umf::Variant::type_real ? value.get_real() : (umf::umf_real)value.get_integer();
+    };
+
+    for( const auto& c : cases )
+    {
+        std::unique_ptr< umf::StatOpBase > op( umf::StatOpFactory::create( umf::StatOpFactory::builtinName( c.type )));
+        ASSERT_TRUE( op->isReversible() );
+
+        op->handle( val1 );
+        op->handle( val2 );
+        op->handle( val3 );
+
+        op->unhandle( val2 );
+        ASSERT_EQ( toReal( op->value() ), c.afterVal2 );
+        op->unhandle( val1 );
+        ASSERT_EQ( toReal( op->value() ), c.afterVal1 );
+        if( c.type != BuiltinOp::Count )
+        {
+            EXPECT_THROW( op->unhandle( umf::Variant( (umf::umf_real)75 )), umf::TypeCastException );
+        }
+        op->unhandle( val3 );
+        if( c.type == BuiltinOp::Count )
+            ASSERT_EQ( op->value().get_integer(), 0 );
+        else
+            ASSERT_EQ( op->value().getType(), umf::Variant::type_empty );
+    }
+
+    std::unique_ptr< umf::StatOpBase > last( umf::StatOpFactory::create( umf::StatOpFactory::builtinName( BuiltinOp::Last )));
+    ASSERT_FALSE( last->isReversible() );
+    EXPECT_THROW( last->unhandle( val1 ), umf::NotImplementedException );
+
+    std::unique_ptr< umf::StatOpBase > user( UserOp::createInstance() );
+    ASSERT_FALSE( user->isReversible() );
+}
+
+TEST_F( TestStatOperations, BuiltinVariance )
+{
+    testBuiltin( umf::StatOpFactory::builtinName( umf::StatOpFactory::BuiltinOp::Variance ),
+                 InputInt | InputReal | OutputReal | ResetEmpty );
+}
+
+TEST_F( TestStatOperations, BuiltinStdDev )
+{
+    testBuiltin( umf::StatOpFactory::builtinName( umf::StatOpFactory::BuiltinOp::StdDev ),
+                 InputInt | InputReal | OutputReal | ResetEmpty );
+}
+
+TEST_F( TestStatOperations, Analytics )
+{
+    typedef umf::StatOpFactory::BuiltinOp BuiltinOp;
+    auto create = []( BuiltinOp::Type type, const std::vector< umf::umf_real >& params )
+    {
+        return std::unique_ptr< umf::StatOpBase >( umf::StatOpFactory::create( umf::StatOpFactory::builtinName( type, params )));
+    };
+
+    std::unique_ptr< umf::StatOpBase > variance( create( BuiltinOp::Variance, {} ));
+    std::unique_ptr< umf::StatOpBase > stddev( create( BuiltinOp::StdDev, {} ));
+    std::unique_ptr< umf::StatOpBase > histogram( create( BuiltinOp::Histogram, { 0, 8, 4 } ));
+    std::unique_ptr< umf::StatOpBase > logHistogram( create( BuiltinOp::LogHistogram, { 1, 16, 4 } ));
+    std::unique_ptr< umf::StatOpBase > quantiles( create( BuiltinOp::Quantiles, { 0, 0.5, 1 } ));
+    for( umf::umf_integer x : { 2, 4, 4, 4, 5, 5, 7, 9 } )
+    {
+        const umf::Variant value( x );
+        variance->handle( value );
+        stddev->handle( value );
+        histogram->handle( value );
+        logHistogram->handle( value );
+        quantiles->handle( value );
+    }
+    ASSERT_DOUBLE_EQ( variance->value().get_real(), 4 );
+    ASSERT_DOUBLE_EQ( stddev->value().get_real(), 2 );
+    ASSERT_EQ( histogram->value().get_integer_vector(), std::vector< umf::umf_integer >({ 0, 0, 1, 5, 1, 1 }));
+    ASSERT_EQ( logHistogram->value().get_integer_vector(), std::vector< umf::umf_integer >({ 0, 0, 1, 6, 1, 0 }));
+    std::vector< umf::umf_real > q = quantiles->value().get_real_vector();
+    ASSERT_EQ( q.size(), 3u );
+    ASSERT_NEAR( q[0], 2, 2 * 0.004 );
+    ASSERT_NEAR( q[1], 4, 4 * 0.004 );
+    ASSERT_NEAR( q[2], 9, 9 * 0.004 );
+
+    // reversible ops get back to the state without the removed value
+    variance->unhandle( umf::Variant( (umf::umf_integer)9 ));
+    histogram->unhandle( umf::Variant( (umf::umf_integer)9 ));
+    quantiles->unhandle( umf::Variant( (umf::umf_integer)9 ));
+    ASSERT_NEAR( variance->value().get_real(), 96.0 / 49, 1e-9 );
+    ASSERT_EQ( histogram->value().get_integer_vector(), std::vector< umf::umf_integer >({ 0, 0, 1, 5, 1, 0 }));
+    ASSERT_NEAR( quantiles->value().get_real_vector()[2], 7, 7 * 0.004 );
+
+    // quantiles of a wide range keep the relative error
+    quantiles->reset();
+    for( int i = 1; i <= 10000; i++ )
+        quantiles->handle( umf::Variant( (umf::umf_real)i * 1e-3 ));
+    q = quantiles->value().get_real_vector();
+    ASSERT_NEAR( q[0], 1e-3, 1e-3 * 0.004 );
+    ASSERT_NEAR( q[1], 5, 5 * 0.004 );
+    ASSERT_NEAR( q[2], 10, 10 * 0.004 );
+
+    std::unique_ptr< umf::StatOpBase > distinct( create( BuiltinOp::DistinctCount, {} ));
+    ASSERT_FALSE( distinct->isReversible() );
+    ASSERT_EQ( distinct->value().get_integer(), 0 );
+    for( int i = 0; i < 100000; i++ )
+    {
+        distinct->handle( umf::Variant( (umf::umf_integer)(i % 20000) ));
+        distinct->handle( umf::Variant( "name" + umf::to_string( (long long)(i % 5000) )));
+    }
+    ASSERT_NEAR( (double)distinct->value().get_integer(), 25000, 25000 * 0.05 );
+    distinct->reset();
+    distinct->handle( umf::Variant( (umf::umf_real)0.0 ));
+    distinct->handle( umf::Variant( (umf::umf_real)-0.0 ));
+    ASSERT_EQ( distinct->value().get_integer(), 1 );
+}
+
+TEST_F( TestStatOperations, BuiltinParams )
+{
+    typedef umf::StatOpFactory::BuiltinOp BuiltinOp;
+    const std::string histogramName = umf::StatOpFactory::builtinName( BuiltinOp::Histogram );
+
+    ASSERT_EQ( umf::StatOpFactory::builtinName( BuiltinOp::Histogram, {} ), histogramName );
+    ASSERT_EQ( umf::StatOpFactory::builtinName( BuiltinOp::Histogram, { -1.5, 2, 7 } ), histogramName + "(-1.5,2,7)" );
+
+    // the name keeps the parameters, so that copies and saved statistics get the same operation
+    const BuiltinOp::Type types[] = { BuiltinOp::Histogram, BuiltinOp::LogHistogram, BuiltinOp::Quantiles, BuiltinOp::DistinctCount };
+    const std::vector< umf::umf_real > params[] = { { -1.5, 2, 7 }, { 0.25, 1e6, 30 }, { 0.1, 0.999 }, { 16 } };
+    for( size_t i = 0; i < sizeof( types ) / sizeof( types[0] ); i++ )
+    {
+        const std::string name = umf::StatOpFactory::builtinName( types[i], params[i] );
+        std::unique_ptr< umf::StatOpBase > op( umf::StatOpFactory::create( name ));
+        ASSERT_EQ( op->name(), name );
+        std::unique_ptr< umf::StatOpBase > defaultOp( umf::StatOpFactory::create( umf::StatOpFactory::builtinName( types[i] )));
+        ASSERT_EQ( defaultOp->name(), umf::StatOpFactory::builtinName( types[i] ));
+    }
+    std::unique_ptr< umf::StatOpBase > spaced( umf::StatOpFactory::create( histogramName + "( 0 , 10, 5 )" ));
+    ASSERT_EQ( spaced->name(), histogramName + "(0,10,5)" );
+
+    EXPECT_THROW( umf::StatOpFactory::create( histogramName + "(0,10)" ), umf::IncorrectParamException );
+    EXPECT_THROW( umf::StatOpFactory::create( histogramName + "(10,0,5)" ), umf::IncorrectParamException );
+    EXPECT_THROW( umf::StatOpFactory::create( histogramName + "(0,10,2.5)" ), umf::IncorrectParamException );
+    EXPECT_THROW( umf::StatOpFactory::create( histogramName + "(0,10;5)" ), umf::IncorrectParamException );
+    EXPECT_THROW( umf::StatOpFactory::create( umf::StatOpFactory::builtinName( BuiltinOp::LogHistogram, { 0, 10, 5 } )), umf::IncorrectParamException );
+    EXPECT_THROW( umf::StatOpFactory::create( umf::StatOpFactory::builtinName( BuiltinOp::Quantiles, { 0.5, 1.5 } )), umf::IncorrectParamException );
+    EXPECT_THROW( umf::StatOpFactory::create( umf::StatOpFactory::builtinName( BuiltinOp::DistinctCount, { 20 } )), umf::IncorrectParamException );
+    EXPECT_THROW( umf::StatOpFactory::create( umf::StatOpFactory::builtinName( BuiltinOp::Sum, { 1 } )), umf::NotFoundException );
+}
+
 TEST_F( TestStatOperations, StatOpFactory )
 {
     testStatOpFactory();
@@ -430,6 +635,7 @@ protected:
         scPersonAgeMax        = "PersonAgeMax";
         scPersonGrowthAverage = "PersonGrowthAverage";
         scPersonSalarySum     = "PersonSalarySum";
+        scPersonSalaryHistogram = "PersonSalaryHistogram";
     }
 
     std::string getWorkingPath() const
@@ -489,6 +695,7 @@ protected:
         fields.emplace_back( scPersonAgeMax, mcSchemaName, mcDescName, mcAgeName, umf::StatOpFactory::builtinName( umf::StatOpFactory::BuiltinOp::Max ));
         fields.emplace_back( scPersonGrowthAverage, mcSchemaName, mcDescName, mcGrowthName, umf::StatOpFactory::builtinName( umf::StatOpFactory::BuiltinOp::Average ));
         fields.emplace_back( scPersonSalarySum, mcSchemaName, mcDescName, mcSalaryName, umf::StatOpFactory::builtinName( umf::StatOpFactory::BuiltinOp::Sum ));
+        fields.emplace_back( scPersonSalaryHistogram, mcSchemaName, mcDescName, mcSalaryName, umf::StatOpFactory::builtinName( umf::StatOpFactory::BuiltinOp::Histogram, { 0, 10000, 4 } ));
         stream.addStat( std::make_shared<umf::Stat>( scStatName, fields, umf::Stat::UpdateMode::Disabled ));
     }
 
@@ -500,6 +707,7 @@ protected:
         stAgeMax = 0;
         stGrowthAverage = 0.0; stGrowthAverageSum = 0; stGrowthAverageCount = 0;
         stSalarySum = 0;
+        stSalaryHistogram.assign( 6, 0 );
         stFirstTimeOnce = true;
     }
 
@@ -540,6 +748,7 @@ protected:
         if( doStatistics )
         {
             stSalarySum += salary;
+            ++stSalaryHistogram[ salary < 0 ? 0 : salary >= 10000 ? 5 : salary / 2500 + 1 ];
         }
 
         stream.add( metadata );
@@ -572,6 +781,7 @@ protected:
         umf::Variant ageMax        = stat[scPersonAgeMax];
         umf::Variant growthAverage = stat[scPersonGrowthAverage];
         umf::Variant salarySum     = stat[scPersonSalarySum];
+        umf::Variant salaryHistogram = stat[scPersonSalaryHistogram];
 
         if( updateMode != umf::Stat::UpdateMode::Disabled )
         {
@@ -581,6 +791,7 @@ protected:
             ASSERT_EQ( ageMax.getType(), umf::Variant::type_integer );
             ASSERT_EQ( growthAverage.getType(), umf::Variant::type_real );
             ASSERT_EQ( salarySum.getType(), umf::Variant::type_integer );
+            ASSERT_EQ( salaryHistogram.getType(), umf::Variant::type_integer_vector );
 
             if( doCompareValues )
             {
@@ -590,6 +801,7 @@ protected:
                 ASSERT_EQ( ageMax.get_integer(), stAgeMax );
                 ASSERT_EQ( growthAverage.get_real(), stGrowthAverage );
                 ASSERT_EQ( salarySum.get_integer(), stSalarySum );
+                ASSERT_EQ( salaryHistogram.get_integer_vector(), stSalaryHistogram );
             }
         }
     }
@@ -615,6 +827,7 @@ protected:
     std::string scPersonAgeMax;
     std::string scPersonGrowthAverage;
     std::string scPersonSalarySum;
+    std::string scPersonSalaryHistogram;
 
     umf::umf_integer stNameCount;
     umf::umf_string stNameLast;
@@ -622,6 +835,7 @@ protected:
     umf::umf_integer stAgeMax;
     umf::umf_real stGrowthAverage; umf::umf_integer stGrowthAverageSum,stGrowthAverageCount;
     umf::umf_integer stSalarySum;
+    std::vector< umf::umf_integer > stSalaryHistogram;
     bool stFirstTimeOnce;
 };
 
@@ -652,6 +866,204 @@ TEST_P( TestStatistics, Gathering )
     stream.close();
 }
 
+TEST_P( TestStatistics, StatBeforeSchema )
+{
+    umf::Stat::UpdateMode::Type updateMode = GetParam();
+    const bool doCompareValues = true;
+
+    umf::MetadataStream stream;
+
+    // the fields are resolved on the first metadata of the description instead of in addStat()
+    configureStatistics( stream );
+    configureSchema( stream );
+
+    std::shared_ptr<umf::Stat> stat = stream.getStat(scStatName);
+    stat->setUpdateMode( updateMode );
+    putMetadata( stream, doCompareValues );
+    stat->update( true );
+
+    checkStatistics( *stat, updateMode, doCompareValues );
+}
+
+TEST_P( TestStatistics, ManyStatObjects )
+{
+    umf::Stat::UpdateMode::Type updateMode = GetParam();
+    const bool doCompareValues = true;
+    const size_t statCount = 32;
+
+    umf::MetadataStream stream;
+
+    configureSchema( stream );
+    configureStatistics( stream );
+
+    std::shared_ptr<umf::Stat> stat = stream.getStat(scStatName);
+    stat->setUpdateMode( updateMode );
+    std::vector< umf::StatField > fields;
+    for( const auto& name : stat->getAllFieldNames() )
+        fields.push_back( stat->getField( name ));
+    for( size_t i = 1; i < statCount; i++ )
+        stream.addStat( std::make_shared<umf::Stat>( scStatName + umf::to_string( (long long)i ), fields, updateMode ));
+
+    {
+        // a copy destroyed with its updates still pending must not affect the others
+        umf::Stat copy( *stat );
+        putMetadata( stream, doCompareValues );
+        for( const auto& metadata : stream.getAll() )
+            copy.notify( metadata );
+    }
+
+    for( const auto& name : stream.getAllStatNames() )
+    {
+        std::shared_ptr<umf::Stat> other = stream.getStat( name );
+        other->update( true );
+        ASSERT_EQ( other->getState(), umf::Stat::State::UpToDate );
+        checkStatistics( *other, updateMode, doCompareValues );
+    }
+
+    stream.close();
+}
+
+TEST_P( TestStatistics, ConcurrentNotify )
+{
+    umf::Stat::UpdateMode::Type updateMode = GetParam();
+    const size_t threadCount = 4;
+    const size_t itemCount = 5000; // overflows the pending queue of the statistics object
+
+    umf::MetadataStream stream;
+
+    configureSchema( stream );
+    configureStatistics( stream );
+
+    std::shared_ptr<umf::Stat> stat = stream.getStat(scStatName);
+    stat->setUpdateMode( updateMode );
+
+    auto metadata = std::make_shared<umf::Metadata>( scMetadataDesc );
+    metadata->setFieldValue( mcPersonName, "Peter" );
+
+    std::vector< std::thread > threads;
+    for( size_t t = 0; t < threadCount; t++ )
+        threads.emplace_back( [&]()
+        {
+            for( size_t i = 0; i < itemCount; i++ )
+                stat->notify( metadata );
+        });
+    for( auto& thread : threads )
+        thread.join();
+    stat->update( true );
+
+    if( updateMode != umf::Stat::UpdateMode::Disabled )
+    {
+        ASSERT_EQ( (*stat)[scPersonNameCount].get_integer(), (umf::umf_integer)(threadCount * itemCount) );
+        ASSERT_EQ( stat->getState(), umf::Stat::State::UpToDate );
+    }
+}
+
+TEST_P( TestStatistics, RemoveWithoutRescan )
+{
+    umf::Stat::UpdateMode::Type updateMode = GetParam();
+
+    umf::MetadataStream stream;
+
+    configureSchema( stream );
+
+    std::vector< umf::StatField > fields;
+    fields.emplace_back( scPersonNameCount, mcSchemaName, mcDescName, mcPersonName, umf::StatOpFactory::builtinName( umf::StatOpFactory::BuiltinOp::Count ));
+    fields.emplace_back( scPersonAgeMin, mcSchemaName, mcDescName, mcAgeName, umf::StatOpFactory::builtinName( umf::StatOpFactory::BuiltinOp::Min ));
+    fields.emplace_back( scPersonAgeMax, mcSchemaName, mcDescName, mcAgeName, umf::StatOpFactory::builtinName( umf::StatOpFactory::BuiltinOp::Max ));
+    fields.emplace_back( scPersonGrowthAverage, mcSchemaName, mcDescName, mcGrowthName, umf::StatOpFactory::builtinName( umf::StatOpFactory::BuiltinOp::Average ));
+    fields.emplace_back( scPersonSalarySum, mcSchemaName, mcDescName, mcSalaryName, umf::StatOpFactory::builtinName( umf::StatOpFactory::BuiltinOp::Sum ));
+    stream.addStat( std::make_shared<umf::Stat>( scStatName, fields, updateMode ));
+
+    // Last can't take a value back, so this one needs a rescan
+    const std::string rescanStatName = scStatName + "Rescan";
+    fields.emplace_back( scPersonNameLast, mcSchemaName, mcDescName, mcPersonName, umf::StatOpFactory::builtinName( umf::StatOpFactory::BuiltinOp::Last ));
+    stream.addStat( std::make_shared<umf::Stat>( rescanStatName, fields, updateMode ));
+
+    putMetadata( stream, false );
+
+    // Peter and Jessica go, Matthias and John stay
+    umf::MetadataSet all = stream.getAll();
+    ASSERT_EQ( all.size(), 4u );
+    ASSERT_TRUE( stream.remove( all[0]->getId() ));
+    umf::MetadataSet removed;
+    removed.push_back( all[1] );
+    stream.remove( removed );
+
+    std::shared_ptr<umf::Stat> stat = stream.getStat( scStatName );
+    std::shared_ptr<umf::Stat> rescanStat = stream.getStat( rescanStatName );
+    stat->update( true );
+
+    if( updateMode != umf::Stat::UpdateMode::Disabled )
+    {
+        ASSERT_EQ( stat->getState(), umf::Stat::State::UpToDate );
+        ASSERT_EQ( (*stat)[scPersonNameCount].get_integer(), 2 );
+        ASSERT_EQ( (*stat)[scPersonAgeMin].get_integer(), 29 );
+        ASSERT_EQ( (*stat)[scPersonAgeMax].get_integer(), 41 );
+        ASSERT_EQ( (*stat)[scPersonGrowthAverage].get_real(), 186.0 );
+        ASSERT_EQ( (*stat)[scPersonSalarySum].get_integer(), 12500 );
+
+        ASSERT_EQ( rescanStat->getState(), umf::Stat::State::NeedRescan );
+        EXPECT_THROW( rescanStat->update( true ), umf::IncorrectParamException );
+
+        stream.recalcStat();
+        rescanStat->update( true );
+        stat->update( true );
+        ASSERT_EQ( rescanStat->getState(), umf::Stat::State::UpToDate );
+        ASSERT_EQ( (*rescanStat)[scPersonNameCount].get_integer(), 2 );
+        ASSERT_EQ( (*stat)[scPersonNameCount].get_integer(), 2 );
+    }
+}
+
+TEST_P( TestStatistics, ChangeThenRemove )
+{
+    umf::Stat::UpdateMode::Type updateMode = GetParam();
+    typedef umf::StatOpFactory::BuiltinOp BuiltinOp;
+
+    // a reversible operation would take back the new value of the changed field instead of the handled one
+    const BuiltinOp::Type types[] = { BuiltinOp::Min, BuiltinOp::Max, BuiltinOp::Average, BuiltinOp::Count, BuiltinOp::Sum,
+                                      BuiltinOp::Variance, BuiltinOp::StdDev, BuiltinOp::Histogram, BuiltinOp::LogHistogram, BuiltinOp::Quantiles };
+    for( BuiltinOp::Type type : types )
+    {
+        std::vector< umf::umf_real > params;
+        if( type == BuiltinOp::Histogram )
+            params = { 0, 200, 4 };
+        else if( type == BuiltinOp::LogHistogram )
+            params = { 1, 256, 4 };
+        std::vector< umf::StatField > fields;
+        fields.emplace_back( scPersonSalarySum, mcSchemaName, mcDescName, mcSalaryName, umf::StatOpFactory::builtinName( type, params ));
+
+        umf::MetadataStream stream;
+        configureSchema( stream );
+        stream.addStat( std::make_shared<umf::Stat>( scStatName, fields, updateMode ));
+        for( umf::umf_integer salary : { 10, 20, 30 } )
+            addMetadata( stream, "Peter", 30, 180, salary, false );
+        std::shared_ptr<umf::Stat> stat = stream.getStat( scStatName );
+        stat->update( true );
+
+        umf::MetadataSet all = stream.getAll();
+        all[0]->setFieldValue( mcSalaryName, (umf::umf_integer)100 );
+        ASSERT_TRUE( stream.remove( all[0]->getId() ));
+        if( updateMode == umf::Stat::UpdateMode::Disabled )
+            continue;
+
+        ASSERT_EQ( stat->getState(), umf::Stat::State::NeedRescan ) << fields[0].getOpName();
+        EXPECT_THROW( stat->update( true ), umf::IncorrectParamException );
+        stream.recalcStat();
+        stat->update( true );
+
+        umf::MetadataStream expected;
+        configureSchema( expected );
+        expected.addStat( std::make_shared<umf::Stat>( scStatName, fields, updateMode ));
+        for( umf::umf_integer salary : { 20, 30 } )
+            addMetadata( expected, "Peter", 30, 180, salary, false );
+        std::shared_ptr<umf::Stat> expectedStat = expected.getStat( scStatName );
+        expectedStat->update( true );
+
+        ASSERT_EQ( stat->getState(), umf::Stat::State::UpToDate );
+        ASSERT_EQ( (*stat)[scPersonSalarySum].toString(), (*expectedStat)[scPersonSalarySum].toString() ) << fields[0].getOpName();
+    }
+}
+
 TEST_P( TestStatistics, SaveLoad )
 {
     umf::Stat::UpdateMode::Type updateMode = GetParam();
@@ -0,0 +1,282 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "test_precomp.hpp"
+
+class TestStreamBatch : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        spSchema = std::make_shared<umf::MetadataSchema>("test_schema");
+        std::vector<umf::FieldDesc> fields;
+        fields.emplace_back(umf::FieldDesc("value", umf::Variant::type_integer));
+        fields.emplace_back(umf::FieldDesc("label", umf::Variant::type_string, true));
+        std::vector<std::shared_ptr<umf::ReferenceDesc>> refs;
+        refs.emplace_back(std::make_shared<umf::ReferenceDesc>("next"));
+        spDesc = std::make_shared<umf::MetadataDesc>("item", fields, refs);
+        spSchema->add(spDesc);
+        stream.addSchema(spSchema);
+    }
+
+    static umf::MetadataInternal makeItem(umf::umf_integer value, umf::IdType id = umf::INVALID_ID)
+    {
+        umf::MetadataInternal mdi("item", "test_schema");
+        mdi.id = id;
+        mdi.fields["value"].value = umf::to_string(value);
+        mdi.frameIndex = value;
+        mdi.frameNum = 1;
+        return mdi;
+    }
+
+    umf::MetadataStream stream;
+    std::shared_ptr<umf::MetadataSchema> spSchema;
+    std::shared_ptr<umf::MetadataDesc> spDesc;
+};
+
+TEST_F(TestStreamBatch, AddInternal)
+{
+    std::vector<umf::MetadataInternal> items;
+    for(umf::umf_integer i = 0; i < 10; i++)
+    {
+        items.push_back(makeItem(i, 100 + i));
+        // Every item refers to the following one, the last one to the first
+        items.back().refs.emplace_back(100 + (i + 1) % 10, "next");
+        if(i > 0)
+            items.back().refs.emplace_back(100 + i - 1, "");
+    }
+    items[3].fields["label"].value = "three";
+
+    std::vector<umf::IdType> ids = stream.addBatch(std::move(items));
+    ASSERT_EQ(10u, ids.size());
+    EXPECT_EQ(100, ids.front());
+    EXPECT_EQ(109, ids.back());
+
+    for(umf::IdType id = 100; id < 110; id++)
+    {
+        auto spItem = stream.getById(id);
+        ASSERT_TRUE((bool)spItem);
+        EXPECT_EQ(id - 100, spItem->getFieldValue("value").get_integer());
+        EXPECT_EQ(id - 100, spItem->getFrameIndex());
+        EXPECT_TRUE(spItem->isReference(100 + (id - 99) % 10, "next"));
+        EXPECT_EQ(id > 100, spItem->isReference(id - 1));
+    }
+    EXPECT_EQ("three", stream.getById(103)->getFieldValue("label").get_string());
+    EXPECT_EQ(1u, stream.queryByFrameIndex(4).size());
+
+    // Auto ids continue after the largest loaded one, references to later items are resolved when they come
+    std::vector<umf::MetadataInternal> more;
+    more.push_back(makeItem(10));
+    more.back().refs.emplace_back(200, "next");
+    ids = stream.addBatch(std::move(more));
+    EXPECT_EQ(110, ids[0]);
+    EXPECT_EQ(0u, stream.getById(110)->getAllReferences().size());
+
+    umf::MetadataInternal last = makeItem(11, 200);
+    stream.add(last);
+    EXPECT_TRUE(stream.getById(110)->isReference(200, "next"));
+}
+
+TEST_F(TestStreamBatch, RemovedReferrerIsNotPending)
+{
+    umf::MetadataInternal referrer = makeItem(1, 1);
+    referrer.refs.emplace_back(100, "next");
+    stream.add(referrer);
+    umf::MetadataInternal kept = makeItem(2, 2);
+    kept.refs.emplace_back(100, "next");
+    stream.add(kept);
+    ASSERT_TRUE(stream.remove(1));
+
+    std::vector<umf::MetadataInternal> items;
+    items.push_back(makeItem(100, 100));
+    ASSERT_NO_THROW(stream.addBatch(std::move(items)));
+    EXPECT_TRUE(stream.getById(2)->isReference(100, "next"));
+
+    referrer.refs.back().first = 101;
+    stream.add(referrer);
+    ASSERT_TRUE(stream.remove(1));
+    ASSERT_NO_THROW(stream.add(makeItem(101, 101)));
+    EXPECT_EQ(3u, stream.getAll().size());
+}
+
+TEST_F(TestStreamBatch, AddMovesValues)
+{
+    umf::MetadataInternal kept = makeItem(1);
+    kept.fields["label"].value = std::string(1000, 'k');
+    umf::IdType id = stream.add(kept);
+    EXPECT_EQ(1000u, kept.fields["label"].value.size());
+    EXPECT_EQ(kept.fields["label"].value, stream.getById(id)->getFieldValue("label").get_string());
+
+    umf::MetadataInternal consumed = makeItem(2);
+    consumed.fields["label"].value = std::string(1000, 'c');
+    const char* pLabel = consumed.fields["label"].value.data();
+    id = stream.add(std::move(consumed));
+    EXPECT_EQ(pLabel, stream.getById(id)->get<umf::umf_string>("label").data());
+    EXPECT_EQ(2, stream.getById(id)->get<umf::umf_integer>("value"));
+
+    std::vector<umf::MetadataInternal> items;
+    items.push_back(makeItem(3));
+    items.back().fields["label"].value = std::string(1000, 'b');
+    pLabel = items.back().fields["label"].value.data();
+    id = stream.addBatch(std::move(items)).front();
+    EXPECT_EQ(pLabel, stream.getById(id)->get<umf::umf_string>("label").data());
+
+    umf::MetadataInternal unknown = makeItem(4);
+    unknown.fields["no_such_field"].value = "value";
+    EXPECT_THROW(stream.add(std::move(unknown)), umf::IncorrectParamException);
+}
+
+TEST_F(TestStreamBatch, FailedBatchLeavesStream)
+{
+    umf::MetadataInternal first = makeItem(0);
+    stream.add(first);
+
+    std::vector<umf::MetadataInternal> items;
+    items.push_back(makeItem(1));
+    items.push_back(makeItem(2, 0));
+    EXPECT_THROW(stream.addBatch(std::move(items)), umf::IncorrectParamException);
+
+    items.clear();
+    items.push_back(makeItem(1, 5));
+    items.push_back(makeItem(2, 5));
+    EXPECT_THROW(stream.addBatch(std::move(items)), umf::IncorrectParamException);
+
+    items.clear();
+    items.push_back(makeItem(1));
+    items.push_back(makeItem(2));
+    items.back().fields.erase("value");
+    EXPECT_THROW(stream.addBatch(std::move(items), 2), umf::ValidateException);
+
+    items.clear();
+    items.push_back(makeItem(1));
+    items.back().schemaName = "unknown";
+    EXPECT_THROW(stream.addBatch(std::move(items)), umf::NotFoundException);
+
+    EXPECT_EQ(1u, stream.getAll().size());
+    umf::MetadataInternal next = makeItem(1);
+    EXPECT_EQ(1, stream.add(next));
+}
+
+TEST_F(TestStreamBatch, AddSet)
+{
+    auto spFirst = std::make_shared<umf::Metadata>(spDesc);
+    spFirst->setFieldValue("value", (umf::umf_integer)-1);
+    stream.add(spFirst);
+
+    std::vector<umf::StatField> statFields;
+    statFields.emplace_back("sum", "test_schema", "item", "value", umf::StatOpFactory::builtinName(umf::StatOpFactory::BuiltinOp::Sum));
+    auto spStat = std::make_shared<umf::Stat>("stat", statFields, umf::Stat::UpdateMode::Manual);
+    stream.addStat(spStat);
+
+    umf::MetadataSet batch;
+    umf::umf_integer sum = 0;
+    for(umf::umf_integer i = 0; i < 1000; i++)
+    {
+        auto spItem = std::make_shared<umf::Metadata>(spDesc);
+        spItem->setFieldValue("value", i);
+        spItem->addReference(spFirst);
+        batch.push_back(spItem);
+        sum += i;
+    }
+    umf::MetadataSet added = batch;
+    stream.addBatch(std::move(batch), 4);
+
+    ASSERT_EQ(1001u, stream.getAll().size());
+    for(size_t i = 0; i < added.size(); i++)
+        EXPECT_EQ((umf::IdType)i + 1, added[i]->getId());
+    EXPECT_EQ(1000u, stream.queryReferrers(spFirst->getId()).size());
+
+    spStat->update(true);
+    EXPECT_EQ(sum, (*spStat)["sum"].get_integer());
+
+    umf::MetadataSet invalid;
+    invalid.push_back(std::make_shared<umf::Metadata>(spDesc));
+    EXPECT_THROW(stream.addBatch(std::move(invalid), 0), umf::ValidateException);
+    EXPECT_EQ(1001u, stream.getAll().size());
+}
+
+TEST_F(TestStreamBatch, RemoveSet)
+{
+    std::vector<umf::MetadataInternal> items;
+    for(umf::umf_integer i = 0; i < 100; i++)
+    {
+        items.push_back(makeItem(i));
+        if(i > 0)
+            items.back().refs.emplace_back(i - 1, "next");
+    }
+    stream.addBatch(std::move(items));
+
+    umf::MetadataSet victims;
+    for(umf::IdType id = 0; id < 100; id += 3)
+        victims.push_back(stream.getById(id));
+    // Duplicates and items out of the stream are ignored
+    victims.push_back(stream.getById(0));
+    auto spForeign = std::make_shared<umf::Metadata>(spDesc);
+    victims.push_back(spForeign);
+
+    stream.remove(victims);
+
+    umf::MetadataSet all = stream.getAll();
+    ASSERT_EQ(66u, all.size());
+    for(auto& spItem : all)
+    {
+        EXPECT_NE(0, spItem->getId() % 3);
+        umf::IdType prev = spItem->getId() - 1;
+        EXPECT_EQ(prev % 3 != 0, spItem->isReference(prev, "next")) << spItem->getId();
+    }
+    for(umf::IdType id = 0; id < 100; id += 3)
+    {
+        EXPECT_FALSE((bool)stream.getById(id));
+        EXPECT_EQ(0u, stream.queryReferrers(id).size());
+        EXPECT_EQ(0u, stream.queryByFrameIndex((size_t)id).size());
+    }
+    EXPECT_EQ(66u, stream.queryByName("item").size());
+
+    stream.remove();
+    EXPECT_EQ(0u, stream.getAll().size());
+    EXPECT_EQ(0u, stream.queryBySchema("test_schema").size());
+}
+
+TEST_F(TestStreamBatch, TrustedSkipsValidation)
+{
+    ASSERT_FALSE(stream.isTrusted());
+    std::vector<umf::MetadataInternal> items;
+    items.push_back(makeItem(1));
+    items.back().fields.erase("value");
+    EXPECT_THROW(stream.addBatch(std::move(items)), umf::ValidateException);
+
+    stream.setTrusted(true);
+    items.clear();
+    for(umf::umf_integer i = 0; i < 10; i++)
+        items.push_back(makeItem(i));
+    items.back().fields.erase("value");
+    EXPECT_EQ(10u, stream.addBatch(std::move(items)).size());
+
+    // Unknown schemas and fields are still rejected
+    umf::MetadataInternal unknown = makeItem(4);
+    unknown.fields["no_such_field"].value = "value";
+    EXPECT_THROW(stream.add(std::move(unknown)), umf::IncorrectParamException);
+    items.clear();
+    items.push_back(makeItem(1));
+    items.back().schemaName = "unknown";
+    EXPECT_THROW(stream.addBatch(std::move(items)), umf::NotFoundException);
+
+    stream.setTrusted(false);
+    umf::MetadataInternal invalid = makeItem(1);
+    invalid.fields.erase("value");
+    EXPECT_THROW(stream.add(invalid), umf::ValidateException);
+    EXPECT_EQ(10u, stream.getAll().size());
+}
@@ -0,0 +1,140 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "test_precomp.hpp"
+
+#include <atomic>
+#include <thread>
+
+class TestStreamConcurrent : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        auto spSchema = std::make_shared<umf::MetadataSchema>("concurrent_schema");
+        std::vector<umf::FieldDesc> fields;
+        fields.emplace_back(umf::FieldDesc("value", umf::Variant::type_integer, false, false, true));
+        spDesc = std::make_shared<umf::MetadataDesc>("item", fields);
+        spSchema->add(spDesc);
+        stream.addSchema(spSchema);
+        stream.setConcurrent(true);
+    }
+
+    std::shared_ptr<umf::Metadata> makeItem(umf::umf_integer value)
+    {
+        auto spItem = std::make_shared<umf::Metadata>(spDesc);
+        spItem->setFieldValue("value", value);
+        spItem->setTimestamp(value * 10, 10);
+        spItem->setFrameIndex(value, 1);
+        return spItem;
+    }
+
+    umf::MetadataStream stream;
+    std::shared_ptr<umf::MetadataDesc> spDesc;
+};
+
+TEST_F(TestStreamConcurrent, Mode)
+{
+    umf::MetadataStream plain;
+    EXPECT_FALSE(plain.isConcurrent());
+    EXPECT_TRUE(stream.isConcurrent());
+    stream.setConcurrent(false);
+    EXPECT_FALSE(stream.isConcurrent());
+    stream.setConcurrent(true);
+    EXPECT_TRUE(stream.isConcurrent());
+}
+
+TEST_F(TestStreamConcurrent, ReadLock)
+{
+    stream.add(makeItem(1));
+    {
+        umf::MetadataStream::ReadLock lock(stream);
+        // Reading functions may be called recursively under the lock
+        EXPECT_EQ(1u, stream.queryByName("item").size());
+        EXPECT_EQ(1u, stream.view().count());
+        EXPECT_THROW(stream.add(makeItem(2)), umf::InternalErrorException);
+    }
+    stream.add(makeItem(2));
+    EXPECT_EQ(2u, stream.getAll().size());
+}
+
+TEST_F(TestStreamConcurrent, ReadersDuringIngest)
+{
+    const umf::umf_integer nItems = 2000;
+    std::atomic<bool> bDone(false);
+    std::atomic<int> nErrors(0);
+
+    std::thread writer([&]()
+    {
+        for(umf::umf_integer i = 0; i < nItems; i++)
+        {
+            auto spItem = makeItem(i);
+            stream.add(spItem);
+            // Odd items are removed, so readers see both kinds of modification
+            if(i % 2)
+                stream.remove(spItem->getId());
+        }
+        bDone = true;
+    });
+
+    std::vector<std::thread> readers;
+    for(int r = 0; r < 4; r++)
+        readers.emplace_back([&, r]()
+        {
+            size_t nLast = 0;
+            while(!bDone)
+            {
+                umf::MetadataSet all = stream.getAll();
+                umf::MetadataSet items = stream.queryByName("item");
+                // An odd item lives only until the writer removes it right after adding
+                for(const umf::MetadataSet* pSet : { &all, &items })
+                {
+                    size_t nOdd = 0;
+                    for(const auto& spItem : *pSet)
+                        nOdd += spItem->getFieldValue("value").get_integer() % 2;
+                    if(nOdd > 1)
+                        nErrors++;
+                }
+                if(!all.empty() && stream.getById(all.back()->getId()) == nullptr && all.back()->getId() % 2 == 0)
+                    nErrors++;
+
+                umf::umf_integer value = (umf::umf_integer)(all.size() * 2 + r) % nItems;
+                for(const auto& spItem : stream.queryByTime(value * 10, value * 10 + 5))
+                    if(spItem->getFieldValue("value").get_integer() < value - 1 || spItem->getFieldValue("value").get_integer() > value)
+                        nErrors++;
+
+                {
+                    umf::MetadataStream::ReadLock lock(stream);
+                    size_t nCount = 0;
+                    for(const auto& spItem : stream.select(umf::QueryExpr::name("item")))
+                        nCount += spItem->getFieldValue("value").get_integer() % 2 == 0;
+                    if(nCount < nLast)
+                        nErrors++;
+                    nLast = nCount;
+                }
+            }
+        });
+
+    writer.join();
+    for(auto& reader : readers)
+        reader.join();
+
+    EXPECT_EQ(0, nErrors.load());
+    EXPECT_EQ((size_t)nItems / 2, stream.getAll().size());
+    EXPECT_EQ((size_t)nItems / 2, stream.queryByName("item").size());
+    EXPECT_EQ(1u, stream.queryByFrameIndex(nItems - 2).size());
+    EXPECT_EQ(0u, stream.queryByFrameIndex(nItems - 1).size());
+}
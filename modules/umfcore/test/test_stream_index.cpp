@@ -0,0 +1,469 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "test_precomp.hpp"
+
+class TestStreamIndex : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        spSchema = std::make_shared<umf::MetadataSchema>("test_schema");
+        std::vector<umf::FieldDesc> fields;
+        fields.emplace_back(umf::FieldDesc("value", umf::Variant::type_integer));
+        spDesc = std::make_shared<umf::MetadataDesc>("item", fields);
+        spSchema->add(spDesc);
+        stream.addSchema(spSchema);
+    }
+
+    std::shared_ptr<umf::Metadata> addItem(long long frameIndex, long long numOfFrames,
+                                           long long timestamp, long long duration)
+    {
+        auto spItem = std::make_shared<umf::Metadata>(spDesc);
+        spItem->setFieldValue("value", (umf::umf_integer)stream.getAll().size());
+        spItem->setFrameIndex(frameIndex, numOfFrames);
+        spItem->setTimestamp(timestamp, duration);
+        stream.add(spItem);
+        return spItem;
+    }
+
+    static std::vector<umf::IdType> ids(const umf::MetadataSet& set)
+    {
+        std::vector<umf::IdType> vIds;
+        for(auto& spItem : set)
+            vIds.push_back(spItem->getId());
+        std::sort(vIds.begin(), vIds.end());
+        return vIds;
+    }
+
+    void compareWithScan()
+    {
+        umf::MetadataSet all = stream.getAll();
+        for(size_t index = 0; index < 64; index++)
+            ASSERT_EQ(ids(all.queryByFrameIndex(index)), ids(stream.queryByFrameIndex(index))) << "frame " << index;
+        for(long long start = -10; start < 300; start += 7)
+            for(long long end = start - 20; end < start + 60; end += 13)
+                ASSERT_EQ(ids(all.queryByTime(start, end)), ids(stream.queryByTime(start, end))) << start << ".." << end;
+    }
+
+    umf::MetadataStream stream;
+    std::shared_ptr<umf::MetadataSchema> spSchema;
+    std::shared_ptr<umf::MetadataDesc> spDesc;
+};
+
+TEST_F(TestStreamIndex, QueryByFrameIndex)
+{
+    auto spA = addItem(0, 5, umf::Metadata::UNDEFINED_TIMESTAMP, umf::Metadata::UNDEFINED_DURATION);
+    auto spB = addItem(3, 1, umf::Metadata::UNDEFINED_TIMESTAMP, umf::Metadata::UNDEFINED_DURATION);
+    addItem(umf::Metadata::UNDEFINED_FRAME_INDEX, umf::Metadata::UNDEFINED_FRAMES_NUMBER,
+            umf::Metadata::UNDEFINED_TIMESTAMP, umf::Metadata::UNDEFINED_DURATION);
+    addItem(10, 0, umf::Metadata::UNDEFINED_TIMESTAMP, umf::Metadata::UNDEFINED_DURATION);
+
+    umf::MetadataSet set = stream.queryByFrameIndex(3);
+    ASSERT_EQ(2u, set.size());
+    EXPECT_EQ(spA, set[0]);
+    EXPECT_EQ(spB, set[1]);
+    EXPECT_EQ(1u, stream.queryByFrameIndex(4).size());
+    EXPECT_EQ(0u, stream.queryByFrameIndex(5).size());
+    EXPECT_EQ(0u, stream.queryByFrameIndex(10).size());
+}
+
+TEST_F(TestStreamIndex, QueryByTime)
+{
+    auto spA = addItem(umf::Metadata::UNDEFINED_FRAME_INDEX, umf::Metadata::UNDEFINED_FRAMES_NUMBER, 100, 50);
+    auto spB = addItem(umf::Metadata::UNDEFINED_FRAME_INDEX, umf::Metadata::UNDEFINED_FRAMES_NUMBER, 160, 0);
+
+    EXPECT_EQ(1u, stream.queryByTime(150, 150).size());
+    EXPECT_EQ(0u, stream.queryByTime(151, 159).size());
+    EXPECT_EQ(2u, stream.queryByTime(0, 1000).size());
+    EXPECT_EQ(spB, stream.queryByTime(160, 170).at(0));
+    EXPECT_EQ(spA, stream.queryByTime(0, 100).at(0));
+}
+
+TEST_F(TestStreamIndex, MatchesScan)
+{
+    for(long long i = 0; i < 200; i++)
+    {
+        long long frameIndex = (i * 7) % 50, numOfFrames = i % 6;
+        long long timestamp = (i % 5 == 0) ? (long long)umf::Metadata::UNDEFINED_TIMESTAMP : (i * 13) % 250;
+        addItem(frameIndex, numOfFrames, timestamp, i % 30);
+    }
+    compareWithScan();
+}
+
+TEST_F(TestStreamIndex, InPlaceChanges)
+{
+    for(long long i = 0; i < 100; i++)
+        addItem(i % 40, 1 + i % 4, (i * 3) % 200, i % 10);
+
+    umf::MetadataSet all = stream.getAll();
+    for(size_t i = 0; i < all.size(); i += 3)
+    {
+        all[i]->setFrameIndex((long long)(i % 17), 2);
+        all[i]->setTimestamp(umf::Metadata::UNDEFINED_TIMESTAMP);
+    }
+    for(size_t i = 1; i < all.size(); i += 5)
+        all[i]->setTimestamp((long long)i * 2, 25);
+    compareWithScan();
+
+    for(size_t i = 0; i < all.size(); i += 4)
+        stream.remove(all[i]->getId());
+    compareWithScan();
+
+    umf::MetadataSet shifted = stream.getAll();
+    shifted.shift(30, 10, 15);
+    compareWithScan();
+}
+
+TEST_F(TestStreamIndex, RemoveById)
+{
+    for(long long i = 0; i < 50; i++)
+        addItem(i, 1, i, 1);
+
+    // Lookups must still find every item and the remaining ones keep their order
+    std::vector<umf::IdType> remaining;
+    for(umf::IdType id = 0; id < 50; id++)
+        remaining.push_back(id);
+    for(umf::IdType id : {0, 49, 17, 48, 1, 25})
+    {
+        ASSERT_TRUE(stream.remove(id));
+        ASSERT_FALSE(stream.remove(id));
+        remaining.erase(std::find(remaining.begin(), remaining.end(), id));
+        for(umf::IdType left : remaining)
+            ASSERT_EQ(left, stream.getById(left)->getId());
+    }
+    std::vector<umf::IdType> order;
+    for(auto& spItem : stream.getAll())
+        order.push_back(spItem->getId());
+    ASSERT_EQ(remaining, order);
+
+    umf::MetadataSet set;
+    set.push_back(stream.getById(2));
+    set.push_back(stream.getById(47));
+    stream.remove(set);
+    ASSERT_TRUE(stream.remove(3));
+    remaining.erase(std::find(remaining.begin(), remaining.end(), 2));
+    remaining.erase(std::find(remaining.begin(), remaining.end(), 47));
+    remaining.erase(std::find(remaining.begin(), remaining.end(), 3));
+    order.clear();
+    for(auto& spItem : stream.getAll())
+        order.push_back(spItem->getId());
+    ASSERT_EQ(remaining, order);
+    ASSERT_EQ(nullptr, stream.getById(47));
+    ASSERT_EQ(41u, stream.getAll().size());
+    for(auto& spItem : stream.getAll())
+        ASSERT_EQ(spItem, stream.getById(spItem->getId()));
+    compareWithScan();
+}
+
+TEST_F(TestStreamIndex, CopiedStream)
+{
+    for(long long i = 0; i < 20; i++)
+        addItem(i, 3, i * 10, 5);
+
+    umf::MetadataStream copy(stream);
+    EXPECT_EQ(3u, copy.queryByFrameIndex(5).size());
+    EXPECT_EQ(2u, copy.queryByTime(55, 60).size());
+
+    stream.clear();
+    EXPECT_EQ(0u, stream.queryByFrameIndex(5).size());
+    EXPECT_EQ(3u, copy.queryByFrameIndex(5).size());
+}
+
+TEST_F(TestStreamIndex, QueryBySchemaAndName)
+{
+    auto spOther = std::make_shared<umf::MetadataSchema>("other_schema");
+    std::vector<umf::FieldDesc> fields;
+    fields.emplace_back(umf::FieldDesc("value", umf::Variant::type_integer));
+    auto spOtherItem = std::make_shared<umf::MetadataDesc>("item", fields);
+    auto spOtherNote = std::make_shared<umf::MetadataDesc>("note", fields);
+    spOther->add(spOtherItem);
+    spOther->add(spOtherNote);
+    stream.addSchema(spOther);
+
+    for(long long i = 0; i < 30; i++)
+    {
+        auto spDescToUse = (i % 3 == 0) ? spDesc : (i % 3 == 1) ? spOtherItem : spOtherNote;
+        auto spItem = std::make_shared<umf::Metadata>(spDescToUse);
+        spItem->setFieldValue("value", (umf::umf_integer)i);
+        stream.add(spItem);
+    }
+
+    EXPECT_EQ(10u, stream.queryBySchema("test_schema").size());
+    EXPECT_EQ(20u, stream.queryBySchema("other_schema").size());
+    EXPECT_EQ(20u, stream.queryByName("item").size());
+    EXPECT_EQ(10u, stream.queryBySchemaAndName("other_schema", "item").size());
+    EXPECT_EQ(0u, stream.queryBySchemaAndName("test_schema", "note").size());
+    EXPECT_EQ(0u, stream.queryBySchema("unknown").size());
+
+    umf::MetadataSet items = stream.queryByName("item");
+    for(size_t i = 1; i < items.size(); i++)
+        EXPECT_LT(items[i-1]->getId(), items[i]->getId());
+
+    umf::MetadataSet all = stream.getAll();
+    for(size_t i = 0; i < all.size(); i += 2)
+        stream.remove(all[i]->getId());
+    all = stream.getAll();
+    EXPECT_EQ(ids(all.queryBySchema("test_schema")), ids(stream.queryBySchema("test_schema")));
+    EXPECT_EQ(ids(all.queryByName("item")), ids(stream.queryByName("item")));
+    EXPECT_EQ(ids(all.queryBySchema("other_schema").queryByName("note")), ids(stream.queryBySchemaAndName("other_schema", "note")));
+
+    stream.remove(spOther);
+    EXPECT_EQ(0u, stream.queryBySchema("other_schema").size());
+    EXPECT_EQ(5u, stream.queryByName("item").size());
+}
+
+class TestFieldIndex : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        spSchema = std::make_shared<umf::MetadataSchema>("test_schema");
+        std::vector<umf::FieldDesc> fields;
+        fields.emplace_back(umf::FieldDesc("id", umf::Variant::type_integer, false, false, true));
+        fields.emplace_back(umf::FieldDesc("score", umf::Variant::type_real, true, false, true));
+        fields.emplace_back(umf::FieldDesc("label", umf::Variant::type_string, true, false, true));
+        fields.emplace_back(umf::FieldDesc("plain", umf::Variant::type_integer, true));
+        spDesc = std::make_shared<umf::MetadataDesc>("item", fields);
+        spSchema->add(spDesc);
+        stream.addSchema(spSchema);
+
+        for(int i = 0; i < 200; i++)
+        {
+            auto spItem = std::make_shared<umf::Metadata>(spDesc);
+            spItem->setFieldValue("id", (umf::umf_integer)(i % 17));
+            if(i % 3)
+                spItem->setFieldValue("score", (umf::umf_real)(i % 11) / 4);
+            if(i % 5)
+                spItem->setFieldValue("label", "label" + std::to_string(i % 7));
+            spItem->setFieldValue("plain", (umf::umf_integer)(i % 13));
+            stream.add(spItem);
+        }
+    }
+
+    static std::vector<umf::IdType> ids(const umf::MetadataSet& set)
+    {
+        std::vector<umf::IdType> vIds;
+        for(auto& spItem : set)
+            vIds.push_back(spItem->getId());
+        return vIds;
+    }
+
+    std::vector<umf::IdType> scanRange(const std::string& sFieldName, double lo, double hi)
+    {
+        return ids(stream.query([&](const std::shared_ptr<umf::Metadata>& spItem)->bool
+        {
+            auto it = spItem->findField(sFieldName);
+            if(it == spItem->end())
+                return false;
+            double value = it->getType() == umf::Variant::type_real ? it->get_real() : (double)it->get_integer();
+            return lo <= value && value <= hi;
+        }));
+    }
+
+    void compareWithScan()
+    {
+        umf::MetadataSet all = stream.getAll();
+        std::vector<umf::FieldValue> values;
+        for(int i = 0; i < 18; i++)
+        {
+            values.emplace_back("id", umf::Variant((umf::umf_integer)i));
+            values.emplace_back("score", umf::Variant((umf::umf_real)i / 4));
+            values.emplace_back("label", umf::Variant("label" + std::to_string(i)));
+            values.emplace_back("plain", umf::Variant((umf::umf_integer)i));
+        }
+        for(auto& value : values)
+            ASSERT_EQ(ids(all.queryByNameAndValue("item", value)), ids(stream.queryByNameAndValue("item", value))) << value.getName();
+        for(size_t i = 0; i + 1 < values.size(); i++)
+        {
+            std::vector<umf::FieldValue> pair(values.begin() + i, values.begin() + i + 2);
+            ASSERT_EQ(ids(all.queryByNameAndFields("item", pair)), ids(stream.queryByNameAndFields("item", pair)));
+        }
+    }
+
+    umf::MetadataStream stream;
+    std::shared_ptr<umf::MetadataSchema> spSchema;
+    std::shared_ptr<umf::MetadataDesc> spDesc;
+};
+
+TEST_F(TestFieldIndex, MatchesScan)
+{
+    compareWithScan();
+    EXPECT_EQ(12u, stream.queryByNameAndValue("item", umf::FieldValue("id", umf::Variant((umf::umf_integer)3))).size());
+    EXPECT_EQ(0u, stream.queryByNameAndValue("other", umf::FieldValue("id", umf::Variant((umf::umf_integer)3))).size());
+    EXPECT_EQ(200u, stream.queryByNameAndFields("item", std::vector<umf::FieldValue>()).size());
+}
+
+TEST_F(TestFieldIndex, QueryByRange)
+{
+    EXPECT_EQ(scanRange("id", 3, 5), ids(stream.queryByNameAndRange("item", "id", umf::Variant((umf::umf_integer)3), umf::Variant((umf::umf_integer)5))));
+    EXPECT_EQ(scanRange("id", 2.5, 5.5), ids(stream.queryByNameAndRange("item", "id", umf::Variant(2.5), umf::Variant(5.5))));
+    EXPECT_EQ(scanRange("score", 0.5, 1.25), ids(stream.queryByNameAndRange("item", "score", umf::Variant(0.5), umf::Variant(1.25))));
+    EXPECT_EQ(scanRange("score", 1, 2), ids(stream.queryByNameAndRange("item", "score", umf::Variant((umf::umf_integer)1), umf::Variant((umf::umf_integer)2))));
+    EXPECT_EQ(scanRange("plain", 4, 8), ids(stream.queryByNameAndRange("item", "plain", umf::Variant((umf::umf_integer)4), umf::Variant((umf::umf_integer)8))));
+    EXPECT_EQ(0u, stream.queryByNameAndRange("item", "id", umf::Variant((umf::umf_integer)5), umf::Variant((umf::umf_integer)3)).size());
+
+    EXPECT_THROW(stream.queryByNameAndRange("item", "label", umf::Variant((umf::umf_integer)0), umf::Variant((umf::umf_integer)1)), umf::IncorrectParamException);
+    EXPECT_THROW(stream.queryByNameAndRange("item", "id", umf::Variant("0"), umf::Variant((umf::umf_integer)1)), umf::IncorrectParamException);
+}
+
+TEST_F(TestFieldIndex, InPlaceChanges)
+{
+    umf::MetadataSet all = stream.getAll();
+    for(size_t i = 0; i < all.size(); i += 4)
+    {
+        all[i]->setFieldValue("id", (umf::umf_integer)(100 + i % 3));
+        all[i]->setFieldValue("score", (umf::umf_real)i);
+        all[i]->setFieldValue("label", "changed");
+    }
+    for(size_t i = 1; i < all.size(); i += 6)
+        stream.remove(all[i]->getId());
+    compareWithScan();
+
+    EXPECT_EQ(ids(stream.getAll().queryByNameAndValue("item", umf::FieldValue("label", umf::Variant("changed")))),
+              ids(stream.queryByNameAndValue("item", umf::FieldValue("label", umf::Variant("changed")))));
+    EXPECT_EQ(scanRange("id", 100, 102), ids(stream.queryByNameAndRange("item", "id", umf::Variant((umf::umf_integer)100), umf::Variant((umf::umf_integer)102))));
+    EXPECT_EQ(scanRange("score", 100, 150), ids(stream.queryByNameAndRange("item", "score", umf::Variant(100.0), umf::Variant(150.0))));
+
+    umf::MetadataStream copy(stream);
+    EXPECT_EQ(ids(stream.queryByNameAndValue("item", umf::FieldValue("id", umf::Variant((umf::umf_integer)101)))),
+              ids(copy.queryByNameAndValue("item", umf::FieldValue("id", umf::Variant((umf::umf_integer)101)))));
+}
+
+class TestReferenceIndex : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        spSchema = std::make_shared<umf::MetadataSchema>("test_schema");
+        std::vector<umf::FieldDesc> fields;
+        fields.emplace_back(umf::FieldDesc("value", umf::Variant::type_integer));
+        std::vector<std::shared_ptr<umf::ReferenceDesc>> refs;
+        refs.emplace_back(std::make_shared<umf::ReferenceDesc>("parent"));
+        spNode = std::make_shared<umf::MetadataDesc>("node", fields, refs);
+        spLeaf = std::make_shared<umf::MetadataDesc>("leaf", fields, refs);
+        spSchema->add(spNode);
+        spSchema->add(spLeaf);
+        stream.addSchema(spSchema);
+    }
+
+    std::shared_ptr<umf::Metadata> addItem(const std::shared_ptr<umf::MetadataDesc>& spDesc, umf::umf_integer value)
+    {
+        auto spItem = std::make_shared<umf::Metadata>(spDesc);
+        spItem->setFieldValue("value", value);
+        stream.add(spItem);
+        return spItem;
+    }
+
+    static std::vector<umf::IdType> ids(const umf::MetadataSet& set)
+    {
+        std::vector<umf::IdType> vIds;
+        for(auto& spItem : set)
+            vIds.push_back(spItem->getId());
+        std::sort(vIds.begin(), vIds.end());
+        return vIds;
+    }
+
+    void compareWithScan()
+    {
+        umf::MetadataSet all = stream.getAll();
+        for(const char* name : {"node", "leaf", "unknown"})
+        {
+            ASSERT_EQ(ids(all.queryByReference(name)), ids(stream.queryByReference(name))) << name;
+            for(umf::umf_integer value = 0; value < 4; value++)
+            {
+                umf::FieldValue fv("value", umf::Variant(value));
+                ASSERT_EQ(ids(all.queryByReference(name, fv)), ids(stream.queryByReference(name, fv))) << name << value;
+                std::vector<umf::FieldValue> vFields(1, fv);
+                ASSERT_EQ(ids(all.queryByReference(name, vFields)), ids(stream.queryByReference(name, vFields))) << name << value;
+            }
+        }
+        for(auto& spItem : all)
+        {
+            std::vector<umf::IdType> referrers;
+            for(auto& spOther : all)
+                if(spOther->isReference(spItem->getId()) || spOther->isReference(spItem->getId(), "parent"))
+                    referrers.push_back(spOther->getId());
+            ASSERT_EQ(referrers, ids(stream.queryReferrers(spItem->getId()))) << spItem->getId();
+        }
+    }
+
+    umf::MetadataStream stream;
+    std::shared_ptr<umf::MetadataSchema> spSchema;
+    std::shared_ptr<umf::MetadataDesc> spNode;
+    std::shared_ptr<umf::MetadataDesc> spLeaf;
+};
+
+TEST_F(TestReferenceIndex, QueryReferrers)
+{
+    auto spRoot = addItem(spNode, 0);
+    auto spChild = addItem(spNode, 1);
+    auto spLeafA = addItem(spLeaf, 2);
+    auto spLeafB = addItem(spLeaf, 3);
+    spChild->addReference(spRoot, "parent");
+    spLeafA->addReference(spChild, "parent");
+    spLeafA->addReference(spRoot);
+    spLeafB->addReference(spChild, "parent");
+    spLeafB->addReference(spLeafA);
+
+    EXPECT_EQ(std::vector<umf::IdType>({spChild->getId(), spLeafA->getId()}), ids(stream.queryReferrers(spRoot->getId())));
+    EXPECT_EQ(std::vector<umf::IdType>({spChild->getId()}), ids(stream.queryReferrers(spRoot->getId(), "parent")));
+    EXPECT_EQ(std::vector<umf::IdType>({spLeafA->getId(), spLeafB->getId()}), ids(stream.queryReferrers(spChild->getId(), "parent")));
+    EXPECT_EQ(0u, stream.queryReferrers(spLeafB->getId()).size());
+    compareWithScan();
+
+    spLeafA->removeReference(spRoot);
+    spLeafB->removeReference(spChild->getId(), "parent");
+    EXPECT_EQ(std::vector<umf::IdType>({spChild->getId()}), ids(stream.queryReferrers(spRoot->getId())));
+    EXPECT_EQ(std::vector<umf::IdType>({spLeafA->getId()}), ids(stream.queryReferrers(spChild->getId())));
+    compareWithScan();
+
+    spLeafB->removeReference(spLeafA);
+    EXPECT_EQ(0u, stream.queryReferrers(spLeafA->getId()).size());
+    compareWithScan();
+}
+
+TEST_F(TestReferenceIndex, Remove)
+{
+    auto spRoot = addItem(spNode, 0);
+    std::vector<std::shared_ptr<umf::Metadata>> children;
+    for(umf::umf_integer i = 0; i < 20; i++)
+    {
+        auto spItem = addItem(i % 2 ? spLeaf : spNode, i % 4);
+        spItem->addReference(spRoot, "parent");
+        if(!children.empty())
+            spItem->addReference(children.back());
+        children.push_back(spItem);
+    }
+    compareWithScan();
+
+    // Named and unnamed references to a removed item are dropped
+    ASSERT_TRUE(stream.remove(children[5]->getId()));
+    EXPECT_FALSE(children[6]->isReference(children[5]->getId()));
+    EXPECT_EQ(0u, stream.queryReferrers(children[5]->getId()).size());
+    compareWithScan();
+
+    ASSERT_TRUE(stream.remove(spRoot->getId()));
+    for(auto& spItem : stream.getAll())
+        EXPECT_FALSE(spItem->isReference(spRoot->getId(), "parent"));
+    compareWithScan();
+
+    // Removed items no longer report their own references
+    EXPECT_EQ(std::vector<umf::IdType>({children[8]->getId()}), ids(stream.queryReferrers(children[7]->getId())));
+    ASSERT_TRUE(stream.remove(children[8]->getId()));
+    EXPECT_EQ(0u, stream.queryReferrers(children[7]->getId()).size());
+    compareWithScan();
+}
@@ -0,0 +1,56 @@
+/* 
+ * Copyright 2015 Intel(r) Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http ://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "test_precomp.hpp"
+
+TEST(TestSymbol, Interning)
+{
+    umf::Symbol a("symbol_test_name"), b(std::string("symbol_test_") + "name"), c("symbol_test_other");
+    ASSERT_TRUE(a == b);
+    ASSERT_TRUE(a != c);
+    ASSERT_EQ(&a.str(), &b.str());
+    ASSERT_EQ("symbol_test_name", a.str());
+    ASSERT_TRUE(a == std::string("symbol_test_name"));
+
+    umf::Symbol empty;
+    ASSERT_TRUE(empty.empty());
+    ASSERT_TRUE(empty == umf::Symbol(""));
+}
+
+TEST(TestSymbol, Find)
+{
+    umf::Symbol found;
+    ASSERT_FALSE(umf::Symbol::find("symbol_test_never_interned", found));
+    ASSERT_TRUE(found.empty());
+
+    umf::Symbol interned("symbol_test_interned");
+    ASSERT_TRUE(umf::Symbol::find("symbol_test_interned", found));
+    ASSERT_TRUE(found == interned);
+}
+
+TEST(TestSymbol, FieldLookup)
+{
+    auto spSchema = umf::MetadataSchema::getStdSchema();
+    umf::Metadata md(spSchema->findMetadataDesc("location"));
+    md.push_back(umf::FieldValue("latitude", (umf::umf_real) 1.5));
+
+    ASSERT_EQ(spSchema->getName(), md.getSchemaName());
+    ASSERT_TRUE(md.getNameSymbol() == umf::Symbol("location"));
+    ASSERT_TRUE(md.findField(umf::Symbol("latitude")) != md.end());
+    ASSERT_TRUE(md.findField("latitude") != md.end());
+    ASSERT_TRUE(md.findField("symbol_test_no_such_field") == md.end());
+    ASSERT_TRUE(md.findField(umf::Symbol("longitude")) == md.end());
+}
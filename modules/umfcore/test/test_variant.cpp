@@ -16,6 +16,11 @@
  */
 #include "test_precomp.hpp"
 
+#include <cfloat>
+#include <cstdio>
+#include <random>
+#include <sstream>
+
 class TestVariant: public ::testing::Test
 {
 public:
@@ -116,6 +121,31 @@ TEST_F(TestVariant, CreateRawbuffer)
     ASSERT_TRUE(result);
 }
 
+TEST_F(TestVariant, CreateByMovingValues)
+{
+    std::string str(1000, 's');
+    const char* pStr = str.data();
+    umf::Variant vStr(std::move(str));
+    ASSERT_EQ(umf::Variant::type_string, vStr.getType());
+    ASSERT_EQ(pStr, vStr.get_string().data());
+
+    umf::umf_rawbuffer rbuf(1000);
+    const char* pBuf = rbuf.data();
+    umf::Variant vBuf(std::move(rbuf));
+    ASSERT_EQ(pBuf, vBuf.get_rawbuffer().data());
+
+    std::vector<umf::umf_real> reals(1000, 0.5);
+    const umf::umf_real* pReals = reals.data();
+    v = std::move(reals);
+    ASSERT_EQ(umf::Variant::type_real_vector, v.getType());
+    ASSERT_EQ(pReals, v.get_real_vector().data());
+
+    std::vector<char> chars(100, 'c');
+    const char* pChars = chars.data();
+    umf::umf_rawbuffer moved(std::move(chars));
+    ASSERT_EQ(pChars, moved.data());
+}
+
 TEST_F(TestVariant, CreateIntegerVector)
 {
     std::vector<umf::umf_integer> vint;
@@ -524,6 +554,76 @@ TEST_F(TestVariant, FloatConstructor)
     ASSERT_DOUBLE_EQ(value, (umf::umf_real) v);
 }
 
+TEST_F(TestVariant, SwitchStorage)
+{
+    umf::Variant inlineValue(umf::umf_vec3d(1, 2, 3));
+    umf::Variant heapValue(umf::umf_string("text"));
+
+    v = inlineValue;
+    ASSERT_TRUE(v == inlineValue);
+    v = heapValue;
+    ASSERT_EQ("text", v.get_string());
+    v = (umf::umf_integer) 7;
+    ASSERT_EQ(7, v.get_integer());
+
+    umf::Variant moved(std::move(heapValue));
+    ASSERT_EQ("text", moved.get_string());
+    ASSERT_EQ(umf::Variant::type_empty, heapValue.getType());
+
+    moved = std::move(inlineValue);
+    ASSERT_EQ(umf::Variant::type_vec3d, moved.getType());
+    ASSERT_DOUBLE_EQ(2, moved.get_vec3d().y);
+
+    v.fromString("(string) abc");
+    ASSERT_EQ("abc", v.get_string());
+    v.fromString("(real) 1.5");
+    ASSERT_DOUBLE_EQ(1.5, v.get_real());
+}
+
+TEST_F(TestVariant, TryGet)
+{
+    v = umf::Variant((umf::umf_integer) 42);
+    ASSERT_TRUE(v.try_get<umf::umf_integer>() != nullptr);
+    ASSERT_EQ(42, *v.try_get<umf::umf_integer>());
+    ASSERT_TRUE(v.try_get<umf::umf_real>() == nullptr);
+
+    v = umf::Variant(std::vector<umf::umf_string>(2, "text"));
+    ASSERT_TRUE(v.try_get<umf::umf_string>() == nullptr);
+    ASSERT_EQ(2u, v.try_get<std::vector<umf::umf_string>>()->size());
+
+    v = umf::Variant();
+    ASSERT_TRUE(v.try_get<umf::umf_integer>() == nullptr);
+}
+
+struct TypeNameVisitor
+{
+    std::string operator()(const umf::Variant::Empty&) const { return "empty"; }
+    std::string operator()(const umf::umf_integer&) const { return "integer"; }
+    std::string operator()(const umf::umf_vec2d&) const { return "vec2d"; }
+    std::string operator()(const umf::umf_string&) const { return "string"; }
+    template<class T> std::string operator()(const std::vector<T>&) const { return "vector"; }
+    template<class T> std::string operator()(const T&) const { return "other"; }
+};
+
+TEST_F(TestVariant, Visit)
+{
+    ASSERT_EQ("empty", v.visit(TypeNameVisitor()));
+    ASSERT_EQ("integer", umf::Variant((umf::umf_integer) 1).visit(TypeNameVisitor()));
+    ASSERT_EQ("vec2d", umf::Variant(umf::umf_vec2d(1, 2)).visit(TypeNameVisitor()));
+    ASSERT_EQ("string", umf::Variant("text").visit(TypeNameVisitor()));
+    ASSERT_EQ("vector", umf::Variant(std::vector<umf::umf_real>(3, 1.0)).visit(TypeNameVisitor()));
+    ASSERT_EQ("other", umf::Variant((umf::umf_real) 1).visit(TypeNameVisitor()));
+    ASSERT_EQ("other", umf::Variant(umf::umf_rawbuffer("raw", 3)).visit(TypeNameVisitor()));
+}
+
+TEST_F(TestVariant, ConvertNumbers)
+{
+    v = umf::Variant((umf::umf_integer) -42);
+    v.convertTo(umf::Variant::type_real);
+    ASSERT_DOUBLE_EQ(-42.0, v.get_real());
+    ASSERT_THROW(v.convertTo(umf::Variant::type_integer), umf::TypeCastException);
+}
+
 TEST_F(TestVariant, VectorIntConstructor)
 {
     std::vector<int> value;
@@ -568,6 +668,97 @@ TEST_F(TestVariant, typeFromString)
     ASSERT_EQ(v.typeFromString("vec4d[]"), umf::Variant::type_vec4d_vector);
 }
 
+static std::string printReal(umf::umf_real value)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.15g", value);
+    return buf;
+}
+
+static umf::umf_real streamReal(const std::string& s)
+{
+    umf::umf_real value = 0;
+    std::istringstream stream(s);
+    stream >> value;
+    return value;
+}
+
+TEST_F(TestVariant, RealTextMatchesPrintf)
+{
+    std::vector<umf::umf_real> values = { 0.0, -0.0, 1.0, -1.0, 0.1, 0.5, 1.5, 42.42, 24.24, 1e15, 1e16, 999999999999999.0,
+        9999999999999995.0, 0.00001, 0.0001, 0.000123456789012345, 123456789012345.6, 1e-300, 1e300, 5e-324,
+        DBL_MAX, DBL_MIN, -DBL_MAX, 1.0 / 3, 2.0 / 3, 0.30000000000000004, 1.0000000000000002, 9.5367431640625e-07,
+        1.1920928955078125e-07, 0.125, 1e22, 1e23, 123.456e-10 };
+
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<double> mantissa(-10, 10);
+    std::uniform_int_distribution<int> exponent(-320, 308);
+    std::uniform_int_distribution<unsigned long long> bits;
+    for(int i = 0; i < 20000; i++)
+    {
+        values.push_back(mantissa(random) * std::pow(10.0, exponent(random) / 10));
+        values.push_back(std::ldexp(mantissa(random), exponent(random)));
+        unsigned long long word = bits(random);
+        umf::umf_real value;
+        memcpy(&value, &word, sizeof(value));
+        if(std::isfinite(value))
+            values.push_back(value);
+    }
+
+    for(auto value : values)
+    {
+        ASSERT_EQ(printReal(value), umf::Variant(value).toString()) << value;
+        umf::Variant parsed;
+        parsed.fromString(umf::Variant::type_real, printReal(value));
+        ASSERT_EQ(streamReal(printReal(value)), parsed.get_real()) << printReal(value);
+    }
+}
+
+TEST_F(TestVariant, ParseNumbers)
+{
+    v.fromString(umf::Variant::type_integer, " -9223372036854775808");
+    EXPECT_EQ(std::numeric_limits<umf::umf_integer>::min(), v.get_integer());
+    v.fromString(umf::Variant::type_integer, "(integer) 9223372036854775807");
+    EXPECT_EQ(std::numeric_limits<umf::umf_integer>::max(), v.get_integer());
+    v.fromString(umf::Variant::type_integer, "+12abc");
+    EXPECT_EQ(12, v.get_integer());
+    v.fromString(umf::Variant::type_integer, "abc");
+    EXPECT_EQ(0, v.get_integer());
+
+    for(const char* psz : { "1", "-2.5", "  .5", "3.", "1e5", "1E-5", "12345678901234567890123", "0.000000000000000000000000123",
+        "1.7976931348623157e308", "4.9406564584124654e-324", "2.2250738585072014e-308", "9007199254740993", "0.1e1x" })
+    {
+        v.fromString(umf::Variant::type_real, psz);
+        EXPECT_EQ(streamReal(psz), v.get_real()) << psz;
+    }
+    v.fromString(umf::Variant::type_real, "-inf");
+    EXPECT_EQ(-std::numeric_limits<umf::umf_real>::infinity(), v.get_real());
+    v.fromString(umf::Variant::type_real, "nan");
+    EXPECT_TRUE(std::isnan(v.get_real()));
+}
+
+TEST_F(TestVariant, ParseVectors)
+{
+    v.fromString(umf::Variant::type_integer_vector, "1 ; -2;3 ;");
+    EXPECT_EQ(std::vector<umf::umf_integer>({1, -2, 3, 0}), v.get_integer_vector());
+    v.fromString(umf::Variant::type_integer_vector, "");
+    EXPECT_EQ(std::vector<umf::umf_integer>({0}), v.get_integer_vector());
+    EXPECT_THROW(v.fromString(umf::Variant::type_integer_vector, "1 2"), umf::IncorrectParamException);
+    EXPECT_THROW(v.fromString(umf::Variant::type_real_vector, "1.5 , 2"), umf::IncorrectParamException);
+
+    std::vector<umf::umf_vec3d> points = { umf::umf_vec3d(0.1, -2, 3e-7), umf::umf_vec3d(1.0 / 3, 1e300, -0.0) };
+    umf::Variant source(points);
+    EXPECT_EQ("0.1 -2 3e-07 ; 0.333333333333333 1e+300 -0", source.toString());
+    v.fromString(umf::Variant::type_vec3d_vector, source.toString());
+    ASSERT_EQ(2u, v.get_vec3d_vector().size());
+    EXPECT_EQ(points[0], v.get_vec3d_vector()[0]);
+    EXPECT_EQ(umf::umf_vec3d(0.333333333333333, 1e300, 0), v.get_vec3d_vector()[1]);
+
+    std::vector<umf::umf_string> strings = { "a b", "", "x;y" };
+    v.fromString(umf::Variant::type_string_vector, umf::Variant(strings).toString());
+    EXPECT_EQ(strings, v.get_string_vector());
+}
+
 class TestVariantVectorTypes : public ::testing::Test
 {
 protected:
@@ -729,3 +920,59 @@ TEST_P(TestVariantRawBuffer_Base64Decoding, TestDecode)
 
 INSTANTIATE_TEST_CASE_P(UnitTest, TestVariantRawBuffer_Base64Decoding, ::testing::Values( std::make_tuple("Zm9==vYgAA", 0), std::make_tuple("AA===", 1),
     std::make_tuple("Zm9vY-gA", 2), std::make_tuple("Zm9vYgAA", 3), std::make_tuple("", 4) ) );
+
+static std::string referenceBase64(const umf::umf_rawbuffer& buf)
+{
+    const char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string s;
+    for(size_t i = 0; i < buf.size(); i += 3)
+    {
+        unsigned group = (unsigned char)buf[i] << 16;
+        if(i + 1 < buf.size()) group |= (unsigned char)buf[i + 1] << 8;
+        if(i + 2 < buf.size()) group |= (unsigned char)buf[i + 2];
+        s += chars[group >> 18];
+        s += chars[(group >> 12) & 0x3f];
+        s += i + 1 < buf.size() ? chars[(group >> 6) & 0x3f] : '=';
+        s += i + 2 < buf.size() ? chars[group & 0x3f] : '=';
+    }
+    return s;
+}
+
+TEST(TestVariantBase64, MatchesReference)
+{
+    std::mt19937 random(1);
+    std::vector<size_t> sizes;
+    for(size_t size = 0; size < 300; size++)
+        sizes.push_back(size);
+    sizes.push_back(1 << 20);
+    sizes.push_back((1 << 20) + 7);
+
+    for(auto size : sizes)
+    {
+        umf::umf_rawbuffer buf;
+        buf.resize(size);
+        for(auto& c : buf)
+            c = (char)random();
+        std::string text = umf::Variant::base64encode(buf);
+        ASSERT_EQ(referenceBase64(buf), text) << size;
+        ASSERT_EQ(buf, umf::Variant::base64decode(text)) << size;
+    }
+}
+
+TEST(TestVariantBase64, InvalidSymbolAnywhere)
+{
+    std::string data(119, 'x');
+    std::string text = umf::Variant::base64encode(umf::umf_rawbuffer(data.data(), data.size()));
+    for(size_t i = 0; i < text.size(); i++)
+    {
+        for(char c : { '-', '=', '\0', '\x80', ' ' })
+        {
+            // '=' may turn into valid padding in the last group
+            if(text[i] == '=' || (c == '=' && i + 4 >= text.size()))
+                continue;
+            std::string broken = text;
+            broken[i] = c;
+            ASSERT_THROW(umf::Variant::base64decode(broken), umf::IncorrectParamException) << i;
+        }
+    }
+}